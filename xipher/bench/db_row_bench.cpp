@@ -0,0 +1,217 @@
+// Row decoding micro-benchmark: the hand-written PQgetvalue/strcmp/stoll
+// loop DatabaseManager::getMessages used to run vs. kPinnedMessageRow, on a
+// synthetic 1,000-row result (no server needed), plus uuid ids decoded from
+// text vs. binary results. Heap allocations are counted per decode.
+//
+//   cmake -S . -B build -DXIPHER_BUILD_BENCHMARKS=ON && cmake --build build --target db_row_bench
+//   ./build/db_row_bench [iterations]
+
+#include "../include/database/db_rows.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace xipher;
+
+namespace {
+
+size_t g_allocations = 0;
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    g_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+constexpr int kRows = 1000;
+
+PGresult* makeResult(const std::vector<std::pair<const char*, Oid>>& columns, int format) {
+    PGresult* res = PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK);
+    std::vector<PGresAttDesc> attrs(columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+        attrs[i] = PGresAttDesc{const_cast<char*>(columns[i].first), 0, 0, format, columns[i].second, -1, -1};
+    }
+    PQsetResultAttrs(res, static_cast<int>(attrs.size()), attrs.data());
+    return res;
+}
+
+void setText(PGresult* res, int row, int col, const std::string& value) {
+    PQsetvalue(res, row, col, const_cast<char*>(value.c_str()), static_cast<int>(value.size()));
+}
+
+void setNull(PGresult* res, int row, int col) {
+    PQsetvalue(res, row, col, nullptr, -1);
+}
+
+std::string uuidFor(int i) {
+    char buf[37];
+    std::snprintf(buf, sizeof(buf), "%08x-0000-4000-8000-%012x", 0x5f3e0000u + static_cast<unsigned>(i),
+                  static_cast<unsigned>(i) * 7919u);
+    return buf;
+}
+
+std::string uuidBytes(const std::string& uuid) {
+    std::string bytes;
+    for (size_t i = 0; i < uuid.size(); ++i) {
+        if (uuid[i] == '-') continue;
+        bytes.push_back(static_cast<char>(std::stoi(uuid.substr(i, 2), nullptr, 16)));
+        ++i;
+    }
+    return bytes;
+}
+
+// Shaped like get_messages: 14 columns, a mix of short and long content
+PGresult* makeMessages() {
+    PGresult* res = makeResult({{"id", kPgUuidOid}, {"sender_id", kPgUuidOid}, {"receiver_id", kPgUuidOid},
+                                {"content", kPgTextOid}, {"created_at", 1184}, {"is_read", kPgBoolOid},
+                                {"is_delivered", kPgBoolOid}, {"message_type", kPgVarcharOid},
+                                {"file_path", kPgTextOid}, {"file_name", kPgTextOid}, {"file_size", kPgInt8Oid},
+                                {"reply_to_message_id", kPgUuidOid}, {"reply_markup", kPgTextOid},
+                                {"is_pinned", kPgBoolOid}},
+                               0);
+    const std::string a = uuidFor(1);
+    const std::string b = uuidFor(2);
+    for (int i = 0; i < kRows; ++i) {
+        setText(res, i, 0, uuidFor(1000 + i));
+        setText(res, i, 1, i % 2 ? a : b);
+        setText(res, i, 2, i % 2 ? b : a);
+        setText(res, i, 3, i % 5 ? "ok" : "Привет! See you at 10:00, bring the docs and the charger please");
+        setText(res, i, 4, "2026-10-17 12:34:56.123456+00");
+        setText(res, i, 5, i % 3 ? "t" : "f");
+        setText(res, i, 6, "t");
+        setText(res, i, 7, i % 7 ? "text" : "image");
+        setText(res, i, 8, i % 7 ? "" : "/files/5f3e/photo.jpg");
+        setText(res, i, 9, i % 7 ? "" : "photo.jpg");
+        setText(res, i, 10, i % 7 ? "0" : "183424");
+        if (i % 4) {
+            setNull(res, i, 11);
+        } else {
+            setText(res, i, 11, uuidFor(999 + i));
+        }
+        setText(res, i, 12, "");
+        setText(res, i, 13, i == 10 ? "t" : "f");
+    }
+    return res;
+}
+
+PGresult* makeIds(int format) {
+    PGresult* res = makeResult({{"user_id", kPgUuidOid}}, format);
+    for (int i = 0; i < kRows; ++i) {
+        const std::string text = uuidFor(i);
+        setText(res, i, 0, format == 1 ? uuidBytes(text) : text);
+    }
+    return res;
+}
+
+// The decoding loop getMessages had before the row mappers
+std::vector<Message> legacyDecode(PGresult* res) {
+    std::vector<Message> messages;
+    int rows = PQntuples(res);
+    for (int i = 0; i < rows; i++) {
+        Message msg;
+        msg.id = PQgetvalue(res, i, 0);
+        msg.sender_id = PQgetvalue(res, i, 1);
+        msg.receiver_id = PQgetvalue(res, i, 2);
+        msg.content = PQgetvalue(res, i, 3);
+        msg.created_at = PQgetvalue(res, i, 4);
+        msg.is_read = (strcmp(PQgetvalue(res, i, 5), "t") == 0);
+        msg.is_delivered = (strcmp(PQgetvalue(res, i, 6), "t") == 0);
+        msg.message_type = (PQgetisnull(res, i, 7)) ? "text" : std::string(PQgetvalue(res, i, 7));
+        msg.file_path = (PQgetisnull(res, i, 8)) ? "" : std::string(PQgetvalue(res, i, 8));
+        msg.file_name = (PQgetisnull(res, i, 9)) ? "" : std::string(PQgetvalue(res, i, 9));
+        msg.file_size = (PQgetisnull(res, i, 10)) ? 0 : std::stoll(PQgetvalue(res, i, 10));
+        msg.reply_to_message_id = (PQgetisnull(res, i, 11)) ? "" : std::string(PQgetvalue(res, i, 11));
+        msg.reply_markup = (PQgetisnull(res, i, 12)) ? "" : std::string(PQgetvalue(res, i, 12));
+        msg.is_pinned = (PQgetisnull(res, i, 13)) ? false : (PQgetvalue(res, i, 13)[0] == 't');
+        messages.push_back(msg);
+    }
+    return messages;
+}
+
+std::vector<std::string> decodeIds(PGresult* res) {
+    std::vector<std::string> ids(static_cast<size_t>(PQntuples(res)));
+    for (int i = 0; i < PQntuples(res); ++i) {
+        pgDecode(res, i, 0, ids[static_cast<size_t>(i)]);
+    }
+    return ids;
+}
+
+bool sameMessages(const std::vector<Message>& a, const std::vector<Message>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        const Message& x = a[i];
+        const Message& y = b[i];
+        if (x.id != y.id || x.sender_id != y.sender_id || x.receiver_id != y.receiver_id || x.content != y.content ||
+            x.created_at != y.created_at || x.is_read != y.is_read || x.is_delivered != y.is_delivered ||
+            x.message_type != y.message_type || x.file_path != y.file_path || x.file_name != y.file_name ||
+            x.file_size != y.file_size || x.reply_to_message_id != y.reply_to_message_id ||
+            x.reply_markup != y.reply_markup || x.is_pinned != y.is_pinned) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Fn>
+void report(const char* name, long iterations, Fn&& fn) {
+    size_t sink = 0;
+    const size_t allocations_before = g_allocations;
+    sink += fn().size();
+    const size_t allocations = g_allocations - allocations_before;
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        sink += fn().size();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (sink == 42) {
+        std::cout << "";  // keep the loop from being optimised away
+    }
+    std::cout << name << ": " << std::chrono::duration<double, std::micro>(elapsed).count() / iterations
+              << " us/result, " << allocations << " allocations\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const long iterations = argc > 1 ? std::atol(argv[1]) : 2000;
+
+    PGresult* messages = makeMessages();
+    if (!sameMessages(legacyDecode(messages), kPinnedMessageRow.all(messages))) {
+        std::cerr << "row mapper output differs from the legacy decoder\n";
+        return 1;
+    }
+    report("messages x1000 legacy", iterations, [&]() { return legacyDecode(messages); });
+    report("messages x1000 kPinnedMessageRow", iterations, [&]() { return kPinnedMessageRow.all(messages); });
+
+    PGresult* text_ids = makeIds(0);
+    PGresult* binary_ids = makeIds(1);
+    if (decodeIds(text_ids) != decodeIds(binary_ids)) {
+        std::cerr << "binary uuid decoding differs from text\n";
+        return 1;
+    }
+    report("uuid x1000 text", iterations, [&]() { return decodeIds(text_ids); });
+    report("uuid x1000 binary", iterations, [&]() { return decodeIds(binary_ids); });
+
+    PQclear(messages);
+    PQclear(text_ids);
+    PQclear(binary_ids);
+    return 0;
+}
@@ -0,0 +1,115 @@
+// JSON parsing micro-benchmark: legacy JsonParser::parse (copy + flat map)
+// vs. JsonDocument (structural index + lazy reads) on request-shaped bodies.
+//
+//   cmake -S . -B build -DXIPHER_BUILD_BENCHMARKS=ON && cmake --build build --target json_bench
+//   ./build/json_bench [iterations]
+
+#include "../include/utils/json_parser.hpp"
+#include "../include/utils/json_view.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace xipher;
+
+namespace {
+
+struct Body {
+    const char* name;
+    std::string json;
+    std::vector<std::string> fields;  // what the handler reads
+    long iterations_divisor;
+};
+
+std::string base64Payload(size_t size) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        out += alphabet[(i * 7 + i / 3) % 64];
+    }
+    return out;
+}
+
+std::string sdpPayload() {
+    std::string sdp;
+    for (int i = 0; i < 40; ++i) {
+        sdp += "a=candidate:" + std::to_string(i) + " 1 udp 2122260223 192.168.1." + std::to_string(i) +
+               " 5" + std::to_string(1000 + i) + " typ host generation 0 network-id 1\\r\\n";
+    }
+    return sdp;
+}
+
+std::vector<Body> makeBodies() {
+    return {
+        {"send-message",
+         R"({"token":"3f9a1c2b7d4e5f60718293a4b5c6d7e8","chat_id":"8f14e45f-ceea-467f-a0e6-b0e3c9a8d2f1",)"
+         R"("content":"Привет! See you at 10:00, bring the \"docs\"","message_type":"text","reply_to":"",)"
+         R"("temp_id":"tmp-1712345678901"})",
+         {"token", "chat_id", "content", "message_type"}, 1},
+        {"bot-sendMessage",
+         R"({"chat_id":"123456","text":"Choose an option","parse_mode":"HTML","reply_markup":{"inline_keyboard":)"
+         R"([[{"text":"Yes","callback_data":"yes"},{"text":"No","callback_data":"no"}],)"
+         R"([{"text":"Open","url":"https://xipher.pro/@channel"}]]},"disable_notification":false})",
+         {"chat_id", "text", "reply_markup"}, 1},
+        {"ws-call-offer",
+         "{\"type\":\"call_offer\",\"token\":\"cookie\",\"receiver_id\":\"42\",\"call_type\":\"video\","
+         "\"offer\":\"v=0\\r\\no=- 4611731400430051336 2 IN IP4 127.0.0.1\\r\\n" + sdpPayload() + "\"}",
+         {"type", "token", "receiver_id", "offer"}, 20},
+        {"upload-file-2MB",
+         "{\"token\":\"3f9a1c2b7d4e5f60718293a4b5c6d7e8\",\"file_name\":\"photo.jpg\",\"file_data\":\"" +
+             base64Payload(2 * 1024 * 1024) + "\"}",
+         {"token", "file_name", "file_data"}, 5000},
+    };
+}
+
+template <class Fn>
+double nsPerOp(long iterations, Fn&& fn) {
+    size_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        sink += fn();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (sink == 42) {
+        std::cout << "";  // keep the loop from being optimised away
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const long base_iterations = argc > 1 ? std::atol(argv[1]) : 200000;
+
+    for (const auto& body : makeBodies()) {
+        const long iterations = std::max(1L, base_iterations / body.iterations_divisor);
+        const double legacy = nsPerOp(iterations, [&]() {
+            auto data = JsonParser::parse(body.json);
+            size_t total = 0;
+            for (const auto& field : body.fields) {
+                total += data[field].size();
+            }
+            return total;
+        });
+        const double indexed = nsPerOp(iterations, [&]() {
+            const JsonDocument doc(body.json);
+            const JsonValue data = doc.root();
+            size_t total = 0;
+            for (const auto& field : body.fields) {
+                total += data[field].asString().size();
+            }
+            return total;
+        });
+        const double shim = nsPerOp(iterations, [&]() {
+            const JsonDocument doc(body.json);
+            return doc.root().toStringMap().size();
+        });
+        std::cout << body.name << " (" << body.json.size() << " bytes): JsonParser::parse " << legacy
+                  << " ns, JsonDocument " << indexed << " ns, toStringMap " << shim << " ns\n";
+    }
+    return 0;
+}
@@ -3,14 +3,18 @@
 
 #include <string>
 #include <map>
-#include <mutex>
+#include <memory>
 #include "../database/db_manager.hpp"
+#include "../utils/lru_cache.hpp"
+#include "password_hasher.hpp"
+#include "session_token.hpp"
 
 namespace xipher {
 
 class AuthManager {
 public:
     AuthManager(DatabaseManager& db_manager);
+    ~AuthManager();
     
     // Registration
     std::map<std::string, std::string> registerUser(const std::string& username, const std::string& password);
@@ -18,23 +22,52 @@ public:
     // Authentication
     std::map<std::string, std::string> login(const std::string& username, const std::string& password);
     
-    // Session management
+    // Session management. Tokens are resolved through an in-memory cache
+    // (XIPHER_SESSION_CACHE_SIZE entries, XIPHER_SESSION_CACHE_TTL_SEC);
+    // tokens the database does not know are remembered for
+    // XIPHER_SESSION_NEGATIVE_TTL_SEC so repeated bogus tokens cost no query.
+    // With XIPHER_SESSION_SIGNING_KEY set, new tokens are signed
+    // (SessionTokenSigner) and checked without the database; opaque tokens
+    // issued before keep working until they expire.
     std::string generateSessionToken(const std::string& user_id);
     bool validateSessionToken(const std::string& token);
     std::string getUserIdFromToken(const std::string& token);
     std::string rotateSessionToken(const std::string& token);
     bool revokeSessionToken(const std::string& token);
+    // Deletes every session of the user (ban, forced logout)
+    bool revokeUserSessions(const std::string& user_id);
+    
+    struct SessionCacheStats {
+        LruCacheStats sessions;
+        LruCacheStats unknown_tokens;
+    };
+    SessionCacheStats sessionCacheStats() const;
     
     // Validation
     bool validateUsername(const std::string& username);
     bool validatePassword(const std::string& password);
     
+    // Argon2 work of every caller goes through this pool
+    PasswordHasher& passwordHasher() { return password_hasher_; }
+    
 private:
     DatabaseManager& db_manager_;
-    std::map<std::string, std::string> sessions_; // token -> user_id
-    std::mutex sessions_mutex_;
+    // token -> user_id; unknown tokens live in their own cache so a spray
+    // of them cannot evict real sessions
+    ShardedLruCache<std::string, std::string> sessions_;
+    ShardedLruCache<std::string, bool> unknown_tokens_;
+    // Both null unless signed tokens are enabled
+    std::unique_ptr<SessionTokenSigner> signer_;
+    std::unique_ptr<SessionRevocations> revocations_;
+    // Last member: destroyed (and joined) first, while background rehashes
+    // can still reach db_manager_
+    PasswordHasher password_hasher_;
     
     std::string generateRandomToken();
+    // User of a live session, from the cache or the database; "" if none
+    std::string lookupSession(const std::string& token);
+    // Puts the session id of a valid signed token on the revocation list
+    void revokeSignedToken(const std::string& token);
 };
 
 } // namespace xipher
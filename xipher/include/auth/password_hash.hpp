@@ -1,6 +1,7 @@
 #ifndef PASSWORD_HASH_HPP
 #define PASSWORD_HASH_HPP
 
+#include <cstdint>
 #include <string>
 
 namespace xipher {
@@ -15,6 +16,11 @@ public:
 
     // Check whether stored hash should be upgraded (legacy format or old params)
     static bool needsRehash(const std::string& hash);
+
+    // Argon2 memory cost (KiB) hash() uses now (XIPHER_ARGON2_MEMORY_KIB)
+    static uint32_t memoryCostKiB();
+    // Memory cost verify() needs for a stored hash; 0 for legacy hashes
+    static uint32_t memoryCostOf(const std::string& hash);
     
     // Generate random salt
     static std::string generateSalt();
@@ -0,0 +1,92 @@
+#ifndef PASSWORD_HASHER_HPP
+#define PASSWORD_HASHER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace xipher {
+
+// Runs Argon2 hashing and verification on its own threads under a memory
+// budget. Each job reserves the memory cost of its hash before it starts,
+// so concurrent jobs never hold more than memory_budget_kib together (a
+// single job larger than the budget runs alone). Jobs wait in a FIFO queue
+// of max_queue entries; when it is full the call returns Busy right away
+// instead of piling up Argon2 buffers during a login burst.
+//
+// Legacy SHA-256 hashes are cheap and are checked on the calling thread.
+// One instance, owned by AuthManager, serves every caller so the budget
+// holds process-wide.
+class PasswordHasher {
+public:
+    struct Config {
+        size_t memory_budget_kib = 512 * 1024;
+        size_t threads = 0;      // 0 = hardware concurrency
+        size_t max_queue = 64;   // waiting jobs
+    };
+
+    // Budget, threads and queue size from XIPHER_ARGON2_MEMORY_BUDGET_MIB,
+    // XIPHER_ARGON2_THREADS and XIPHER_ARGON2_QUEUE_MAX
+    static Config configFromEnv();
+
+    explicit PasswordHasher(Config config);
+    ~PasswordHasher();
+
+    PasswordHasher(const PasswordHasher&) = delete;
+    PasswordHasher& operator=(const PasswordHasher&) = delete;
+
+    enum class Status {
+        Ok,
+        Busy,   // queue full or shutting down; nothing was computed
+        Failed  // hashing failed
+    };
+
+    // PasswordHash::hash on the pool; blocks until done
+    Status hash(const std::string& password, std::string* out);
+    // PasswordHash::verify on the pool; blocks until done
+    Status verify(const std::string& password, const std::string& hash, bool* matches);
+    // Hashes without a waiting caller and hands the result to `on_done`
+    // (not called when hashing fails). Only accepted while the queue is at
+    // most half full, so it never takes a slot a login would need.
+    bool hashInBackground(const std::string& password, std::function<void(const std::string&)> on_done);
+
+    struct Stats {
+        size_t queued = 0;
+        size_t running = 0;
+        size_t memory_in_use_kib = 0;
+        uint64_t completed = 0;
+        uint64_t rejected = 0;
+    };
+    Stats stats() const;
+
+private:
+    struct Job {
+        size_t cost_kib = 0;
+        // Runs the job, or reports that it was dropped (false) on shutdown
+        std::function<void(bool run)> fn;
+    };
+
+    bool enqueue(Job job, size_t max_queued);
+    void workerLoop();
+
+    Config config_;
+    std::deque<Job> queue_;
+    size_t running_ = 0;
+    size_t memory_in_use_kib_ = 0;
+    uint64_t completed_ = 0;
+    uint64_t rejected_ = 0;
+    bool stopping_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace xipher
+
+#endif // PASSWORD_HASHER_HPP
@@ -0,0 +1,93 @@
+#ifndef SESSION_TOKEN_HPP
+#define SESSION_TOKEN_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace xipher {
+
+class DatabaseManager;
+
+// Self-contained session tokens:
+//   xs1.<user_id>.<session_id>.<issued_at>.<expires_at>.<hmac>
+// where hmac is the hex HMAC-SHA256 of everything before it, keyed with
+// XIPHER_SESSION_SIGNING_KEY. Verifying one needs no I/O; revocation is
+// handled by SessionRevocations.
+class SessionTokenSigner {
+public:
+    struct Claims {
+        std::string user_id;
+        std::string session_id;
+        int64_t issued_at = 0;   // Unix seconds
+        int64_t expires_at = 0;
+    };
+
+    // nullptr when XIPHER_SESSION_SIGNING_KEY is unset or shorter than 32
+    // bytes; only opaque tokens are issued then.
+    static std::unique_ptr<SessionTokenSigner> fromEnv();
+
+    explicit SessionTokenSigner(std::string key);
+
+    // Empty when no random session id could be generated
+    std::string issue(const std::string& user_id, int64_t now, int64_t ttl_seconds) const;
+    // Signature and expiry check; `out` is filled only on success
+    bool verify(const std::string& token, int64_t now, Claims* out) const;
+
+    // Has the signed-token shape (says nothing about validity)
+    static bool isSigned(const std::string& token);
+
+private:
+    std::string sign(const std::string& body) const;
+
+    std::string key_;
+};
+
+// Session ids revoked before their token expired. Revocations made here
+// apply at once; the ones other instances made are pulled from the
+// revoked_sessions table every sync interval. Entries are dropped when the
+// token they revoke would have expired anyway, so the set stays small.
+class SessionRevocations {
+public:
+    SessionRevocations(DatabaseManager& db_manager, std::chrono::seconds sync_interval);
+    ~SessionRevocations();
+
+    SessionRevocations(const SessionRevocations&) = delete;
+    SessionRevocations& operator=(const SessionRevocations&) = delete;
+
+    // Loads the current set, then syncs in the background
+    void start();
+    void stop();
+
+    bool isRevoked(const std::string& session_id) const;
+    // Recorded locally even if the database write fails
+    bool revoke(const std::string& session_id, int64_t expires_at);
+
+    void sync();
+    size_t size() const;
+
+private:
+    void syncLoop();
+
+    DatabaseManager& db_manager_;
+    const std::chrono::seconds sync_interval_;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, int64_t> revoked_;  // session_id -> expires_at
+    int64_t synced_until_us_ = 0;  // newest revoked_at seen in the table
+
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    bool stopping_ = false;
+    std::thread sync_thread_;
+};
+
+} // namespace xipher
+
+#endif // SESSION_TOKEN_HPP
@@ -0,0 +1,29 @@
+#ifndef ASYNC_PIPELINE_HPP
+#define ASYNC_PIPELINE_HPP
+
+#include "connection_pool.hpp"
+#include "pg_pipeline.hpp"
+#include <functional>
+#include <boost/asio/any_io_executor.hpp>
+
+namespace xipher {
+
+using PipelineHandler = std::function<void(bool ok, PipelineResults results)>;
+
+// Runs `batch` on a pooled connection without blocking the calling thread:
+// the connection is borrowed with acquireAsync(), queries are sent in
+// pipeline mode, and the libpq socket is watched by the asio reactor of
+// `executor` until every result has arrived. `on_done` is always invoked
+// on `executor`, with ok == false if no connection was available or it
+// failed mid-batch (per-query errors are reported in `results`).
+//
+// Meant for io threads (WebSocket handlers); code that already runs on the
+// worker pool can just call ConnectionPool::executePipeline.
+void asyncExecutePipeline(ConnectionPool& pool,
+                          boost::asio::any_io_executor executor,
+                          PipelineBatch batch,
+                          PipelineHandler on_done);
+
+} // namespace xipher
+
+#endif // ASYNC_PIPELINE_HPP
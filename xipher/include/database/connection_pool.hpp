@@ -0,0 +1,243 @@
+#ifndef CONNECTION_POOL_HPP
+#define CONNECTION_POOL_HPP
+
+#include "db_connection.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <libpq-fe.h>
+
+namespace xipher {
+
+struct ConnectionPoolStats {
+    size_t size = 0;
+    size_t idle = 0;
+    uint64_t checkouts = 0;
+    uint64_t waited = 0;          // checkouts that found no idle connection
+    uint64_t timeouts = 0;        // checkouts that gave up after checkout_timeout
+    uint64_t total_wait_us = 0;
+    uint64_t max_wait_us = 0;
+    uint64_t reconnects = 0;
+};
+
+// A statement the pool prepares on its connections (see registerStatements)
+struct PreparedStatementDef {
+    const char* name;
+    const char* sql;
+};
+
+// Fixed set of PostgreSQL connections shared by every thread. Callers either
+// check a connection out explicitly (acquire()/pin()) or use the
+// DatabaseConnection-style facade, where every call borrows a connection for
+// the duration of one statement.
+//
+// Prepared statements are registered once on the pool. Each connection
+// prepares a statement the first time it runs there (or all of them in one
+// pipelined batch with eager_prepare) and forgets them on reconnect, so
+// executePrepared works on whichever connection a call lands on.
+// A background thread pings idle connections and reconnects dead ones. When
+// the connection breaks under a statement, it is retried once on a fresh
+// connection if it never reached the server (the connection was already
+// gone, or preparing it failed) or if it only reads (SELECT and the like).
+// A write that was sent is not repeated: the backend may have committed it
+// before the connection dropped. Nothing is retried inside a pinned
+// transaction.
+class ConnectionPool {
+public:
+    struct Config {
+        size_t size = 8;
+        std::chrono::milliseconds checkout_timeout{5000};
+        std::chrono::seconds health_check_interval{30};
+        // Prepare every registered statement when a connection is first
+        // handed out instead of on first use
+        bool eager_prepare = false;
+    };
+
+    // Size, checkout timeout, health check interval and prepare mode come
+    // from XIPHER_DB_POOL_SIZE, XIPHER_DB_POOL_TIMEOUT_MS,
+    // XIPHER_DB_HEALTH_CHECK_SEC and XIPHER_DB_PREPARE (lazy|eager);
+    // `size` overrides the env when non-zero.
+    static Config configFromEnv(size_t size = 0);
+
+    ConnectionPool(const std::string& host,
+                   const std::string& port,
+                   const std::string& dbname,
+                   const std::string& user,
+                   const std::string& password,
+                   Config config);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Opens every connection; succeeds if at least one is up (the rest are
+    // retried by the health check).
+    bool connect();
+    void disconnect();
+    bool isConnected() const;
+
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease();
+
+        explicit operator bool() const { return conn_ != nullptr; }
+        DatabaseConnection* get() const { return conn_; }
+        DatabaseConnection* operator->() const { return conn_; }
+        DatabaseConnection& operator*() const { return *conn_; }
+
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool* pool, size_t slot, bool pinned);
+        void reset();
+
+        ConnectionPool* pool_ = nullptr;
+        DatabaseConnection* conn_ = nullptr;
+        size_t slot_ = 0;
+        bool pinned_ = false;
+    };
+
+    // Waits up to checkout_timeout for an idle connection; an empty lease on timeout.
+    Lease acquire();
+
+    // Never blocks: `on_ready` runs right away when a connection is idle,
+    // otherwise on the thread that releases the next one. It receives an
+    // empty lease if the pool shuts down or the connection cannot be used.
+    void acquireAsync(std::function<void(Lease)> on_ready);
+
+    // Like acquire(), but while the lease lives every facade call made on
+    // this thread runs on the same connection. Used for BEGIN ... COMMIT.
+    // Nested pins on one thread share the outer connection.
+    Lease pin();
+
+    // DatabaseConnection-compatible facade
+    PGresult* executeQuery(const std::string& query);
+    PGresult* executePrepared(const std::string& stmt_name,
+                              int n_params,
+                              const char* const* param_values);
+    PGresult* executePrepared(const std::string& stmt_name,
+                              int n_params,
+                              const char* const* param_values,
+                              const int* param_lengths,
+                              const int* param_formats,
+                              PgFormat result_format);
+    template <size_t N>
+    PGresult* executePrepared(const std::string& stmt_name,
+                              const PgParams<N>& params,
+                              PgFormat result_format = PgFormat::Text) {
+        return executePrepared(stmt_name, params.size(), params.values(), params.lengths(), params.formats(),
+                               result_format);
+    }
+    // PQexecParams with text parameters; the result is returned as is
+    // (including error results), like the raw libpq call it replaces.
+    PGresult* executeParams(const std::string& query,
+                            int n_params,
+                            const char* const* param_values);
+    // One round-trip for the whole batch (pipeline mode); runs on the
+    // connection pinned to this thread if there is one.
+    bool executePipeline(const PipelineBatch& batch, PipelineResults& results);
+    // Prepares the batch's statements that the lease's connection has not
+    // prepared yet (one round-trip, nothing when all are). For callers that
+    // drive the pipeline themselves (asyncExecutePipeline).
+    bool preparePipeline(const Lease& lease, const PipelineBatch& batch);
+    // Registers statements for every connection of the pool. Nothing is
+    // sent to the server here; a name registered again with different SQL
+    // is re-prepared on each connection at its next use.
+    void registerStatements(const PreparedStatementDef* statements, size_t count);
+    void prepareStatement(const std::string& stmt_name,
+                          const std::string& query);
+    // With eager_prepare, prepares all registered statements on every idle
+    // connection (one thread and one pipelined batch per connection);
+    // otherwise only logs the registry size. Called once at startup.
+    void prepareAll();
+    // Error text of the last failed call made through the facade on this thread.
+    std::string getLastError() const;
+
+    ConnectionPoolStats stats() const;
+    size_t size() const { return slots_.size(); }
+
+private:
+    struct Slot {
+        std::unique_ptr<DatabaseConnection> conn;
+        bool in_use = false;
+        // Version of each registry entry prepared on this connection, by
+        // registry index (0 = not prepared). Only the lease holder touches it.
+        std::vector<uint32_t> prepared;
+        // registry_epoch_ the eager warm-up last caught up with
+        uint64_t registry_epoch = 0;
+    };
+    struct Statement {
+        std::string name;
+        std::string query;
+        uint32_t version = 1;  // bumped when re-registered with other SQL
+        bool read_only = false;  // safe to repeat after a lost connection
+    };
+
+    struct AsyncWaiter {
+        std::function<void(Lease)> on_ready;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    size_t checkout(std::chrono::milliseconds timeout, bool* ok);
+    void release(size_t slot);
+    // Reconnects a dead connection and, with eager_prepare, prepares the
+    // statements it is missing. Runs with the slot checked out, outside mutex_.
+    bool prepareSlot(size_t slot);
+    // Lazy path: prepares `stmt_name` / the batch's statements on the slot's
+    // connection if they are not prepared there yet.
+    bool ensurePrepared(size_t slot, const std::string& stmt_name);
+    bool ensurePrepared(size_t slot, const PipelineBatch& batch);
+    // Prepares the given registry entries (all of them when null) that are
+    // missing or outdated on the slot's connection, pipelined when there
+    // is more than one.
+    bool prepareMissing(size_t slot, const std::vector<size_t>* indices);
+    void registerLocked(const std::string& stmt_name, const std::string& query);
+    bool reconnectSlot(size_t slot);
+    // Index of the connection pinned to this thread, if any
+    bool pinnedSlot(size_t* slot) const;
+
+    bool statementIsReadOnly(const std::string& stmt_name) const;
+    bool batchIsReadOnly(const PipelineBatch& batch) const;
+
+    // fn(slot, conn, bool* sent) runs the statement and sets *sent once it
+    // hands it to libpq; read_only allows a retry even after that.
+    template <class Fn>
+    PGresult* run(Fn&& fn, bool read_only);
+
+    void healthLoop();
+
+    Config config_;
+    std::vector<Slot> slots_;
+    std::vector<size_t> idle_;
+    mutable std::mutex mutex_;
+    std::condition_variable idle_cv_;
+    std::deque<AsyncWaiter> async_waiters_;
+
+    // Read on every executePrepared, written at startup
+    mutable std::shared_mutex registry_mutex_;
+    std::vector<Statement> registry_;
+    std::unordered_map<std::string, size_t> registry_index_;
+    uint64_t registry_epoch_ = 0;  // bumped whenever the registry changes
+
+    ConnectionPoolStats stats_;
+
+    bool stopping_ = false;
+    std::condition_variable health_cv_;
+    std::thread health_thread_;
+};
+
+} // namespace xipher
+
+#endif // CONNECTION_POOL_HPP
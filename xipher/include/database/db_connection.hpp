@@ -3,7 +3,10 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
 #include <libpq-fe.h>
+#include "pg_pipeline.hpp"
+#include "pg_row.hpp"
 
 namespace xipher {
 
@@ -19,14 +22,47 @@ public:
     bool connect();
     void disconnect();
     bool isConnected() const;
+    // Re-establishes a dropped connection (PQreset); prepared statements are lost.
+    bool reconnect();
+    // Cheap round-trip (empty query) used by the pool's health check.
+    bool ping();
     
     PGresult* executeQuery(const std::string& query);
     PGresult* executePrepared(const std::string& stmt_name,
                               int n_params,
                               const char* const* param_values);
+    // Full PQexecPrepared: binary parameters and/or binary results
+    PGresult* executePrepared(const std::string& stmt_name,
+                              int n_params,
+                              const char* const* param_values,
+                              const int* param_lengths,
+                              const int* param_formats,
+                              PgFormat result_format);
+    // PQexecParams with text parameters; error results are returned, not cleared.
+    PGresult* executeParams(const std::string& query,
+                            int n_params,
+                            const char* const* param_values);
+    
+    // Sends every query of the batch in pipeline mode and waits for all
+    // results: one round-trip instead of batch.size(). False if the
+    // connection failed; per-query errors are reported in `results`.
+    bool executePipeline(const PipelineBatch& batch, PipelineResults& results);
+    
+    // Building blocks for driving a pipeline from an event loop (see
+    // AsyncPipeline): send, then flush while writable and consume while
+    // readable until *done, then end. None of them block. Ending a pipeline
+    // that still has results pending marks the connection for a reset.
+    bool beginPipeline(const PipelineBatch& batch, PipelineResults& results);
+    int flushPipeline();  // 0 = all sent, 1 = wait for writable, -1 = error
+    bool consumePipeline(PipelineResults& results, bool* done);
+    void endPipeline();
+    int socket() const { return conn_ ? PQsocket(conn_) : -1; }
     
+    // DEALLOCATE + PREPARE, for statements that may already exist.
     void prepareStatement(const std::string& stmt_name,
                          const std::string& query);
+    // PREPARE on a connection known not to have the statement yet.
+    bool prepare(const std::string& stmt_name, const std::string& query);
     
     std::string getLastError() const;
     
@@ -40,7 +76,16 @@ private:
     std::string user_;
     std::string password_;
     PGconn* conn_;
+    // libpq connections are not thread-safe; serialize statement execution
+    // now that the server runs handlers on several io threads.
+    std::mutex exec_mutex_;
     
+    bool prepareLocked(const std::string& stmt_name, const std::string& query);
+    // Query of the running pipeline whose results arrive next
+    size_t pipeline_cursor_ = 0;
+    // Set when a pipeline could not be left cleanly; isConnected() then
+    // reports false until reconnect()
+    bool needs_reset_ = false;
     void logError();
 };
 
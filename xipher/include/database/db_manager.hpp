@@ -6,7 +6,9 @@
 #include <vector>
 #include <cstdint>
 #include <optional>
-#include "db_connection.hpp"
+#include "connection_pool.hpp"
+#include "presence_tracker.hpp"
+#include "../utils/lru_cache.hpp"
 
 namespace xipher {
 
@@ -141,6 +143,12 @@ struct UserSession {
     std::string user_agent;
 };
 
+struct RevokedSession {
+    std::string session_id;
+    int64_t expires_at = 0;     // Unix seconds
+    int64_t revoked_at_us = 0;  // Unix microseconds
+};
+
 // Advanced chat v2 (unified chats/channels/supergroups)
 struct Chat {
     std::string id;
@@ -225,7 +233,8 @@ public:
                    const std::string& port = "5432",
                    const std::string& dbname = "xipher",
                    const std::string& user = "xipher",
-                   const std::string& password = "xipher");
+                   const std::string& password = "xipher",
+                   size_t pool_size = 0);
     
     bool initialize();
     
@@ -236,7 +245,19 @@ public:
     User getUserById(const std::string& user_id);
     bool usernameExists(const std::string& username);
     bool updateLastLogin(const std::string& user_id);
+    // Recorded in memory (PresenceTracker) and written behind in batches
     bool updateLastActivity(const std::string& user_id);
+    // getUserById, getUsersByIds, getUserProfile, getUserPrivacy and
+    // getUserPublic read through per-entity LRU caches; the write methods
+    // below drop the entries they change, and every entry expires after
+    // XIPHER_ENTITY_CACHE_TTL_SEC in case another instance changed it.
+    struct EntityCacheStats {
+        LruCacheStats users;
+        LruCacheStats profiles;
+        LruCacheStats privacy;
+        LruCacheStats public_users;
+    };
+    EntityCacheStats entityCacheStats() const;
     bool updateUserAvatar(const std::string& user_id, const std::string& avatar_url);
     bool setUserPremium(const std::string& user_id, bool is_premium, const std::string& plan);
     bool createPremiumPayment(const std::string& user_id, const std::string& plan, const std::string& amount, PremiumPayment& out_payment);
@@ -247,6 +268,8 @@ public:
     bool resetPremiumPaymentStatus(const std::string& label);
     bool hasTrialPayment(const std::string& user_id);
     std::vector<AdminPremiumPayment> listPremiumPayments(const std::string& status, int limit);
+    // Answered from PresenceTracker; only users it has not seen are read
+    // from the database
     std::string getUserLastActivity(const std::string& user_id);
     bool isUserOnline(const std::string& user_id, int threshold_seconds = 300);  // Default 5 minutes
 
@@ -272,10 +295,16 @@ public:
     bool upsertUserSession(const std::string& token,
                            const std::string& user_id,
                            int ttl_seconds = 60 * 60 * 24 * 30); // default 30 days
-    std::string getUserIdBySessionToken(const std::string& token);
+    // `lookup_failed` tells a query error apart from an unknown token
+    std::string getUserIdBySessionToken(const std::string& token, bool* lookup_failed = nullptr);
     bool deleteUserSession(const std::string& token);
     std::vector<UserSession> getUserSessions(const std::string& user_id);
     bool updateUserSessionUserAgent(const std::string& token, const std::string& user_agent);
+    // Revoked ids of signed session tokens (see SessionRevocations)
+    bool revokeSessionId(const std::string& session_id, int64_t expires_at);
+    // Unexpired revocations made after `since_us`; false on a query error
+    bool getRevokedSessionsSince(int64_t since_us, std::vector<RevokedSession>& out);
+    bool purgeExpiredRevokedSessions();
 
     // Push tokens
     bool upsertPushToken(const std::string& user_id,
@@ -299,7 +328,16 @@ public:
                      const std::string& file_name = "", long long file_size = 0, const std::string& reply_to_message_id = "",
                      const std::string& forwarded_from_user_id = "", const std::string& forwarded_from_username = "",
                      const std::string& forwarded_from_message_id = "", const std::string& reply_markup = "");
-    std::vector<Message> getMessages(const std::string& user1_id, const std::string& user2_id, int limit = 50);
+    // History pages, newest first. With before_id: the `limit` messages
+    // older than that message; with after_id: the `limit` messages newer
+    // than it. Keyset on (created_at, id), so any page costs the same.
+    std::vector<Message> getMessages(const std::string& user1_id, const std::string& user2_id, int limit = 50,
+                                     const std::string& before_id = "", const std::string& after_id = "");
+    // Full-text search in one conversation, or in every direct conversation
+    // of user1_id when user2_id is empty. Best match first.
+    std::vector<Message> searchMessagesInChat(const std::string& user1_id, const std::string& user2_id,
+                                              const std::string& query, int limit = 50,
+                                              const std::string& cursor_id = "");
     bool pinDirectMessage(const std::string& user1_id, const std::string& user2_id, const std::string& message_id, const std::string& pinned_by);
     bool unpinDirectMessage(const std::string& user1_id, const std::string& user2_id);
     bool getDirectPinnedMessage(const std::string& user1_id, const std::string& user2_id, std::string& out_message_id);
@@ -316,8 +354,42 @@ public:
     bool markMessageDeliveredById(const std::string& message_id);
     std::vector<Friend> getChatPartners(const std::string& user_id);  // Получить всех пользователей, с которыми есть переписка
     bool hasSavedMessages(const std::string& user_id);  // Проверить наличие избранных сообщений
+
+    // Everything the chat list shows about one conversation. Saved messages
+    // are the row whose partner.id is the user's own id.
+    struct ChatSummary {
+        Friend partner;          // created_at = time of the latest message
+        Message last_message;
+        int unread = 0;
+        bool is_bot = false;
+        bool is_premium = false;
+        bool online = false;
+        std::string last_activity;
+        std::string first_name;
+        std::string last_name;
+    };
+    // All conversations of `user_id`, most recent first, from one set-based
+    // query (replaces getChatPartners + six lookups per partner).
+    std::vector<ChatSummary> getChatSummaries(const std::string& user_id, int online_threshold_seconds = 300);
+
+    // Batched lookups: the queries for all ids go out in one libpq pipeline,
+    // so a list of N entries costs one round-trip instead of several per
+    // entry. Results line up with the input ids; a missing id yields an
+    // empty struct, like the single-row getters.
+    struct PeerSummary {
+        User user;
+        UserProfile profile;
+        bool online = false;
+        std::string last_activity;
+    };
+    std::vector<PeerSummary> getPeerSummaries(const std::vector<std::string>& peer_ids,
+                                              int online_threshold_seconds = 300);
+    std::vector<User> getUsersByIds(const std::vector<std::string>& user_ids);
+    std::vector<Message> getMessagesByIds(const std::vector<std::string>& message_ids);
     bool setUserActive(const std::string& user_id, bool is_active);
     bool updateUserPasswordHash(const std::string& user_id, const std::string& password_hash);
+    // Only while the stored hash is still `old_hash` (a rehash must not undo a password change)
+    bool replaceUserPasswordHash(const std::string& user_id, const std::string& old_hash, const std::string& new_hash);
     bool setUserRole(const std::string& user_id, const std::string& role);
     bool setUserAdminFlag(const std::string& user_id, bool is_admin);
     bool deleteMessagesByUser(const std::string& user_id);
@@ -337,7 +409,11 @@ public:
     std::string getAdminSetting(const std::string& key);
     bool upsertAdminSetting(const std::string& key, const std::string& value);
     std::vector<AdminUserSummary> searchUsers(const std::string& query, int limit);
-    std::vector<AdminMessageSummary> searchMessages(const std::string& query, int limit);
+    // Ranked full-text search over all direct messages; a message id as
+    // `query` also finds that message. `cursor_id` is the last hit of the
+    // previous page (same for the other message searches).
+    std::vector<AdminMessageSummary> searchMessages(const std::string& query, int limit,
+                                                    const std::string& cursor_id = "");
     std::vector<Group> searchGroups(const std::string& query, int limit);
     std::vector<Channel> searchChannels(const std::string& query, int limit);
     bool createReport(const std::string& reporter_id,
@@ -352,6 +428,11 @@ public:
     std::vector<Report> getReportsPaginated(int page,
                                             int page_size,
                                             const std::string& status_filter);
+    // The `limit` reports after `before_id` in getReportsPaginated order,
+    // without OFFSET
+    std::vector<Report> getReportsBefore(const std::string& before_id,
+                                         int limit,
+                                         const std::string& status_filter);
     long long countReports(const std::string& status_filter);
     Report getReportById(const std::string& report_id);
     bool updateReportStatus(const std::string& report_id,
@@ -378,8 +459,8 @@ public:
         std::string username;
         std::string role; // 'member', 'admin', 'creator'
         std::string permissions; // JSON с правами админа
-        bool is_muted;
-        bool is_banned;
+        bool is_muted = false;
+        bool is_banned = false;
         std::string joined_at;
     };
     
@@ -411,6 +492,15 @@ public:
     bool muteGroupMember(const std::string& group_id, const std::string& user_id, bool muted);
     bool banGroupMember(const std::string& group_id, const std::string& user_id, bool banned, const std::string& until = "");
     std::vector<GroupMember> getGroupMembers(const std::string& group_id);
+    // For callers that run a pipeline themselves (asyncExecutePipeline):
+    // queue* appends the lookup to `batch` and returns its result index,
+    // the matching *FromResult decodes that result.
+    static size_t queueUserById(PipelineBatch& batch, const std::string& user_id);
+    static User userFromResult(const PGresult* res);
+    static size_t queueGroupMembers(PipelineBatch& batch, const std::string& group_id);
+    static std::vector<GroupMember> groupMembersFromResult(const PGresult* res);
+    static size_t queueChannelSubscriberIds(PipelineBatch& batch, const std::string& chat_id);
+    static std::vector<std::string> channelSubscriberIdsFromResult(const PGresult* res);
     GroupMember getGroupMember(const std::string& group_id, const std::string& user_id);
     bool sendGroupMessage(const std::string& group_id, const std::string& sender_id, const std::string& content,
                          const std::string& message_type = "text", const std::string& file_path = "",
@@ -418,7 +508,9 @@ public:
                          const std::string& reply_to_message_id = "",
                          const std::string& forwarded_from_user_id = "", const std::string& forwarded_from_username = "",
                          const std::string& forwarded_from_message_id = "");
-    std::vector<GroupMessage> getGroupMessages(const std::string& group_id, int limit = 50);
+    // Same paging as getMessages
+    std::vector<GroupMessage> getGroupMessages(const std::string& group_id, int limit = 50,
+                                               const std::string& before_id = "", const std::string& after_id = "");
     bool pinGroupMessage(const std::string& group_id, const std::string& message_id, const std::string& user_id);
     bool unpinGroupMessage(const std::string& group_id, const std::string& message_id);
     std::string createGroupInviteLink(const std::string& group_id, const std::string& creator_id, int expires_in_seconds = 0);
@@ -458,7 +550,7 @@ public:
         std::string user_id;
         std::string username;
         std::string role;
-        bool is_banned;
+        bool is_banned = false;
         std::string joined_at;
         uint64_t admin_perms = 0;
         std::string admin_title;
@@ -503,7 +595,9 @@ public:
     bool sendChannelMessage(const std::string& channel_id, const std::string& sender_id, const std::string& content,
                            const std::string& message_type = "text", const std::string& file_path = "",
                            const std::string& file_name = "", long long file_size = 0);
-    std::vector<ChannelMessage> getChannelMessages(const std::string& channel_id, int limit = 50);
+    // Same paging as getMessages
+    std::vector<ChannelMessage> getChannelMessages(const std::string& channel_id, int limit = 50,
+                                                   const std::string& before_id = "", const std::string& after_id = "");
     bool pinChannelMessage(const std::string& channel_id, const std::string& message_id, const std::string& user_id);
     bool unpinChannelMessage(const std::string& channel_id, const std::string& message_id);
     bool setChannelCustomLink(const std::string& channel_id, const std::string& custom_link);
@@ -540,6 +634,15 @@ public:
                       const std::string& user_id,
                       uint64_t perms,
                       const std::string& title);
+    // getChatPermissions, getGroupMember and getChannelMember read through
+    // per-(chat, user) caches that also keep "not a member" answers; the
+    // membership writes drop the entries they change.
+    struct MembershipCacheStats {
+        LruCacheStats chat_permissions;
+        LruCacheStats group_members;
+        LruCacheStats channel_members;
+    };
+    MembershipCacheStats membershipCacheStats() const;
     ChatPermissions getChatPermissions(const std::string& chat_id, const std::string& user_id);
     Restriction getParticipantRestriction(const std::string& chat_id, const std::string& user_id);
     Chat getChatV2(const std::string& chat_id);
@@ -568,7 +671,9 @@ public:
     
     // Group management
     bool deleteGroup(const std::string& group_id);
-    std::vector<GroupMessage> searchGroupMessages(const std::string& group_id, const std::string& query, int limit = 50);
+    // Best match first (ts_rank, then newest)
+    std::vector<GroupMessage> searchGroupMessages(const std::string& group_id, const std::string& query, int limit = 50,
+                                                  const std::string& cursor_id = "");
     bool updateGroupPermission(const std::string& group_id, const std::string& permission, bool enabled);
     
     std::vector<ChannelMessage> getChannelMessagesV2(const std::string& chat_id,
@@ -956,13 +1061,59 @@ public:
     // Common groups between two users
     std::vector<Group> getCommonGroups(const std::string& user1_id, const std::string& user2_id, int limit = 10);
     
-    // Raw database access for custom queries
-    DatabaseConnection* getDb() { return db_.get(); }
+    // Raw database access for custom queries. Each call borrows a pooled
+    // connection; use getDb()->pin() to keep one for a transaction.
+    ConnectionPool* getDb() { return db_.get(); }
     
 private:
-    std::unique_ptr<DatabaseConnection> db_;
+    std::unique_ptr<ConnectionPool> db_;
+    // Declared after db_: destroyed first, so its final flush has the pool
+    std::unique_ptr<PresenceTracker> presence_;
+    
+    struct PublicUser {
+        std::string username;
+        std::string avatar_url;
+    };
+    ShardedLruCache<std::string, User> user_cache_;
+    ShardedLruCache<std::string, UserProfile> profile_cache_;
+    ShardedLruCache<std::string, UserPrivacySettings> privacy_cache_;
+    ShardedLruCache<std::string, PublicUser> public_user_cache_;
+    // Keyed by membershipKey(); an empty entry means "not a member"
+    ShardedLruCache<std::string, ChatPermissions> chat_permission_cache_;
+    ShardedLruCache<std::string, GroupMember> group_member_cache_;
+    ShardedLruCache<std::string, ChannelMember> channel_member_cache_;
+    
+    static std::string membershipKey(const std::string& chat_id, const std::string& user_id);
+    // Drops the cached memberships of every user in the chat
+    template <class Cache>
+    static void forgetChatMembers(Cache& cache, const std::string& chat_id) {
+        const std::string prefix = membershipKey(chat_id, "");
+        cache.eraseIf([&prefix](const std::string& key) { return key.compare(0, prefix.size(), prefix) == 0; });
+    }
+    ChatPermissions loadChatPermissions(const std::string& chat_id, const std::string& user_id, bool* cacheable);
+    
+    // Last-seen times (0 = never) lined up with `user_ids`; the ones the
+    // tracker does not know are fetched in one query and remembered.
+    std::vector<PresenceTracker::Micros> lastSeenOf(const std::vector<std::string>& user_ids);
     
-    void initializeSchema();
+    // Applies the migrations newer than the recorded schema version;
+    // nothing runs when the schema is current.
+    bool migrateSchema();
+    int schemaVersion();
+    bool migrateBaselineSchema();
+    bool migrateChatListIndexes();
+    bool migrateKeysetIndexes();
+    bool migrateSearchIndexes();
+    bool migrateRevokedSessions();
+    // CREATE INDEX CONCURRENTLY `name` `definition` ("ON table(...)"), which
+    // does not block writes. Needs autocommit, so never inside a
+    // transaction. An INVALID index left by an interrupted build is dropped
+    // and rebuilt; true once the index exists and is valid.
+    bool createIndexConcurrently(const std::string& name, const std::string& definition);
+    // to_tsquery() text for a user's search string: every word as a prefix,
+    // all words required. Empty when `text` has no words.
+    static std::string searchQueryFor(const std::string& text);
+    // Registers the compile-time statement table with the pool
     void prepareStatements();
 };
 
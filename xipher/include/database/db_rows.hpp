@@ -0,0 +1,64 @@
+#ifndef DB_ROWS_HPP
+#define DB_ROWS_HPP
+
+#include "db_manager.hpp"
+#include "pg_row.hpp"
+#include <string>
+
+namespace xipher {
+
+// Column -> field bindings for the rows DatabaseManager reads most. Each
+// mapper follows the SELECT list of the statements named next to it; keep
+// them in sync when a column is added.
+
+// get_user_by_id, get_user_by_username
+inline const auto kUserRow = pgRowMapper<User>(
+    &User::id, &User::username, &User::password_hash, &User::created_at, &User::is_active, &User::is_admin,
+    &User::role, &User::totp_secret, &User::admin_ip_whitelist, &User::is_bot, &User::is_premium,
+    &User::premium_plan, &User::premium_expires_at);
+
+// get_user_profile (user_id is the parameter, not a column)
+inline const auto kUserProfileRow = pgRowMapper<UserProfile>(
+    &UserProfile::first_name, &UserProfile::last_name, &UserProfile::bio, &UserProfile::birth_day,
+    &UserProfile::birth_month, &UserProfile::birth_year, &UserProfile::linked_channel_id,
+    &UserProfile::business_hours_json);
+
+// get_message_by_id, get_last_message, get_last_saved_message, and columns
+// 0-12 of get_chat_summaries
+inline const auto kMessageRow = pgRowMapper<Message>(
+    &Message::id, &Message::sender_id, &Message::receiver_id, &Message::content, &Message::created_at,
+    &Message::is_read, &Message::is_delivered, pgColumn(&Message::message_type, "text"), &Message::file_path,
+    &Message::file_name, &Message::file_size, &Message::reply_to_message_id, &Message::reply_markup);
+
+// get_messages, get_saved_messages: kMessageRow + is_pinned
+inline const auto kPinnedMessageRow = pgRowMapper<Message>(
+    &Message::id, &Message::sender_id, &Message::receiver_id, &Message::content, &Message::created_at,
+    &Message::is_read, &Message::is_delivered, pgColumn(&Message::message_type, "text"), &Message::file_path,
+    &Message::file_name, &Message::file_size, &Message::reply_to_message_id, &Message::reply_markup,
+    &Message::is_pinned);
+
+// get_message_context: kMessageRow without reply_markup
+inline const auto kMessageContextRow = pgRowMapper<Message>(
+    &Message::id, &Message::sender_id, &Message::receiver_id, &Message::content, &Message::created_at,
+    &Message::is_read, &Message::is_delivered, pgColumn(&Message::message_type, "text"), &Message::file_path,
+    &Message::file_name, &Message::file_size, &Message::reply_to_message_id);
+
+// get_group_members, get_group_member
+inline const auto kGroupMemberRow = pgRowMapper<DatabaseManager::GroupMember>(
+    &DatabaseManager::GroupMember::id, &DatabaseManager::GroupMember::group_id,
+    &DatabaseManager::GroupMember::user_id, &DatabaseManager::GroupMember::username,
+    &DatabaseManager::GroupMember::role, &DatabaseManager::GroupMember::is_muted,
+    &DatabaseManager::GroupMember::is_banned, &DatabaseManager::GroupMember::joined_at,
+    &DatabaseManager::GroupMember::permissions);
+
+// get_channel_by_id, get_channel_by_custom_link, get_user_channels
+inline const auto kChannelRow = pgRowMapper<DatabaseManager::Channel>(
+    &DatabaseManager::Channel::id, &DatabaseManager::Channel::name, &DatabaseManager::Channel::description,
+    &DatabaseManager::Channel::creator_id, &DatabaseManager::Channel::custom_link,
+    &DatabaseManager::Channel::avatar_url, &DatabaseManager::Channel::is_private,
+    &DatabaseManager::Channel::show_author, &DatabaseManager::Channel::created_at,
+    &DatabaseManager::Channel::is_verified);
+
+} // namespace xipher
+
+#endif // DB_ROWS_HPP
@@ -0,0 +1,15 @@
+#ifndef DB_STATEMENTS_HPP
+#define DB_STATEMENTS_HPP
+
+#include "connection_pool.hpp"
+#include <cstddef>
+
+namespace xipher {
+
+// Compile-time statement table (src/database/db_statements.cpp)
+extern const PreparedStatementDef kPreparedStatements[];
+extern const size_t kPreparedStatementCount;
+
+} // namespace xipher
+
+#endif // DB_STATEMENTS_HPP
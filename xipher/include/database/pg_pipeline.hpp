@@ -0,0 +1,69 @@
+#ifndef PG_PIPELINE_HPP
+#define PG_PIPELINE_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <libpq-fe.h>
+
+namespace xipher {
+
+struct PgResultDeleter {
+    void operator()(PGresult* res) const { PQclear(res); }
+};
+// Owning PGresult handle
+using PgResult = std::unique_ptr<PGresult, PgResultDeleter>;
+
+// Queries sent to the server back to back in libpq pipeline mode and
+// answered in one round-trip. Parameters are copied, so the batch may
+// outlive the strings it was built from (needed by the async path).
+// Results come back in the order the queries were added.
+class PipelineBatch {
+public:
+    enum class Kind {
+        Prepared,  // `text` is a statement name registered with the pool
+        Params,    // `text` is SQL with $n placeholders
+        Prepare    // creates statement `text` from the SQL in params[0]
+    };
+
+    struct Query {
+        Kind kind;
+        std::string text;
+        std::vector<std::string> params;
+    };
+
+    size_t addPrepared(std::string stmt_name, std::vector<std::string> params) {
+        queries_.push_back(Query{Kind::Prepared, std::move(stmt_name), std::move(params)});
+        return queries_.size() - 1;
+    }
+
+    size_t addParams(std::string sql, std::vector<std::string> params) {
+        queries_.push_back(Query{Kind::Params, std::move(sql), std::move(params)});
+        return queries_.size() - 1;
+    }
+
+    // PQprepare as part of the batch; parameter types are inferred by the server
+    size_t addPrepare(std::string stmt_name, std::string sql) {
+        queries_.push_back(Query{Kind::Prepare, std::move(stmt_name), {std::move(sql)}});
+        return queries_.size() - 1;
+    }
+
+    const std::vector<Query>& queries() const { return queries_; }
+    size_t size() const { return queries_.size(); }
+    bool empty() const { return queries_.empty(); }
+
+private:
+    std::vector<Query> queries_;
+};
+
+// One entry per query; an entry is null or carries an error status when
+// that query failed (a failed query also aborts the rest of the batch).
+using PipelineResults = std::vector<PgResult>;
+
+inline bool pipelineRowsOk(const PgResult& res) {
+    return res && PQresultStatus(res.get()) == PGRES_TUPLES_OK;
+}
+
+} // namespace xipher
+
+#endif // PG_PIPELINE_HPP
@@ -0,0 +1,334 @@
+#ifndef PG_ROW_HPP
+#define PG_ROW_HPP
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <libpq-fe.h>
+
+namespace xipher {
+
+// Built-in type OIDs (pg_type_d.h is a server header, not shipped with libpq)
+enum : Oid {
+    kPgBoolOid = 16,
+    kPgByteaOid = 17,
+    kPgInt8Oid = 20,
+    kPgInt2Oid = 21,
+    kPgInt4Oid = 23,
+    kPgTextOid = 25,
+    kPgFloat4Oid = 700,
+    kPgFloat8Oid = 701,
+    kPgVarcharOid = 1043,
+    kPgUuidOid = 2950,
+    kPgJsonbOid = 3802
+};
+
+enum class PgFormat : int {
+    Text = 0,
+    Binary = 1
+};
+
+// Parameters
+
+// Parameter arrays for up to N values, kept inline (on the caller's stack):
+// no new[] and no strlen per call. Strings are referenced, not copied, and
+// must outlive the statement. Integers and bools go out in binary, so use
+// addInt4/addInt8/addBool only where the statement's parameter has exactly
+// that type (pin it with a cast such as $2::int when it is inferred).
+template <size_t N>
+class PgParams {
+public:
+    PgParams& add(const std::string& text) { return push(text.c_str(), 0, 0); }
+    PgParams& add(const char* text) { return push(text, 0, 0); }
+    PgParams& addNull() { return push(nullptr, 0, 0); }
+
+    PgParams& addBool(bool flag) {
+        scratch_[count_][0] = flag ? 1 : 0;
+        return push(scratch_[count_], 1, 1);
+    }
+
+    PgParams& addInt4(int32_t number) {
+        storeBigEndian(scratch_[count_], static_cast<uint32_t>(number), 4);
+        return push(scratch_[count_], 4, 1);
+    }
+
+    PgParams& addInt8(int64_t number) {
+        storeBigEndian(scratch_[count_], static_cast<uint64_t>(number), 8);
+        return push(scratch_[count_], 8, 1);
+    }
+
+    int size() const { return count_; }
+    const char* const* values() const { return count_ ? values_ : nullptr; }
+    const int* lengths() const { return count_ ? lengths_ : nullptr; }
+    const int* formats() const { return count_ ? formats_ : nullptr; }
+
+private:
+    PgParams& push(const char* value, int length, int format) {
+        static_assert(N > 0, "PgParams needs room for at least one value");
+        values_[count_] = value;
+        lengths_[count_] = length;
+        formats_[count_] = format;
+        count_++;
+        return *this;
+    }
+
+    static void storeBigEndian(char* out, uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; --i) {
+            out[i] = static_cast<char>(value & 0xFF);
+            value >>= 8;
+        }
+    }
+
+    const char* values_[N];
+    int lengths_[N];
+    int formats_[N];
+    char scratch_[N][8];
+    int count_ = 0;
+};
+
+// Field decoding
+// Every decoder accepts text and binary results (PQfformat per column), so a
+// mapper works no matter which format the statement was executed with.
+// Binary results are meant for statements returning ints, bools, uuids and
+// text; timestamps keep their server-side text rendering only in text format.
+
+inline std::string_view pgView(const PGresult* res, int row, int col) {
+    return std::string_view(PQgetvalue(res, row, col), static_cast<size_t>(PQgetlength(res, row, col)));
+}
+
+inline bool pgBinary(const PGresult* res, int col) {
+    return PQfformat(res, col) == 1;
+}
+
+inline uint64_t pgLoadBigEndian(const char* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(data[i]);
+    }
+    return value;
+}
+
+inline void pgDecode(const PGresult* res, int row, int col, bool& out) {
+    const char* value = PQgetvalue(res, row, col);
+    out = pgBinary(res, col) ? value[0] != 0 : value[0] == 't';
+}
+
+template <class Int, typename std::enable_if<std::is_integral<Int>::value && !std::is_same<Int, bool>::value, int>::type = 0>
+void pgDecode(const PGresult* res, int row, int col, Int& out) {
+    const std::string_view text = pgView(res, row, col);
+    if (pgBinary(res, col)) {
+        switch (text.size()) {
+            case 1: out = static_cast<Int>(static_cast<unsigned char>(text[0])); break;
+            case 2: out = static_cast<Int>(static_cast<int16_t>(pgLoadBigEndian(text.data(), 2))); break;
+            case 4: out = static_cast<Int>(static_cast<int32_t>(pgLoadBigEndian(text.data(), 4))); break;
+            case 8: out = static_cast<Int>(static_cast<int64_t>(pgLoadBigEndian(text.data(), 8))); break;
+            default: out = 0; break;
+        }
+        return;
+    }
+    out = 0;
+    std::from_chars(text.data(), text.data() + text.size(), out);
+}
+
+inline void pgDecode(const PGresult* res, int row, int col, double& out) {
+    const char* value = PQgetvalue(res, row, col);
+    if (!pgBinary(res, col)) {
+        out = std::strtod(value, nullptr);
+        return;
+    }
+    if (PQftype(res, col) == kPgFloat4Oid) {
+        const uint32_t bits = static_cast<uint32_t>(pgLoadBigEndian(value, 4));
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        out = f;
+    } else {
+        const uint64_t bits = pgLoadBigEndian(value, 8);
+        std::memcpy(&out, &bits, sizeof(out));
+    }
+}
+
+// Assigns into `out`, reusing its capacity: the only allocation is the
+// one the returned string itself may need.
+inline void pgDecode(const PGresult* res, int row, int col, std::string& out) {
+    const std::string_view text = pgView(res, row, col);
+    if (!pgBinary(res, col)) {
+        out.assign(text.data(), text.size());
+        return;
+    }
+    switch (PQftype(res, col)) {
+        case kPgUuidOid: {
+            static const char kHex[] = "0123456789abcdef";
+            if (text.size() != 16) {
+                out.clear();
+                break;
+            }
+            out.resize(36);
+            char* p = &out[0];
+            for (size_t i = 0; i < 16; ++i) {
+                if (i == 4 || i == 6 || i == 8 || i == 10) {
+                    *p++ = '-';
+                }
+                const unsigned char byte = static_cast<unsigned char>(text[i]);
+                *p++ = kHex[byte >> 4];
+                *p++ = kHex[byte & 0xF];
+            }
+            break;
+        }
+        case kPgBoolOid:
+            out.assign(!text.empty() && text[0] ? "t" : "f", 1);
+            break;
+        case kPgInt2Oid:
+        case kPgInt4Oid:
+        case kPgInt8Oid: {
+            int64_t number = 0;
+            pgDecode(res, row, col, number);
+            char buf[24];
+            const auto end = std::to_chars(buf, buf + sizeof(buf), number).ptr;
+            out.assign(buf, static_cast<size_t>(end - buf));
+            break;
+        }
+        case kPgJsonbOid:
+            // Binary jsonb is a version byte followed by the JSON text
+            out.assign(text.size() > 1 ? text.data() + 1 : text.data(), text.size() > 1 ? text.size() - 1 : 0);
+            break;
+        default:
+            // text, varchar, name, json, bytea: the bytes themselves
+            out.assign(text.data(), text.size());
+            break;
+    }
+}
+
+// Row mappers
+
+// One result column bound to a struct member; NULL stores `fallback`.
+template <class T, class M>
+struct PgColumn {
+    M T::*field;
+    M fallback;
+
+    void read(const PGresult* res, int row, int col, T& out) const {
+        if (PQgetisnull(res, row, col)) {
+            out.*field = fallback;
+        } else {
+            pgDecode(res, row, col, out.*field);
+        }
+    }
+};
+
+// A result column the mapper ignores
+struct PgSkip {
+    template <class T>
+    void read(const PGresult*, int, int, T&) const {}
+};
+
+template <class M>
+struct PgNonDeduced {
+    using type = M;
+};
+
+template <class T, class M>
+PgColumn<T, M> pgColumn(M T::*field, typename PgNonDeduced<M>::type fallback = M()) {
+    return PgColumn<T, M>{field, std::move(fallback)};
+}
+
+inline PgSkip pgSkip() {
+    return PgSkip();
+}
+
+template <class T, class M>
+PgColumn<T, M> pgAsColumn(M T::*field) {
+    return PgColumn<T, M>{field, M()};
+}
+
+template <class Column>
+Column pgAsColumn(Column column) {
+    return column;
+}
+
+// Column -> field bindings declared once per struct, in SELECT order:
+//
+//   const auto kChannelRow = pgRowMapper<Channel>(
+//       &Channel::id, &Channel::name, pgColumn(&Channel::kind, std::string("text")), pgSkip(), ...);
+//   std::vector<Channel> channels = kChannelRow.all(res);
+//
+// Strings are decoded straight from the PGresult buffer into the struct; no
+// intermediate std::string, strcmp or stoll.
+template <class T, class... Columns>
+class PgRowMapper {
+public:
+    explicit PgRowMapper(Columns... columns) : columns_(std::move(columns)...) {}
+
+    static constexpr int width() { return static_cast<int>(sizeof...(Columns)); }
+
+    // Decodes `row` starting at column `first_col` into `out`.
+    void read(const PGresult* res, int row, T& out, int first_col = 0) const {
+        readColumns(res, row, out, first_col, std::index_sequence_for<Columns...>());
+    }
+
+    T row(const PGresult* res, int row, int first_col = 0) const {
+        T out{};
+        read(res, row, out, first_col);
+        return out;
+    }
+
+    // First row, or a default T when the result failed or is empty
+    T first(const PGresult* res) const {
+        if (!ok(res) || PQntuples(res) == 0) {
+            return T{};
+        }
+        return row(res, 0);
+    }
+
+    std::vector<T> all(const PGresult* res) const {
+        std::vector<T> rows;
+        if (!ok(res)) {
+            return rows;
+        }
+        const int count = PQntuples(res);
+        rows.resize(static_cast<size_t>(count));
+        for (int i = 0; i < count; ++i) {
+            read(res, i, rows[static_cast<size_t>(i)]);
+        }
+        return rows;
+    }
+
+private:
+    static bool ok(const PGresult* res) {
+        return res && PQresultStatus(res) == PGRES_TUPLES_OK;
+    }
+
+    template <size_t... I>
+    void readColumns(const PGresult* res, int row, T& out, int first_col, std::index_sequence<I...>) const {
+        (std::get<I>(columns_).read(res, row, first_col + static_cast<int>(I), out), ...);
+    }
+
+    std::tuple<Columns...> columns_;
+};
+
+template <class T, class... Args>
+auto pgRowMapper(Args... args) -> PgRowMapper<T, decltype(pgAsColumn(args))...> {
+    return PgRowMapper<T, decltype(pgAsColumn(args))...>(pgAsColumn(args)...);
+}
+
+// Single value of the first row (COUNT(*), EXISTS, ...); `fallback` when
+// the result failed, is empty or NULL.
+template <class V>
+V pgScalar(const PGresult* res, V fallback = V()) {
+    if (!res || PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0 || PQgetisnull(res, 0, 0)) {
+        return fallback;
+    }
+    V value{};
+    pgDecode(res, 0, 0, value);
+    return value;
+}
+
+} // namespace xipher
+
+#endif // PG_ROW_HPP
@@ -0,0 +1,97 @@
+#ifndef PRESENCE_TRACKER_HPP
+#define PRESENCE_TRACKER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace xipher {
+
+class ConnectionPool;
+
+// Last-seen time of every user, kept in memory and written behind to
+// users.last_activity. touch() is a map update under one shard's mutex;
+// a background thread writes the entries touched since the last flush in
+// one UPDATE per batch every flush_interval, and once more on stop().
+//
+// Users are loaded from the database on first lookup, and re-read once
+// neither a touch nor a load has refreshed them for reload_after, so
+// activity recorded by another instance still shows up. Each flush drops
+// the written entries that have gone unrefreshed that long, so memory
+// follows the recently active users rather than everyone ever seen.
+class PresenceTracker {
+public:
+    struct Config {
+        size_t shards = 16;
+        std::chrono::milliseconds flush_interval{5000};
+        std::chrono::seconds reload_after{30};
+        size_t max_batch = 500;  // users per UPDATE
+    };
+
+    // Flush interval from XIPHER_PRESENCE_FLUSH_MS
+    static Config configFromEnv();
+
+    // Microseconds since the Unix epoch; 0 = never seen
+    using Micros = int64_t;
+
+    PresenceTracker(ConnectionPool& pool, Config config);
+    ~PresenceTracker();
+
+    PresenceTracker(const PresenceTracker&) = delete;
+    PresenceTracker& operator=(const PresenceTracker&) = delete;
+
+    void start();
+    // Stops the flush thread and writes what is still pending
+    void stop();
+
+    // The user is active now
+    void touch(const std::string& user_id);
+
+    // Last-seen time of the user; false when it has to come from the
+    // database (never looked up, or not refreshed for reload_after).
+    bool lastSeen(const std::string& user_id, Micros* out) const;
+    // Stores a value read from the database (kept only if newer).
+    void remember(const std::string& user_id, Micros seen);
+
+    // Writes every dirty entry now; returns the number of users written.
+    size_t flush();
+
+    static Micros now();
+    // "YYYY-MM-DD HH:MM:SS.ffffff+00", the shape of a timestamptz in UTC
+    static std::string format(Micros seen);
+
+private:
+    struct Entry {
+        Micros seen = 0;
+        Micros checked = 0;  // last touch or database read
+        bool dirty = false;  // touched since the last flush
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    Shard& shardFor(const std::string& user_id) const;
+    bool writeBatch(const std::vector<std::pair<std::string, Micros>>& batch);
+    void flushLoop();
+
+    ConnectionPool& pool_;
+    Config config_;
+    std::unique_ptr<Shard[]> shards_;
+
+    std::mutex flush_mutex_;  // one flush at a time
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    bool stopping_ = false;
+    std::thread flush_thread_;
+};
+
+} // namespace xipher
+
+#endif // PRESENCE_TRACKER_HPP
@@ -4,6 +4,7 @@
 #include <string>
 #include <unordered_map>
 #include <chrono>
+#include <mutex>
 
 namespace xipher {
 
@@ -33,6 +34,7 @@ private:
     int max_attempts_;
     int window_seconds_;
     int ban_seconds_;
+    std::mutex mutex_;
     std::unordered_map<std::string, Entry> entries_;
 };
 
@@ -8,6 +8,7 @@
 #include "../database/db_manager.hpp"
 #include "../auth/auth_manager.hpp"
 #include "../security/admin_security.hpp"
+#include "http_response.hpp"
 
 namespace xipher {
 
@@ -15,8 +16,8 @@ class AdminHandler {
 public:
     AdminHandler(DatabaseManager& db_manager, AuthManager& auth_manager);
 
-    std::string handleLogin(const std::map<std::string, std::string>& headers, const std::string& body);
-    std::string handleAction(const std::map<std::string, std::string>& headers, const std::string& body);
+    HttpResponse handleLogin(const std::map<std::string, std::string>& headers, const std::string& body);
+    HttpResponse handleAction(const std::map<std::string, std::string>& headers, const std::string& body);
 
 private:
     DatabaseManager& db_manager_;
@@ -28,7 +29,7 @@ private:
 
     std::string hashContext(const std::string& input) const;
     bool validateAdminSession(const std::string& token, const std::string& ip, const std::string& user_agent);
-    std::string buildHttpJson(const std::string& body, const std::map<std::string, std::string>& extra_headers = {});
+    HttpResponse buildHttpJson(const std::string& body, const std::map<std::string, std::string>& extra_headers = {});
 };
 
 } // namespace xipher
@@ -0,0 +1,93 @@
+#ifndef FILE_RANGE_BODY_HPP
+#define FILE_RANGE_BODY_HPP
+
+#include <boost/beast/core/file.hpp>
+#include <boost/beast/http/error.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/optional.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace xipher {
+
+// Beast body that serves a byte range [offset, offset + length) of a file
+// through a fixed-size buffer, so memory per download does not depend on
+// the file size. http::file_body in Boost 1.74 always sends the whole file,
+// which rules out 206 Partial Content.
+struct FileRangeBody {
+    class value_type {
+    public:
+        void open(const char* path, std::uint64_t offset, std::uint64_t length,
+                  boost::beast::error_code& ec) {
+            file_.open(path, boost::beast::file_mode::scan, ec);
+            if (ec) {
+                return;
+            }
+            const std::uint64_t file_size = file_.size(ec);
+            if (ec) {
+                return;
+            }
+            offset_ = std::min(offset, file_size);
+            length_ = std::min(length, file_size - offset_);
+        }
+
+        bool is_open() const { return file_.is_open(); }
+        std::uint64_t size() const { return length_; }
+
+    private:
+        friend struct FileRangeBody;
+        boost::beast::file file_;
+        std::uint64_t offset_ = 0;
+        std::uint64_t length_ = 0;
+    };
+
+    static std::uint64_t size(const value_type& body) {
+        return body.size();
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer(boost::beast::http::header<isRequest, Fields>&, value_type& body)
+            : body_(body) {
+        }
+
+        void init(boost::beast::error_code& ec) {
+            remain_ = body_.length_;
+            body_.file_.seek(body_.offset_, ec);
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(boost::beast::error_code& ec) {
+            if (remain_ == 0) {
+                ec = {};
+                return boost::none;
+            }
+            const std::size_t amount = static_cast<std::size_t>(
+                std::min<std::uint64_t>(remain_, sizeof(buf_)));
+            const std::size_t nread = body_.file_.read(buf_, amount, ec);
+            if (ec) {
+                return boost::none;
+            }
+            if (nread == 0) {
+                // File shrank underneath us; the declared Content-Length can no longer be met
+                ec = boost::beast::http::error::short_read;
+                return boost::none;
+            }
+            remain_ -= nread;
+            return {{const_buffers_type{buf_, nread}, remain_ > 0}};
+        }
+
+    private:
+        value_type& body_;
+        std::uint64_t remain_ = 0;
+        char buf_[64 * 1024];
+    };
+};
+
+} // namespace xipher
+
+#endif // FILE_RANGE_BODY_HPP
@@ -0,0 +1,41 @@
+#ifndef HTTP_BODY_READER_HPP
+#define HTTP_BODY_READER_HPP
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <chrono>
+#include <utility>
+
+namespace xipher {
+
+// Reads the rest of a request whose header the parser already holds. The
+// stream deadline is re-armed before every read, so `idle_timeout` limits
+// the silence between two chunks, not the whole upload: a large body on a
+// slow link keeps going while a client that stops sending is dropped.
+// `handler(error_code)` runs once, after the body is complete or on error;
+// the caller keeps the stream, buffer and parser alive until then.
+template <class Parser, class Handler>
+void asyncReadBody(boost::beast::tcp_stream& stream,
+                   boost::beast::flat_buffer& buffer,
+                   Parser& parser,
+                   std::chrono::steady_clock::duration idle_timeout,
+                   Handler handler) {
+    if (parser.is_done()) {
+        handler(boost::beast::error_code{});
+        return;
+    }
+    stream.expires_after(idle_timeout);
+    boost::beast::http::async_read_some(stream, buffer, parser,
+        [&stream, &buffer, &parser, idle_timeout, handler = std::move(handler)](
+            boost::beast::error_code ec, std::size_t) mutable {
+            if (ec) {
+                handler(ec);
+                return;
+            }
+            asyncReadBody(stream, buffer, parser, idle_timeout, std::move(handler));
+        });
+}
+
+} // namespace xipher
+
+#endif // HTTP_BODY_READER_HPP
@@ -0,0 +1,64 @@
+#ifndef HTTP_RESPONSE_HPP
+#define HTTP_RESPONSE_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <variant>
+#include <memory>
+#include <cstdint>
+
+namespace xipher {
+
+// Response produced by RequestHandler and mapped to Beast by HttpServer
+// without going through an "HTTP/1.1 ..." text representation.
+class HttpResponse {
+public:
+    // Body served straight from disk; `length` is clamped to the file size,
+    // so the defaults mean "whole file".
+    struct FileBody {
+        std::string path;
+        std::uint64_t offset = 0;
+        std::uint64_t length = UINT64_MAX;
+    };
+
+    // Immutable buffer owned by a cache; the response only holds a reference.
+    struct SharedBody {
+        std::shared_ptr<const std::string> data;
+    };
+
+    using Body = std::variant<std::string, FileBody, SharedBody>;
+    using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+    HttpResponse();
+
+    static HttpResponse json(std::string body, int status = 200);
+    static HttpResponse text(int status, const std::string& content_type, std::string body);
+    static HttpResponse file(std::string path, const std::string& content_type, int status = 200);
+    static HttpResponse fileRange(std::string path, const std::string& content_type,
+                                  std::uint64_t offset, std::uint64_t length, int status = 206);
+    static HttpResponse shared(int status, const std::string& content_type, std::shared_ptr<const std::string> data);
+    static HttpResponse redirect(const std::string& location, int status = 302);
+
+    int status() const { return status_; }
+    void setStatus(int status) { status_ = status; }
+
+    // Replaces every header with the same (case-insensitive) name.
+    void setHeader(const std::string& name, const std::string& value);
+    // Appends without replacing (Set-Cookie may legitimately repeat).
+    void addHeader(const std::string& name, const std::string& value);
+    const std::string* findHeader(const std::string& name) const;
+    const HeaderList& headers() const { return headers_; }
+
+    Body& body() { return body_; }
+    const Body& body() const { return body_; }
+
+private:
+    int status_;
+    HeaderList headers_;
+    Body body_;
+};
+
+} // namespace xipher
+
+#endif // HTTP_RESPONSE_HPP
@@ -10,11 +10,19 @@
 #include <mutex>
 #include <memory>
 #include <unordered_map>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include "../database/db_manager.hpp"
 #include "../auth/auth_manager.hpp"
 #include "../voip/voip_access_control.hpp"
 #include "../bots/bot_scheduler.hpp"
 #include "request_handler.hpp"
+#include "http_response.hpp"
+#include "worker_pool.hpp"
+#include "websocket_session.hpp"
+#include "websocket_registry.hpp"
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -26,7 +34,8 @@ namespace xipher {
 
 class HttpServer {
 public:
-    HttpServer(const std::string& address, unsigned short port);
+    // io_threads == 0 selects std::thread::hardware_concurrency().
+    HttpServer(const std::string& address, unsigned short port, unsigned int io_threads = 0);
     ~HttpServer();
     
     bool start();
@@ -35,39 +44,65 @@ public:
 private:
     std::string address_;
     unsigned short port_;
+    unsigned int io_threads_;
     net::io_context ioc_;
+    std::vector<std::thread> io_workers_;
     std::unique_ptr<tcp::acceptor> acceptor_;
     std::unique_ptr<DatabaseManager> db_manager_;
     std::unique_ptr<AuthManager> auth_manager_;
     std::unique_ptr<RequestHandler> request_handler_;
     std::unique_ptr<VoipAccessControl> voip_access_control_;
+    // Declared after the handlers so it is destroyed (and joined) first.
+    std::unique_ptr<WorkerPool> worker_pool_;
+    std::unique_ptr<net::signal_set> reload_signals_;
     BotScheduler bot_scheduler_;
-    bool running_;
+    std::atomic<bool> running_;
+    // Startup timing: start() entry, and whether the first response was logged
+    std::chrono::steady_clock::time_point started_at_;
+    std::atomic<bool> first_response_logged_{false};
     
-    // WebSocket connections storage (user_id -> websocket stream)
-    std::map<std::string, std::weak_ptr<websocket::stream<beast::tcp_stream>>> ws_connections_;
-    std::mutex ws_connections_mutex_;
-    std::unordered_map<void*, std::string> ws_user_ids_;
-    std::mutex ws_user_ids_mutex_;
+    // WebSocket sessions by user_id, every device of a user. Each socket runs
+    // on its own strand; the registry is the only state shared between io threads.
+    WebSocketRegistry ws_registry_;
+    
+    // Per-connection HTTP state. The stream is bound to the connection's strand
+    // and the buffer is reused across keep-alive requests, so bytes of a
+    // pipelined request that arrive early are parsed on the next read.
+    struct HttpConnection {
+        explicit HttpConnection(tcp::socket&& socket) : stream(std::move(socket)) {}
+        beast::tcp_stream stream;
+        beast::flat_buffer buffer;
+        unsigned int requests_served = 0;
+    };
+    
+    std::chrono::seconds http_idle_timeout_;
+    unsigned int http_max_requests_per_connection_;
+    WebSocketSession::Limits ws_limits_;
     
     void acceptConnections();
+    void waitForReloadSignal();
     void handleConnection(std::shared_ptr<tcp::socket> socket);
-    void readRequest(std::shared_ptr<tcp::socket> socket,
-                    std::shared_ptr<beast::flat_buffer> buffer);
-    void processRequest(std::shared_ptr<tcp::socket> socket,
-                       http::request<http::string_body> req);
-    void sendResponse(std::shared_ptr<tcp::socket> socket,
-                     http::response<http::string_body> res);
-    void handleWebSocketUpgrade(std::shared_ptr<tcp::socket> socket,
+    void readRequest(std::shared_ptr<HttpConnection> conn);
+    void handleReadError(std::shared_ptr<HttpConnection> conn, beast::error_code ec);
+    void processRequest(std::shared_ptr<HttpConnection> conn,
+                       http::request<http::string_body> req,
+                       const RouteInfo& info);
+    void deliverResponse(std::shared_ptr<HttpConnection> conn, HttpResponse response,
+                         bool secure, bool keep_alive);
+    template <class Body>
+    void sendResponse(std::shared_ptr<HttpConnection> conn,
+                     http::response<Body> res);
+    void closeConnection(std::shared_ptr<HttpConnection> conn);
+    void handleWebSocketUpgrade(std::shared_ptr<HttpConnection> conn,
                                http::request<http::string_body> req);
-    void doReadWebSocket(std::shared_ptr<websocket::stream<beast::tcp_stream>> ws);
-    void handleWebSocketMessage(std::shared_ptr<websocket::stream<beast::tcp_stream>> ws,
+    void doReadWebSocket(std::shared_ptr<WebSocketSession> ws);
+    void handleWebSocketMessage(std::shared_ptr<WebSocketSession> ws,
                                const std::string& message);
     void registerWebSocketConnection(const std::string& user_id, 
-                                     std::shared_ptr<websocket::stream<beast::tcp_stream>> ws);
-    void unregisterWebSocketConnection(const std::string& user_id);
+                                     std::shared_ptr<WebSocketSession> ws);
+    void unregisterWebSocketConnection(std::shared_ptr<WebSocketSession> ws);
     void sendToUser(const std::string& user_id, const std::string& message);
-    std::string getWebSocketUserId(std::shared_ptr<websocket::stream<beast::tcp_stream>> ws);
+    std::string getWebSocketUserId(std::shared_ptr<WebSocketSession> ws);
 };
 
 } // namespace xipher
@@ -13,6 +13,9 @@
 #include "../notifications/rustore_client.hpp"
 #include <functional>
 #include "admin_handler.hpp"
+#include "http_response.hpp"
+#include "router.hpp"
+#include "static_asset_cache.hpp"
 #include "../security/admin_security.hpp"
 
 namespace xipher {
@@ -21,10 +24,10 @@ class RequestHandler {
 public:
     RequestHandler(DatabaseManager& db_manager, AuthManager& auth_manager);
     
-    std::string handleRequest(const std::string& method,
-                             const std::string& path,
-                             const std::map<std::string, std::string>& headers,
-                             const std::string& body);
+    HttpResponse handleRequest(const std::string& method,
+                              const std::string& path,
+                              const std::map<std::string, std::string>& headers,
+                              const std::string& body);
 
     enum class ChannelPermission {
         ManageSettings,
@@ -46,6 +49,13 @@ public:
     void storeCallOffer(const std::string& caller_id, const std::string& receiver_id, const std::string& offer_json);
     void storeCallAnswer(const std::string& caller_id, const std::string& receiver_id, const std::string& answer_json);
     void storeCallIce(const std::string& sender_id, const std::string& receiver_id, const std::string& candidate_json);
+
+    // Re-scan web/ and reload changed assets (SIGHUP)
+    void reloadStaticAssets();
+
+    // Metadata of the route a request line resolves to. Called by HttpServer
+    // after the headers are read, to pick the body limit and the executor.
+    RouteInfo routeInfo(const std::string& method, const std::string& path) const;
     
 private:
     DatabaseManager& db_manager_;
@@ -53,17 +63,24 @@ private:
     AdminHandler admin_handler_;
     FcmClient fcm_client_;
     RuStoreClient rustore_client_;
+    std::unique_ptr<StaticAssetCache> static_assets_;
+    Router router_;
+
+    void registerRoutes();
+    static std::string normalizeRoutePath(const std::string& method, const std::string& path);
+    bool isPrdSession(const std::map<std::string, std::string>& headers);
+    HttpResponse serveAdminPage(const std::string& file_path, const std::map<std::string, std::string>& headers);
     
     // Route handlers
-    std::string handleGet(const std::string& path, const std::map<std::string, std::string>& headers);
-    std::string handlePost(const std::string& path, const std::string& body, const std::map<std::string, std::string>& headers = std::map<std::string, std::string>());
-    std::string handleOptions(const std::string& path, const std::map<std::string, std::string>& headers);
+    HttpResponse handleGet(const std::string& path, const std::map<std::string, std::string>& headers);
+    HttpResponse handlePost(const std::string& path, const std::string& body, const std::map<std::string, std::string>& headers = std::map<std::string, std::string>());
+    HttpResponse handleOptions(const std::string& path, const std::map<std::string, std::string>& headers);
     
     // API endpoints
     std::string handleRegister(const std::string& body);
-    std::string handleLogin(const std::string& body, const std::map<std::string, std::string>& headers);
-    std::string handleLogout(const std::string& body, const std::map<std::string, std::string>& headers);
-    std::string handleRefreshSession(const std::string& body, const std::map<std::string, std::string>& headers);
+    HttpResponse handleLogin(const std::string& body, const std::map<std::string, std::string>& headers);
+    HttpResponse handleLogout(const std::string& body, const std::map<std::string, std::string>& headers);
+    HttpResponse handleRefreshSession(const std::string& body, const std::map<std::string, std::string>& headers);
     std::string handleGetSessions(const std::string& body);
     std::string handleRevokeSession(const std::string& body);
     std::string handleRevokeSelectedSessions(const std::string& body);
@@ -79,10 +96,11 @@ private:
     std::string handleSetPremium(const std::string& body);
     std::string handleCreatePremiumPayment(const std::string& body);
     std::string handleCreatePremiumGiftPayment(const std::string& body);
-    std::string handleYooMoneyNotification(const std::string& body);
-    std::string handleStripeWebhook(const std::string& body, const std::map<std::string, std::string>& headers);
+    HttpResponse handleYooMoneyNotification(const std::string& body);
+    HttpResponse handleStripeWebhook(const std::string& body, const std::map<std::string, std::string>& headers);
     std::string handleSetPersonalChannel(const std::string& body);
     std::string handleGetMessages(const std::string& body);
+    std::string handleSearchMessages(const std::string& body);
     std::string handleSendMessage(const std::string& body);
     std::string handleRegisterPushToken(const std::string& body);
     std::string handleDeletePushToken(const std::string& body);
@@ -115,8 +133,11 @@ private:
     std::string handleUploadVoice(const std::string& body, const std::map<std::string, std::string>& headers);
     std::string handleUploadAvatar(const std::string& body, const std::map<std::string, std::string>& headers);
     std::string handleUploadChannelAvatar(const std::string& body, const std::map<std::string, std::string>& headers);
-    std::string handleGetFile(const std::string& path);
-    std::string handleGetAvatar(const std::string& path);
+    HttpResponse handleGetFile(const std::string& path, const std::map<std::string, std::string>& headers);
+    HttpResponse handleGetAvatar(const std::string& path, const std::map<std::string, std::string>& headers);
+    // ETag/Last-Modified, conditional GET (304) and single-range requests (206)
+    HttpResponse serveFileWithValidators(const std::string& file_path, const std::string& mime_type,
+                                         const std::map<std::string, std::string>& headers);
 
     bool sendPremiumGiftMessage(const PremiumPayment& payment);
     
@@ -207,7 +228,7 @@ private:
     std::string handleBanChannelMember(const std::string& body);
     std::string handleGetChannelMembers(const std::string& body);
     std::string handleSearchChannel(const std::string& body);
-    std::string handleChannelUrl(const std::string& path);
+    HttpResponse handleChannelUrl(const std::string& path);
     std::string handleGetChannelInfo(const std::string& body);
     std::string handleUnsubscribeChannel(const std::string& body);
     std::string handleDeleteChannel(const std::string& body);
@@ -226,8 +247,8 @@ private:
     std::string handleDeleteIntegration(const std::string& body);
     std::string handleOAuthCallback(const std::string& path, const std::string& body);
 
-    std::string buildHttpJson(const std::string& body,
-                              const std::map<std::string, std::string>& extra_headers = {});
+    HttpResponse buildHttpJson(std::string body,
+                               const std::map<std::string, std::string>& extra_headers = {});
     std::string extractSessionTokenFromHeaders(const std::map<std::string, std::string>& headers);
     std::string maybeInjectSessionToken(const std::string& body, const std::map<std::string, std::string>& headers);
     bool isSecureRequest(const std::map<std::string, std::string>& headers) const;
@@ -331,8 +352,9 @@ private:
     std::string handleSecurityUpdate(const std::string& body);
     
     // Static file serving
-    std::string serveStaticFile(const std::string& path);
-    std::string serveStaticFileWithStatus(const std::string& path, const std::string& status_line);
+    HttpResponse serveStaticFile(const std::string& path, const std::map<std::string, std::string>& headers);
+    HttpResponse serveStaticFileWithStatus(const std::string& path, int status,
+                                           const std::map<std::string, std::string>& headers);
     std::string getMimeType(const std::string& extension);
     
     // Bot API handlers (Telegram Bot API format: /bot<token>/method_name)
@@ -0,0 +1,72 @@
+#ifndef ROUTER_HPP
+#define ROUTER_HPP
+
+#include <string>
+#include <map>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <cstddef>
+#include "http_response.hpp"
+
+namespace xipher {
+
+// Per-route metadata, known before the body is read.
+struct RouteInfo {
+    bool blocking = true;         // may hit libpq/curl/Argon2: run on the worker pool
+    std::size_t body_limit = 0;   // max request body in bytes (0 = server default)
+    std::string route_class = "default";  // worker pool admission class
+};
+
+struct RouteRequest {
+    const std::string& path;
+    const std::string& body;
+    const std::map<std::string, std::string>& headers;
+};
+
+using RouteHandler = std::function<HttpResponse(const RouteRequest&)>;
+
+struct Route {
+    RouteHandler handler;
+    RouteInfo info;
+};
+
+// Method + path dispatch table built once at startup. Exact paths are a hash
+// lookup; parameterised paths (/chat/<id>, /files/<name>, /bot<token>/<method>)
+// are registered as prefixes in a trie and resolved by longest match, so the
+// cost of a lookup no longer depends on how many routes precede it.
+class Router {
+public:
+    Router();
+    ~Router();
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+
+    void add(const std::string& method, const std::string& path, RouteHandler handler, RouteInfo info = RouteInfo());
+    void addPrefix(const std::string& method, const std::string& prefix, RouteHandler handler, RouteInfo info = RouteInfo());
+
+    // nullptr when nothing matches. Exact routes win over prefixes.
+    const Route* match(const std::string& method, const std::string& path) const;
+
+    std::size_t size() const { return route_count_; }
+
+private:
+    struct TrieNode {
+        std::vector<std::pair<char, std::unique_ptr<TrieNode>>> children;
+        std::unique_ptr<Route> route;
+        TrieNode* child(char c) const;
+    };
+
+    struct MethodTable {
+        std::unordered_map<std::string, Route> exact;
+        TrieNode prefixes;
+    };
+
+    std::unordered_map<std::string, MethodTable> tables_;
+    std::size_t route_count_ = 0;
+};
+
+} // namespace xipher
+
+#endif // ROUTER_HPP
@@ -0,0 +1,78 @@
+#ifndef STATIC_ASSET_CACHE_HPP
+#define STATIC_ASSET_CACHE_HPP
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+
+namespace xipher {
+
+// In-memory copy of the web/ tree. Every file is read once, hashed for a
+// strong ETag and compressed ahead of time (gzip, and brotli when built with
+// XIPHER_HAVE_BROTLI), so serving an asset is a map lookup plus a pointer copy.
+// A watcher thread re-stats the tree periodically and only re-reads files
+// whose mtime or size changed; reload() forces the same pass (SIGHUP).
+class StaticAssetCache {
+public:
+    struct Asset {
+        std::string content_type;
+        std::string cache_control;
+        std::string etag;            // strong, identity encoding; variants add -gz / -br
+        std::string last_modified;
+        std::time_t mtime = 0;
+        std::uint64_t size = 0;
+        std::shared_ptr<const std::string> identity;
+        std::shared_ptr<const std::string> gzip;    // null when compression doesn't pay off
+        std::shared_ptr<const std::string> brotli;  // null when unavailable or not worth it
+    };
+
+    using MimeResolver = std::function<std::string(const std::string& extension)>;
+
+    // Files larger than max_file_size stay on disk and are served by the
+    // regular file path.
+    StaticAssetCache(std::string root, MimeResolver mime_resolver,
+                     std::uint64_t max_file_size, std::chrono::seconds recheck_interval);
+    ~StaticAssetCache();
+
+    void start();
+    void stop();
+    void reload();
+
+    // Exact match on the absolute path ("/root/xipher/web/js/chat.js").
+    std::shared_ptr<const Asset> find(const std::string& path) const;
+
+    // true if the Accept-Encoding header allows `coding` (q=0 excludes it;
+    // an entry naming the coding takes precedence over "*").
+    static bool acceptsEncoding(const std::string& accept_encoding, const std::string& coding);
+
+private:
+    using AssetMap = std::unordered_map<std::string, std::shared_ptr<const Asset>>;
+
+    std::string root_;
+    MimeResolver mime_resolver_;
+    std::uint64_t max_file_size_;
+    std::chrono::seconds recheck_interval_;
+
+    mutable std::mutex assets_mutex_;
+    std::shared_ptr<const AssetMap> assets_;
+
+    std::mutex reload_mutex_;
+    std::mutex watcher_mutex_;
+    std::condition_variable watcher_cv_;
+    bool stopping_ = false;
+    std::thread watcher_;
+
+    std::shared_ptr<const Asset> loadAsset(const std::string& path, std::time_t mtime, std::uint64_t size) const;
+    void watchLoop();
+};
+
+} // namespace xipher
+
+#endif // STATIC_ASSET_CACHE_HPP
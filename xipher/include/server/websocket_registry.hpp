@@ -0,0 +1,55 @@
+#ifndef WEBSOCKET_REGISTRY_HPP
+#define WEBSOCKET_REGISTRY_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "websocket_session.hpp"
+
+namespace xipher {
+
+// user_id -> all live sessions of that user (one per device/tab).
+// Users are spread over fixed shards by hash, each with its own mutex, so a
+// fan-out to one user never waits on registrations of unrelated users.
+// Register and unregister are hash lookups; the session remembers its
+// user_id, so removal needs no scan.
+class WebSocketRegistry {
+public:
+    using SessionPtr = std::shared_ptr<WebSocketSession>;
+
+    // Re-registering a session under another user moves it.
+    void add(const std::string& user_id, const SessionPtr& session);
+    void remove(const SessionPtr& session);
+
+    // Snapshot of the user's live sessions; expired entries are pruned on the way.
+    std::vector<SessionPtr> sessionsFor(const std::string& user_id);
+
+    size_t sessionCount() const { return session_count_.load(std::memory_order_relaxed); }
+    size_t userCount() const { return user_count_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kShardCount = 64;
+
+    using SessionSet = std::unordered_map<const WebSocketSession*, std::weak_ptr<WebSocketSession>>;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, SessionSet> users;
+    };
+
+    Shard& shardFor(const std::string& user_id);
+    void removeLocked(Shard& shard, const std::string& user_id, const WebSocketSession* session);
+
+    std::array<Shard, kShardCount> shards_;
+    std::atomic<size_t> session_count_{0};
+    std::atomic<size_t> user_count_{0};
+};
+
+} // namespace xipher
+
+#endif // WEBSOCKET_REGISTRY_HPP
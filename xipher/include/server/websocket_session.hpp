@@ -0,0 +1,81 @@
+#ifndef WEBSOCKET_SESSION_HPP
+#define WEBSOCKET_SESSION_HPP
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace xipher {
+
+// One accepted WebSocket connection and its outbound queue.
+// send() may be called from any thread: frames are queued under a mutex and a
+// single write loop on the stream's strand drains them, so writes never
+// overlap and every payload lives until its write completes. The queue is
+// bounded; a consumer that falls behind the high-water mark has new frames
+// dropped or is disconnected, depending on the policy.
+class WebSocketSession : public std::enable_shared_from_this<WebSocketSession> {
+public:
+    using Stream = boost::beast::websocket::stream<boost::beast::tcp_stream>;
+
+    enum class SlowConsumerPolicy {
+        Drop,
+        Disconnect
+    };
+
+    struct Limits {
+        size_t max_queued_bytes = 4 * 1024 * 1024;
+        size_t max_queued_frames = 1024;
+        // Queued frames are merged into one text frame up to this size, only for
+        // clients that announced they parse concatenated JSON (see setCoalescing).
+        size_t coalesce_max_bytes = 64 * 1024;
+        SlowConsumerPolicy policy = SlowConsumerPolicy::Disconnect;
+    };
+
+    struct QueueStats {
+        size_t queued_frames = 0;
+        size_t queued_bytes = 0;
+        uint64_t dropped_frames = 0;
+        bool write_in_flight = false;
+    };
+
+    WebSocketSession(boost::beast::tcp_stream&& stream, const Limits& limits);
+
+    Stream& stream() { return ws_; }
+
+    // false when the frame was dropped or the session is closing
+    bool send(std::string message);
+    void setCoalescing(bool enabled);
+    QueueStats queueStats() const;
+    // Abort the connection; pending reads and writes complete with an error.
+    void close();
+
+    // Set once the socket authenticates (WebSocketRegistry keeps it in sync)
+    std::string userId() const;
+    void setUserId(std::string user_id);
+
+private:
+    void flush();
+    void closeOnStrand();
+
+    Stream ws_;
+    Limits limits_;
+    mutable std::mutex mutex_;
+    std::deque<std::string> pending_;
+    size_t pending_bytes_ = 0;
+    uint64_t dropped_frames_ = 0;
+    bool dropping_ = false;
+    bool writing_ = false;
+    bool closing_ = false;
+    bool coalesce_ = false;
+    std::string in_flight_;
+    std::string user_id_;
+};
+
+} // namespace xipher
+
+#endif // WEBSOCKET_SESSION_HPP
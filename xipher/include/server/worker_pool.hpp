@@ -0,0 +1,65 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <unordered_map>
+#include <cstddef>
+
+namespace xipher {
+
+// Bounded executor for blocking request work (libpq, curl, Argon2).
+// io threads only parse and do socket I/O; everything that may block is
+// submitted here. Admission is decided up front: when the queue is full or a
+// route class is already at its concurrency limit the task is rejected and
+// the caller answers 503 instead of letting the backlog grow.
+class WorkerPool {
+public:
+    enum class SubmitResult {
+        Accepted,
+        QueueFull,
+        RouteLimited,
+        Stopped
+    };
+
+    WorkerPool(size_t thread_count, size_t max_queue_depth);
+    ~WorkerPool();
+
+    void start();
+    void stop();
+
+    // Max tasks of one route class queued or running at the same time (0 = unlimited).
+    void setRouteLimit(const std::string& route_class, size_t max_in_flight);
+
+    SubmitResult submit(const std::string& route_class, std::function<void()> task);
+
+    size_t queueDepth() const;
+    size_t threadCount() const { return thread_count_; }
+
+private:
+    struct Task {
+        std::string route_class;
+        std::function<void()> fn;
+    };
+
+    size_t thread_count_;
+    size_t max_queue_depth_;
+    bool running_ = false;
+    std::deque<Task> queue_;
+    std::unordered_map<std::string, size_t> route_limits_;
+    std::unordered_map<std::string, size_t> route_in_flight_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::thread> workers_;
+
+    void workerLoop();
+};
+
+} // namespace xipher
+
+#endif // WORKER_POOL_HPP
@@ -52,7 +52,10 @@ public:
                      const std::string& forwarded_from_username = "",
                      const std::string& forwarded_from_message_id = "",
                      std::string* message_id = nullptr);
-    std::vector<Message> getMessages(const std::string& user1_id, const std::string& user2_id, int limit = 50);
+    // Pages in chronological order; before_id/after_id select the `limit`
+    // messages older/newer than that message (as DatabaseManager::getMessages)
+    std::vector<Message> getMessages(const std::string& user1_id, const std::string& user2_id, int limit = 50,
+                                     const std::string& before_id = "", const std::string& after_id = "");
     Message getLastMessage(const std::string& user1_id, const std::string& user2_id);
     Message getMessageById(const std::string& message_id);
     bool editMessage(const std::string& message_id, const std::string& new_content);
@@ -81,7 +84,9 @@ public:
                          const std::string& forwarded_from_username = "",
                          const std::string& forwarded_from_message_id = "",
                          std::string* message_id = nullptr);
-    std::vector<DatabaseManager::GroupMessage> getGroupMessages(const std::string& group_id, int limit = 50);
+    std::vector<DatabaseManager::GroupMessage> getGroupMessages(const std::string& group_id, int limit = 50,
+                                                                const std::string& before_id = "",
+                                                                const std::string& after_id = "");
     bool pinGroupMessage(const std::string& group_id, const std::string& message_id, const std::string& user_id);
     bool unpinGroupMessage(const std::string& group_id, const std::string& message_id);
     std::string createGroupInviteLink(const std::string& group_id, const std::string& creator_id, 
@@ -112,7 +117,9 @@ public:
                            const std::string& message_type = "text", const std::string& file_path = "",
                            const std::string& file_name = "", long long file_size = 0,
                            std::string* message_id = nullptr);
-    std::vector<DatabaseManager::ChannelMessage> getChannelMessages(const std::string& channel_id, int limit = 50);
+    std::vector<DatabaseManager::ChannelMessage> getChannelMessages(const std::string& channel_id, int limit = 50,
+                                                                    const std::string& before_id = "",
+                                                                    const std::string& after_id = "");
     bool pinChannelMessage(const std::string& channel_id, const std::string& message_id, const std::string& user_id);
     bool unpinChannelMessage(const std::string& channel_id, const std::string& message_id);
     bool setChannelCustomLink(const std::string& channel_id, const std::string& custom_link);
@@ -242,6 +249,10 @@ private:
     std::unordered_map<std::string, std::vector<std::string>> channel_message_list_; // channel_id -> [message_ids]
     std::unordered_map<std::string, std::string> pinned_channel_messages_; // "channel_id:message_id" -> user_id
     
+    // Send order of every direct/group/channel message: the message lists
+    // above are sorted by it, so a cursor is found by binary search
+    std::unordered_map<std::string, int64_t> message_order_; // message_id -> sequence
+    
     // Reactions and views
     std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> message_reactions_; // message_id -> [(user_id, reaction)]
     std::unordered_map<std::string, std::vector<std::string>> message_views_; // message_id -> [user_ids]
@@ -264,11 +275,16 @@ private:
     int64_t bot_id_counter_ = 1;
     int64_t update_id_counter_ = 1;
     int64_t request_id_counter_ = 1;
+    int64_t message_order_counter_ = 1;
     
     // Helper methods
     std::string normalizeChatKey(const std::string& user1_id, const std::string& user2_id);
     bool isNumeric(const std::string& str);
     int64_t stringToInt64(const std::string& str);
+    // [begin, end) of the page of `message_ids` selected by limit and cursor
+    void pageRange(const std::vector<std::string>& message_ids, int limit,
+                   const std::string& before_id, const std::string& after_id,
+                   size_t* begin, size_t* end) const;
     std::string int64ToString(int64_t value);
 };
 
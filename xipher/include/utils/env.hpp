@@ -0,0 +1,23 @@
+#ifndef ENV_HPP
+#define ENV_HPP
+
+#include <cstddef>
+#include <cstdlib>
+
+namespace xipher {
+
+// Non-negative integer from the environment; `fallback` when the variable is
+// unset, empty or not entirely digits.
+inline size_t readEnvSize(const char* name, size_t fallback) {
+    const char* raw = std::getenv(name);
+    if (!raw || !*raw) {
+        return fallback;
+    }
+    char* end = nullptr;
+    const unsigned long value = std::strtoul(raw, &end, 10);
+    return (end && *end == '\0') ? static_cast<size_t>(value) : fallback;
+}
+
+} // namespace xipher
+
+#endif // ENV_HPP
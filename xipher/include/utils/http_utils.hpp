@@ -0,0 +1,30 @@
+#ifndef HTTP_UTILS_HPP
+#define HTTP_UTILS_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <string>
+
+namespace xipher {
+
+// ASCII lower-case copy, for header values, tokens and file extensions.
+inline std::string toLowerCopy(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return value;
+}
+
+// IMF-fixdate (RFC 7231), as used by Last-Modified and Date.
+inline std::string formatHttpDate(std::time_t value) {
+    std::tm tm_utc{};
+    gmtime_r(&value, &tm_utc);
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm_utc);
+    return buf;
+}
+
+} // namespace xipher
+
+#endif // HTTP_UTILS_HPP
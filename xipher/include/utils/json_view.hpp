@@ -0,0 +1,156 @@
+#ifndef JSON_VIEW_HPP
+#define JSON_VIEW_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xipher {
+
+class JsonDocument;
+
+enum class JsonType {
+    Invalid,
+    Null,
+    Bool,
+    Number,
+    String,
+    Object,
+    Array
+};
+
+// Read-only view of one value inside a JsonDocument. Nothing is copied or
+// unescaped until a value is read with asString()/asInt()/...; objects and
+// arrays are walked through the document's structural index on demand.
+// A lookup that misses (absent key, wrong type, index out of range) yields an
+// Invalid value whose accessors return the fallback, so chains like
+// doc.root()["reply_markup"]["inline_keyboard"][0] never throw.
+class JsonValue {
+public:
+    JsonValue() = default;
+
+    JsonType type() const;
+    bool valid() const { return doc_ != nullptr; }
+    bool isNull() const { return type() == JsonType::Null; }
+    bool isString() const { return type() == JsonType::String; }
+    bool isObject() const { return type() == JsonType::Object; }
+    bool isArray() const { return type() == JsonType::Array; }
+
+    // Object member / array element; Invalid when absent
+    JsonValue operator[](std::string_view key) const;
+    JsonValue operator[](size_t index) const;
+    bool has(std::string_view key) const { return (*this)[key].valid(); }
+    // Members of an object or elements of an array
+    size_t size() const;
+
+    // Exact source text of the value (strings keep their quotes and escapes)
+    std::string_view raw() const;
+    // Unescaped string; other types return their raw text (numbers, true,
+    // nested objects), which is what the flat JsonParser::parse map held.
+    std::string asString(std::string_view fallback = {}) const;
+    // Raw string contents without quotes, still escaped; empty for non-strings
+    std::string_view rawString() const;
+    int64_t asInt(int64_t fallback = 0) const;
+    double asDouble(double fallback = 0.0) const;
+    bool asBool(bool fallback = false) const;
+
+    // Callback gets (key, value) for objects
+    template <class Fn>
+    void forEachMember(Fn&& fn) const;
+    // Callback gets (value) for arrays
+    template <class Fn>
+    void forEachElement(Fn&& fn) const;
+
+    // Compatibility shim for the std::map API of JsonParser::parse: top-level
+    // members, strings unescaped, everything else as raw JSON text.
+    std::map<std::string, std::string> toStringMap() const;
+
+private:
+    friend class JsonDocument;
+    JsonValue(const JsonDocument* doc, uint32_t begin, uint32_t token)
+        : doc_(doc), begin_(begin), token_(token) {}
+
+    // First member/element of a container, or false if empty
+    bool firstChild(uint32_t& token) const;
+    // Given the token where a child value starts, returns the token after it
+    uint32_t skipValue(uint32_t token) const;
+    JsonValue valueAtToken(uint32_t token) const;
+    std::string_view keyAt(uint32_t token) const;
+    bool keyEquals(uint32_t token, std::string_view key) const;
+
+    const JsonDocument* doc_ = nullptr;
+    uint32_t begin_ = 0;   // byte offset of the first character of the value
+    uint32_t token_ = 0;   // index of the first structural at or after begin_
+};
+
+// Parses a JSON text by building an index of its structural characters
+// ({ } [ ] : , and unescaped quotes) in one pass; on x86 the scan tests 16
+// bytes per step with SSE2 so long string payloads (base64 uploads, SDP) are
+// skipped without per-byte branching. The document only references `json`,
+// which must outlive it and every JsonValue taken from it.
+class JsonDocument {
+public:
+    // Offsets are 32-bit: a longer text gives an invalid document, so routes
+    // that parse bodies with it cap body_limit at this size.
+    static constexpr std::size_t kMaxSize = UINT32_MAX - 1;
+
+    explicit JsonDocument(std::string_view json);
+
+    // False for unbalanced brackets, unterminated strings or stray characters;
+    // root() of an invalid document is an Invalid value.
+    bool valid() const { return valid_; }
+    JsonValue root() const;
+
+    std::string_view text() const { return json_; }
+
+private:
+    friend class JsonValue;
+    void buildIndex();
+    char tokenChar(uint32_t token) const { return json_[structurals_[token]]; }
+
+    std::string_view json_;
+    std::vector<uint32_t> structurals_;
+    bool valid_ = false;
+};
+
+template <class Fn>
+void JsonValue::forEachMember(Fn&& fn) const {
+    uint32_t token = 0;
+    if (type() != JsonType::Object || !firstChild(token)) {
+        return;
+    }
+    for (;;) {
+        const std::string_view key = keyAt(token);
+        const uint32_t value_token = token + 3;  // "key" ":"
+        const JsonValue value = valueAtToken(value_token);
+        fn(key, value);
+        const uint32_t next = skipValue(value_token);
+        if (next >= doc_->structurals_.size() || doc_->tokenChar(next) != ',') {
+            return;
+        }
+        token = next + 1;
+    }
+}
+
+template <class Fn>
+void JsonValue::forEachElement(Fn&& fn) const {
+    uint32_t token = 0;
+    if (type() != JsonType::Array || !firstChild(token)) {
+        return;
+    }
+    for (;;) {
+        fn(valueAtToken(token));
+        const uint32_t next = skipValue(token);
+        if (next >= doc_->structurals_.size() || doc_->tokenChar(next) != ',') {
+            return;
+        }
+        token = next + 1;
+    }
+}
+
+} // namespace xipher
+
+#endif // JSON_VIEW_HPP
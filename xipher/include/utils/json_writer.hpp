@@ -0,0 +1,91 @@
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace xipher {
+
+// Streaming JSON builder that appends straight into one std::string: no
+// ostringstream, no temporary per escaped field. Commas are inserted
+// automatically, so a list is just
+//
+//   JsonWriter w(64 + items.size() * 256);
+//   w.beginObject().field("success", true).key("items").beginArray();
+//   for (...) { w.beginObject().field("id", item.id).endObject(); }
+//   w.endArray().endObject();
+//   return w.take();
+//
+// take() moves the buffer out, so the response body handed to Beast is the
+// same allocation the writer filled. The writer does not validate nesting;
+// keys and values must be written in a legal order.
+class JsonWriter {
+public:
+    // Owns its buffer, reserving `reserve_bytes` up front.
+    explicit JsonWriter(size_t reserve_bytes = 256);
+    // Appends to an existing buffer (a reused scratch string or a response body).
+    explicit JsonWriter(std::string& out);
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(bool flag);
+    JsonWriter& value(double number);
+    template <class T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    JsonWriter& value(T number) {
+        if (std::is_signed<T>::value) {
+            appendInt(static_cast<int64_t>(number));
+        } else {
+            appendUint(static_cast<uint64_t>(number));
+        }
+        return *this;
+    }
+    JsonWriter& null();
+    // Pre-serialized JSON (stored reply_markup, permissions); written as is.
+    JsonWriter& raw(std::string_view json);
+
+    template <class T>
+    JsonWriter& field(std::string_view name, const T& v) {
+        key(name);
+        return value(v);
+    }
+    JsonWriter& rawField(std::string_view name, std::string_view json) {
+        key(name);
+        return raw(json);
+    }
+
+    std::string& buffer() { return *out_; }
+    std::string take() { return std::move(*out_); }
+
+    // Appends `text` with JSON string escaping (no surrounding quotes). Runs of
+    // bytes that need no escaping (everything except '"', '\\' and control
+    // characters, UTF-8 included) are found 16 bytes at a time with SSE2 and
+    // copied in one append.
+    static void appendEscaped(std::string& out, std::string_view text);
+
+private:
+    void separate();
+    void appendInt(int64_t number);
+    void appendUint(uint64_t number);
+
+    std::string own_;
+    std::string* out_;
+    bool need_comma_ = false;
+};
+
+} // namespace xipher
+
+#endif // JSON_WRITER_HPP
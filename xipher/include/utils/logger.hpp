@@ -5,6 +5,12 @@
 #include <fstream>
 #include <mutex>
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <thread>
 
 namespace xipher {
 
@@ -15,33 +21,128 @@ enum class LogLevel {
     ERROR
 };
 
+// Asynchronous logger. Callers only format their message and push it into a
+// bounded lock-free MPSC ring; one background thread timestamps, batches and
+// writes the lines to stdout/stderr and the log file. When the ring is full
+// lines are dropped (and counted) rather than blocking request threads.
 class Logger {
 public:
     static Logger& getInstance();
-    
+
     void log(LogLevel level, const std::string& message);
+    void log(LogLevel level, std::string&& message);
     void debug(const std::string& message);
     void info(const std::string& message);
     void warning(const std::string& message);
     void error(const std::string& message);
-    
+
     void setLogFile(const std::string& filename);
-    
+
+    // Runtime threshold; the initial value comes from XIPHER_LOG_LEVEL (default info).
+    void setLevel(LogLevel level);
+    LogLevel level() const { return static_cast<LogLevel>(level_.load(std::memory_order_relaxed)); }
+    bool isEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= level_.load(std::memory_order_relaxed);
+    }
+
+    // Block until everything logged so far has been written.
+    void flush();
+
 private:
-    Logger() = default;
-    ~Logger() = default;
+    Logger();
+    ~Logger();
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
-    
-    std::mutex mutex_;
+
+    struct Record {
+        LogLevel level = LogLevel::INFO;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+    };
+
+    // Bounded MPSC ring (Vyukov): producers claim a slot with one CAS, the
+    // writer thread is the only consumer.
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        Record record;
+    };
+    static constexpr uint64_t kRingCapacity = 1 << 16;
+
+    bool tryPush(Record&& record);
+    bool tryPop(Record& record);
+    void writerLoop();
+
+    std::unique_ptr<Slot[]> ring_;
+    alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+    alignas(64) uint64_t dequeue_pos_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<int> level_{static_cast<int>(LogLevel::INFO)};
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    std::atomic<bool> writer_idle_{false};
+    bool stopping_ = false;
+    uint64_t written_pos_ = 0;
+    std::thread writer_;
+
+    std::mutex file_mutex_;
     std::ofstream log_file_;
     bool file_logging_enabled_ = false;
-    
-    std::string levelToString(LogLevel level);
-    std::string getCurrentTime();
+
+    static const char* levelToString(LogLevel level);
+};
+
+// Per-call-site rate limit: at most `per_second` lines per second, the rest
+// are counted and reported with the next line that gets through.
+class LogRateLimiter {
+public:
+    explicit LogRateLimiter(uint32_t per_second) : per_second_(per_second) {}
+
+    // Returns false when the line should be skipped; *suppressed receives the
+    // number of lines skipped since the last one that was let through.
+    bool allow(uint64_t* suppressed);
+
+private:
+    uint32_t per_second_;
+    std::atomic<int64_t> window_{0};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint64_t> suppressed_{0};
 };
 
 } // namespace xipher
 
-#endif // LOGGER_HPP
+// Level-checked logging: the message expression is not evaluated (no string
+// concatenation) when the level is disabled.
+#define XIPHER_LOG(level, expr)                                            \
+    do {                                                                    \
+        auto& xipher_logger_ = ::xipher::Logger::getInstance();             \
+        if (xipher_logger_.isEnabled(level)) {                              \
+            xipher_logger_.log(level, (expr));                              \
+        }                                                                   \
+    } while (0)
+
+#define XIPHER_LOG_DEBUG(expr) XIPHER_LOG(::xipher::LogLevel::DEBUG, expr)
+#define XIPHER_LOG_INFO(expr) XIPHER_LOG(::xipher::LogLevel::INFO, expr)
+#define XIPHER_LOG_WARNING(expr) XIPHER_LOG(::xipher::LogLevel::WARNING, expr)
+#define XIPHER_LOG_ERROR(expr) XIPHER_LOG(::xipher::LogLevel::ERROR, expr)
 
+// Same, limited to `per_second` lines per second for this call site.
+#define XIPHER_LOG_RATE_LIMITED(level, per_second, expr)                           \
+    do {                                                                            \
+        auto& xipher_logger_ = ::xipher::Logger::getInstance();                     \
+        if (xipher_logger_.isEnabled(level)) {                                      \
+            static ::xipher::LogRateLimiter xipher_log_limiter_(per_second);        \
+            uint64_t xipher_suppressed_ = 0;                                        \
+            if (xipher_log_limiter_.allow(&xipher_suppressed_)) {                   \
+                std::string xipher_line_ = (expr);                                  \
+                if (xipher_suppressed_ > 0) {                                       \
+                    xipher_line_ += " (" + std::to_string(xipher_suppressed_) +     \
+                                    " similar suppressed)";                         \
+                }                                                                   \
+                xipher_logger_.log(level, std::move(xipher_line_));                 \
+            }                                                                       \
+        }                                                                           \
+    } while (0)
+
+#endif // LOGGER_HPP
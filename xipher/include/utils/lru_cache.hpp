@@ -0,0 +1,201 @@
+#ifndef LRU_CACHE_HPP
+#define LRU_CACHE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace xipher {
+
+struct LruCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;      // dropped to stay within capacity
+    uint64_t expirations = 0;    // found past their TTL
+    uint64_t invalidations = 0;
+    size_t size = 0;
+
+    double hitRate() const {
+        const uint64_t lookups = hits + misses;
+        return lookups ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0;
+    }
+};
+
+// Thread-safe LRU map split into shards by key hash, each with its own
+// mutex and recency list, so lookups of different keys rarely contend.
+// Every entry also expires `ttl` after it was stored; capacity 0 disables
+// the cache (get() always misses, put() does nothing).
+//
+// Read-through callers should pass the ticket of the missed get() to
+// put(): if the key's shard saw an erase() in between (a write raced the
+// load), the possibly stale value is not stored.
+template <class Key, class Value, class Hash = std::hash<Key>>
+class ShardedLruCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ShardedLruCache(size_t capacity, std::chrono::milliseconds ttl, size_t shards = 16)
+        : shard_count_(std::max<size_t>(1, shards)),
+          shard_capacity_(capacity == 0 ? 0 : std::max<size_t>(1, (capacity + shard_count_ - 1) / shard_count_)),
+          ttl_(ttl),
+          shards_(new Shard[shard_count_]) {}
+
+    ShardedLruCache(const ShardedLruCache&) = delete;
+    ShardedLruCache& operator=(const ShardedLruCache&) = delete;
+
+    bool enabled() const { return shard_capacity_ > 0; }
+
+    // Copies the cached value into `out`. On a miss, `ticket` (if given)
+    // receives the token to hand to put().
+    bool get(const Key& key, Value* out, uint64_t* ticket = nullptr) {
+        if (!enabled()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            if (ticket) *ticket = shard.generation;
+            return false;
+        }
+        if (Clock::now() >= it->second->expires) {
+            shard.lru.erase(it->second);
+            shard.index.erase(it);
+            expirations_.fetch_add(1, std::memory_order_relaxed);
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            if (ticket) *ticket = shard.generation;
+            return false;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        *out = it->second->value;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Stores `value`, unless `ticket` comes from a get() that an erase()
+    // on the same shard has since overtaken.
+    void put(const Key& key, Value value, const uint64_t* ticket = nullptr) {
+        if (!enabled()) {
+            return;
+        }
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (ticket && *ticket != shard.generation) {
+            return;
+        }
+        const Clock::time_point expires = Clock::now() + ttl_;
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            it->second->value = std::move(value);
+            it->second->expires = expires;
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return;
+        }
+        shard.lru.push_front(Node{key, std::move(value), expires});
+        shard.index.emplace(key, shard.lru.begin());
+        if (shard.index.size() > shard_capacity_) {
+            shard.index.erase(shard.lru.back().key);
+            shard.lru.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void erase(const Key& key) {
+        if (!enabled()) {
+            return;
+        }
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.generation++;
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.lru.erase(it->second);
+            shard.index.erase(it);
+        }
+        invalidations_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Erases every entry whose key matches `pred` (walks all shards)
+    template <class Pred>
+    void eraseIf(Pred pred) {
+        eraseEntriesIf([&pred](const Key& key, const Value&) { return pred(key); });
+    }
+
+    // Same, with `pred` called on the key and the value
+    template <class Pred>
+    void eraseEntriesIf(Pred pred) {
+        for (size_t i = 0; i < shard_count_; ++i) {
+            Shard& shard = shards_[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.generation++;
+            for (auto it = shard.lru.begin(); it != shard.lru.end();) {
+                if (pred(it->key, it->value)) {
+                    shard.index.erase(it->key);
+                    it = shard.lru.erase(it);
+                    invalidations_.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void clear() {
+        eraseIf([](const Key&) { return true; });
+    }
+
+    LruCacheStats stats() const {
+        LruCacheStats stats;
+        stats.hits = hits_.load(std::memory_order_relaxed);
+        stats.misses = misses_.load(std::memory_order_relaxed);
+        stats.evictions = evictions_.load(std::memory_order_relaxed);
+        stats.expirations = expirations_.load(std::memory_order_relaxed);
+        stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < shard_count_; ++i) {
+            std::lock_guard<std::mutex> lock(shards_[i].mutex);
+            stats.size += shards_[i].index.size();
+        }
+        return stats;
+    }
+
+private:
+    struct Node {
+        Key key;
+        Value value;
+        Clock::time_point expires;
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Node> lru;  // most recently used first
+        std::unordered_map<Key, typename std::list<Node>::iterator, Hash> index;
+        uint64_t generation = 0;  // bumped by every erase on this shard
+    };
+
+    Shard& shardFor(const Key& key) {
+        return shards_[Hash()(key) % shard_count_];
+    }
+
+    const size_t shard_count_;
+    const size_t shard_capacity_;
+    const std::chrono::milliseconds ttl_;
+    std::unique_ptr<Shard[]> shards_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> expirations_{0};
+    std::atomic<uint64_t> invalidations_{0};
+};
+
+} // namespace xipher
+
+#endif // LRU_CACHE_HPP
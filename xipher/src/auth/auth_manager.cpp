@@ -1,7 +1,10 @@
 #include "../include/auth/auth_manager.hpp"
 #include "../include/auth/password_hash.hpp"
+#include "../include/utils/env.hpp"
 #include "../include/utils/logger.hpp"
 #include "../include/utils/json_parser.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <random>
 #include <sstream>
 #include <iomanip>
@@ -10,7 +13,35 @@
 
 namespace xipher {
 
-AuthManager::AuthManager(DatabaseManager& db_manager) : db_manager_(db_manager) {
+namespace {
+
+// Longer than any token we issue; such strings are not looked up or cached
+constexpr size_t kMaxTokenLength = 256;
+// Lifetime of a signed token, the same as a persisted opaque session
+constexpr int64_t kSessionTtlSeconds = 60 * 60 * 24 * 30;
+
+} // namespace
+
+AuthManager::AuthManager(DatabaseManager& db_manager)
+    : db_manager_(db_manager),
+      sessions_(readEnvSize("XIPHER_SESSION_CACHE_SIZE", 100000),
+                std::chrono::seconds(std::max<size_t>(1, readEnvSize("XIPHER_SESSION_CACHE_TTL_SEC", 300)))),
+      unknown_tokens_(readEnvSize("XIPHER_SESSION_CACHE_SIZE", 100000) / 4,
+                      std::chrono::seconds(std::max<size_t>(1, readEnvSize("XIPHER_SESSION_NEGATIVE_TTL_SEC", 30)))),
+      signer_(SessionTokenSigner::fromEnv()),
+      password_hasher_(PasswordHasher::configFromEnv()) {
+    if (signer_) {
+        revocations_ = std::make_unique<SessionRevocations>(
+            db_manager_, std::chrono::seconds(readEnvSize("XIPHER_SESSION_REVOCATION_SYNC_SEC", 10)));
+        revocations_->start();
+        Logger::getInstance().info("Signed session tokens enabled");
+    }
+}
+
+AuthManager::~AuthManager() {
+    if (revocations_) {
+        revocations_->stop();
+    }
 }
 
 std::map<std::string, std::string> AuthManager::registerUser(const std::string& username, const std::string& password) {
@@ -37,8 +68,14 @@ std::map<std::string, std::string> AuthManager::registerUser(const std::string&
     }
     
     // Hash password
-    std::string password_hash = PasswordHash::hash(password);
-    if (password_hash.empty()) {
+    std::string password_hash;
+    const PasswordHasher::Status hashed = password_hasher_.hash(password, &password_hash);
+    if (hashed == PasswordHasher::Status::Busy) {
+        result["success"] = "false";
+        result["message"] = "Server is busy, please try again later";
+        return result;
+    }
+    if (hashed != PasswordHasher::Status::Ok) {
         result["success"] = "false";
         result["message"] = "Failed to hash password";
         return result;
@@ -68,18 +105,26 @@ std::map<std::string, std::string> AuthManager::login(const std::string& usernam
     }
     
     // Verify password
-    if (!PasswordHash::verify(password, user.password_hash)) {
+    bool matches = false;
+    if (password_hasher_.verify(password, user.password_hash, &matches) == PasswordHasher::Status::Busy) {
+        result["success"] = "false";
+        result["message"] = "Server is busy, please try again later";
+        return result;
+    }
+    if (!matches) {
         result["success"] = "false";
         result["message"] = "Invalid username or password";
         return result;
     }
 
-    // Upgrade legacy hashes to Argon2id on successful login
+    // Upgrade legacy hashes to Argon2id on successful login, off the
+    // request path; if the pool is busy the next login tries again
     if (PasswordHash::needsRehash(user.password_hash)) {
-        std::string upgraded_hash = PasswordHash::hash(password);
-        if (!upgraded_hash.empty()) {
-            db_manager_.updateUserPasswordHash(user.id, upgraded_hash);
-        }
+        const std::string user_id = user.id;
+        const std::string old_hash = user.password_hash;
+        password_hasher_.hashInBackground(password, [this, user_id, old_hash](const std::string& upgraded_hash) {
+            db_manager_.replaceUserPasswordHash(user_id, old_hash, upgraded_hash);
+        });
     }
     
     // Check if user is active
@@ -109,13 +154,21 @@ std::map<std::string, std::string> AuthManager::login(const std::string& usernam
 }
 
 std::string AuthManager::generateSessionToken(const std::string& user_id) {
-    std::string token = generateRandomToken();
+    std::string token;
+    if (signer_) {
+        token = signer_->issue(user_id, static_cast<int64_t>(std::time(nullptr)), kSessionTtlSeconds);
+    } else {
+        token = generateRandomToken();
+    }
     if (token.empty()) {
         return "";
     }
     
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    sessions_[token] = user_id;
+    // Signed tokens are verified without the cache; the row below only
+    // lists them among the user's sessions
+    if (!signer_) {
+        sessions_.put(token, user_id);
+    }
     
     // Persist session to DB so it survives restarts (best-effort)
     if (!db_manager_.upsertUserSession(token, user_id)) {
@@ -127,41 +180,50 @@ std::string AuthManager::generateSessionToken(const std::string& user_id) {
     return token;
 }
 
-bool AuthManager::validateSessionToken(const std::string& token) {
-    {
-        std::lock_guard<std::mutex> lock(sessions_mutex_);
-        if (sessions_.find(token) != sessions_.end()) {
-            return true;
+std::string AuthManager::lookupSession(const std::string& token) {
+    if (token.empty() || token.size() > kMaxTokenLength) {
+        return "";
+    }
+    if (SessionTokenSigner::isSigned(token)) {
+        SessionTokenSigner::Claims claims;
+        if (!signer_ || !signer_->verify(token, static_cast<int64_t>(std::time(nullptr)), &claims) ||
+            revocations_->isRevoked(claims.session_id)) {
+            return "";
         }
+        return claims.user_id;
     }
-    // Fallback to DB
-    std::string user_id = db_manager_.getUserIdBySessionToken(token);
-    if (!user_id.empty()) {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-        sessions_[token] = user_id;
-        return true;
+    std::string user_id;
+    uint64_t ticket = 0;
+    if (sessions_.get(token, &user_id, &ticket)) {
+        return user_id;
     }
-    return false;
-}
-
-std::string AuthManager::getUserIdFromToken(const std::string& token) {
-    if (token.empty()) {
+    bool unknown = false;
+    if (unknown_tokens_.get(token, &unknown)) {
         return "";
     }
-    
-    {
-        std::lock_guard<std::mutex> lock(sessions_mutex_);
-        auto it = sessions_.find(token);
-        if (it != sessions_.end()) {
-            return it->second;
-        }
-    }
 
     // Fallback to DB (persisted sessions)
-    std::string user_id = db_manager_.getUserIdBySessionToken(token);
+    bool lookup_failed = false;
+    user_id = db_manager_.getUserIdBySessionToken(token, &lookup_failed);
     if (!user_id.empty()) {
-        std::lock_guard<std::mutex> lock(sessions_mutex_);
-        sessions_[token] = user_id;
+        // Dropped if the token was revoked while we were reading it
+        sessions_.put(token, user_id, &ticket);
+    } else if (!lookup_failed) {
+        unknown_tokens_.put(token, true);
+    }
+    return user_id;
+}
+
+bool AuthManager::validateSessionToken(const std::string& token) {
+    return !lookupSession(token).empty();
+}
+
+std::string AuthManager::getUserIdFromToken(const std::string& token) {
+    std::string user_id = lookupSession(token);
+    if (!user_id.empty()) {
+        // Every authenticated request counts as activity (in memory, see
+        // PresenceTracker)
+        db_manager_.updateLastActivity(user_id);
         return user_id;
     }
 
@@ -180,18 +242,12 @@ std::string AuthManager::rotateSessionToken(const std::string& token) {
         return "";
     }
 
-    std::string new_token = generateRandomToken();
+    // Signed when signing is enabled, whatever the old token was
+    std::string new_token = generateSessionToken(user_id);
     if (new_token.empty()) {
         return "";
     }
-    {
-        std::lock_guard<std::mutex> lock(sessions_mutex_);
-        sessions_.erase(token);
-        sessions_[new_token] = user_id;
-    }
-
-    db_manager_.deleteUserSession(token);
-    db_manager_.upsertUserSession(new_token, user_id);
+    revokeSessionToken(token);
 
     return new_token;
 }
@@ -200,11 +256,47 @@ bool AuthManager::revokeSessionToken(const std::string& token) {
     if (token.empty()) {
         return false;
     }
-    {
-        std::lock_guard<std::mutex> lock(sessions_mutex_);
-        sessions_.erase(token);
+    revokeSignedToken(token);
+    // Row first, cache second: a lookup that read the row before the delete
+    // holds an older ticket, so the erase keeps it from re-caching the token
+    const bool deleted = db_manager_.deleteUserSession(token);
+    sessions_.erase(token);
+    return deleted;
+}
+
+void AuthManager::revokeSignedToken(const std::string& token) {
+    if (!signer_ || !SessionTokenSigner::isSigned(token)) {
+        return;
+    }
+    SessionTokenSigner::Claims claims;
+    // An expired or forged token needs no revocation
+    if (signer_->verify(token, static_cast<int64_t>(std::time(nullptr)), &claims)) {
+        revocations_->revoke(claims.session_id, claims.expires_at);
+    }
+}
+
+bool AuthManager::revokeUserSessions(const std::string& user_id) {
+    if (user_id.empty()) {
+        return false;
+    }
+    if (signer_) {
+        for (const auto& session : db_manager_.getUserSessions(user_id)) {
+            revokeSignedToken(session.token);
+        }
     }
-    return db_manager_.deleteUserSession(token);
+    // Same order as revokeSessionToken: delete the rows, then the cache
+    const bool deleted = db_manager_.deleteUserSessionsByUser(user_id);
+    sessions_.eraseEntriesIf([&user_id](const std::string&, const std::string& owner) {
+        return owner == user_id;
+    });
+    return deleted;
+}
+
+AuthManager::SessionCacheStats AuthManager::sessionCacheStats() const {
+    SessionCacheStats stats;
+    stats.sessions = sessions_.stats();
+    stats.unknown_tokens = unknown_tokens_.stats();
+    return stats;
 }
 
 bool AuthManager::validateUsername(const std::string& username) {
@@ -48,7 +48,7 @@ bool constantTimeEquals(const std::string& a, const std::string& b) {
 
 std::string PasswordHash::hash(const std::string& password) {
     const uint32_t t_cost = readEnvUint("XIPHER_ARGON2_TIME_COST", kArgon2TimeCost, 2, 10);
-    const uint32_t m_cost = readEnvUint("XIPHER_ARGON2_MEMORY_KIB", kArgon2MemoryKiB, 32768, 524288);
+    const uint32_t m_cost = memoryCostKiB();
     const uint32_t parallelism = readEnvUint("XIPHER_ARGON2_PARALLELISM", kArgon2Parallelism, 1, 8);
 
     unsigned char salt[kArgon2SaltLength];
@@ -96,6 +96,28 @@ bool PasswordHash::needsRehash(const std::string& hash) {
     return !isArgon2Hash(hash);
 }
 
+uint32_t PasswordHash::memoryCostKiB() {
+    return readEnvUint("XIPHER_ARGON2_MEMORY_KIB", kArgon2MemoryKiB, 32768, 524288);
+}
+
+uint32_t PasswordHash::memoryCostOf(const std::string& hash) {
+    if (!isArgon2Hash(hash)) {
+        return 0;
+    }
+    // $argon2id$v=19$m=65536,t=3,p=1$salt$hash
+    const size_t pos = hash.find("$m=");
+    if (pos == std::string::npos) {
+        return memoryCostKiB();
+    }
+    const char* begin = hash.c_str() + pos + 3;
+    char* end = nullptr;
+    const unsigned long value = std::strtoul(begin, &end, 10);
+    if (end == begin || *end != ',' || value == 0 || value > 0xFFFFFFFFul) {
+        return memoryCostKiB();
+    }
+    return static_cast<uint32_t>(value);
+}
+
 std::string PasswordHash::generateSalt() {
     unsigned char salt[16];
     if (RAND_bytes(salt, sizeof(salt)) != 1) {
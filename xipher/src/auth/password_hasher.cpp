@@ -0,0 +1,202 @@
+#include "../include/auth/password_hasher.hpp"
+#include "../include/auth/password_hash.hpp"
+#include "../include/utils/env.hpp"
+#include "../include/utils/logger.hpp"
+#include <openssl/crypto.h>
+#include <algorithm>
+#include <cstdlib>
+#include <future>
+#include <memory>
+
+namespace xipher {
+
+namespace {
+
+// The job's copy of the password should not outlive the job
+void wipe(std::string& secret) {
+    if (!secret.empty()) {
+        OPENSSL_cleanse(&secret[0], secret.size());
+    }
+    secret.clear();
+}
+
+} // namespace
+
+PasswordHasher::Config PasswordHasher::configFromEnv() {
+    Config config;
+    const size_t budget_mib = readEnvSize("XIPHER_ARGON2_MEMORY_BUDGET_MIB", 0);
+    if (budget_mib > 0) {
+        config.memory_budget_kib = budget_mib * 1024;
+    }
+    config.threads = readEnvSize("XIPHER_ARGON2_THREADS", config.threads);
+    const size_t max_queue = readEnvSize("XIPHER_ARGON2_QUEUE_MAX", 0);
+    if (max_queue > 0) {
+        config.max_queue = max_queue;
+    }
+    return config;
+}
+
+PasswordHasher::PasswordHasher(Config config) : config_(config) {
+    config_.memory_budget_kib = std::max<size_t>(1, config_.memory_budget_kib);
+    config_.max_queue = std::max<size_t>(1, config_.max_queue);
+    if (config_.threads == 0) {
+        config_.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // More threads than the budget can feed would only sit waiting
+    const size_t slots = std::max<size_t>(1, config_.memory_budget_kib / std::max<uint32_t>(1, PasswordHash::memoryCostKiB()));
+    config_.threads = std::min(config_.threads, slots);
+
+    workers_.reserve(config_.threads);
+    for (size_t i = 0; i < config_.threads; ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+PasswordHasher::~PasswordHasher() {
+    std::deque<Job> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        dropped.swap(queue_);
+    }
+    cv_.notify_all();
+    for (auto& job : dropped) {
+        job.fn(false);
+    }
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+PasswordHasher::Status PasswordHasher::hash(const std::string& password, std::string* out) {
+    auto done = std::make_shared<std::promise<Status>>();
+    std::future<Status> result = done->get_future();
+    Job job;
+    job.cost_kib = PasswordHash::memoryCostKiB();
+    job.fn = [done, secret = password, out](bool run) mutable {
+        if (!run) {
+            wipe(secret);
+            done->set_value(Status::Busy);
+            return;
+        }
+        std::string hashed = PasswordHash::hash(secret);
+        wipe(secret);
+        if (hashed.empty()) {
+            done->set_value(Status::Failed);
+            return;
+        }
+        *out = std::move(hashed);
+        done->set_value(Status::Ok);
+    };
+    if (!enqueue(std::move(job), config_.max_queue)) {
+        return Status::Busy;
+    }
+    return result.get();
+}
+
+PasswordHasher::Status PasswordHasher::verify(const std::string& password, const std::string& hash, bool* matches) {
+    const uint32_t cost = PasswordHash::memoryCostOf(hash);
+    if (cost == 0) {
+        *matches = PasswordHash::verify(password, hash);
+        return Status::Ok;
+    }
+
+    auto done = std::make_shared<std::promise<Status>>();
+    std::future<Status> result = done->get_future();
+    Job job;
+    job.cost_kib = cost;
+    job.fn = [done, secret = password, hash, matches](bool run) mutable {
+        if (run) {
+            *matches = PasswordHash::verify(secret, hash);
+        }
+        wipe(secret);
+        done->set_value(run ? Status::Ok : Status::Busy);
+    };
+    if (!enqueue(std::move(job), config_.max_queue)) {
+        return Status::Busy;
+    }
+    return result.get();
+}
+
+bool PasswordHasher::hashInBackground(const std::string& password, std::function<void(const std::string&)> on_done) {
+    Job job;
+    job.cost_kib = PasswordHash::memoryCostKiB();
+    job.fn = [secret = password, on_done = std::move(on_done)](bool run) mutable {
+        std::string hashed = run ? PasswordHash::hash(secret) : std::string();
+        wipe(secret);
+        if (!hashed.empty()) {
+            on_done(hashed);
+        }
+    };
+    return enqueue(std::move(job), std::max<size_t>(1, config_.max_queue / 2));
+}
+
+PasswordHasher::Stats PasswordHasher::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.queued = queue_.size();
+    stats.running = running_;
+    stats.memory_in_use_kib = memory_in_use_kib_;
+    stats.completed = completed_;
+    stats.rejected = rejected_;
+    return stats;
+}
+
+bool PasswordHasher::enqueue(Job job, size_t max_queued) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || queue_.size() >= max_queued) {
+            rejected_++;
+            return false;
+        }
+        queue_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void PasswordHasher::workerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // FIFO: the head waits for memory rather than being overtaken
+            cv_.wait(lock, [this]() {
+                if (stopping_) {
+                    return true;
+                }
+                if (queue_.empty()) {
+                    return false;
+                }
+                return memory_in_use_kib_ == 0 ||
+                       memory_in_use_kib_ + queue_.front().cost_kib <= config_.memory_budget_kib;
+            });
+            if (stopping_) {
+                return;
+            }
+            job = std::move(queue_.front());
+            queue_.pop_front();
+            running_++;
+            memory_in_use_kib_ += job.cost_kib;
+        }
+
+        try {
+            job.fn(true);
+        } catch (const std::exception& e) {
+            Logger::getInstance().error(std::string("Password hashing job failed: ") + e.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_--;
+            memory_in_use_kib_ -= job.cost_kib;
+            completed_++;
+        }
+        // Freed memory may let the next job in
+        cv_.notify_all();
+    }
+}
+
+} // namespace xipher
@@ -0,0 +1,236 @@
+#include "../include/auth/session_token.hpp"
+#include "../include/database/db_manager.hpp"
+#include "../include/utils/logger.hpp"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+namespace xipher {
+
+namespace {
+
+constexpr const char* kSignedPrefix = "xs1.";
+constexpr size_t kMinKeyLength = 32;
+// Overlap of incremental syncs, for rows whose transaction committed after
+// a later revoked_at was already read
+constexpr int64_t kSyncOverlapUs = 5 * 1000000LL;
+
+std::string toHex(const unsigned char* data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(size * 2, '0');
+    for (size_t i = 0; i < size; ++i) {
+        out[2 * i] = digits[data[i] >> 4];
+        out[2 * i + 1] = digits[data[i] & 0x0f];
+    }
+    return out;
+}
+
+bool isIdText(const std::string& text) {
+    if (text.empty() || text.size() > 64) {
+        return false;
+    }
+    return std::all_of(text.begin(), text.end(), [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || c == '-';
+    });
+}
+
+bool parseSeconds(const std::string& text, int64_t* out) {
+    if (text.empty() || text.size() > 12) {
+        return false;
+    }
+    char* end = nullptr;
+    const long long value = std::strtoll(text.c_str(), &end, 10);
+    if (!end || *end != '\0' || value < 0) {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+int64_t nowSeconds() {
+    return static_cast<int64_t>(std::time(nullptr));
+}
+
+} // namespace
+
+std::unique_ptr<SessionTokenSigner> SessionTokenSigner::fromEnv() {
+    const char* raw = std::getenv("XIPHER_SESSION_SIGNING_KEY");
+    if (!raw || !*raw) {
+        return nullptr;
+    }
+    std::string key(raw);
+    if (key.size() < kMinKeyLength) {
+        Logger::getInstance().warning("XIPHER_SESSION_SIGNING_KEY is shorter than 32 bytes; signed session tokens are disabled");
+        return nullptr;
+    }
+    return std::make_unique<SessionTokenSigner>(std::move(key));
+}
+
+SessionTokenSigner::SessionTokenSigner(std::string key) : key_(std::move(key)) {
+}
+
+std::string SessionTokenSigner::sign(const std::string& body) const {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    HMAC(EVP_sha256(),
+         reinterpret_cast<const unsigned char*>(key_.data()),
+         static_cast<int>(key_.size()),
+         reinterpret_cast<const unsigned char*>(body.data()),
+         body.size(),
+         digest,
+         &len);
+    return toHex(digest, len);
+}
+
+std::string SessionTokenSigner::issue(const std::string& user_id, int64_t now, int64_t ttl_seconds) const {
+    unsigned char id_bytes[16];
+    if (RAND_bytes(id_bytes, sizeof(id_bytes)) != 1) {
+        return "";
+    }
+    std::string body = kSignedPrefix;
+    body += user_id;
+    body += '.';
+    body += toHex(id_bytes, sizeof(id_bytes));
+    body += '.';
+    body += std::to_string(now);
+    body += '.';
+    body += std::to_string(now + ttl_seconds);
+    return body + '.' + sign(body);
+}
+
+bool SessionTokenSigner::verify(const std::string& token, int64_t now, Claims* out) const {
+    if (!isSigned(token)) {
+        return false;
+    }
+    const size_t mac_pos = token.rfind('.');
+    const std::string body = token.substr(0, mac_pos);
+    const std::string expected = sign(body);
+    const std::string mac = token.substr(mac_pos + 1);
+    if (mac.size() != expected.size() || CRYPTO_memcmp(mac.data(), expected.data(), mac.size()) != 0) {
+        return false;
+    }
+
+    // body: xs1.<user_id>.<session_id>.<issued_at>.<expires_at>
+    std::vector<std::string> parts;
+    size_t start = 0;
+    for (;;) {
+        const size_t dot = body.find('.', start);
+        parts.push_back(body.substr(start, dot == std::string::npos ? std::string::npos : dot - start));
+        if (dot == std::string::npos) {
+            break;
+        }
+        start = dot + 1;
+    }
+    Claims claims;
+    if (parts.size() != 5 || !isIdText(parts[1]) || !isIdText(parts[2]) ||
+        !parseSeconds(parts[3], &claims.issued_at) || !parseSeconds(parts[4], &claims.expires_at)) {
+        return false;
+    }
+    if (claims.expires_at <= now) {
+        return false;
+    }
+    claims.user_id = parts[1];
+    claims.session_id = parts[2];
+    *out = std::move(claims);
+    return true;
+}
+
+bool SessionTokenSigner::isSigned(const std::string& token) {
+    return token.compare(0, 4, kSignedPrefix) == 0;
+}
+
+SessionRevocations::SessionRevocations(DatabaseManager& db_manager, std::chrono::seconds sync_interval)
+    : db_manager_(db_manager), sync_interval_(std::max(std::chrono::seconds(1), sync_interval)) {
+}
+
+SessionRevocations::~SessionRevocations() {
+    stop();
+}
+
+void SessionRevocations::start() {
+    sync();
+    std::lock_guard<std::mutex> lock(stop_mutex_);
+    if (sync_thread_.joinable()) {
+        return;
+    }
+    stopping_ = false;
+    sync_thread_ = std::thread([this]() { syncLoop(); });
+}
+
+void SessionRevocations::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        stopping_ = true;
+    }
+    stop_cv_.notify_all();
+    if (sync_thread_.joinable()) {
+        sync_thread_.join();
+    }
+}
+
+bool SessionRevocations::isRevoked(const std::string& session_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return revoked_.count(session_id) > 0;
+}
+
+bool SessionRevocations::revoke(const std::string& session_id, int64_t expires_at) {
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        revoked_[session_id] = expires_at;
+    }
+    return db_manager_.revokeSessionId(session_id, expires_at);
+}
+
+void SessionRevocations::sync() {
+    int64_t since = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        since = std::max<int64_t>(0, synced_until_us_ - kSyncOverlapUs);
+    }
+    std::vector<RevokedSession> fresh;
+    if (!db_manager_.getRevokedSessionsSince(since, fresh)) {
+        Logger::getInstance().warning("Session revocations: sync failed, keeping the current set");
+        return;
+    }
+    // The table only has to hold revocations whose tokens are still valid
+    db_manager_.purgeExpiredRevokedSessions();
+
+    const int64_t now = nowSeconds();
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& revoked : fresh) {
+        revoked_[revoked.session_id] = revoked.expires_at;
+        synced_until_us_ = std::max(synced_until_us_, revoked.revoked_at_us);
+    }
+    for (auto it = revoked_.begin(); it != revoked_.end();) {
+        if (it->second <= now) {
+            it = revoked_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t SessionRevocations::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return revoked_.size();
+}
+
+void SessionRevocations::syncLoop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(stop_mutex_);
+            stop_cv_.wait_for(lock, sync_interval_, [this]() { return stopping_; });
+            if (stopping_) {
+                return;
+            }
+        }
+        sync();
+    }
+}
+
+} // namespace xipher
@@ -28,7 +28,8 @@ void BotScheduler::start() {
         std::string db_user = env_user ? env_user : "xipher";
         std::string db_pass = env_pass ? env_pass : "xipher";
 
-        DatabaseManager db(db_host, db_port, db_name, db_user, db_pass);
+        // Single scheduler thread: one connection is enough
+        DatabaseManager db(db_host, db_port, db_name, db_user, db_pass, 1);
         if (!db.initialize()) {
             Logger::getInstance().error("BotScheduler: failed to initialize DB, scheduler disabled");
             running_ = false;
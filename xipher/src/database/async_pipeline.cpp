@@ -0,0 +1,124 @@
+#include "../include/database/async_pipeline.hpp"
+#include "../include/utils/logger.hpp"
+#include <boost/asio/post.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <memory>
+#include <unistd.h>
+
+namespace xipher {
+
+namespace {
+
+class PipelineOp : public std::enable_shared_from_this<PipelineOp> {
+public:
+    PipelineOp(boost::asio::any_io_executor executor, PipelineBatch batch, PipelineHandler on_done)
+        : executor_(std::move(executor)),
+          socket_(executor_),
+          batch_(std::move(batch)),
+          on_done_(std::move(on_done)) {}
+
+    const boost::asio::any_io_executor& executor() const { return executor_; }
+
+    void start(ConnectionPool& pool, ConnectionPool::Lease lease) {
+        lease_ = std::move(lease);
+        if (!lease_) {
+            finish(false);
+            return;
+        }
+        // Statements this connection has not used yet are prepared
+        // synchronously; a blocking round-trip at most once per statement
+        // and connection (never with XIPHER_DB_PREPARE=eager).
+        if (!pool.preparePipeline(lease_, batch_) || !lease_->beginPipeline(batch_, results_)) {
+            finish(false);
+            return;
+        }
+        // asio takes ownership of the descriptor it watches, so give it a
+        // duplicate and leave the original to libpq.
+        const int fd = ::dup(lease_->socket());
+        if (fd < 0) {
+            lease_->endPipeline();
+            finish(false);
+            return;
+        }
+        boost::system::error_code ec;
+        socket_.assign(fd, ec);
+        if (ec) {
+            ::close(fd);
+            lease_->endPipeline();
+            finish(false);
+            return;
+        }
+        step();
+    }
+
+private:
+    void step() {
+        const int flushed = lease_->flushPipeline();
+        if (flushed < 0) {
+            fail();
+            return;
+        }
+        // Replies a flush already read into libpq's buffer would never make
+        // the socket readable, so take them before waiting
+        bool done = false;
+        if (!lease_->consumePipeline(results_, &done)) {
+            fail();
+            return;
+        }
+        if (done) {
+            lease_->endPipeline();
+            finish(true);
+            return;
+        }
+        auto self = shared_from_this();
+        socket_.async_wait(flushed == 1 ? boost::asio::posix::stream_descriptor::wait_write
+                                        : boost::asio::posix::stream_descriptor::wait_read,
+                           [self](const boost::system::error_code& ec) {
+                               if (ec) {
+                                   self->fail();
+                                   return;
+                               }
+                               self->step();
+                           });
+    }
+
+    void fail() {
+        Logger::getInstance().error("PostgreSQL async pipeline failed: " + lease_->getLastError());
+        lease_->endPipeline();
+        finish(false);
+    }
+
+    void finish(bool ok) {
+        boost::system::error_code ignored;
+        socket_.close(ignored);
+        // Give the connection back before running user code
+        lease_ = ConnectionPool::Lease();
+        boost::asio::post(executor_, [on_done = std::move(on_done_), ok, results = std::move(results_)]() mutable {
+            on_done(ok, std::move(results));
+        });
+    }
+
+    boost::asio::any_io_executor executor_;
+    boost::asio::posix::stream_descriptor socket_;
+    ConnectionPool::Lease lease_;
+    PipelineBatch batch_;
+    PipelineResults results_;
+    PipelineHandler on_done_;
+};
+
+} // namespace
+
+void asyncExecutePipeline(ConnectionPool& pool,
+                          boost::asio::any_io_executor executor,
+                          PipelineBatch batch,
+                          PipelineHandler on_done) {
+    auto op = std::make_shared<PipelineOp>(std::move(executor), std::move(batch), std::move(on_done));
+    // The lease may arrive on whichever thread releases a connection; hop
+    // back to the executor before touching the socket.
+    pool.acquireAsync([op, &pool](ConnectionPool::Lease lease) {
+        auto shared_lease = std::make_shared<ConnectionPool::Lease>(std::move(lease));
+        boost::asio::post(op->executor(), [op, &pool, shared_lease]() { op->start(pool, std::move(*shared_lease)); });
+    });
+}
+
+} // namespace xipher
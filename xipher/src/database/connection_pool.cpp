@@ -0,0 +1,757 @@
+#include "../include/database/connection_pool.hpp"
+#include "../include/utils/env.hpp"
+#include "../include/utils/logger.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace xipher {
+
+namespace {
+
+struct PinnedConnection {
+    const ConnectionPool* pool;
+    size_t slot;
+    int depth;
+};
+
+// Connections pinned by pin() on this thread (normally zero or one)
+thread_local std::vector<PinnedConnection> t_pinned;
+thread_local std::string t_last_error;
+
+// Plain SELECT/VALUES/SHOW/TABLE: repeating one after a lost connection
+// cannot apply anything twice. WITH is excluded, it may wrap a write.
+bool isReadOnlySql(const std::string& sql) {
+    size_t pos = 0;
+    while (pos < sql.size() && (std::isspace(static_cast<unsigned char>(sql[pos])) || sql[pos] == '(')) {
+        ++pos;
+    }
+    size_t end = pos;
+    while (end < sql.size() && std::isalpha(static_cast<unsigned char>(sql[end]))) {
+        ++end;
+    }
+    std::string keyword = sql.substr(pos, end - pos);
+    for (auto& c : keyword) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return keyword == "SELECT" || keyword == "VALUES" || keyword == "SHOW" || keyword == "TABLE";
+}
+
+bool resultFailed(PGresult* res) {
+    if (!res) {
+        return true;
+    }
+    const ExecStatusType status = PQresultStatus(res);
+    return status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK;
+}
+
+} // namespace
+
+ConnectionPool::Config ConnectionPool::configFromEnv(size_t size) {
+    Config config;
+    if (size == 0) {
+        size = readEnvSize("XIPHER_DB_POOL_SIZE", 0);
+    }
+    if (size == 0) {
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        size = std::min<size_t>(16, std::max<size_t>(4, 2 * cores));
+    }
+    config.size = size;
+    config.checkout_timeout = std::chrono::milliseconds(
+        readEnvSize("XIPHER_DB_POOL_TIMEOUT_MS", static_cast<size_t>(config.checkout_timeout.count())));
+    config.health_check_interval = std::chrono::seconds(
+        readEnvSize("XIPHER_DB_HEALTH_CHECK_SEC", static_cast<size_t>(config.health_check_interval.count())));
+    const char* prepare = std::getenv("XIPHER_DB_PREPARE");
+    config.eager_prepare = prepare && std::strcmp(prepare, "eager") == 0;
+    return config;
+}
+
+ConnectionPool::ConnectionPool(const std::string& host,
+                               const std::string& port,
+                               const std::string& dbname,
+                               const std::string& user,
+                               const std::string& password,
+                               Config config)
+    : config_(config), slots_(std::max<size_t>(1, config.size)) {
+    for (auto& slot : slots_) {
+        slot.conn = std::make_unique<DatabaseConnection>(host, port, dbname, user, password);
+    }
+}
+
+ConnectionPool::~ConnectionPool() {
+    disconnect();
+}
+
+bool ConnectionPool::connect() {
+    size_t connected = 0;
+    for (auto& slot : slots_) {
+        if (slot.conn->connect()) {
+            connected++;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.clear();
+        for (size_t i = slots_.size(); i-- > 0;) {
+            idle_.push_back(i);
+        }
+        stopping_ = false;
+    }
+    Logger::getInstance().info("PostgreSQL pool: " + std::to_string(connected) + "/" +
+                               std::to_string(slots_.size()) + " connections up");
+    if (connected == 0) {
+        return false;
+    }
+    if (!health_thread_.joinable() && config_.health_check_interval.count() > 0) {
+        health_thread_ = std::thread([this]() { healthLoop(); });
+    }
+    return true;
+}
+
+void ConnectionPool::disconnect() {
+    std::deque<AsyncWaiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        waiters.swap(async_waiters_);
+    }
+    for (auto& waiter : waiters) {
+        waiter.on_ready(Lease());
+    }
+    health_cv_.notify_all();
+    idle_cv_.notify_all();
+    if (health_thread_.joinable()) {
+        health_thread_.join();
+    }
+    for (auto& slot : slots_) {
+        slot.conn->disconnect();
+        slot.prepared.clear();
+        slot.registry_epoch = 0;
+    }
+}
+
+bool ConnectionPool::isConnected() const {
+    for (const auto& slot : slots_) {
+        if (slot.conn->isConnected()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t ConnectionPool::checkout(std::chrono::milliseconds timeout, bool* ok) {
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    const bool waited = idle_.empty();
+    idle_cv_.wait_for(lock, timeout, [this]() { return !idle_.empty() || stopping_; });
+    if (idle_.empty()) {
+        stats_.timeouts++;
+        *ok = false;
+        return 0;
+    }
+    const size_t slot = idle_.back();
+    idle_.pop_back();
+    slots_[slot].in_use = true;
+    stats_.checkouts++;
+    if (waited) {
+        const uint64_t us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        stats_.waited++;
+        stats_.total_wait_us += us;
+        stats_.max_wait_us = std::max(stats_.max_wait_us, us);
+    }
+    *ok = true;
+    return slot;
+}
+
+void ConnectionPool::release(size_t slot) {
+    AsyncWaiter waiter;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (async_waiters_.empty() || stopping_) {
+            slots_[slot].in_use = false;
+            idle_.push_back(slot);
+        } else {
+            // Hand the connection straight to the oldest async waiter
+            waiter = std::move(async_waiters_.front());
+            async_waiters_.pop_front();
+            const uint64_t us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - waiter.since).count());
+            stats_.checkouts++;
+            stats_.waited++;
+            stats_.total_wait_us += us;
+            stats_.max_wait_us = std::max(stats_.max_wait_us, us);
+        }
+    }
+    if (!waiter.on_ready) {
+        idle_cv_.notify_one();
+        return;
+    }
+    if (!prepareSlot(slot)) {
+        waiter.on_ready(Lease());
+        release(slot);
+        return;
+    }
+    waiter.on_ready(Lease(this, slot, false));
+}
+
+bool ConnectionPool::reconnectSlot(size_t slot) {
+    DatabaseConnection& conn = *slots_[slot].conn;
+    if (!conn.reconnect()) {
+        return false;
+    }
+    // Server-side prepared statements died with the old backend
+    slots_[slot].prepared.clear();
+    slots_[slot].registry_epoch = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.reconnects++;
+    return true;
+}
+
+bool ConnectionPool::prepareSlot(size_t slot) {
+    DatabaseConnection& conn = *slots_[slot].conn;
+    if (!conn.isConnected()) {
+        Logger::getInstance().warning("PostgreSQL pool: connection " + std::to_string(slot) + " is down, reconnecting");
+        if (!reconnectSlot(slot)) {
+            return false;
+        }
+    }
+    if (!config_.eager_prepare) {
+        return true;
+    }
+
+    uint64_t epoch = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(registry_mutex_);
+        epoch = registry_epoch_;
+    }
+    Slot& s = slots_[slot];
+    if (s.registry_epoch == epoch) {
+        return true;
+    }
+    // Statements that fail here are retried lazily on first use
+    prepareMissing(slot, nullptr);
+    s.registry_epoch = epoch;
+    return true;
+}
+
+bool ConnectionPool::ensurePrepared(size_t slot, const std::string& stmt_name) {
+    size_t index = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(registry_mutex_);
+        auto it = registry_index_.find(stmt_name);
+        if (it == registry_index_.end()) {
+            // Not ours: let the server report the unknown statement
+            return true;
+        }
+        index = it->second;
+        const std::vector<uint32_t>& prepared = slots_[slot].prepared;
+        if (index < prepared.size() && prepared[index] == registry_[index].version) {
+            return true;
+        }
+    }
+    const std::vector<size_t> indices{index};
+    return prepareMissing(slot, &indices);
+}
+
+bool ConnectionPool::ensurePrepared(size_t slot, const PipelineBatch& batch) {
+    std::vector<size_t> indices;
+    {
+        std::shared_lock<std::shared_mutex> lock(registry_mutex_);
+        for (const auto& query : batch.queries()) {
+            if (query.kind != PipelineBatch::Kind::Prepared) {
+                continue;
+            }
+            auto it = registry_index_.find(query.text);
+            if (it != registry_index_.end()) {
+                indices.push_back(it->second);
+            }
+        }
+    }
+    if (indices.empty()) {
+        return true;
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    return prepareMissing(slot, &indices);
+}
+
+bool ConnectionPool::prepareMissing(size_t slot, const std::vector<size_t>* indices) {
+    struct Pending {
+        size_t index;
+        uint32_t version;
+        std::string name;
+        std::string query;
+    };
+    Slot& s = slots_[slot];
+    std::vector<Pending> pending;
+    std::vector<std::string> outdated;
+    {
+        std::shared_lock<std::shared_mutex> lock(registry_mutex_);
+        s.prepared.resize(registry_.size(), 0);
+        auto collect = [&](size_t index) {
+            const Statement& stmt = registry_[index];
+            if (s.prepared[index] == stmt.version) {
+                return;
+            }
+            if (s.prepared[index] != 0) {
+                outdated.push_back(stmt.name);
+            }
+            pending.push_back(Pending{index, stmt.version, stmt.name, stmt.query});
+        };
+        if (indices) {
+            for (size_t index : *indices) {
+                collect(index);
+            }
+        } else {
+            for (size_t index = 0; index < registry_.size(); ++index) {
+                collect(index);
+            }
+        }
+    }
+    if (pending.empty()) {
+        return true;
+    }
+
+    DatabaseConnection& conn = *s.conn;
+    for (const auto& name : outdated) {
+        // Re-registered with different SQL since it was prepared here
+        PGresult* res = conn.executeQuery("DEALLOCATE " + name);
+        if (res) PQclear(res);
+    }
+    if (pending.size() == 1) {
+        if (!conn.prepare(pending[0].name, pending[0].query)) {
+            return false;
+        }
+        s.prepared[pending[0].index] = pending[0].version;
+        return true;
+    }
+
+    // A failed PREPARE aborts the rest of its pipeline: drop the failed
+    // statement and send the aborted ones again.
+    bool ok = true;
+    while (!pending.empty()) {
+        PipelineBatch batch;
+        for (const auto& stmt : pending) {
+            batch.addPrepare(stmt.name, stmt.query);
+        }
+        PipelineResults results;
+        if (!conn.executePipeline(batch, results)) {
+            return false;
+        }
+        std::vector<Pending> aborted;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            const ExecStatusType status = results[i] ? PQresultStatus(results[i].get()) : PGRES_FATAL_ERROR;
+            if (status == PGRES_COMMAND_OK) {
+                s.prepared[pending[i].index] = pending[i].version;
+            } else if (status == PGRES_PIPELINE_ABORTED) {
+                aborted.push_back(std::move(pending[i]));
+            } else {
+                ok = false;
+            }
+        }
+        pending.swap(aborted);
+    }
+    return ok;
+}
+
+bool ConnectionPool::pinnedSlot(size_t* slot) const {
+    for (const auto& pinned : t_pinned) {
+        if (pinned.pool == this) {
+            *slot = pinned.slot;
+            return true;
+        }
+    }
+    return false;
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    bool ok = false;
+    const size_t slot = checkout(config_.checkout_timeout, &ok);
+    if (!ok) {
+        Logger::getInstance().error("PostgreSQL pool: checkout timed out");
+        return Lease();
+    }
+    if (!prepareSlot(slot)) {
+        release(slot);
+        return Lease();
+    }
+    return Lease(this, slot, false);
+}
+
+void ConnectionPool::acquireAsync(std::function<void(Lease)> on_ready) {
+    size_t slot = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            slot = slots_.size();
+        } else if (idle_.empty()) {
+            async_waiters_.push_back(AsyncWaiter{std::move(on_ready), std::chrono::steady_clock::now()});
+            return;
+        } else {
+            slot = idle_.back();
+            idle_.pop_back();
+            slots_[slot].in_use = true;
+            stats_.checkouts++;
+        }
+    }
+    if (slot == slots_.size()) {
+        on_ready(Lease());
+        return;
+    }
+    if (!prepareSlot(slot)) {
+        release(slot);
+        on_ready(Lease());
+        return;
+    }
+    on_ready(Lease(this, slot, false));
+}
+
+ConnectionPool::Lease ConnectionPool::pin() {
+    for (auto& pinned : t_pinned) {
+        if (pinned.pool == this) {
+            pinned.depth++;
+            return Lease(this, pinned.slot, true);
+        }
+    }
+    bool ok = false;
+    const size_t slot = checkout(config_.checkout_timeout, &ok);
+    if (!ok) {
+        Logger::getInstance().error("PostgreSQL pool: checkout timed out");
+        return Lease();
+    }
+    if (!prepareSlot(slot)) {
+        release(slot);
+        return Lease();
+    }
+    t_pinned.push_back(PinnedConnection{this, slot, 1});
+    return Lease(this, slot, true);
+}
+
+ConnectionPool::Lease::Lease(ConnectionPool* pool, size_t slot, bool pinned)
+    : pool_(pool), conn_(pool->slots_[slot].conn.get()), slot_(slot), pinned_(pinned) {}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), conn_(other.conn_), slot_(other.slot_), pinned_(other.pinned_) {
+    other.pool_ = nullptr;
+    other.conn_ = nullptr;
+}
+
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        reset();
+        pool_ = other.pool_;
+        conn_ = other.conn_;
+        slot_ = other.slot_;
+        pinned_ = other.pinned_;
+        other.pool_ = nullptr;
+        other.conn_ = nullptr;
+    }
+    return *this;
+}
+
+ConnectionPool::Lease::~Lease() {
+    reset();
+}
+
+void ConnectionPool::Lease::reset() {
+    if (!pool_) {
+        return;
+    }
+    if (pinned_) {
+        for (auto it = t_pinned.begin(); it != t_pinned.end(); ++it) {
+            if (it->pool == pool_) {
+                if (--it->depth > 0) {
+                    pool_ = nullptr;
+                    conn_ = nullptr;
+                    return;
+                }
+                t_pinned.erase(it);
+                break;
+            }
+        }
+    }
+    pool_->release(slot_);
+    pool_ = nullptr;
+    conn_ = nullptr;
+}
+
+template <class Fn>
+PGresult* ConnectionPool::run(Fn&& fn, bool read_only) {
+    size_t slot = 0;
+    bool sent = false;
+    if (pinnedSlot(&slot)) {
+        // Inside a transaction: never switch connections or retry
+        DatabaseConnection& conn = *slots_[slot].conn;
+        PGresult* res = fn(slot, conn, &sent);
+        if (resultFailed(res)) {
+            t_last_error = conn.getLastError();
+        }
+        return res;
+    }
+
+    for (int attempt = 0;; ++attempt) {
+        Lease lease = acquire();
+        if (!lease) {
+            t_last_error = "No database connection available";
+            return nullptr;
+        }
+        sent = false;
+        PGresult* res = fn(lease.slot_, *lease, &sent);
+        if (!resultFailed(res)) {
+            return res;
+        }
+        t_last_error = lease->getLastError();
+        const bool broken = !lease->isConnected();
+        if (!broken || attempt > 0) {
+            return res;
+        }
+        // Once the statement was sent the backend may have run and committed
+        // it before the connection dropped, so only a read is safe to repeat.
+        if (sent && !read_only) {
+            return res;
+        }
+        if (res) PQclear(res);
+        Logger::getInstance().warning("PostgreSQL pool: connection lost, retrying on a fresh connection");
+    }
+}
+
+PGresult* ConnectionPool::executeQuery(const std::string& query) {
+    return run([&](size_t, DatabaseConnection& conn, bool* sent) {
+                   *sent = conn.isConnected();
+                   return conn.executeQuery(query);
+               },
+               isReadOnlySql(query));
+}
+
+PGresult* ConnectionPool::executePrepared(const std::string& stmt_name,
+                                          int n_params,
+                                          const char* const* param_values) {
+    return run([&](size_t slot, DatabaseConnection& conn, bool* sent) -> PGresult* {
+                   if (!ensurePrepared(slot, stmt_name)) {
+                       return nullptr;
+                   }
+                   *sent = conn.isConnected();
+                   return conn.executePrepared(stmt_name, n_params, param_values);
+               },
+               statementIsReadOnly(stmt_name));
+}
+
+PGresult* ConnectionPool::executePrepared(const std::string& stmt_name,
+                                          int n_params,
+                                          const char* const* param_values,
+                                          const int* param_lengths,
+                                          const int* param_formats,
+                                          PgFormat result_format) {
+    return run([&](size_t slot, DatabaseConnection& conn, bool* sent) -> PGresult* {
+                   if (!ensurePrepared(slot, stmt_name)) {
+                       return nullptr;
+                   }
+                   *sent = conn.isConnected();
+                   return conn.executePrepared(stmt_name, n_params, param_values, param_lengths, param_formats,
+                                               result_format);
+               },
+               statementIsReadOnly(stmt_name));
+}
+
+PGresult* ConnectionPool::executeParams(const std::string& query,
+                                        int n_params,
+                                        const char* const* param_values) {
+    return run([&](size_t, DatabaseConnection& conn, bool* sent) {
+                   *sent = conn.isConnected();
+                   return conn.executeParams(query, n_params, param_values);
+               },
+               isReadOnlySql(query));
+}
+
+bool ConnectionPool::executePipeline(const PipelineBatch& batch, PipelineResults& results) {
+    size_t slot = 0;
+    if (pinnedSlot(&slot)) {
+        return ensurePrepared(slot, batch) && slots_[slot].conn->executePipeline(batch, results);
+    }
+    for (int attempt = 0;; ++attempt) {
+        Lease lease = acquire();
+        if (!lease) {
+            t_last_error = "No database connection available";
+            return false;
+        }
+        if (!ensurePrepared(lease.slot_, batch)) {
+            // Nothing of the batch itself was sent yet
+            t_last_error = lease->getLastError();
+            if (lease->isConnected() || attempt > 0) {
+                return false;
+            }
+        } else if (lease->executePipeline(batch, results)) {
+            return true;
+        } else {
+            t_last_error = lease->getLastError();
+            if (lease->isConnected() || attempt > 0 || !batchIsReadOnly(batch)) {
+                return false;
+            }
+        }
+        Logger::getInstance().warning("PostgreSQL pool: connection lost, retrying pipeline on a fresh connection");
+    }
+}
+
+bool ConnectionPool::statementIsReadOnly(const std::string& stmt_name) const {
+    std::shared_lock<std::shared_mutex> lock(registry_mutex_);
+    auto it = registry_index_.find(stmt_name);
+    return it != registry_index_.end() && registry_[it->second].read_only;
+}
+
+bool ConnectionPool::batchIsReadOnly(const PipelineBatch& batch) const {
+    for (const auto& query : batch.queries()) {
+        switch (query.kind) {
+            case PipelineBatch::Kind::Prepared:
+                if (!statementIsReadOnly(query.text)) {
+                    return false;
+                }
+                break;
+            case PipelineBatch::Kind::Params:
+                if (!isReadOnlySql(query.text)) {
+                    return false;
+                }
+                break;
+            case PipelineBatch::Kind::Prepare:
+                break;
+        }
+    }
+    return true;
+}
+
+bool ConnectionPool::preparePipeline(const Lease& lease, const PipelineBatch& batch) {
+    return lease.pool_ == this && ensurePrepared(lease.slot_, batch);
+}
+
+void ConnectionPool::registerLocked(const std::string& stmt_name, const std::string& query) {
+    auto it = registry_index_.find(stmt_name);
+    if (it == registry_index_.end()) {
+        registry_index_.emplace(stmt_name, registry_.size());
+        registry_.push_back(Statement{stmt_name, query, 1, isReadOnlySql(query)});
+        registry_epoch_++;
+        return;
+    }
+    Statement& stmt = registry_[it->second];
+    if (stmt.query != query) {
+        stmt.query = query;
+        stmt.read_only = isReadOnlySql(query);
+        stmt.version++;
+        registry_epoch_++;
+    }
+}
+
+void ConnectionPool::registerStatements(const PreparedStatementDef* statements, size_t count) {
+    std::unique_lock<std::shared_mutex> lock(registry_mutex_);
+    registry_.reserve(registry_.size() + count);
+    registry_index_.reserve(registry_index_.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        registerLocked(statements[i].name, statements[i].sql);
+    }
+}
+
+void ConnectionPool::prepareStatement(const std::string& stmt_name, const std::string& query) {
+    std::unique_lock<std::shared_mutex> lock(registry_mutex_);
+    registerLocked(stmt_name, query);
+}
+
+void ConnectionPool::prepareAll() {
+    size_t statements = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(registry_mutex_);
+        statements = registry_.size();
+    }
+    if (!config_.eager_prepare) {
+        Logger::getInstance().info("PostgreSQL pool: " + std::to_string(statements) +
+                                   " statements registered, each is prepared on first use per connection");
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<Lease> leases;
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        bool ok = false;
+        const size_t slot = checkout(std::chrono::milliseconds(0), &ok);
+        if (!ok) {
+            break;
+        }
+        leases.push_back(Lease(this, slot, false));
+    }
+    std::vector<std::thread> workers;
+    for (const auto& lease : leases) {
+        const size_t slot = lease.slot_;
+        workers.emplace_back([this, slot]() { prepareSlot(slot); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    Logger::getInstance().info("PostgreSQL pool: prepared " + std::to_string(statements) + " statements on " +
+                               std::to_string(leases.size()) + " connections in " +
+                               std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   std::chrono::steady_clock::now() - start).count()) + " ms");
+}
+
+std::string ConnectionPool::getLastError() const {
+    return t_last_error;
+}
+
+ConnectionPoolStats ConnectionPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ConnectionPoolStats out = stats_;
+    out.size = slots_.size();
+    out.idle = idle_.size();
+    return out;
+}
+
+void ConnectionPool::healthLoop() {
+    ConnectionPoolStats last = stats();
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            health_cv_.wait_for(lock, config_.health_check_interval, [this]() { return stopping_; });
+            if (stopping_) {
+                return;
+            }
+        }
+
+        // Ping idle connections one at a time so requests never wait on the check
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = std::find(idle_.begin(), idle_.end(), i);
+                if (stopping_ || it == idle_.end()) {
+                    continue;
+                }
+                idle_.erase(it);
+                slots_[i].in_use = true;
+            }
+            if (!slots_[i].conn->ping()) {
+                Logger::getInstance().warning("PostgreSQL pool: connection " + std::to_string(i) +
+                                              " failed health check, reconnecting");
+                if (reconnectSlot(i)) {
+                    prepareSlot(i);
+                }
+            }
+            release(i);
+        }
+
+        const ConnectionPoolStats now = stats();
+        const uint64_t waited = now.waited - last.waited;
+        const uint64_t timeouts = now.timeouts - last.timeouts;
+        if (waited > 0 || timeouts > 0) {
+            const uint64_t avg_us = waited > 0 ? (now.total_wait_us - last.total_wait_us) / waited : 0;
+            const std::string line = "PostgreSQL pool: " + std::to_string(waited) + " of " +
+                std::to_string(now.checkouts - last.checkouts) + " checkouts waited (avg " +
+                std::to_string(avg_us) + " us, max so far " + std::to_string(now.max_wait_us) + " us), " +
+                std::to_string(timeouts) + " timed out";
+            if (timeouts > 0) {
+                Logger::getInstance().warning(line);
+            } else {
+                Logger::getInstance().info(line);
+            }
+        }
+        last = now;
+    }
+}
+
+} // namespace xipher
@@ -1,6 +1,8 @@
 #include "../include/database/db_connection.hpp"
 #include "../include/utils/logger.hpp"
 #include <cstring>
+#include <cerrno>
+#include <poll.h>
 
 namespace xipher {
 
@@ -30,7 +32,7 @@ bool DatabaseConnection::connect() {
         return false;
     }
     
-    Logger::getInstance().info("Connected to PostgreSQL database");
+    XIPHER_LOG_DEBUG("Connected to PostgreSQL database");
     return true;
 }
 
@@ -42,10 +44,37 @@ void DatabaseConnection::disconnect() {
 }
 
 bool DatabaseConnection::isConnected() const {
-    return conn_ != nullptr && PQstatus(conn_) == CONNECTION_OK;
+    return conn_ != nullptr && !needs_reset_ && PQstatus(conn_) == CONNECTION_OK;
+}
+
+bool DatabaseConnection::reconnect() {
+    std::lock_guard<std::mutex> lock(exec_mutex_);
+    if (!conn_) {
+        return connect();
+    }
+    PQreset(conn_);
+    if (PQstatus(conn_) != CONNECTION_OK) {
+        logError();
+        return false;
+    }
+    needs_reset_ = false;
+    Logger::getInstance().info("Reconnected to PostgreSQL database");
+    return true;
+}
+
+bool DatabaseConnection::ping() {
+    std::lock_guard<std::mutex> lock(exec_mutex_);
+    if (!isConnected()) {
+        return false;
+    }
+    PGresult* res = PQexec(conn_, "");
+    const bool ok = res && PQresultStatus(res) == PGRES_EMPTY_QUERY;
+    PQclear(res);
+    return ok && isConnected();
 }
 
 PGresult* DatabaseConnection::executeQuery(const std::string& query) {
+    std::lock_guard<std::mutex> lock(exec_mutex_);
     if (!isConnected()) {
         Logger::getInstance().error("Database not connected");
         return nullptr;
@@ -65,28 +94,25 @@ PGresult* DatabaseConnection::executeQuery(const std::string& query) {
 PGresult* DatabaseConnection::executePrepared(const std::string& stmt_name,
                                              int n_params,
                                              const char* const* param_values) {
+    // Text parameters: libpq takes their lengths from the terminating NUL
+    // and a null pointer as SQL NULL, so no length/format arrays are needed.
+    return executePrepared(stmt_name, n_params, param_values, nullptr, nullptr, PgFormat::Text);
+}
+
+PGresult* DatabaseConnection::executePrepared(const std::string& stmt_name,
+                                             int n_params,
+                                             const char* const* param_values,
+                                             const int* param_lengths,
+                                             const int* param_formats,
+                                             PgFormat result_format) {
+    std::lock_guard<std::mutex> lock(exec_mutex_);
     if (!isConnected()) {
         Logger::getInstance().error("Database not connected");
         return nullptr;
     }
     
-    // Создаем массивы для длин параметров (нужны для NULL значений)
-    int* param_lengths = new int[n_params];
-    int* param_formats = new int[n_params];
-    
-    for (int i = 0; i < n_params; i++) {
-        if (param_values[i] == nullptr) {
-            param_lengths[i] = -1;  // -1 означает NULL значение в PostgreSQL
-        } else {
-            param_lengths[i] = strlen(param_values[i]);
-        }
-        param_formats[i] = 0;  // 0 = text format, 1 = binary format
-    }
-    
-    PGresult* res = PQexecPrepared(conn_, stmt_name.c_str(), n_params, param_values, param_lengths, param_formats, 0);
-    
-    delete[] param_lengths;
-    delete[] param_formats;
+    PGresult* res = PQexecPrepared(conn_, stmt_name.c_str(), n_params, param_values, param_lengths, param_formats,
+                                   static_cast<int>(result_format));
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK && PQresultStatus(res) != PGRES_TUPLES_OK) {
         std::string error_msg = PQresultErrorMessage(res) ? PQresultErrorMessage(res) : "Unknown error";
@@ -98,9 +124,155 @@ PGresult* DatabaseConnection::executePrepared(const std::string& stmt_name,
     return res;
 }
 
+PGresult* DatabaseConnection::executeParams(const std::string& query,
+                                           int n_params,
+                                           const char* const* param_values) {
+    std::lock_guard<std::mutex> lock(exec_mutex_);
+    if (!isConnected()) {
+        Logger::getInstance().error("Database not connected");
+        return nullptr;
+    }
+    return PQexecParams(conn_, query.c_str(), n_params, nullptr, param_values, nullptr, nullptr, 0);
+}
+
+bool DatabaseConnection::beginPipeline(const PipelineBatch& batch, PipelineResults& results) {
+    if (!isConnected()) {
+        Logger::getInstance().error("Database not connected");
+        return false;
+    }
+    results.clear();
+    results.resize(batch.size());
+    pipeline_cursor_ = 0;
+    // Non-blocking sends so a large batch cannot deadlock against the
+    // server filling its own output buffer.
+    if (PQsetnonblocking(conn_, 1) != 0 || PQenterPipelineMode(conn_) != 1) {
+        logError();
+        PQsetnonblocking(conn_, 0);
+        return false;
+    }
+    std::vector<const char*> values;
+    for (const auto& query : batch.queries()) {
+        if (query.kind == PipelineBatch::Kind::Prepare) {
+            if (query.params.empty() ||
+                PQsendPrepare(conn_, query.text.c_str(), query.params[0].c_str(), 0, nullptr) != 1) {
+                logError();
+                endPipeline();
+                return false;
+            }
+            continue;
+        }
+        values.clear();
+        for (const auto& param : query.params) {
+            values.push_back(param.c_str());
+        }
+        const int n_params = static_cast<int>(values.size());
+        const char* const* param_values = values.empty() ? nullptr : values.data();
+        const int sent = query.kind == PipelineBatch::Kind::Prepared
+            ? PQsendQueryPrepared(conn_, query.text.c_str(), n_params, param_values, nullptr, nullptr, 0)
+            : PQsendQueryParams(conn_, query.text.c_str(), n_params, nullptr, param_values, nullptr, nullptr, 0);
+        if (sent != 1) {
+            logError();
+            endPipeline();
+            return false;
+        }
+    }
+    if (PQpipelineSync(conn_) != 1) {
+        logError();
+        endPipeline();
+        return false;
+    }
+    return true;
+}
+
+int DatabaseConnection::flushPipeline() {
+    return PQflush(conn_);
+}
+
+bool DatabaseConnection::consumePipeline(PipelineResults& results, bool* done) {
+    *done = false;
+    if (PQconsumeInput(conn_) != 1) {
+        logError();
+        return false;
+    }
+    while (!PQisBusy(conn_)) {
+        PGresult* res = PQgetResult(conn_);
+        if (!res) {
+            // End of the current query's results
+            pipeline_cursor_++;
+            continue;
+        }
+        if (PQresultStatus(res) == PGRES_PIPELINE_SYNC) {
+            PQclear(res);
+            *done = true;
+            return true;
+        }
+        if (pipeline_cursor_ < results.size() && !results[pipeline_cursor_]) {
+            if (PQresultStatus(res) == PGRES_FATAL_ERROR) {
+                Logger::getInstance().error("PostgreSQL pipeline query " + std::to_string(pipeline_cursor_) +
+                                            " failed: " + std::string(PQresultErrorMessage(res)));
+            }
+            results[pipeline_cursor_].reset(res);
+        } else {
+            PQclear(res);
+        }
+    }
+    return true;
+}
+
+void DatabaseConnection::endPipeline() {
+    if (PQpipelineStatus(conn_) != PQ_PIPELINE_OFF && PQexitPipelineMode(conn_) != 1) {
+        // Results are still pending (the batch failed half-sent or half-read),
+        // so the connection is not usable for the next statement. Draining
+        // them could block on a connection that already failed; the pool
+        // reconnects it before handing it out again instead.
+        Logger::getInstance().warning("PostgreSQL: pipeline aborted with results pending, connection will be reset");
+        needs_reset_ = true;
+    }
+    PQsetnonblocking(conn_, 0);
+}
+
+bool DatabaseConnection::executePipeline(const PipelineBatch& batch, PipelineResults& results) {
+    std::lock_guard<std::mutex> lock(exec_mutex_);
+    if (batch.empty()) {
+        results.clear();
+        return true;
+    }
+    if (!beginPipeline(batch, results)) {
+        return false;
+    }
+    for (;;) {
+        const int flushed = flushPipeline();
+        if (flushed < 0) {
+            logError();
+            endPipeline();
+            return false;
+        }
+        // A flush may already have pulled the replies into libpq's buffer,
+        // after which the socket would not report them as readable
+        bool done = false;
+        if (!consumePipeline(results, &done)) {
+            endPipeline();
+            return false;
+        }
+        if (done) {
+            break;
+        }
+        pollfd pfd{};
+        pfd.fd = socket();
+        pfd.events = static_cast<short>(POLLIN | (flushed == 1 ? POLLOUT : 0));
+        if (::poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+            endPipeline();
+            return false;
+        }
+    }
+    endPipeline();
+    return true;
+}
+
 void DatabaseConnection::prepareStatement(const std::string& stmt_name, const std::string& query) {
     // Log preparation attempt for debugging
     Logger::getInstance().info("Preparing statement: " + stmt_name);
+    std::lock_guard<std::mutex> lock(exec_mutex_);
     if (!isConnected()) {
         Logger::getInstance().error("Database not connected");
         return;
@@ -111,36 +283,36 @@ void DatabaseConnection::prepareStatement(const std::string& stmt_name, const st
     PGresult* dealloc_res = PQexec(conn_, deallocate.c_str());
     PQclear(dealloc_res); // Игнорируем ошибку, если statement не существует
     
-    // Подсчитываем количество параметров ($1, $2, ...)
-    int param_count = 0;
-    size_t pos = 0;
-    while ((pos = query.find('$', pos)) != std::string::npos) {
-        pos++;
-        if (pos < query.length() && std::isdigit(query[pos])) {
-            int num = 0;
-            while (pos < query.length() && std::isdigit(query[pos])) {
-                num = num * 10 + (query[pos] - '0');
-                pos++;
-            }
-            if (num > param_count) param_count = num;
-        }
+    prepareLocked(stmt_name, query);
+}
+
+bool DatabaseConnection::prepare(const std::string& stmt_name, const std::string& query) {
+    std::lock_guard<std::mutex> lock(exec_mutex_);
+    if (!isConnected()) {
+        Logger::getInstance().error("Database not connected");
+        return false;
     }
+    return prepareLocked(stmt_name, query);
+}
+
+bool DatabaseConnection::prepareLocked(const std::string& stmt_name, const std::string& query) {
+    // nParams = 0: the server infers the parameter count and types from the SQL
+    PGresult* res = PQprepare(conn_, stmt_name.c_str(), query.c_str(), 0, nullptr);
     
-    // Теперь создаем statement с правильным количеством параметров
-    PGresult* res = PQprepare(conn_, stmt_name.c_str(), query.c_str(), param_count, nullptr);
-    
-    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+    const bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (!ok) {
         std::string error = PQerrorMessage(conn_);
-        Logger::getInstance().error("Failed to prepare statement '" + stmt_name + "' with " + std::to_string(param_count) + " params: " + error);
+        Logger::getInstance().error("Failed to prepare statement '" + stmt_name + "': " + error);
         // Игнорируем ошибку "already exists", это нормально
         if (error.find("already exists") == std::string::npos && error.find("does not exist") == std::string::npos) {
             logError();
         }
     } else {
-        Logger::getInstance().info("Successfully prepared statement '" + stmt_name + "' with " + std::to_string(param_count) + " parameters");
+        XIPHER_LOG_DEBUG("Successfully prepared statement '" + stmt_name + "'");
     }
     
     PQclear(res);
+    return ok;
 }
 
 std::string DatabaseConnection::getLastError() const {
@@ -1,36 +1,262 @@
 #include "../include/database/db_manager.hpp"
+#include "../include/database/db_rows.hpp"
+#include "../include/database/db_statements.hpp"
+#include "../include/utils/env.hpp"
 #include "../include/utils/logger.hpp"
 #include "../include/utils/json_parser.hpp"
 #include <sstream>
+#include <cctype>
 #include <cstring>
 #include <cstdlib>
+#include <unordered_map>
 #include <utility>
 #include <stdexcept>
 #include <cstdint>
+#include <chrono>
+#include <thread>
 
 namespace xipher {
 
 namespace {
 constexpr uint64_t kAllAdminPerms = 0xFFu; // owner full permissions
+
+// Number of the last migration in DatabaseManager::migrateSchema()
+constexpr int kSchemaVersion = 5;
+// pg_advisory_lock key held while migrating
+constexpr int64_t kMigrationLockKey = 0x78697068u;
+constexpr std::chrono::milliseconds kMigrationLockPoll{500};
+
+bool isSearchWordByte(char c) {
+    const unsigned char byte = static_cast<unsigned char>(c);
+    return byte >= 0x80 || std::isalnum(byte);
+}
+
+// Entries per entity cache (0 disables them) and their TTL
+size_t entityCacheCapacity() {
+    return readEnvSize("XIPHER_ENTITY_CACHE_SIZE", 10000);
+}
+
+// Entries per membership cache; they share the entity TTL
+size_t membershipCacheCapacity() {
+    return readEnvSize("XIPHER_MEMBERSHIP_CACHE_SIZE", 50000);
+}
+
+std::chrono::milliseconds entityCacheTtl() {
+    const char* raw = std::getenv("XIPHER_ENTITY_CACHE_TTL_SEC");
+    long seconds = 60;
+    if (raw && *raw) {
+        char* end = nullptr;
+        const long value = std::strtol(raw, &end, 10);
+        if (end && *end == '\0' && value > 0) {
+            seconds = value;
+        }
+    }
+    return std::chrono::seconds(seconds);
+}
+
+long long elapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count());
+}
 }
 
 DatabaseManager::DatabaseManager(const std::string& host,
                                 const std::string& port,
                                 const std::string& dbname,
                                 const std::string& user,
-                                const std::string& password) {
-    db_ = std::make_unique<DatabaseConnection>(host, port, dbname, user, password);
+                                const std::string& password,
+                                size_t pool_size)
+    : user_cache_(entityCacheCapacity(), entityCacheTtl()),
+      profile_cache_(entityCacheCapacity(), entityCacheTtl()),
+      privacy_cache_(entityCacheCapacity(), entityCacheTtl()),
+      public_user_cache_(entityCacheCapacity(), entityCacheTtl()),
+      chat_permission_cache_(membershipCacheCapacity(), entityCacheTtl()),
+      group_member_cache_(membershipCacheCapacity(), entityCacheTtl()),
+      channel_member_cache_(membershipCacheCapacity(), entityCacheTtl()) {
+    db_ = std::make_unique<ConnectionPool>(host, port, dbname, user, password,
+                                           ConnectionPool::configFromEnv(pool_size));
+    presence_ = std::make_unique<PresenceTracker>(*db_, PresenceTracker::configFromEnv());
 }
 
 bool DatabaseManager::initialize() {
+    const auto start = std::chrono::steady_clock::now();
     if (!db_->connect()) {
         Logger::getInstance().error("Failed to connect to database");
         return false;
     }
+    const auto connected = std::chrono::steady_clock::now();
+
+    migrateSchema();
+    const auto migrated = std::chrono::steady_clock::now();
+
+    prepareStatements();
+    db_->prepareAll();
+    presence_->start();
+    const auto ready = std::chrono::steady_clock::now();
+
+    Logger::getInstance().info("Database initialized in " + std::to_string(elapsedMs(start, ready)) +
+                               " ms (connect " + std::to_string(elapsedMs(start, connected)) +
+                               " ms, schema " + std::to_string(elapsedMs(connected, migrated)) +
+                               " ms, statements " + std::to_string(elapsedMs(migrated, ready)) + " ms)");
+    return true;
+}
+
+bool DatabaseManager::migrateSchema() {
+    // Fast path: the schema is current, so no DDL and no lock
+    const int current = schemaVersion();
+    if (current >= kSchemaVersion) {
+        XIPHER_LOG_DEBUG("Database schema is up to date (version " + std::to_string(current) + ")");
+        return true;
+    }
+
+    // Everything below runs on one connection, which holds the advisory
+    // lock so that instances starting together migrate one at a time.
+    ConnectionPool::Lease lease = db_->pin();
+    if (!lease) {
+        Logger::getInstance().error("Schema migration: no database connection available");
+        return false;
+    }
+    // Polled rather than waited for inside pg_advisory_lock(): a waiting
+    // statement holds a snapshot, and CREATE INDEX CONCURRENTLY in the
+    // instance that has the lock would wait for it in turn.
+    const std::string try_lock = "SELECT pg_try_advisory_lock(" + std::to_string(kMigrationLockKey) + ")";
+    for (bool waiting = false;; waiting = true) {
+        PGresult* lock = db_->executeQuery(try_lock);
+        if (!lock) {
+            Logger::getInstance().error("Schema migration: could not take the migration lock: " + db_->getLastError());
+            return false;
+        }
+        const bool locked = pgScalar<bool>(lock, false);
+        PQclear(lock);
+        if (locked) {
+            break;
+        }
+        if (!waiting) {
+            Logger::getInstance().info("Schema migration: waiting for another instance to finish migrating");
+        }
+        std::this_thread::sleep_for(kMigrationLockPoll);
+    }
+
+    PGresult* table = db_->executeQuery(
+        "CREATE TABLE IF NOT EXISTS schema_migrations ("
+        "version INTEGER PRIMARY KEY, "
+        "applied_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT CURRENT_TIMESTAMP)");
+    if (table) PQclear(table);
+
+    // Another instance may have migrated while we waited for the lock
+    const int from = schemaVersion();
+    struct Migration {
+        int version;
+        bool (DatabaseManager::*apply)();
+    };
+    const Migration migrations[] = {
+        {1, &DatabaseManager::migrateBaselineSchema},
+        {2, &DatabaseManager::migrateChatListIndexes},
+        {3, &DatabaseManager::migrateKeysetIndexes},
+        {4, &DatabaseManager::migrateSearchIndexes},
+        {5, &DatabaseManager::migrateRevokedSessions},
+    };
+    static_assert(sizeof(migrations) / sizeof(migrations[0]) == kSchemaVersion,
+                  "kSchemaVersion must be the number of the last migration");
+
+    // Steps are idempotent and all of them run, as they did before
+    // versioning. A version is recorded only when it and every earlier one
+    // succeeded, so a failed step is retried on the next start.
+    int recorded = from;
+    bool complete = true;
+    for (const auto& migration : migrations) {
+        if (migration.version <= from) {
+            continue;
+        }
+        if (!(this->*migration.apply)()) {
+            Logger::getInstance().warning("Schema migration " + std::to_string(migration.version) +
+                                          " did not complete, it will be retried on the next start");
+            complete = false;
+        }
+        if (!complete) {
+            continue;
+        }
+        const std::string version = std::to_string(migration.version);
+        const char* param_values[1] = {version.c_str()};
+        PGresult* res = db_->executeParams(
+            "INSERT INTO schema_migrations (version) VALUES ($1::int) ON CONFLICT (version) DO NOTHING",
+            1, param_values);
+        if (res && PQresultStatus(res) == PGRES_COMMAND_OK) {
+            recorded = migration.version;
+        } else {
+            complete = false;
+        }
+        if (res) PQclear(res);
+    }
+
+    PGresult* unlock = db_->executeQuery("SELECT pg_advisory_unlock(" + std::to_string(kMigrationLockKey) + ")");
+    if (unlock) PQclear(unlock);
+
+    Logger::getInstance().info("Database schema migrated from version " + std::to_string(from) + " to " +
+                               std::to_string(recorded) + " (latest " + std::to_string(kSchemaVersion) + ")");
+    return recorded >= kSchemaVersion;
+}
+
+int DatabaseManager::schemaVersion() {
+    PGresult* exists = db_->executeQuery("SELECT to_regclass('schema_migrations') IS NOT NULL");
+    const bool has_table = pgScalar<bool>(exists, false);
+    if (exists) PQclear(exists);
+    if (!has_table) {
+        return 0;
+    }
+    PGresult* res = db_->executeQuery("SELECT COALESCE(MAX(version), 0) FROM schema_migrations");
+    const int version = pgScalar<int>(res, 0);
+    if (res) PQclear(res);
+    return version;
+}
+
+bool DatabaseManager::createIndexConcurrently(const std::string& name, const std::string& definition) {
+    // Missing, valid, or INVALID (left by an interrupted concurrent build)
+    auto state = [&](bool* exists) {
+        const char* param_values[1] = {name.c_str()};
+        PGresult* res = db_->executeParams(
+            "SELECT indisvalid FROM pg_index WHERE indexrelid = to_regclass($1)", 1, param_values);
+        const bool ok = res && PQresultStatus(res) == PGRES_TUPLES_OK;
+        *exists = ok && PQntuples(res) > 0;
+        const bool valid = *exists && PQgetvalue(res, 0, 0)[0] == 't';
+        if (res) PQclear(res);
+        return valid;
+    };
+
+    bool exists = false;
+    if (state(&exists)) {
+        return true;
+    }
+    if (exists) {
+        // IF NOT EXISTS would keep the broken index, so build it again
+        Logger::getInstance().warning("Schema migration: rebuilding invalid index " + name);
+        PGresult* drop = db_->executeQuery("DROP INDEX CONCURRENTLY IF EXISTS " + name);
+        if (!drop) {
+            return false;
+        }
+        PQclear(drop);
+    }
+    PGresult* res = db_->executeQuery("CREATE INDEX CONCURRENTLY IF NOT EXISTS " + name + " " + definition);
+    if (!res) {
+        return false;
+    }
+    PQclear(res);
+    return state(&exists);
+}
+
+// Migration 1: the DDL initialize() used to run on every start
+bool DatabaseManager::migrateBaselineSchema() {
+    bool ok = true;
+    auto exec = [&](const std::string& sql) {
+        PGresult* res = db_->executeQuery(sql);
+        if (!res) {
+            ok = false;
+        }
+        return res;
+    };
 
     // Make sure saved messages (self-chat) are allowed even if the DB was created
     // before the dedicated migration was applied.
-    PGresult* savedMsgConstraint = db_->executeQuery("ALTER TABLE messages DROP CONSTRAINT IF EXISTS no_self_message");
+    PGresult* savedMsgConstraint = exec("ALTER TABLE messages DROP CONSTRAINT IF EXISTS no_self_message");
     if (!savedMsgConstraint) {
         Logger::getInstance().warning("Could not drop no_self_message constraint (it may already be absent): " + db_->getLastError());
     } else {
@@ -38,7 +264,7 @@ bool DatabaseManager::initialize() {
         Logger::getInstance().info("Ensured no_self_message constraint is dropped for saved messages support");
     }
 
-    PGresult* messageTypeConstraint = db_->executeQuery(
+    PGresult* messageTypeConstraint = exec(
         "DO $$ "
         "DECLARE c record; "
         "BEGIN "
@@ -66,7 +292,7 @@ bool DatabaseManager::initialize() {
     }
 
     // v2 pinned message support (non-destructive). We try to create it only if v2 core tables exist.
-    PGresult* pinsTable = db_->executeQuery(
+    PGresult* pinsTable = exec(
         "DO $$ BEGIN "
         "IF to_regclass('public.chats') IS NOT NULL AND to_regclass('public.chat_messages') IS NOT NULL THEN "
         "EXECUTE 'CREATE TABLE IF NOT EXISTS chat_pins ("
@@ -83,7 +309,7 @@ bool DatabaseManager::initialize() {
         PQclear(pinsTable);
     }
 
-    PGresult* chatPinsTable = db_->executeQuery(
+    PGresult* chatPinsTable = exec(
         "CREATE TABLE IF NOT EXISTS user_chat_pins ("
         "  user_id UUID NOT NULL REFERENCES users(id) ON DELETE CASCADE,"
         "  chat_type VARCHAR(16) NOT NULL,"
@@ -96,11 +322,11 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(chatPinsTable);
     }
-    PGresult* chatPinsIdx = db_->executeQuery(
+    PGresult* chatPinsIdx = exec(
         "CREATE INDEX IF NOT EXISTS idx_user_chat_pins_user ON user_chat_pins (user_id)");
     if (chatPinsIdx) PQclear(chatPinsIdx);
 
-    PGresult* chatFoldersTable = db_->executeQuery(
+    PGresult* chatFoldersTable = exec(
         "CREATE TABLE IF NOT EXISTS user_chat_folders ("
         "  user_id UUID PRIMARY KEY REFERENCES users(id) ON DELETE CASCADE,"
         "  folders JSONB NOT NULL DEFAULT '[]'::jsonb,"
@@ -112,7 +338,7 @@ bool DatabaseManager::initialize() {
         PQclear(chatFoldersTable);
     }
 
-    PGresult* linkedChannelCol = db_->executeQuery(
+    PGresult* linkedChannelCol = exec(
         "ALTER TABLE IF EXISTS user_profiles "
         "ADD COLUMN IF NOT EXISTS linked_channel_id UUID");
     if (!linkedChannelCol) {
@@ -121,7 +347,7 @@ bool DatabaseManager::initialize() {
         PQclear(linkedChannelCol);
     }
 
-    PGresult* businessHoursCol = db_->executeQuery(
+    PGresult* businessHoursCol = exec(
         "ALTER TABLE IF EXISTS user_profiles "
         "ADD COLUMN IF NOT EXISTS business_hours_json JSONB");
     if (!businessHoursCol) {
@@ -130,7 +356,7 @@ bool DatabaseManager::initialize() {
         PQclear(businessHoursCol);
     }
 
-    PGresult* legacyChannelAvatarCol = db_->executeQuery(
+    PGresult* legacyChannelAvatarCol = exec(
         "ALTER TABLE IF EXISTS channels "
         "ADD COLUMN IF NOT EXISTS avatar_url VARCHAR(500)");
     if (!legacyChannelAvatarCol) {
@@ -139,7 +365,7 @@ bool DatabaseManager::initialize() {
         PQclear(legacyChannelAvatarCol);
     }
 
-    PGresult* chatAvatarCol = db_->executeQuery(
+    PGresult* chatAvatarCol = exec(
         "DO $$ BEGIN "
         "IF to_regclass('public.chats') IS NOT NULL THEN "
         "EXECUTE 'ALTER TABLE chats ADD COLUMN IF NOT EXISTS avatar_url VARCHAR(500)'; "
@@ -152,7 +378,7 @@ bool DatabaseManager::initialize() {
     }
 
     // Add is_verified column to chats table for verified channels
-    PGresult* chatVerifiedCol = db_->executeQuery(
+    PGresult* chatVerifiedCol = exec(
         "DO $$ BEGIN "
         "IF to_regclass('public.chats') IS NOT NULL THEN "
         "EXECUTE 'ALTER TABLE chats ADD COLUMN IF NOT EXISTS is_verified BOOLEAN DEFAULT FALSE'; "
@@ -164,7 +390,7 @@ bool DatabaseManager::initialize() {
         PQclear(chatVerifiedCol);
     }
 
-    PGresult* chatJoinRequestsTable = db_->executeQuery(
+    PGresult* chatJoinRequestsTable = exec(
         "DO $$ BEGIN "
         "IF to_regclass('public.chats') IS NOT NULL THEN "
         "EXECUTE 'CREATE TABLE IF NOT EXISTS chat_join_requests ("
@@ -184,7 +410,7 @@ bool DatabaseManager::initialize() {
         PQclear(chatJoinRequestsTable);
     }
 
-    PGresult* chatAllowedReactionsTable = db_->executeQuery(
+    PGresult* chatAllowedReactionsTable = exec(
         "DO $$ BEGIN "
         "IF to_regclass('public.chats') IS NOT NULL THEN "
         "EXECUTE 'CREATE TABLE IF NOT EXISTS chat_allowed_reactions ("
@@ -202,7 +428,7 @@ bool DatabaseManager::initialize() {
         PQclear(chatAllowedReactionsTable);
     }
 
-    PGresult* chatInviteLinksTable = db_->executeQuery(
+    PGresult* chatInviteLinksTable = exec(
         "DO $$ BEGIN "
         "IF to_regclass('public.chats') IS NOT NULL THEN "
         "EXECUTE 'CREATE TABLE IF NOT EXISTS chat_invite_links ("
@@ -228,7 +454,7 @@ bool DatabaseManager::initialize() {
     // Bot Builder: profile fields (non-destructive).
     // Use ALTER TABLE IF EXISTS to avoid failing on older deployments that don't have bot_builder_bots.
     // NOTE: keep these statements simple (no DO/EXECUTE quoting) to avoid migration syntax issues.
-    PGresult* botBuilderCol1 = db_->executeQuery(
+    PGresult* botBuilderCol1 = exec(
         "ALTER TABLE IF EXISTS bot_builder_bots "
         "ADD COLUMN IF NOT EXISTS bot_description TEXT DEFAULT ''");
     if (!botBuilderCol1) {
@@ -236,7 +462,7 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(botBuilderCol1);
     }
-    PGresult* botBuilderCol2 = db_->executeQuery(
+    PGresult* botBuilderCol2 = exec(
         "ALTER TABLE IF EXISTS bot_builder_bots "
         "ADD COLUMN IF NOT EXISTS bot_avatar_url VARCHAR(500) DEFAULT ''");
     if (!botBuilderCol2) {
@@ -244,7 +470,7 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(botBuilderCol2);
     }
-    PGresult* botBuilderCol3 = db_->executeQuery(
+    PGresult* botBuilderCol3 = exec(
         "ALTER TABLE IF EXISTS bot_builder_bots "
         "ADD COLUMN IF NOT EXISTS bot_user_id UUID");
     if (!botBuilderCol3) {
@@ -254,7 +480,7 @@ bool DatabaseManager::initialize() {
     }
 
     // Bot Builder: bot scripts (Python) (non-destructive)
-    PGresult* botScriptCol1 = db_->executeQuery(
+    PGresult* botScriptCol1 = exec(
         "ALTER TABLE IF EXISTS bot_builder_bots "
         "ADD COLUMN IF NOT EXISTS script_lang VARCHAR(16) DEFAULT 'lite'");
     if (!botScriptCol1) {
@@ -262,7 +488,7 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(botScriptCol1);
     }
-    PGresult* botScriptCol2 = db_->executeQuery(
+    PGresult* botScriptCol2 = exec(
         "ALTER TABLE IF EXISTS bot_builder_bots "
         "ADD COLUMN IF NOT EXISTS script_enabled BOOLEAN DEFAULT FALSE");
     if (!botScriptCol2) {
@@ -270,7 +496,7 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(botScriptCol2);
     }
-    PGresult* botScriptCol3 = db_->executeQuery(
+    PGresult* botScriptCol3 = exec(
         "ALTER TABLE IF EXISTS bot_builder_bots "
         "ADD COLUMN IF NOT EXISTS script_code TEXT DEFAULT ''");
     if (!botScriptCol3) {
@@ -280,7 +506,7 @@ bool DatabaseManager::initialize() {
     }
 
     // Bot runtime tables (non-destructive)
-    PGresult* botNotesTable = db_->executeQuery(
+    PGresult* botNotesTable = exec(
         "CREATE TABLE IF NOT EXISTS bot_notes ("
         "  id uuid PRIMARY KEY DEFAULT uuid_generate_v4(),"
         "  bot_user_id uuid NOT NULL REFERENCES users(id) ON DELETE CASCADE,"
@@ -298,12 +524,12 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(botNotesTable);
     }
-    PGresult* botNotesIdx = db_->executeQuery(
+    PGresult* botNotesIdx = exec(
         "CREATE INDEX IF NOT EXISTS idx_bot_notes_scope "
         "ON bot_notes (bot_user_id, scope_type, scope_id)");
     if (botNotesIdx) PQclear(botNotesIdx);
 
-    PGresult* botRemindersTable = db_->executeQuery(
+    PGresult* botRemindersTable = exec(
         "CREATE TABLE IF NOT EXISTS bot_reminders ("
         "  id uuid PRIMARY KEY DEFAULT uuid_generate_v4(),"
         "  bot_user_id uuid NOT NULL REFERENCES users(id) ON DELETE CASCADE,"
@@ -320,13 +546,13 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(botRemindersTable);
     }
-    PGresult* botRemindersIdx = db_->executeQuery(
+    PGresult* botRemindersIdx = exec(
         "CREATE INDEX IF NOT EXISTS idx_bot_reminders_due "
         "ON bot_reminders (due_at) WHERE sent_at IS NULL");
     if (botRemindersIdx) PQclear(botRemindersIdx);
 
     // Bot developers (collaboration) table
-    PGresult* botDevelopersTable = db_->executeQuery(
+    PGresult* botDevelopersTable = exec(
         "CREATE TABLE IF NOT EXISTS bot_developers ("
         "  bot_id uuid NOT NULL REFERENCES bot_builder_bots(id) ON DELETE CASCADE,"
         "  developer_user_id uuid NOT NULL REFERENCES users(id) ON DELETE CASCADE,"
@@ -339,17 +565,17 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(botDevelopersTable);
     }
-    PGresult* botDevelopersIdx = db_->executeQuery(
+    PGresult* botDevelopersIdx = exec(
         "CREATE INDEX IF NOT EXISTS idx_bot_developers_bot "
         "ON bot_developers (bot_id)");
     if (botDevelopersIdx) PQclear(botDevelopersIdx);
-    PGresult* botDevelopersUserIdx = db_->executeQuery(
+    PGresult* botDevelopersUserIdx = exec(
         "CREATE INDEX IF NOT EXISTS idx_bot_developers_user "
         "ON bot_developers (developer_user_id)");
     if (botDevelopersUserIdx) PQclear(botDevelopersUserIdx);
 
     // Bot project files (for IDE)
-    PGresult* botFilesTable = db_->executeQuery(
+    PGresult* botFilesTable = exec(
         "CREATE TABLE IF NOT EXISTS bot_files ("
         "  id uuid PRIMARY KEY DEFAULT uuid_generate_v4(),"
         "  bot_id uuid NOT NULL REFERENCES bot_builder_bots(id) ON DELETE CASCADE,"
@@ -364,13 +590,13 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(botFilesTable);
     }
-    PGresult* botFilesIdx = db_->executeQuery(
+    PGresult* botFilesIdx = exec(
         "CREATE INDEX IF NOT EXISTS idx_bot_files_bot "
         "ON bot_files (bot_id)");
     if (botFilesIdx) PQclear(botFilesIdx);
 
     // Messages: reply_markup (inline keyboard buttons) support (non-destructive)
-    PGresult* messagesReplyMarkup = db_->executeQuery(
+    PGresult* messagesReplyMarkup = exec(
         "ALTER TABLE IF EXISTS messages "
         "ADD COLUMN IF NOT EXISTS reply_markup JSONB DEFAULT NULL");
     if (!messagesReplyMarkup) {
@@ -380,7 +606,7 @@ bool DatabaseManager::initialize() {
     }
 
     // Users: is_bot flag (non-destructive). Needed for bot-user backfill below.
-    PGresult* usersBotCol = db_->executeQuery(
+    PGresult* usersBotCol = exec(
         "ALTER TABLE users "
         "ADD COLUMN IF NOT EXISTS is_bot BOOLEAN DEFAULT FALSE");
     if (!usersBotCol) {
@@ -389,7 +615,7 @@ bool DatabaseManager::initialize() {
         PQclear(usersBotCol);
     }
 
-    PGresult* usersPremiumCols = db_->executeQuery(
+    PGresult* usersPremiumCols = exec(
         "ALTER TABLE users "
         "ADD COLUMN IF NOT EXISTS is_premium BOOLEAN DEFAULT FALSE, "
         "ADD COLUMN IF NOT EXISTS premium_plan VARCHAR(16) DEFAULT '', "
@@ -400,7 +626,7 @@ bool DatabaseManager::initialize() {
         PQclear(usersPremiumCols);
     }
 
-    PGresult* premiumPaymentsTable = db_->executeQuery(
+    PGresult* premiumPaymentsTable = exec(
         "CREATE TABLE IF NOT EXISTS premium_payments ("
         "  id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),"
         "  user_id UUID NOT NULL REFERENCES users(id) ON DELETE CASCADE,"
@@ -418,7 +644,7 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(premiumPaymentsTable);
     }
-    PGresult* premiumPaymentsGiftCol = db_->executeQuery(
+    PGresult* premiumPaymentsGiftCol = exec(
         "ALTER TABLE IF EXISTS premium_payments "
         "ADD COLUMN IF NOT EXISTS gift_receiver_id UUID REFERENCES users(id) ON DELETE SET NULL");
     if (!premiumPaymentsGiftCol) {
@@ -426,14 +652,14 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(premiumPaymentsGiftCol);
     }
-    PGresult* premiumPaymentsIdx = db_->executeQuery(
+    PGresult* premiumPaymentsIdx = exec(
         "CREATE INDEX IF NOT EXISTS idx_premium_payments_user_id ON premium_payments(user_id)");
     if (premiumPaymentsIdx) {
         PQclear(premiumPaymentsIdx);
     }
 
     // Users: admin fields (non-destructive).
-    PGresult* usersAdminCols = db_->executeQuery(
+    PGresult* usersAdminCols = exec(
         "ALTER TABLE users "
         "ADD COLUMN IF NOT EXISTS is_admin BOOLEAN DEFAULT FALSE, "
         "ADD COLUMN IF NOT EXISTS role VARCHAR(32) DEFAULT 'user', "
@@ -446,7 +672,7 @@ bool DatabaseManager::initialize() {
     }
 
     // Admin settings (key/value)
-    PGresult* adminSettingsTable = db_->executeQuery(
+    PGresult* adminSettingsTable = exec(
         "CREATE TABLE IF NOT EXISTS admin_settings ("
         "  key TEXT PRIMARY KEY,"
         "  value TEXT NOT NULL,"
@@ -461,7 +687,7 @@ bool DatabaseManager::initialize() {
     // Backfill bot_user_id for legacy Bot Builder bots (created before bot_user_id existed).
     // We avoid a PL/pgSQL DO block here to prevent subtle quoting/syntax issues across deployments.
     // 1) Link to existing bot users by username
-    PGresult* botBuilderBackfillLink1 = db_->executeQuery(
+    PGresult* botBuilderBackfillLink1 = exec(
         "UPDATE bot_builder_bots b "
         "SET bot_user_id = u.id "
         "FROM users u "
@@ -476,7 +702,7 @@ bool DatabaseManager::initialize() {
     }
 
     // 2) Create missing bot users (only when username is completely free in users table)
-    PGresult* botBuilderBackfillInsert = db_->executeQuery(
+    PGresult* botBuilderBackfillInsert = exec(
         "WITH missing AS ("
         "  SELECT DISTINCT b.bot_username "
         "  FROM bot_builder_bots b "
@@ -495,7 +721,7 @@ bool DatabaseManager::initialize() {
     }
 
     // 3) Link again (for newly inserted users)
-    PGresult* botBuilderBackfillLink2 = db_->executeQuery(
+    PGresult* botBuilderBackfillLink2 = exec(
         "UPDATE bot_builder_bots b "
         "SET bot_user_id = u.id "
         "FROM users u "
@@ -511,7 +737,7 @@ bool DatabaseManager::initialize() {
 
     // Make legacy bots appear in chats list: ensure owner<->bot friendship exists.
     // This is idempotent and safe due to ON CONFLICT DO NOTHING.
-    PGresult* botBuilderFriendBackfill = db_->executeQuery(
+    PGresult* botBuilderFriendBackfill = exec(
         "INSERT INTO friends (user1_id, user2_id) "
         "SELECT LEAST(user_id, bot_user_id), GREATEST(user_id, bot_user_id) "
         "FROM bot_builder_bots "
@@ -523,7 +749,7 @@ bool DatabaseManager::initialize() {
         PQclear(botBuilderFriendBackfill);
     }
 
-    PGresult* pushTokensTable = db_->executeQuery(
+    PGresult* pushTokensTable = exec(
         "CREATE TABLE IF NOT EXISTS user_push_tokens ("
         "  user_id UUID NOT NULL REFERENCES users(id) ON DELETE CASCADE,"
         "  device_token TEXT NOT NULL,"
@@ -537,12 +763,12 @@ bool DatabaseManager::initialize() {
     } else {
         PQclear(pushTokensTable);
     }
-    PGresult* pushTokensIdx = db_->executeQuery(
+    PGresult* pushTokensIdx = exec(
         "CREATE INDEX IF NOT EXISTS idx_user_push_tokens_user "
         "ON user_push_tokens (user_id)");
     if (pushTokensIdx) PQclear(pushTokensIdx);
 
-    PGresult* sessionUserAgentCol = db_->executeQuery(
+    PGresult* sessionUserAgentCol = exec(
         "ALTER TABLE IF EXISTS user_sessions "
         "ADD COLUMN IF NOT EXISTS user_agent TEXT");
     if (!sessionUserAgentCol) {
@@ -552,1060 +778,137 @@ bool DatabaseManager::initialize() {
     }
 
     // Public Directory: Add category and is_public columns to groups
-    PGresult* groupsCategoryCol = db_->executeQuery(
+    PGresult* groupsCategoryCol = exec(
         "ALTER TABLE groups ADD COLUMN IF NOT EXISTS category VARCHAR(50) DEFAULT ''");
     if (groupsCategoryCol) PQclear(groupsCategoryCol);
     
-    PGresult* groupsIsPublicCol = db_->executeQuery(
+    PGresult* groupsIsPublicCol = exec(
         "ALTER TABLE groups ADD COLUMN IF NOT EXISTS is_public BOOLEAN DEFAULT FALSE");
     if (groupsIsPublicCol) PQclear(groupsIsPublicCol);
     
     // Public Directory: Add category and is_verified columns to channels
-    PGresult* channelsCategoryCol = db_->executeQuery(
+    PGresult* channelsCategoryCol = exec(
         "ALTER TABLE channels ADD COLUMN IF NOT EXISTS category VARCHAR(50) DEFAULT ''");
     if (channelsCategoryCol) PQclear(channelsCategoryCol);
     
-    PGresult* channelsIsVerifiedCol = db_->executeQuery(
+    PGresult* channelsIsVerifiedCol = exec(
         "ALTER TABLE channels ADD COLUMN IF NOT EXISTS is_verified BOOLEAN DEFAULT FALSE");
     if (channelsIsVerifiedCol) PQclear(channelsIsVerifiedCol);
     
     // Indexes for public directory queries
-    PGresult* idxGroupsPublic = db_->executeQuery(
+    PGresult* idxGroupsPublic = exec(
         "CREATE INDEX IF NOT EXISTS idx_groups_is_public ON groups(is_public) WHERE is_public = TRUE");
     if (idxGroupsPublic) PQclear(idxGroupsPublic);
     
-    PGresult* idxChannelsPrivate = db_->executeQuery(
+    PGresult* idxChannelsPrivate = exec(
         "CREATE INDEX IF NOT EXISTS idx_channels_is_private_false ON channels(is_private) WHERE is_private = FALSE");
     if (idxChannelsPrivate) PQclear(idxChannelsPrivate);
-    
-    prepareStatements();
-    Logger::getInstance().info("Database initialized successfully");
-    return true;
-}
-
-void DatabaseManager::prepareStatements() {
-    // Prepare statements for better performance and security
-    db_->prepareStatement("get_user_by_username",
-        "SELECT id, username, password_hash, created_at, is_active, "
-        "COALESCE(is_admin, FALSE), COALESCE(role, 'user'), "
-        "COALESCE(totp_secret, ''), COALESCE(admin_ip_whitelist, ''), COALESCE(is_bot, FALSE), "
-        "CASE WHEN COALESCE(is_premium, FALSE) AND (premium_expires_at IS NULL OR premium_expires_at > now()) "
-        "THEN TRUE ELSE FALSE END, "
-        "COALESCE(premium_plan, ''), "
-        "COALESCE(premium_expires_at::text, '') "
-        "FROM users WHERE username = $1");
-    
-    db_->prepareStatement("get_user_by_id",
-        "SELECT id, username, password_hash, created_at, is_active, "
-        "COALESCE(is_admin, FALSE), COALESCE(role, 'user'), "
-        "COALESCE(totp_secret, ''), COALESCE(admin_ip_whitelist, ''), COALESCE(is_bot, FALSE), "
-        "CASE WHEN COALESCE(is_premium, FALSE) AND (premium_expires_at IS NULL OR premium_expires_at > now()) "
-        "THEN TRUE ELSE FALSE END, "
-        "COALESCE(premium_plan, ''), "
-        "COALESCE(premium_expires_at::text, '') "
-        "FROM users WHERE id = $1");
-
-    // Lightweight public profile lookup
-    db_->prepareStatement("get_user_public",
-        "SELECT id::text, username, COALESCE(avatar_url, '') "
-        "FROM users WHERE id = $1::uuid");
-    
-    db_->prepareStatement("check_username_exists",
-        "SELECT COUNT(*) FROM users WHERE username = $1");
-    
-    db_->prepareStatement("are_friends",
-        "SELECT COUNT(*) FROM friends WHERE (user1_id = $1 AND user2_id = $2) OR (user1_id = $2 AND user2_id = $1)");
-    
-    // Prepared statements prevent SQL injection for auth flows.
-    db_->prepareStatement("create_user",
-        "INSERT INTO users (username, password_hash) VALUES ($1, $2)");
-
-    db_->prepareStatement("create_bot_user",
-        "INSERT INTO users (username, password_hash, is_active, is_bot) "
-        "VALUES ($1, $2, TRUE, TRUE) RETURNING id");
-    
-    db_->prepareStatement("update_last_login",
-        "UPDATE users SET last_login = CURRENT_TIMESTAMP WHERE id = $1");
-    
-    db_->prepareStatement("update_last_activity",
-        "UPDATE users SET last_activity = CURRENT_TIMESTAMP WHERE id = $1");
-
-    // Persistent sessions (survive restarts)
-    db_->prepareStatement("upsert_user_session",
-        "INSERT INTO user_sessions (token, user_id, expires_at) "
-        "VALUES ($1, $2::uuid, now() + ($3::text || ' seconds')::interval) "
-        "ON CONFLICT (token) DO UPDATE SET user_id = EXCLUDED.user_id, expires_at = EXCLUDED.expires_at, last_seen = now()");
-    db_->prepareStatement("get_user_id_by_session",
-        "SELECT user_id FROM user_sessions WHERE token = $1 AND (expires_at IS NULL OR expires_at > now())");
-    db_->prepareStatement("touch_user_session",
-        "UPDATE user_sessions SET last_seen = now() WHERE token = $1");
-    db_->prepareStatement("delete_user_session",
-        "DELETE FROM user_sessions WHERE token = $1");
-    db_->prepareStatement("list_user_sessions",
-        "SELECT token, COALESCE(created_at::text, ''), COALESCE(last_seen::text, ''), "
-        "COALESCE(user_agent, '') "
-        "FROM user_sessions "
-        "WHERE user_id = $1::uuid AND (expires_at IS NULL OR expires_at > now()) "
-        "ORDER BY last_seen DESC");
-    db_->prepareStatement("update_user_session_user_agent",
-        "UPDATE user_sessions SET user_agent = $2 WHERE token = $1");
-
-    db_->prepareStatement("upsert_push_token",
-        "INSERT INTO user_push_tokens (user_id, device_token, platform) "
-        "VALUES ($1::uuid, $2, $3) "
-        "ON CONFLICT (user_id, device_token) DO UPDATE "
-        "SET platform = EXCLUDED.platform, updated_at = now()");
-    db_->prepareStatement("delete_push_token",
-        "DELETE FROM user_push_tokens WHERE user_id = $1::uuid AND device_token = $2");
-    db_->prepareStatement("get_push_tokens",
-        "SELECT device_token, platform FROM user_push_tokens WHERE user_id = $1::uuid");
-    
-    db_->prepareStatement("set_user_active",
-        "UPDATE users SET is_active = $2 WHERE id = $1");
-    
-    db_->prepareStatement("update_user_password_hash",
-        "UPDATE users SET password_hash = $2 WHERE id = $1");
-
-    db_->prepareStatement("set_user_role",
-        "UPDATE users SET role = $2 WHERE id = $1::uuid");
-
-    db_->prepareStatement("set_user_admin_flag",
-        "UPDATE users SET is_admin = $2 WHERE id = $1::uuid");
-
-    db_->prepareStatement("delete_user_sessions_by_user",
-        "DELETE FROM user_sessions WHERE user_id = $1::uuid");
 
-    db_->prepareStatement("count_banned_users",
-        "SELECT COUNT(*) FROM users WHERE is_active = FALSE");
-
-    db_->prepareStatement("count_active_users_since",
-        "SELECT COUNT(*) FROM users WHERE last_activity IS NOT NULL "
-        "AND last_activity > (now() - ($1::text || ' seconds')::interval)");
+    return ok;
+}
 
-    db_->prepareStatement("count_groups",
-        "SELECT COUNT(*) FROM groups");
+// Migration 2: indexes for the chat list (get_chat_summaries, get_last_message, get_unread_count).
+// The (sender_id, receiver_id, created_at) index comes with migration 3,
+// as idx_messages_pair_keyset.
+bool DatabaseManager::migrateChatListIndexes() {
+    bool ok = true;
+    ok = createIndexConcurrently("idx_messages_receiver_created",
+                                 "ON messages(receiver_id, created_at DESC)") && ok;
+    ok = createIndexConcurrently("idx_messages_unread",
+                                 "ON messages(receiver_id, sender_id) WHERE is_read = false") && ok;
+    return ok;
+}
 
-    db_->prepareStatement("count_channels",
-        "SELECT COUNT(*) FROM channels");
+// Migration 3: (created_at, id) indexes behind the history cursors
+// (get_*_messages_before/_after, get_message_reports_before). Built
+// concurrently: these tables are large and written to by instances that
+// are still serving while this one starts.
+bool DatabaseManager::migrateKeysetIndexes() {
+    bool ok = true;
+    ok = createIndexConcurrently("idx_messages_pair_keyset",
+                                 "ON messages(sender_id, receiver_id, created_at DESC, id DESC)") && ok;
+    ok = createIndexConcurrently("idx_group_messages_keyset",
+                                 "ON group_messages(group_id, created_at DESC, id DESC) WHERE topic_id IS NULL") && ok;
+    ok = createIndexConcurrently("idx_channel_messages_keyset",
+                                 "ON channel_messages(channel_id, created_at DESC, id DESC)") && ok;
+    ok = createIndexConcurrently("idx_message_reports_keyset",
+                                 "ON message_reports(created_at DESC, id DESC)") && ok;
+    return ok;
+}
 
-    db_->prepareStatement("count_bots",
-        "SELECT COUNT(*) FROM bot_builder_bots");
+// Migration 4: full-text indexes behind the *search_*messages statements.
+// The 'simple' configuration (lowercasing, no stemming, no stop words)
+// because messages mix languages; the expression must match the one in
+// the statements for the planner to use the index. GIN builds over the
+// message tables are slow, so they run concurrently.
+bool DatabaseManager::migrateSearchIndexes() {
+    bool ok = true;
+    ok = createIndexConcurrently("idx_messages_search",
+                                 "ON messages USING GIN (to_tsvector('simple', content))") && ok;
+    ok = createIndexConcurrently("idx_group_messages_search",
+                                 "ON group_messages USING GIN (to_tsvector('simple', content))") && ok;
+    return ok;
+}
 
-    db_->prepareStatement("count_reports_by_status",
-        "SELECT COUNT(*) FROM message_reports WHERE ($1 = '' OR status = $1)");
+// Migration 5: revoked ids of signed session tokens. Rows are only needed
+// until the token expires; revoked_at drives the incremental sync.
+bool DatabaseManager::migrateRevokedSessions() {
+    bool ok = true;
+    auto exec = [&](const std::string& sql) {
+        PGresult* res = db_->executeQuery(sql);
+        if (!res) {
+            ok = false;
+        }
+        return res;
+    };
 
-    db_->prepareStatement("upsert_admin_setting",
-        "INSERT INTO admin_settings (key, value) VALUES ($1, $2) "
-        "ON CONFLICT (key) DO UPDATE SET value = EXCLUDED.value, updated_at = now()");
+    PGresult* table = exec(
+        "CREATE TABLE IF NOT EXISTS revoked_sessions ("
+        "session_id VARCHAR(64) PRIMARY KEY, "
+        "expires_at TIMESTAMP WITH TIME ZONE NOT NULL, "
+        "revoked_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT CURRENT_TIMESTAMP)");
+    if (table) PQclear(table);
 
-    db_->prepareStatement("get_admin_setting",
-        "SELECT value FROM admin_settings WHERE key = $1");
-    
-    db_->prepareStatement("delete_messages_by_user",
-        "DELETE FROM messages WHERE sender_id = $1 OR receiver_id = $1");
-    
-    db_->prepareStatement("count_users",
-        "SELECT COUNT(*) FROM users");
-    
-    db_->prepareStatement("count_messages_today",
-        "SELECT COUNT(*) FROM messages WHERE created_at::date = CURRENT_DATE");
-    
-    db_->prepareStatement("count_online_users",
-        "SELECT COUNT(*) FROM users WHERE last_activity IS NOT NULL "
-        "AND (EXTRACT(EPOCH FROM (CURRENT_TIMESTAMP - last_activity))::int < $1)");
-
-    db_->prepareStatement("admin_search_users",
-        "SELECT id::text, username, COALESCE(is_active, TRUE), COALESCE(is_admin, FALSE), "
-        "COALESCE(is_bot, FALSE), COALESCE(role, 'user'), COALESCE(last_login::text,''), "
-        "COALESCE(last_activity::text,''), created_at::text "
-        "FROM users "
-        "WHERE username ILIKE $1 OR id::text = $2 "
-        "ORDER BY CASE "
-        "WHEN id::text = $2 THEN 0 "
-        "WHEN lower(username) = lower($3) THEN 1 "
-        "WHEN lower(username) LIKE lower($3) || '%' THEN 2 "
-        "ELSE 3 END, username "
-        "LIMIT $4");
-
-    db_->prepareStatement("admin_search_messages",
-        "SELECT m.id::text, m.sender_id::text, COALESCE(s.username,''), "
-        "m.receiver_id::text, COALESCE(r.username,''), m.content, "
-        "COALESCE(m.message_type,'text'), m.created_at::text "
-        "FROM messages m "
-        "LEFT JOIN users s ON s.id = m.sender_id "
-        "LEFT JOIN users r ON r.id = m.receiver_id "
-        "WHERE m.content ILIKE $1 OR m.id::text = $2 "
-        "ORDER BY m.created_at DESC "
-        "LIMIT $3");
-
-    db_->prepareStatement("admin_search_groups",
-        "SELECT id::text, name, COALESCE(description,''), creator_id::text, "
-        "COALESCE(invite_link,''), created_at::text "
-        "FROM groups "
-        "WHERE name ILIKE $1 OR id::text = $2 "
-        "ORDER BY name "
-        "LIMIT $3");
-
-    db_->prepareStatement("admin_search_channels",
-        "SELECT id::text, name, COALESCE(description,''), creator_id::text, "
-        "COALESCE(custom_link,''), created_at::text "
-        "FROM channels "
-        "WHERE name ILIKE $1 OR custom_link ILIKE $1 OR id::text = $2 "
-        "ORDER BY name "
-        "LIMIT $3");
-    
-    db_->prepareStatement("update_user_avatar",
-        "UPDATE users SET avatar_url = $1 WHERE id = $2");
-
-    db_->prepareStatement("set_user_premium",
-        "UPDATE users SET is_premium = $2::boolean, premium_plan = NULLIF($3, ''), "
-        "premium_expires_at = CASE "
-        "WHEN $2::boolean THEN "
-        "CASE "
-        "WHEN $3 = 'year' THEN "
-        "  (CASE WHEN premium_expires_at IS NOT NULL AND premium_expires_at > now() "
-        "        THEN premium_expires_at ELSE now() END) + interval '1 year' "
-        "WHEN $3 = 'half' THEN "
-        "  (CASE WHEN premium_expires_at IS NOT NULL AND premium_expires_at > now() "
-        "        THEN premium_expires_at ELSE now() END) + interval '6 months' "
-        "WHEN $3 = 'month' THEN "
-        "  (CASE WHEN premium_expires_at IS NOT NULL AND premium_expires_at > now() "
-        "        THEN premium_expires_at ELSE now() END) + interval '1 month' "
-        "WHEN $3 = 'trial' THEN "
-        "  (CASE WHEN premium_expires_at IS NOT NULL AND premium_expires_at > now() "
-        "        THEN premium_expires_at ELSE now() END) + interval '7 days' "
-        "ELSE NULL "
-        "END "
-        "ELSE NULL "
-        "END "
-        "WHERE id = $1::uuid");
-
-    db_->prepareStatement("create_premium_payment",
-        "INSERT INTO premium_payments (user_id, plan, amount, label) "
-        "VALUES ($1::uuid, $2, $3::numeric, 'pp_' || uuid_generate_v4()) "
-        "RETURNING id::text, label, plan, amount::text, status");
-
-    db_->prepareStatement("create_premium_gift_payment",
-        "INSERT INTO premium_payments (user_id, plan, amount, label, gift_receiver_id) "
-        "VALUES ($1::uuid, $2, $3::numeric, 'pp_' || uuid_generate_v4(), $4::uuid) "
-        "RETURNING id::text, label, plan, amount::text, status, COALESCE(gift_receiver_id::text, '')");
-
-    db_->prepareStatement("get_premium_payment_by_label",
-        "SELECT id::text, user_id::text, plan, amount::text, status, "
-        "COALESCE(operation_id, ''), COALESCE(payment_type, ''), "
-        "COALESCE(gift_receiver_id::text, ''), "
-        "created_at::text, COALESCE(paid_at::text, '') "
-        "FROM premium_payments WHERE label = $1");
-
-    db_->prepareStatement("mark_premium_payment_paid",
-        "UPDATE premium_payments "
-        "SET status = 'paid', operation_id = $2, payment_type = $3, paid_at = now() "
-        "WHERE label = $1 AND status <> 'paid' "
-        "RETURNING id");
-
-    db_->prepareStatement("reset_premium_payment_status",
-        "UPDATE premium_payments "
-        "SET status = 'pending', operation_id = '', payment_type = '', paid_at = NULL "
-        "WHERE label = $1 AND status = 'paid' "
-        "RETURNING id");
-
-    db_->prepareStatement("has_trial_payment",
-        "SELECT 1 FROM premium_payments WHERE user_id = $1::uuid AND plan = 'trial' AND status = 'paid' LIMIT 1");
-
-    db_->prepareStatement("admin_list_premium_payments",
-        "SELECT p.id::text, p.label, p.plan, p.amount::text, p.status, "
-        "COALESCE(p.operation_id, ''), COALESCE(p.payment_type, ''), "
-        "p.created_at::text, COALESCE(p.paid_at::text, ''), "
-        "u.id::text, u.username "
-        "FROM premium_payments p "
-        "JOIN users u ON u.id = p.user_id "
-        "WHERE ($1 = '' OR p.status = $1) "
-        "ORDER BY p.created_at DESC "
-        "LIMIT $2");
-    
-    db_->prepareStatement("get_user_last_activity",
-        "SELECT last_activity FROM users WHERE id = $1");
-    
-    db_->prepareStatement("check_user_online",
-        "SELECT CASE WHEN last_activity IS NOT NULL AND (EXTRACT(EPOCH FROM (CURRENT_TIMESTAMP - last_activity))::int < $2) THEN true ELSE false END as is_online FROM users WHERE id = $1");
-
-    // Profile + privacy
-    db_->prepareStatement("get_user_profile",
-        "SELECT COALESCE(first_name,''), COALESCE(last_name,''), COALESCE(bio,''), "
-        "COALESCE(birth_day,0), COALESCE(birth_month,0), COALESCE(birth_year,0), "
-        "COALESCE(linked_channel_id::text, ''), COALESCE(business_hours_json::text, '') "
-        "FROM user_profiles WHERE user_id = $1::uuid");
-    db_->prepareStatement("upsert_user_profile",
-        "INSERT INTO user_profiles (user_id, first_name, last_name, bio, birth_day, birth_month, birth_year) "
-        "VALUES ($1::uuid, $2, $3, $4, NULLIF($5::int,0), NULLIF($6::int,0), NULLIF($7::int,0)) "
-        "ON CONFLICT (user_id) DO UPDATE SET first_name = EXCLUDED.first_name, last_name = EXCLUDED.last_name, "
-        "bio = EXCLUDED.bio, birth_day = EXCLUDED.birth_day, birth_month = EXCLUDED.birth_month, birth_year = EXCLUDED.birth_year");
-    db_->prepareStatement("upsert_user_linked_channel",
-        "INSERT INTO user_profiles (user_id, linked_channel_id) "
-        "VALUES ($1::uuid, NULLIF($2,'')::uuid) "
-        "ON CONFLICT (user_id) DO UPDATE SET linked_channel_id = EXCLUDED.linked_channel_id");
-    db_->prepareStatement("set_user_business_hours",
-        "INSERT INTO user_profiles (user_id, business_hours_json) "
-        "VALUES ($1::uuid, NULLIF($2,'')::jsonb) "
-        "ON CONFLICT (user_id) DO UPDATE SET business_hours_json = EXCLUDED.business_hours_json");
-    db_->prepareStatement("get_user_privacy",
-        "SELECT bio_visibility, birth_visibility, last_seen_visibility, avatar_visibility, send_read_receipts "
-        "FROM user_privacy_settings WHERE user_id = $1::uuid");
-    db_->prepareStatement("upsert_user_privacy",
-        "INSERT INTO user_privacy_settings (user_id, bio_visibility, birth_visibility, last_seen_visibility, avatar_visibility, send_read_receipts) "
-        "VALUES ($1::uuid, $2, $3, $4, $5, $6) "
-        "ON CONFLICT (user_id) DO UPDATE SET bio_visibility = EXCLUDED.bio_visibility, "
-        "birth_visibility = EXCLUDED.birth_visibility, last_seen_visibility = EXCLUDED.last_seen_visibility, "
-        "avatar_visibility = EXCLUDED.avatar_visibility, send_read_receipts = EXCLUDED.send_read_receipts");
-
-    db_->prepareStatement("get_chat_pins",
-        "SELECT chat_type, chat_id FROM user_chat_pins WHERE user_id = $1::uuid ORDER BY created_at ASC");
-    db_->prepareStatement("pin_chat",
-        "INSERT INTO user_chat_pins (user_id, chat_type, chat_id) VALUES ($1::uuid, $2, $3::uuid) "
-        "ON CONFLICT (user_id, chat_type, chat_id) DO NOTHING");
-    db_->prepareStatement("unpin_chat",
-        "DELETE FROM user_chat_pins WHERE user_id = $1::uuid AND chat_type = $2 AND chat_id = $3::uuid");
-
-    db_->prepareStatement("get_chat_folders",
-        "SELECT COALESCE(folders::text, '[]') FROM user_chat_folders WHERE user_id = $1::uuid");
-    db_->prepareStatement("set_chat_folders",
-        "INSERT INTO user_chat_folders (user_id, folders) VALUES ($1::uuid, $2::jsonb) "
-        "ON CONFLICT (user_id) DO UPDATE SET folders = EXCLUDED.folders, updated_at = now()");
-
-    db_->prepareStatement("count_user_channels_v2",
-        "SELECT COUNT(*) FROM chats WHERE type = 'channel' AND created_by = $1::uuid");
-    db_->prepareStatement("count_user_channels_legacy",
-        "SELECT COUNT(*) FROM channels WHERE creator_id = $1");
-    db_->prepareStatement("count_user_public_links_v2",
-        "SELECT COUNT(*) FROM chats WHERE type = 'channel' AND created_by = $1::uuid "
-        "AND COALESCE(username, '') <> ''");
-    db_->prepareStatement("count_user_public_links_legacy",
-        "SELECT COUNT(*) FROM channels WHERE creator_id = $1 AND COALESCE(custom_link, '') <> ''");
-    
-    db_->prepareStatement("create_friend_request",
-        "INSERT INTO friend_requests (sender_id, receiver_id) VALUES ($1, $2)");
-    
-    db_->prepareStatement("get_friend_request",
-        "SELECT id, sender_id, receiver_id FROM friend_requests WHERE id = $1");
-    
-    db_->prepareStatement("update_friend_request_status",
-        "UPDATE friend_requests SET status = $1 WHERE id = $2");
-    
-    db_->prepareStatement("create_friendship",
-        "INSERT INTO friends (user1_id, user2_id) VALUES ($1, $2)");
-    db_->prepareStatement("create_friendship_pair",
-        "INSERT INTO friends (user1_id, user2_id) VALUES (LEAST($1::uuid, $2::uuid), GREATEST($1::uuid, $2::uuid)) "
-        "ON CONFLICT (user1_id, user2_id) DO NOTHING");
-    
-    db_->prepareStatement("get_friend_requests",
-        "SELECT id, sender_id, receiver_id, status, created_at FROM friend_requests WHERE receiver_id = $1 AND status = 'pending'");
-    
-    db_->prepareStatement("get_friends",
-        "SELECT u.id, u.username, COALESCE(u.avatar_url, '') as avatar_url, f.created_at FROM friends f "
-        "JOIN users u ON (u.id = CASE WHEN f.user1_id = $1 THEN f.user2_id ELSE f.user1_id END) "
-        "WHERE f.user1_id = $1 OR f.user2_id = $1");
-    
-    db_->prepareStatement("send_message",
-        "INSERT INTO messages (sender_id, receiver_id, content, message_type, file_path, file_name, file_size, reply_to_message_id, reply_markup) VALUES ($1, $2, $3, $4, $5, $6, $7, $8, CASE WHEN $9 = '' THEN NULL ELSE $9::jsonb END)");
-    Logger::getInstance().info("Prepared statement 'send_message' creation attempted");
-    
-    db_->prepareStatement("get_messages",
-        "SELECT m.id, m.sender_id, m.receiver_id, m.content, m.created_at, m.is_read, m.is_delivered, m.message_type, "
-        "m.file_path, m.file_name, m.file_size, m.reply_to_message_id, "
-        "COALESCE(m.reply_markup::text, '') as reply_markup, "
-        "COALESCE(dp.message_id = m.id, FALSE) AS is_pinned "
-        "FROM messages m "
-        "LEFT JOIN direct_pins dp ON dp.user_low = LEAST($1::uuid, $2::uuid) AND dp.user_high = GREATEST($1::uuid, $2::uuid) "
-        "WHERE (m.sender_id = $1 AND m.receiver_id = $2) OR (m.sender_id = $2 AND m.receiver_id = $1) "
-        "ORDER BY m.created_at DESC LIMIT $3");
-    
-    // Special query for saved messages (when user_id == friend_id)
-    db_->prepareStatement("get_saved_messages",
-        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id, "
-        "COALESCE(reply_markup::text, '') as reply_markup, "
-        "FALSE AS is_pinned "
-        "FROM messages "
-        "WHERE sender_id = $1 AND receiver_id = $1 "
-        "ORDER BY created_at DESC LIMIT $2");
-    
-    db_->prepareStatement("get_last_message",
-        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id, "
-        "COALESCE(reply_markup::text, '') as reply_markup "
-        "FROM messages "
-        "WHERE (sender_id = $1 AND receiver_id = $2) OR (sender_id = $2 AND receiver_id = $1) "
-        "ORDER BY created_at DESC LIMIT 1");
-    
-    // Special query for saved messages last message
-    db_->prepareStatement("get_last_saved_message",
-        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id, "
-        "COALESCE(reply_markup::text, '') as reply_markup "
-        "FROM messages "
-        "WHERE sender_id = $1 AND receiver_id = $1 "
-        "ORDER BY created_at DESC LIMIT 1");
-    
-    db_->prepareStatement("get_message_by_id",
-        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id, "
-        "COALESCE(reply_markup::text, '') as reply_markup "
-        "FROM messages WHERE id = $1");
+    PGresult* idxRevokedAt = exec(
+        "CREATE INDEX IF NOT EXISTS idx_revoked_sessions_revoked_at ON revoked_sessions(revoked_at)");
+    if (idxRevokedAt) PQclear(idxRevokedAt);
 
-    db_->prepareStatement("delete_message_by_id",
-        "DELETE FROM messages WHERE id = $1");
-    
-    db_->prepareStatement("get_unread_count",
-        "SELECT COUNT(*) FROM messages WHERE receiver_id = $1 AND sender_id = $2 AND is_read = false");
-    
-    db_->prepareStatement("mark_messages_read",
-        "UPDATE messages SET is_read = true WHERE receiver_id = $1 AND sender_id = $2 AND is_read = false");
+    return ok;
+}
 
-    db_->prepareStatement("mark_messages_delivered",
-        "UPDATE messages SET is_delivered = true WHERE receiver_id = $1 AND sender_id = $2 AND is_delivered = false");
+std::string DatabaseManager::searchQueryFor(const std::string& text) {
+    // Words are runs of ASCII letters/digits and non-ASCII (UTF-8) bytes;
+    // everything else separates them, so no tsquery syntax reaches the
+    // server. Each word matches as a prefix ('hel' finds "hello"), all of
+    // them must match.
+    constexpr size_t kMaxTerms = 8;
+    std::string query;
+    size_t terms = 0;
+    size_t i = 0;
+    while (i < text.size() && terms < kMaxTerms) {
+        while (i < text.size() && !isSearchWordByte(text[i])) {
+            ++i;
+        }
+        const size_t start = i;
+        while (i < text.size() && isSearchWordByte(text[i])) {
+            ++i;
+        }
+        if (i == start) {
+            break;
+        }
+        if (!query.empty()) {
+            query += " & ";
+        }
+        query += '\'';
+        query.append(text, start, i - start);
+        query += "':*";
+        terms++;
+    }
+    return query;
+}
 
-    db_->prepareStatement("mark_message_delivered_by_id",
-        "UPDATE messages SET is_delivered = true WHERE id = $1::uuid AND is_delivered = false");
-    
-    db_->prepareStatement("get_chat_partners",
-        "SELECT u.id, u.username, COALESCE(u.avatar_url, '') as avatar_url, COALESCE(MAX(m.created_at)::text, '') as last_message_time "
-        "FROM messages m "
-        "JOIN users u ON (u.id = CASE WHEN m.sender_id = $1 THEN m.receiver_id ELSE m.sender_id END) "
-        "WHERE (m.sender_id = $1 OR m.receiver_id = $1) "
-        "GROUP BY u.id, u.username, u.avatar_url "
-        "ORDER BY MAX(m.created_at) DESC NULLS LAST");
-    
-    // Check if user has saved messages
-    db_->prepareStatement("has_saved_messages",
-        "SELECT COUNT(*) > 0 FROM messages WHERE sender_id = $1 AND receiver_id = $1");
-    db_->prepareStatement("pin_direct_message",
-        "INSERT INTO direct_pins (user_low, user_high, message_id, pinned_by) "
-        "VALUES (LEAST($1::uuid, $2::uuid), GREATEST($1::uuid, $2::uuid), $3::uuid, $4::uuid) "
-        "ON CONFLICT (user_low, user_high) DO UPDATE SET message_id = EXCLUDED.message_id, pinned_by = EXCLUDED.pinned_by, pinned_at = now()");
-    db_->prepareStatement("unpin_direct_message",
-        "DELETE FROM direct_pins WHERE user_low = LEAST($1::uuid, $2::uuid) AND user_high = GREATEST($1::uuid, $2::uuid)");
-    db_->prepareStatement("get_direct_pinned_message",
-        "SELECT message_id FROM direct_pins WHERE user_low = LEAST($1::uuid, $2::uuid) AND user_high = GREATEST($1::uuid, $2::uuid) LIMIT 1");
-    
-    // Group statements
-    db_->prepareStatement("create_group",
-        "INSERT INTO groups (name, description, creator_id) VALUES ($1, $2, $3) RETURNING id");
-    db_->prepareStatement("get_group_by_id",
-        "SELECT id, name, description, creator_id, invite_link, created_at FROM groups WHERE id = $1");
-    db_->prepareStatement("get_user_groups",
-        "SELECT g.id, g.name, g.description, g.creator_id, g.invite_link, g.created_at "
-        "FROM groups g JOIN group_members gm ON g.id = gm.group_id "
-        "WHERE gm.user_id = $1 AND gm.is_banned = FALSE ORDER BY g.created_at DESC");
-    db_->prepareStatement("add_group_member",
-        "INSERT INTO group_members (group_id, user_id, role) VALUES ($1, $2, $3) "
-        "ON CONFLICT (group_id, user_id) DO UPDATE SET is_banned = FALSE, role = $3");
-    db_->prepareStatement("send_group_message",
-        "INSERT INTO group_messages (group_id, sender_id, content, message_type, file_path, file_name, file_size, "
-        "reply_to_message_id, forwarded_from_user_id, forwarded_from_username, forwarded_from_message_id) "
-        "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11)");
-    db_->prepareStatement("get_group_messages",
-        "SELECT gm.id, gm.group_id, gm.sender_id, u.username, gm.content, gm.message_type, "
-        "gm.file_path, gm.file_name, gm.file_size, gm.reply_to_message_id, "
-        "gm.forwarded_from_user_id, gm.forwarded_from_username, gm.forwarded_from_message_id, "
-        "gm.is_pinned, gm.created_at "
-        "FROM group_messages gm JOIN users u ON gm.sender_id = u.id "
-        "WHERE gm.group_id = $1 AND gm.topic_id IS NULL ORDER BY gm.created_at DESC LIMIT $2");
-    db_->prepareStatement("create_group_invite",
-        "INSERT INTO group_invites (group_id, invite_link, created_by, expires_at) VALUES ($1, $2, $3, $4)");
-    db_->prepareStatement("update_group_name",
-        "UPDATE groups SET name = $1 WHERE id = $2");
-    db_->prepareStatement("update_group_description",
-        "UPDATE groups SET description = $1 WHERE id = $2");
-    db_->prepareStatement("pin_group_message",
-        "INSERT INTO pinned_messages (group_id, message_id, pinned_by) VALUES ($1, $2, $3) "
-        "ON CONFLICT (group_id, message_id) DO NOTHING");
-    db_->prepareStatement("update_message_pinned",
-        "UPDATE group_messages SET is_pinned = TRUE WHERE id = $1");
-    db_->prepareStatement("remove_group_member",
-        "DELETE FROM group_members WHERE group_id = $1 AND user_id = $2");
-    db_->prepareStatement("update_group_member_role",
-        "UPDATE group_members SET role = $1 WHERE group_id = $2 AND user_id = $3");
-    db_->prepareStatement("mute_group_member",
-        "UPDATE group_members SET is_muted = $1 WHERE group_id = $2 AND user_id = $3");
-    db_->prepareStatement("ban_group_member",
-        "UPDATE group_members SET is_banned = $1, banned_until = $2 WHERE group_id = $3 AND user_id = $4");
-    db_->prepareStatement("get_group_members",
-        "SELECT gm.id, gm.group_id, gm.user_id, u.username, gm.role, gm.is_muted, gm.is_banned, gm.joined_at, COALESCE(gm.permissions::text, '{}') "
-        "FROM group_members gm JOIN users u ON gm.user_id = u.id WHERE gm.group_id = $1");
-    db_->prepareStatement("get_group_member",
-        "SELECT gm.id, gm.group_id, gm.user_id, u.username, gm.role, gm.is_muted, gm.is_banned, gm.joined_at, COALESCE(gm.permissions::text, '{}') "
-        "FROM group_members gm JOIN users u ON gm.user_id = u.id WHERE gm.group_id = $1 AND gm.user_id = $2");
-    db_->prepareStatement("update_admin_permissions",
-        "UPDATE group_members SET permissions = $1::jsonb WHERE group_id = $2 AND user_id = $3");
-    db_->prepareStatement("get_invite_info",
-        "SELECT group_id, expires_at, max_uses, current_uses FROM group_invites WHERE invite_link = $1");
-    db_->prepareStatement("unpin_group_message",
-        "DELETE FROM pinned_messages WHERE group_id = $1 AND message_id = $2");
-    db_->prepareStatement("update_message_unpinned",
-        "UPDATE group_messages SET is_pinned = FALSE WHERE id = $1");
-    
-    // Group management statements
-    db_->prepareStatement("delete_group",
-        "DELETE FROM groups WHERE id = $1");
-    db_->prepareStatement("delete_group_messages",
-        "DELETE FROM group_messages WHERE group_id = $1");
-    db_->prepareStatement("delete_group_members",
-        "DELETE FROM group_members WHERE group_id = $1");
-    db_->prepareStatement("delete_group_invites",
-        "DELETE FROM group_invites WHERE group_id = $1");
-    db_->prepareStatement("delete_group_pinned",
-        "DELETE FROM pinned_messages WHERE group_id = $1");
-    db_->prepareStatement("search_group_messages",
-        "SELECT gm.id, gm.group_id, gm.sender_id, u.username, gm.content, gm.message_type, "
-        "COALESCE(gm.file_path, ''), COALESCE(gm.file_name, ''), COALESCE(gm.file_size, 0), "
-        "gm.created_at, COALESCE(gm.is_pinned, false) "
-        "FROM group_messages gm JOIN users u ON gm.sender_id = u.id "
-        "WHERE gm.group_id = $1 AND gm.content ILIKE $2 ORDER BY gm.created_at DESC LIMIT $3");
-    db_->prepareStatement("update_group_permissions",
-        "UPDATE groups SET permissions = COALESCE(permissions, '{}'::jsonb) || $1::jsonb WHERE id = $2");
-    
-    // Channel statements
-    db_->prepareStatement("create_channel",
-        "INSERT INTO channels (name, description, creator_id, custom_link) VALUES ($1, $2, $3, $4) RETURNING id");
-    db_->prepareStatement("check_channel_custom_link",
-        "SELECT COUNT(*) FROM channels WHERE custom_link = $1");
-    db_->prepareStatement("get_channel_by_id",
-        "SELECT id, name, description, creator_id, custom_link, COALESCE(avatar_url, ''), is_private, show_author, created_at, COALESCE(is_verified, false) FROM channels WHERE id = $1");
-    db_->prepareStatement("get_channel_by_custom_link",
-        "SELECT id, name, description, creator_id, custom_link, COALESCE(avatar_url, ''), is_private, show_author, created_at, COALESCE(is_verified, false) FROM channels WHERE custom_link = $1");
-    db_->prepareStatement("get_user_channels",
-        "SELECT c.id, c.name, c.description, c.creator_id, c.custom_link, COALESCE(c.avatar_url, ''), c.is_private, c.show_author, c.created_at, COALESCE(c.is_verified, false) "
-        "FROM channels c JOIN channel_members cm ON c.id = cm.channel_id "
-        "WHERE cm.user_id = $1 AND cm.is_banned = FALSE ORDER BY c.created_at DESC");
-    db_->prepareStatement("add_channel_member",
-        "INSERT INTO channel_members (channel_id, user_id, role) VALUES ($1, $2, $3) "
-        "ON CONFLICT (channel_id, user_id) DO UPDATE SET is_banned = FALSE, role = $3");
-    db_->prepareStatement("send_channel_message",
-        "INSERT INTO channel_messages (channel_id, sender_id, content, message_type, file_path, file_name, file_size) "
-        "VALUES ($1, $2, $3, $4, $5, $6, $7)");
-    db_->prepareStatement("get_channel_messages",
-        "SELECT cm.id, cm.channel_id, cm.sender_id, u.username, cm.content, cm.message_type, "
-        "cm.file_path, cm.file_name, cm.file_size, cm.is_pinned, "
-        "COALESCE((SELECT COUNT(*) FROM channel_message_views WHERE message_id = cm.id), 0) as views_count, "
-        "cm.created_at "
-        "FROM channel_messages cm JOIN users u ON cm.sender_id = u.id "
-        "WHERE cm.channel_id = $1 ORDER BY cm.created_at DESC LIMIT $2");
-    db_->prepareStatement("add_message_reaction",
-        "INSERT INTO channel_message_reactions (message_id, user_id, reaction) VALUES ($1, $2, $3) "
-        "ON CONFLICT (message_id, user_id, reaction) DO NOTHING");
-    db_->prepareStatement("remove_message_reaction",
-        "DELETE FROM channel_message_reactions WHERE message_id = $1 AND user_id = $2 AND reaction = $3");
-    db_->prepareStatement("get_message_reactions",
-        "SELECT reaction FROM channel_message_reactions WHERE message_id = $1");
-    db_->prepareStatement("add_message_view",
-        "INSERT INTO channel_message_views (message_id, user_id) VALUES ($1, $2) "
-        "ON CONFLICT (message_id, user_id) DO NOTHING");
-    db_->prepareStatement("get_message_views_count",
-        "SELECT COUNT(*) FROM channel_message_views WHERE message_id = $1");
-    db_->prepareStatement("update_channel_message_views",
-        "UPDATE channel_messages SET views_count = (SELECT COUNT(*) FROM channel_message_views WHERE message_id = $1) WHERE id = $1");
-    db_->prepareStatement("remove_channel_member",
-        "DELETE FROM channel_members WHERE channel_id = $1 AND user_id = $2");
-    db_->prepareStatement("update_channel_member_role",
-        "UPDATE channel_members SET role = $1 WHERE channel_id = $2 AND user_id = $3");
-    db_->prepareStatement("ban_channel_member",
-        "UPDATE channel_members SET is_banned = $1 WHERE channel_id = $2 AND user_id = $3");
-    db_->prepareStatement("get_channel_members",
-        "SELECT cm.id, cm.channel_id, cm.user_id, u.username, cm.role, cm.is_banned, cm.joined_at "
-        "FROM channel_members cm JOIN users u ON cm.user_id = u.id WHERE cm.channel_id = $1");
-    db_->prepareStatement("count_channel_subscribers",
-        "SELECT COUNT(*) FROM channel_members WHERE channel_id = $1 AND role = 'subscriber'");
-    db_->prepareStatement("count_channel_members",
-        "SELECT COUNT(*) FROM channel_members WHERE channel_id = $1");
-    db_->prepareStatement("get_channel_member",
-        "SELECT cm.id, cm.channel_id, cm.user_id, u.username, cm.role, cm.is_banned, cm.joined_at "
-        "FROM channel_members cm JOIN users u ON cm.user_id = u.id WHERE cm.channel_id = $1 AND cm.user_id = $2");
-    // Legacy pin/unpin must be scoped to channel_id and match callers' param counts
-    db_->prepareStatement("pin_channel_message",
-        "UPDATE channel_messages SET is_pinned = TRUE WHERE channel_id = $1 AND id = $2");
-    db_->prepareStatement("unpin_channel_message",
-        "UPDATE channel_messages SET is_pinned = FALSE WHERE channel_id = $1 AND id = $2");
-    db_->prepareStatement("get_channel_message_meta",
-        "SELECT channel_id::text, sender_id::text FROM channel_messages WHERE id = $1");
-    db_->prepareStatement("delete_channel_message",
-        "DELETE FROM channel_messages WHERE id = $1 AND channel_id = $2");
-    db_->prepareStatement("get_group_message_meta",
-        "SELECT group_id::text, sender_id::text FROM group_messages WHERE id = $1");
-    db_->prepareStatement("delete_group_message",
-        "DELETE FROM group_messages WHERE id = $1 AND group_id = $2");
-    db_->prepareStatement("set_channel_custom_link",
-        "UPDATE channels SET custom_link = NULLIF($1, '') WHERE id = $2");
-    db_->prepareStatement("update_channel_name",
-        "UPDATE channels SET name = $1 WHERE id = $2");
-    db_->prepareStatement("update_channel_description",
-        "UPDATE channels SET description = $1 WHERE id = $2");
-    db_->prepareStatement("set_channel_privacy",
-        "UPDATE channels SET is_private = $1 WHERE id = $2");
-    db_->prepareStatement("set_channel_show_author",
-        "UPDATE channels SET show_author = $1 WHERE id = $2");
-    db_->prepareStatement("delete_channel_legacy",
-        "DELETE FROM channels WHERE id = $1");
-    db_->prepareStatement("add_allowed_reaction",
-        "INSERT INTO channel_allowed_reactions (channel_id, reaction) VALUES ($1, $2) "
-        "ON CONFLICT (channel_id, reaction) DO NOTHING");
-    db_->prepareStatement("remove_allowed_reaction",
-        "DELETE FROM channel_allowed_reactions WHERE channel_id = $1 AND reaction = $2");
-    db_->prepareStatement("get_allowed_reactions",
-        "SELECT reaction FROM channel_allowed_reactions WHERE channel_id = $1");
-    db_->prepareStatement("create_channel_join_request",
-        "INSERT INTO channel_join_requests (channel_id, user_id) VALUES ($1, $2) "
-        "ON CONFLICT (channel_id, user_id) DO NOTHING");
-    db_->prepareStatement("accept_channel_join_request",
-        "UPDATE channel_join_requests SET status = 'accepted' WHERE channel_id = $1 AND user_id = $2");
-    db_->prepareStatement("reject_channel_join_request",
-        "UPDATE channel_join_requests SET status = 'rejected' WHERE channel_id = $1 AND user_id = $2");
-    db_->prepareStatement("get_channel_join_requests",
-        "SELECT cjr.id, cjr.channel_id, cjr.user_id, u.username, cjr.created_at "
-        "FROM channel_join_requests cjr JOIN users u ON cjr.user_id = u.id "
-        "WHERE cjr.channel_id = $1 AND cjr.status = 'pending'");
-    db_->prepareStatement("create_channel_chat",
-        "INSERT INTO channel_chats (channel_id, group_id) VALUES ($1, $2) "
-        "ON CONFLICT (channel_id) DO UPDATE SET group_id = EXCLUDED.group_id");
-    
-    // Marketplace statements
-    db_->prepareStatement("create_market_product",
-        "INSERT INTO market_products (owner_chat_id, owner_type, title, description, price_amount, price_currency, product_type, image_path, stock_quantity, created_by) "
-        "VALUES ($1, $2, $3, $4, $5, $6, $7, NULLIF($8, ''), NULLIF($9::integer, NULL), $10) RETURNING id");
-    db_->prepareStatement("update_market_product",
-        "UPDATE market_products SET title = $1, description = $2, price_amount = $3, price_currency = $4, image_path = NULLIF($5, ''), stock_quantity = NULLIF($6::integer, NULL), is_active = $7 WHERE id = $8");
-    db_->prepareStatement("delete_market_product",
-        "DELETE FROM market_products WHERE id = $1");
-    db_->prepareStatement("get_market_products",
-        "SELECT id, owner_chat_id, owner_type, title, description, price_amount, price_currency, product_type, image_path, is_active, stock_quantity, created_at, created_by "
-        "FROM market_products WHERE owner_chat_id = $1 AND owner_type = $2 AND is_active = TRUE ORDER BY created_at DESC");
-    db_->prepareStatement("get_market_product_by_id",
-        "SELECT id, owner_chat_id, owner_type, title, description, price_amount, price_currency, product_type, image_path, is_active, stock_quantity, created_at, created_by "
-        "FROM market_products WHERE id = $1");
-    db_->prepareStatement("add_product_key",
-        "INSERT INTO product_keys (product_id, key_value) VALUES ($1, $2)");
-    db_->prepareStatement("get_unused_product_key",
-        "SELECT id, key_value FROM product_keys WHERE product_id = $1 AND is_used = FALSE LIMIT 1 FOR UPDATE SKIP LOCKED");
-    db_->prepareStatement("mark_product_key_used",
-        "UPDATE product_keys SET is_used = TRUE, used_by = $2, used_at = CURRENT_TIMESTAMP WHERE id = $1");
-    db_->prepareStatement("create_product_purchase",
-        "INSERT INTO product_purchases (product_id, buyer_id, seller_id, price_amount, price_currency, platform_fee, invoice_id, status) "
-        "VALUES ($1, $2, $3, $4, $5, $4 * 0.05, $6, 'paid') RETURNING id");
-    db_->prepareStatement("update_purchase_key",
-        "UPDATE product_purchases SET key_id = $2, status = 'delivered', delivered_at = CURRENT_TIMESTAMP WHERE id = $1");
-    db_->prepareStatement("get_user_purchases",
-        "SELECT id, product_id, buyer_id, seller_id, price_amount, price_currency, platform_fee, status, invoice_id, key_id, created_at "
-        "FROM product_purchases WHERE buyer_id = $1 ORDER BY created_at DESC");
-    
-    // Integration statements
-    db_->prepareStatement("create_integration_binding",
-        "INSERT INTO integration_bindings (chat_id, chat_type, service_name, external_token, config_json, created_by) "
-        "VALUES ($1, $2, $3, $4, $5::jsonb, $6) RETURNING id");
-    db_->prepareStatement("update_integration_binding",
-        "UPDATE integration_bindings SET config_json = $1::jsonb, is_active = $2 WHERE id = $3");
-    db_->prepareStatement("delete_integration_binding",
-        "DELETE FROM integration_bindings WHERE id = $1");
-    db_->prepareStatement("get_integration_bindings",
-        "SELECT id, chat_id, chat_type, service_name, config_json, is_active, created_at, created_by "
-        "FROM integration_bindings WHERE chat_id = $1 AND chat_type = $2");
-    db_->prepareStatement("get_integration_binding_by_id",
-        "SELECT id, chat_id, chat_type, service_name, config_json, is_active, created_at, created_by "
-        "FROM integration_bindings WHERE id = $1");
-    
-    // Bot Builder statements
-    db_->prepareStatement("create_bot_builder_bot",
-        "INSERT INTO bot_builder_bots (user_id, bot_user_id, bot_token, bot_username, bot_name, flow_json) "
-        "VALUES ($1, $2::uuid, $3, $4, $5, $6::jsonb) RETURNING id");
-    db_->prepareStatement("update_bot_builder_bot",
-        "UPDATE bot_builder_bots SET flow_json = $1::jsonb, is_active = $2, updated_at = CURRENT_TIMESTAMP WHERE id = $3");
-    db_->prepareStatement("delete_bot_builder_bot",
-        "DELETE FROM bot_builder_bots WHERE id = $1");
-    
-    // Bot developers
-    db_->prepareStatement("add_bot_developer",
-        "INSERT INTO bot_developers (bot_id, developer_user_id, added_by_user_id) "
-        "VALUES ($1::uuid, $2::uuid, $3::uuid) "
-        "ON CONFLICT (bot_id, developer_user_id) DO NOTHING");
-    db_->prepareStatement("remove_bot_developer",
-        "DELETE FROM bot_developers WHERE bot_id = $1::uuid AND developer_user_id = $2::uuid");
-    db_->prepareStatement("get_bot_developers",
-        "SELECT d.developer_user_id, u.username, d.added_by_user_id, d.added_at "
-        "FROM bot_developers d "
-        "JOIN users u ON u.id = d.developer_user_id "
-        "WHERE d.bot_id = $1::uuid "
-        "ORDER BY d.added_at ASC");
-    db_->prepareStatement("is_bot_developer",
-        "SELECT 1 FROM bot_developers WHERE bot_id = $1::uuid AND developer_user_id = $2::uuid LIMIT 1");
-    
-    // Bot files
-    db_->prepareStatement("upsert_bot_file",
-        "INSERT INTO bot_files (bot_id, file_path, file_content) "
-        "VALUES ($1::uuid, $2, $3) "
-        "ON CONFLICT (bot_id, file_path) "
-        "DO UPDATE SET file_content = $3, updated_at = CURRENT_TIMESTAMP");
-    db_->prepareStatement("get_bot_file",
-        "SELECT file_content FROM bot_files WHERE bot_id = $1::uuid AND file_path = $2");
-    db_->prepareStatement("delete_bot_file",
-        "DELETE FROM bot_files WHERE bot_id = $1::uuid AND file_path = $2");
-    db_->prepareStatement("list_bot_files",
-        "SELECT id, file_path, file_content, created_at, updated_at "
-        "FROM bot_files WHERE bot_id = $1::uuid ORDER BY file_path ASC");
-    
-    db_->prepareStatement("get_user_bots",
-        "SELECT id, user_id, COALESCE(bot_user_id::text, ''), bot_token, bot_username, bot_name, flow_json, is_active, created_at, deployed_at, "
-        "COALESCE(bot_description, ''), COALESCE(bot_avatar_url, '') "
-        "FROM bot_builder_bots WHERE user_id = $1 ORDER BY created_at DESC");
-    db_->prepareStatement("get_bot_builder_bot_by_token",
-        "SELECT id, user_id, COALESCE(bot_user_id::text, ''), bot_token, bot_username, bot_name, flow_json, is_active, created_at, deployed_at, "
-        "COALESCE(bot_description, ''), COALESCE(bot_avatar_url, '') "
-        "FROM bot_builder_bots WHERE bot_token = $1");
-    db_->prepareStatement("get_bot_builder_bot_by_username",
-        "SELECT id, user_id, COALESCE(bot_user_id::text, ''), bot_token, bot_username, bot_name, flow_json, is_active, created_at, deployed_at, "
-        "COALESCE(bot_description, ''), COALESCE(bot_avatar_url, '') "
-        "FROM bot_builder_bots WHERE bot_username = $1");
-    db_->prepareStatement("get_bot_builder_bot_by_id",
-        "SELECT id, user_id, COALESCE(bot_user_id::text, ''), bot_token, bot_username, bot_name, flow_json, is_active, created_at, deployed_at, "
-        "COALESCE(bot_description, ''), COALESCE(bot_avatar_url, '') "
-        "FROM bot_builder_bots WHERE id = $1");
-    db_->prepareStatement("get_bot_builder_bot_by_user_id",
-        "SELECT id, user_id, COALESCE(bot_user_id::text, ''), bot_token, bot_username, bot_name, flow_json, is_active, created_at, deployed_at, "
-        "COALESCE(bot_description, ''), COALESCE(bot_avatar_url, '') "
-        "FROM bot_builder_bots WHERE bot_user_id = $1::uuid");
-    db_->prepareStatement("update_bot_builder_profile",
-        "UPDATE bot_builder_bots SET bot_name = $1, bot_description = $2, updated_at = CURRENT_TIMESTAMP WHERE id = $3");
-    db_->prepareStatement("update_bot_builder_avatar",
-        "UPDATE bot_builder_bots SET bot_avatar_url = $1, updated_at = CURRENT_TIMESTAMP WHERE id = $2");
-    db_->prepareStatement("get_bot_builder_script_by_bot_user_id",
-        "SELECT COALESCE(script_lang, 'lite'), COALESCE(script_enabled, FALSE), COALESCE(script_code, '') "
-        "FROM bot_builder_bots WHERE bot_user_id = $1::uuid LIMIT 1");
-    db_->prepareStatement("get_bot_builder_script_by_id",
-        "SELECT COALESCE(script_lang, 'lite'), COALESCE(script_enabled, FALSE), COALESCE(script_code, '') "
-        "FROM bot_builder_bots WHERE id = $1::uuid LIMIT 1");
-    db_->prepareStatement("update_bot_builder_script",
-        "UPDATE bot_builder_bots SET script_lang = $1, script_enabled = $2::boolean, script_code = $3, updated_at = CURRENT_TIMESTAMP "
-        "WHERE id = $4::uuid");
-    db_->prepareStatement("log_bot_execution",
-        "INSERT INTO bot_execution_logs (bot_id, update_id, user_id, chat_id, node_id, node_type, execution_result, execution_time_ms, error_message) "
-        "VALUES ($1, $2, $3, $4, $5, $6, $7::jsonb, $8, $9)");
-
-    // Bot runtime: notes
-    db_->prepareStatement("upsert_bot_note",
-        "INSERT INTO bot_notes (bot_user_id, scope_type, scope_id, note_key, note_value, created_by) "
-        "VALUES ($1::uuid, $2, $3::uuid, $4, $5, NULLIF($6,'')::uuid) "
-        "ON CONFLICT (bot_user_id, scope_type, scope_id, note_key) "
-        "DO UPDATE SET note_value = EXCLUDED.note_value, updated_at = now(), created_by = EXCLUDED.created_by");
-    db_->prepareStatement("get_bot_note",
-        "SELECT note_value FROM bot_notes "
-        "WHERE bot_user_id = $1::uuid AND scope_type = $2 AND scope_id = $3::uuid AND note_key = $4 "
-        "LIMIT 1");
-    db_->prepareStatement("list_bot_notes",
-        "SELECT note_key FROM bot_notes "
-        "WHERE bot_user_id = $1::uuid AND scope_type = $2 AND scope_id = $3::uuid "
-        "ORDER BY note_key ASC LIMIT 200");
-    db_->prepareStatement("delete_bot_note",
-        "DELETE FROM bot_notes "
-        "WHERE bot_user_id = $1::uuid AND scope_type = $2 AND scope_id = $3::uuid AND note_key = $4");
-
-    // Bot runtime: reminders
-    db_->prepareStatement("create_bot_reminder",
-        "INSERT INTO bot_reminders (bot_user_id, scope_type, scope_id, target_user_id, reminder_text, due_at) "
-        "VALUES ($1::uuid, $2, $3::uuid, NULLIF($4,'')::uuid, $5, now() + ($6::text || ' seconds')::interval) "
-        "RETURNING id::text");
-    db_->prepareStatement("claim_due_bot_reminders",
-        "WITH due AS ("
-        "  SELECT id FROM bot_reminders "
-        "  WHERE sent_at IS NULL AND due_at <= now() "
-        "  ORDER BY due_at ASC "
-        "  LIMIT $1"
-        ") "
-        "UPDATE bot_reminders br "
-        "SET sent_at = now() "
-        "WHERE br.id IN (SELECT id FROM due) "
-        "RETURNING br.id::text, br.bot_user_id::text, br.scope_type, br.scope_id::text, COALESCE(br.target_user_id::text,''), br.reminder_text");
-
-    // Bot runtime: group bots (members)
-    db_->prepareStatement("get_group_bot_user_ids",
-        "SELECT gm.user_id::text "
-        "FROM group_members gm "
-        "JOIN bot_builder_bots b ON b.bot_user_id = gm.user_id "
-        "WHERE gm.group_id = $1::uuid AND b.is_active = TRUE");
-    
-    // Event Router statements
-    db_->prepareStatement("create_trigger_rule",
-        "INSERT INTO trigger_rules (chat_id, chat_type, rule_name, trigger_conditions, actions, rate_limit_per_second, created_by) "
-        "VALUES ($1, $2, $3, $4::jsonb, $5::jsonb, $6, $7) RETURNING id");
-    db_->prepareStatement("update_trigger_rule",
-        "UPDATE trigger_rules SET trigger_conditions = $1::jsonb, actions = $2::jsonb, is_active = $3, rate_limit_per_second = $4 WHERE id = $5");
-    db_->prepareStatement("delete_trigger_rule",
-        "DELETE FROM trigger_rules WHERE id = $1");
-    db_->prepareStatement("get_trigger_rules",
-        "SELECT id, chat_id, chat_type, rule_name, trigger_conditions, actions, is_active, rate_limit_per_second, created_at, created_by "
-        "FROM trigger_rules WHERE chat_id = $1 AND chat_type = $2 AND is_active = TRUE");
-    db_->prepareStatement("create_event_webhook",
-        "INSERT INTO event_webhooks (trigger_rule_id, webhook_url, secret_token, http_method, headers_json) "
-        "VALUES ($1, $2, $3, $4, $5::jsonb) RETURNING id");
-    db_->prepareStatement("log_trigger_execution",
-        "INSERT INTO trigger_executions (trigger_rule_id, event_type, event_data, execution_result, status, error_message) "
-        "VALUES ($1, $2, $3::jsonb, $4::jsonb, $5, $6)");
-
-    // Advanced chats/supergroups (v2 unified)
-    db_->prepareStatement("create_chat_v2",
-        "INSERT INTO chats (type, title, username, about, is_public, slow_mode_sec, sign_messages, created_by) "
-        "VALUES ($1::chat_type, $2, NULLIF($3, ''), NULLIF($4, ''), $5::boolean, NULLIF($6, '0')::integer, $7::boolean, $8::uuid) "
-        "RETURNING id");
-    db_->prepareStatement("update_chat_title_v2",
-        "UPDATE chats SET title = $1 WHERE id = $2::uuid");
-    db_->prepareStatement("update_chat_about_v2",
-        "UPDATE chats SET about = $1 WHERE id = $2::uuid");
-    db_->prepareStatement("update_chat_username_v2",
-        "UPDATE chats SET username = NULLIF($1, '') WHERE id = $2::uuid");
-    db_->prepareStatement("update_chat_is_public_v2",
-        "UPDATE chats SET is_public = $1::boolean WHERE id = $2::uuid");
-    db_->prepareStatement("update_chat_sign_messages_v2",
-        "UPDATE chats SET sign_messages = $1::boolean WHERE id = $2::uuid");
-    db_->prepareStatement("insert_chat_sequence_v2",
-        "INSERT INTO chat_sequences (chat_id, next_local) VALUES ($1::uuid, 1) ON CONFLICT (chat_id) DO NOTHING");
-    db_->prepareStatement("insert_chat_participant_owner_v2",
-        "INSERT INTO chat_participants (chat_id, user_id, status) VALUES ($1::uuid, $2::uuid, 'owner') "
-        "ON CONFLICT (chat_id, user_id) DO UPDATE SET status = 'owner', admin_role_id = NULL");
-    db_->prepareStatement("upsert_chat_member_v2",
-        "INSERT INTO chat_participants (chat_id, user_id, status) VALUES ($1::uuid, $2::uuid, 'member') "
-        "ON CONFLICT (chat_id, user_id) DO UPDATE SET status = 'member', admin_role_id = NULL");
-    db_->prepareStatement("leave_chat_v2",
-        "UPDATE chat_participants SET status = 'left', admin_role_id = NULL WHERE chat_id = $1::uuid AND user_id = $2::uuid");
-    db_->prepareStatement("get_chat_type_v2",
-        "SELECT type FROM chats WHERE id = $1::uuid");
-    db_->prepareStatement("insert_chat_link_v2",
-        "INSERT INTO chat_links (channel_id, discussion_id) VALUES ($1::uuid, $2::uuid) "
-        "ON CONFLICT (channel_id) DO UPDATE SET discussion_id = EXCLUDED.discussion_id");
-    db_->prepareStatement("upsert_admin_role_v2",
-        "INSERT INTO admin_roles (chat_id, title, perms) VALUES ($1::uuid, $2, $3::bigint) "
-        "ON CONFLICT (chat_id, title) DO UPDATE SET perms = EXCLUDED.perms "
-        "RETURNING id, perms");
-    db_->prepareStatement("upsert_participant_admin_v2",
-        "INSERT INTO chat_participants (chat_id, user_id, status, admin_role_id) VALUES ($1::uuid, $2::uuid, 'admin', $3::uuid) "
-        "ON CONFLICT (chat_id, user_id) DO UPDATE SET status = 'admin', admin_role_id = EXCLUDED.admin_role_id");
-    db_->prepareStatement("set_owner_adminrole_v2",
-        "UPDATE chat_participants SET admin_role_id = $2::uuid WHERE chat_id = $1::uuid AND user_id = $3::uuid");
-    db_->prepareStatement("get_participant_role_v2",
-        "SELECT status, admin_role_id FROM chat_participants WHERE chat_id = $1::uuid AND user_id = $2::uuid");
-    db_->prepareStatement("get_admin_role_perms_v2",
-        "SELECT perms FROM admin_roles WHERE id = $1::uuid");
-    db_->prepareStatement("get_participant_restriction_v2",
-        "SELECT can_send_messages, can_send_media, can_add_links, can_invite_users, until "
-        "FROM participant_restrictions "
-        "WHERE chat_id = $1::uuid AND user_id = $2::uuid AND (until IS NULL OR until > now())");
-    db_->prepareStatement("get_chat_v2",
-        "SELECT id, type, title, COALESCE(username, ''), COALESCE(about, ''), COALESCE(avatar_url, ''), is_public, "
-        "COALESCE(sign_messages, true), COALESCE(slow_mode_sec, 0), created_by, created_at, COALESCE(is_verified, false) "
-        "FROM chats WHERE id = $1::uuid");
-    db_->prepareStatement("get_chat_by_username_v2",
-        "SELECT id, type, title, COALESCE(username, ''), COALESCE(about, ''), COALESCE(avatar_url, ''), is_public, "
-        "COALESCE(sign_messages, true), COALESCE(slow_mode_sec, 0), created_by, created_at, COALESCE(is_verified, false) "
-        "FROM chats WHERE username = $1");
-    db_->prepareStatement("get_user_channels_v2",
-        "SELECT c.id, c.title, COALESCE(c.about, ''), COALESCE(c.username, ''), COALESCE(c.avatar_url, ''), c.is_public, "
-        "COALESCE(c.sign_messages, true), c.created_by, c.created_at, COALESCE(c.is_verified, false) "
-        "FROM chats c "
-        "JOIN chat_participants cp ON cp.chat_id = c.id "
-        "WHERE c.type = 'channel' AND cp.user_id = $1::uuid AND cp.status NOT IN ('kicked','left') "
-        "ORDER BY c.created_at DESC");
-    db_->prepareStatement("get_channel_members_v2",
-        "SELECT cp.user_id, COALESCE(u.username, ''), cp.status::text, cp.joined_at::text, "
-        "       COALESCE(ar.perms, 0), COALESCE(ar.title, '') "
-        "FROM chat_participants cp "
-        "LEFT JOIN users u ON u.id = cp.user_id "
-        "LEFT JOIN admin_roles ar ON ar.id = cp.admin_role_id "
-        "WHERE cp.chat_id = $1::uuid AND cp.status != 'left'");
-    db_->prepareStatement("get_chat_link_v2",
-        "SELECT discussion_id FROM chat_links WHERE channel_id = $1::uuid");
-    db_->prepareStatement("get_chat_participant_v2",
-        "SELECT status::text, admin_role_id::text, joined_at::text "
-        "FROM chat_participants WHERE chat_id = $1::uuid AND user_id = $2::uuid");
-    db_->prepareStatement("update_chat_participant_status_v2",
-        "UPDATE chat_participants SET status = $3::participant_status, admin_role_id = NULL "
-        "WHERE chat_id = $1::uuid AND user_id = $2::uuid");
-    db_->prepareStatement("demote_chat_admin_v2",
-        "UPDATE chat_participants SET status = 'member', admin_role_id = NULL "
-        "WHERE chat_id = $1::uuid AND user_id = $2::uuid");
-    db_->prepareStatement("update_chat_avatar_v2",
-        "UPDATE chats SET avatar_url = NULLIF($1, '') WHERE id = $2::uuid");
-    db_->prepareStatement("delete_chat_v2",
-        "DELETE FROM chats WHERE id = $1::uuid");
-    db_->prepareStatement("update_channel_avatar",
-        "UPDATE channels SET avatar_url = NULLIF($1, '') WHERE id = $2");
-    db_->prepareStatement("inc_local_id_v2",
-        "UPDATE chat_sequences SET next_local = next_local + 1 WHERE chat_id = $1::uuid RETURNING next_local");
-    db_->prepareStatement("insert_chat_message_v2",
-        "INSERT INTO chat_messages (chat_id, local_id, sender_id, replied_to, thread_root_id, content_type, content, is_silent) "
-        "VALUES ($1::uuid, $2::bigint, $3::uuid, $4::bigint, $5::bigint, $6, $7::jsonb, $8::boolean) "
-        "RETURNING id");
-    // Reactions v2
-    db_->prepareStatement("insert_reaction_counts_v2",
-        "INSERT INTO message_reaction_counts (message_id, counts) VALUES ($1::bigint, '{}'::jsonb) ON CONFLICT DO NOTHING");
-    db_->prepareStatement("insert_reaction_shard_v2",
-        "INSERT INTO message_reactions_shard (shard, message_id, user_id, reaction) VALUES ($1::smallint, $2::bigint, $3::uuid, $4) "
-        "ON CONFLICT DO NOTHING");
-    db_->prepareStatement("delete_reaction_shard_v2",
-        "DELETE FROM message_reactions_shard WHERE shard = $1::smallint AND message_id = $2::bigint AND user_id = $3::uuid AND reaction = $4");
-    db_->prepareStatement("update_reaction_count_v2",
-        "UPDATE message_reaction_counts SET counts = jsonb_set(COALESCE(counts, '{}'::jsonb), "
-        "ARRAY[$2], to_jsonb(GREATEST(0, COALESCE((counts->>$2)::bigint, 0) + $3))) "
-        "WHERE message_id = $1::bigint RETURNING counts");
-    db_->prepareStatement("get_reaction_counts_v2",
-        "SELECT counts FROM message_reaction_counts WHERE message_id = $1::bigint");
-    db_->prepareStatement("get_reaction_counts_kv_v2",
-        "SELECT key, (value)::bigint FROM message_reaction_counts, LATERAL jsonb_each(counts) WHERE message_id = $1::bigint");
-    db_->prepareStatement("get_chat_messages_v2",
-        "SELECT m.id, m.local_id, m.sender_id, COALESCE(u.username, ''), m.content, m.content_type, m.is_silent, m.created_at, "
-        "       (cp.message_id IS NOT NULL) AS is_pinned "
-        "FROM chat_messages m "
-        "LEFT JOIN users u ON u.id = m.sender_id "
-        "LEFT JOIN chat_pins cp ON cp.chat_id = m.chat_id AND cp.message_id = m.id "
-        "WHERE m.chat_id = $1::uuid "
-        "AND ($2::bigint = 0 OR local_id < $2::bigint) "
-        "ORDER BY local_id DESC LIMIT $3");
-
-    db_->prepareStatement("pin_chat_message_v2",
-        "INSERT INTO chat_pins (chat_id, message_id, pinned_by) "
-        "VALUES ($1::uuid, $2::bigint, $3::uuid) "
-        "ON CONFLICT (chat_id) DO UPDATE "
-        "SET message_id = EXCLUDED.message_id, pinned_by = EXCLUDED.pinned_by, pinned_at = now()");
-    db_->prepareStatement("unpin_chat_message_v2",
-        "DELETE FROM chat_pins WHERE chat_id = $1::uuid");
-    db_->prepareStatement("get_chat_message_meta_v2",
-        "SELECT chat_id::text, COALESCE(sender_id::text, '') "
-        "FROM chat_messages WHERE id = $1::bigint");
-    db_->prepareStatement("delete_chat_message_v2",
-        "DELETE FROM chat_messages WHERE id = $1::bigint AND chat_id = $2::uuid");
-
-    db_->prepareStatement("upsert_channel_read_state_v2",
-        "INSERT INTO channel_read_states (channel_id, user_id, max_read_local) "
-        "VALUES ($1::uuid, $2::uuid, $3::bigint) "
-        "ON CONFLICT (channel_id, user_id) "
-        "DO UPDATE SET max_read_local = GREATEST(channel_read_states.max_read_local, EXCLUDED.max_read_local), "
-        "updated_at = now()");
-
-    db_->prepareStatement("get_channel_unread_v2",
-        "SELECT (COALESCE(cs.next_local,1)-1) - COALESCE(crs.max_read_local,0) AS unread "
-        "FROM channel_sequences cs "
-        "LEFT JOIN channel_read_states crs ON crs.channel_id = cs.channel_id AND crs.user_id = $2::uuid "
-        "WHERE cs.channel_id = $1::uuid");
-
-    // Join requests + reactions (v2 chats)
-    db_->prepareStatement("create_chat_join_request",
-        "INSERT INTO chat_join_requests (chat_id, user_id) VALUES ($1::uuid, $2::uuid) "
-        "ON CONFLICT (chat_id, user_id) DO NOTHING");
-    db_->prepareStatement("accept_chat_join_request",
-        "UPDATE chat_join_requests SET status = 'accepted' WHERE chat_id = $1::uuid AND user_id = $2::uuid");
-    db_->prepareStatement("reject_chat_join_request",
-        "UPDATE chat_join_requests SET status = 'rejected' WHERE chat_id = $1::uuid AND user_id = $2::uuid");
-    db_->prepareStatement("get_chat_join_requests",
-        "SELECT cjr.id, cjr.chat_id, cjr.user_id, COALESCE(u.username, ''), cjr.created_at "
-        "FROM chat_join_requests cjr JOIN users u ON u.id = cjr.user_id "
-        "WHERE cjr.chat_id = $1::uuid AND cjr.status = 'pending'");
-    db_->prepareStatement("add_chat_allowed_reaction",
-        "INSERT INTO chat_allowed_reactions (chat_id, reaction) VALUES ($1::uuid, $2) "
-        "ON CONFLICT (chat_id, reaction) DO NOTHING");
-    db_->prepareStatement("remove_chat_allowed_reaction",
-        "DELETE FROM chat_allowed_reactions WHERE chat_id = $1::uuid AND reaction = $2");
-    db_->prepareStatement("get_chat_allowed_reactions",
-        "SELECT reaction FROM chat_allowed_reactions WHERE chat_id = $1::uuid");
-
-    // Chat invites (v2)
-    db_->prepareStatement("create_chat_invite_v2",
-        "INSERT INTO chat_invite_links (chat_id, token, expire_at, usage_limit, created_by) "
-        "VALUES ($1::uuid, uuid_generate_v4()::text, "
-        "CASE WHEN $3::int > 0 THEN now() + ($3::text || ' seconds')::interval ELSE NULL END, "
-        "NULLIF($4::int, 0), $2::uuid) RETURNING token");
-    db_->prepareStatement("revoke_chat_invite_v2",
-        "UPDATE chat_invite_links SET is_revoked = TRUE WHERE token = $1");
-    db_->prepareStatement("get_chat_invite_v2",
-        "SELECT chat_id, expire_at, usage_limit, usage_count, is_revoked FROM chat_invite_links WHERE token = $1");
-    db_->prepareStatement("inc_chat_invite_usage_v2",
-        "UPDATE chat_invite_links SET usage_count = usage_count + 1 WHERE token = $1");
-
-    // Channel invites (legacy)
-    db_->prepareStatement("create_channel_invite_legacy",
-        "INSERT INTO channel_invite_links (channel_id, token, expire_at, usage_limit, created_by) "
-        "VALUES ($1::uuid, uuid_generate_v4()::text, "
-        "CASE WHEN $3::int > 0 THEN now() + ($3::text || ' seconds')::interval ELSE NULL END, "
-        "NULLIF($4::int, 0), $2::uuid) RETURNING token");
-    db_->prepareStatement("revoke_channel_invite_legacy",
-        "UPDATE channel_invite_links SET is_revoked = TRUE WHERE token = $1");
-    db_->prepareStatement("get_channel_invite_legacy",
-        "SELECT channel_id, expire_at, usage_limit, usage_count, is_revoked FROM channel_invite_links WHERE token = $1");
-    db_->prepareStatement("inc_channel_invite_usage_legacy",
-        "UPDATE channel_invite_links SET usage_count = usage_count + 1 WHERE token = $1");
-    db_->prepareStatement("get_channel_subscribers_v2",
-        "SELECT user_id FROM chat_participants WHERE chat_id = $1::uuid AND status IN ('owner','admin','member')");
-    db_->prepareStatement("count_chat_subscribers_v2",
-        "SELECT COUNT(*) FROM chat_participants WHERE chat_id = $1::uuid AND status IN ('owner','admin','member')");
-    db_->prepareStatement("count_chat_members_v2",
-        "SELECT COUNT(*) FROM chat_participants WHERE chat_id = $1::uuid AND status != 'left'");
-
-    // Polls v2 (supports chat, channel, group)
-    db_->prepareStatement("insert_poll_v2",
-        "INSERT INTO polls (message_id, message_type, question, is_anonymous, allows_multiple, closes_at) "
-        "VALUES ($1::bigint, $2, $3, $4::boolean, $5::boolean, NULLIF($6,'')::timestamptz) RETURNING id");
-    db_->prepareStatement("insert_poll_option_v2",
-        "INSERT INTO poll_options (poll_id, option_text) VALUES ($1::bigint, $2) RETURNING id");
-    db_->prepareStatement("vote_poll_v2",
-        "INSERT INTO poll_votes (poll_id, option_id, user_id) VALUES ($1::bigint, $2::bigint, $3::uuid) "
-        "ON CONFLICT DO NOTHING");
-    db_->prepareStatement("inc_poll_option_v2",
-        "UPDATE poll_options SET vote_count = vote_count + 1 WHERE id = $1::bigint RETURNING vote_count");
-    db_->prepareStatement("get_poll_v2",
-        "SELECT p.id, p.message_id, p.message_type, p.question, p.is_anonymous, p.allows_multiple, p.closes_at, "
-        "po.id, po.option_text, po.vote_count "
-        "FROM polls p JOIN poll_options po ON p.id = po.poll_id WHERE p.id = $1::bigint");
-    db_->prepareStatement("get_poll_by_message",
-        "SELECT p.id, p.message_id, p.message_type, p.question, p.is_anonymous, p.allows_multiple, p.closes_at, "
-        "po.id, po.option_text, po.vote_count "
-        "FROM polls p JOIN poll_options po ON p.id = po.poll_id "
-        "WHERE p.message_type = $1 AND p.message_id = $2::bigint");
-
-    // Moderation reports
-    db_->prepareStatement("create_message_report",
-        "INSERT INTO message_reports (reporter_id, reported_user_id, message_id, message_type, message_content, reason, comment, context_json) "
-        "VALUES ($1::uuid, $2::uuid, $3, $4, $5, $6, NULLIF($7, ''), COALESCE($8::jsonb, '[]'::jsonb)) RETURNING id");
-    db_->prepareStatement("get_message_reports_paginated",
-        "SELECT r.id, r.reporter_id, COALESCE(rep.username, '') as reporter_username, "
-        "r.reported_user_id, COALESCE(u.username, '') as reported_username, "
-        "r.message_id, r.message_type, r.message_content, r.reason, COALESCE(r.comment,''), "
-        "r.context_json, r.status, COALESCE(r.resolution_note,''), r.resolved_by, "
-        "r.resolved_at, r.created_at "
-        "FROM message_reports r "
-        "LEFT JOIN users u ON u.id = r.reported_user_id "
-        "LEFT JOIN users rep ON rep.id = r.reporter_id "
-        "WHERE ($3 = '' OR r.status = $3) "
-        "ORDER BY r.created_at DESC "
-        "LIMIT $1 OFFSET $2");
-    db_->prepareStatement("count_message_reports",
-        "SELECT COUNT(*) FROM message_reports WHERE ($1 = '' OR status = $1)");
-    db_->prepareStatement("count_reports_for_user_window",
-        "SELECT COUNT(*) FROM message_reports "
-        "WHERE reported_user_id = $1::uuid "
-        "AND ($2 = '' OR reason = $2) "
-        "AND status <> 'dismissed' "
-        "AND created_at >= (now() - ($3::text || ' minutes')::interval)");
-    db_->prepareStatement("get_message_report_by_id",
-        "SELECT r.id, r.reporter_id, COALESCE(rep.username, '') as reporter_username, "
-        "r.reported_user_id, COALESCE(u.username, '') as reported_username, "
-        "r.message_id, r.message_type, r.message_content, r.reason, COALESCE(r.comment,''), "
-        "r.context_json, r.status, COALESCE(r.resolution_note,''), r.resolved_by, "
-        "r.resolved_at, r.created_at "
-        "FROM message_reports r "
-        "LEFT JOIN users u ON u.id = r.reported_user_id "
-        "LEFT JOIN users rep ON rep.id = r.reporter_id "
-        "WHERE r.id = $1::uuid");
-    db_->prepareStatement("update_message_report_status",
-        "UPDATE message_reports SET status = $2, resolved_by = NULLIF($3, '')::uuid, "
-        "resolution_note = NULLIF($4, ''), "
-        "resolved_at = CASE WHEN $2 IN ('resolved','dismissed') THEN NOW() ELSE resolved_at END "
-        "WHERE id = $1::uuid");
-    db_->prepareStatement("get_message_context",
-        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id "
-        "FROM messages "
-        "WHERE ((sender_id = $1::uuid AND receiver_id = $2::uuid) OR (sender_id = $2::uuid AND receiver_id = $1::uuid)) "
-        "AND created_at BETWEEN (SELECT created_at FROM messages WHERE id = $3::uuid) - INTERVAL '15 minutes' "
-        "AND (SELECT created_at FROM messages WHERE id = $3::uuid) + INTERVAL '15 minutes' "
-        "ORDER BY created_at ASC LIMIT $4");
+void DatabaseManager::prepareStatements() {
+    db_->registerStatements(kPreparedStatements, kPreparedStatementCount);
 }
 
 bool DatabaseManager::createUser(const std::string& username, const std::string& password_hash) {
@@ -1638,33 +941,12 @@ User DatabaseManager::getUserByUsername(const std::string& username) {
     const char* param_values[1] = {username.c_str()};
     
     PGresult* res = db_->executePrepared("get_user_by_username", 1, param_values);
-    if (!res) {
-        // Prepared statements may be lost after DB reconnect; re-prepare once and retry
-        Logger::getInstance().warning("Prepared statement get_user_by_username missing, re-preparing statements");
-        prepareStatements();
-        res = db_->executePrepared("get_user_by_username", 1, param_values);
-        if (!res) {
-            return user;
-        }
-    }
     if (!res || PQntuples(res) == 0) {
         if (res) PQclear(res);
         return user;
     }
     
-    user.id = PQgetvalue(res, 0, 0);
-    user.username = PQgetvalue(res, 0, 1);
-    user.password_hash = PQgetvalue(res, 0, 2);
-    user.created_at = PQgetvalue(res, 0, 3);
-    user.is_active = (strcmp(PQgetvalue(res, 0, 4), "t") == 0);
-    user.is_admin = (strcmp(PQgetvalue(res, 0, 5), "t") == 0);
-    user.role = PQgetvalue(res, 0, 6);
-    user.totp_secret = PQgetvalue(res, 0, 7);
-    user.admin_ip_whitelist = PQgetvalue(res, 0, 8);
-    user.is_bot = (strcmp(PQgetvalue(res, 0, 9), "t") == 0);
-    user.is_premium = (strcmp(PQgetvalue(res, 0, 10), "t") == 0);
-    user.premium_plan = PQgetvalue(res, 0, 11);
-    user.premium_expires_at = PQgetvalue(res, 0, 12);
+    kUserRow.read(res, 0, user);
     
     PQclear(res);
     return user;
@@ -1672,32 +954,62 @@ User DatabaseManager::getUserByUsername(const std::string& username) {
 
 User DatabaseManager::getUserById(const std::string& user_id) {
     User user;
+    uint64_t ticket = 0;
+    if (user_cache_.get(user_id, &user, &ticket)) {
+        return user;
+    }
     const char* param_values[1] = {user_id.c_str()};
     
     PGresult* res = db_->executePrepared("get_user_by_id", 1, param_values);
-    if (!res || PQntuples(res) == 0) {
-        if (res) PQclear(res);
-        return user;
+    user = userFromResult(res);
+    if (res) PQclear(res);
+    if (!user.id.empty()) {
+        user_cache_.put(user_id, user, &ticket);
     }
-    
-    user.id = PQgetvalue(res, 0, 0);
-    user.username = PQgetvalue(res, 0, 1);
-    user.password_hash = PQgetvalue(res, 0, 2);
-    user.created_at = PQgetvalue(res, 0, 3);
-    user.is_active = (strcmp(PQgetvalue(res, 0, 4), "t") == 0);
-    user.is_admin = (strcmp(PQgetvalue(res, 0, 5), "t") == 0);
-    user.role = PQgetvalue(res, 0, 6);
-    user.totp_secret = PQgetvalue(res, 0, 7);
-    user.admin_ip_whitelist = PQgetvalue(res, 0, 8);
-    user.is_bot = (strcmp(PQgetvalue(res, 0, 9), "t") == 0);
-    user.is_premium = (strcmp(PQgetvalue(res, 0, 10), "t") == 0);
-    user.premium_plan = PQgetvalue(res, 0, 11);
-    user.premium_expires_at = PQgetvalue(res, 0, 12);
-    
-    PQclear(res);
     return user;
 }
 
+size_t DatabaseManager::queueUserById(PipelineBatch& batch, const std::string& user_id) {
+    return batch.addPrepared("get_user_by_id", {user_id});
+}
+
+User DatabaseManager::userFromResult(const PGresult* res) {
+    return kUserRow.first(res);
+}
+
+std::vector<User> DatabaseManager::getUsersByIds(const std::vector<std::string>& user_ids) {
+    std::vector<User> users(user_ids.size());
+    // Only the cache misses go to the database
+    std::vector<size_t> missing;
+    std::vector<uint64_t> tickets;
+    for (size_t i = 0; i < user_ids.size(); ++i) {
+        uint64_t ticket = 0;
+        if (!user_cache_.get(user_ids[i], &users[i], &ticket)) {
+            missing.push_back(i);
+            tickets.push_back(ticket);
+        }
+    }
+    if (missing.empty()) {
+        return users;
+    }
+    PipelineBatch batch;
+    for (size_t i : missing) {
+        queueUserById(batch, user_ids[i]);
+    }
+    PipelineResults results;
+    if (!db_->executePipeline(batch, results)) {
+        Logger::getInstance().error("Failed to fetch users: " + db_->getLastError());
+    }
+    for (size_t j = 0; j < missing.size(); ++j) {
+        User& user = users[missing[j]];
+        user = j < results.size() ? userFromResult(results[j].get()) : User();
+        if (!user.id.empty()) {
+            user_cache_.put(user_ids[missing[j]], user, &tickets[j]);
+        }
+    }
+    return users;
+}
+
 bool DatabaseManager::usernameExists(const std::string& username) {
     const char* param_values[1] = {username.c_str()};
     
@@ -1724,20 +1036,14 @@ bool DatabaseManager::updateLastLogin(const std::string& user_id) {
 }
 
 bool DatabaseManager::updateLastActivity(const std::string& user_id) {
-    const char* param_values[1] = {user_id.c_str()};
-    PGresult* res = db_->executePrepared("update_last_activity", 1, param_values);
-    if (!res) {
-        return false;
-    }
-    
-    bool success = (PQresultStatus(res) == PGRES_COMMAND_OK);
-    PQclear(res);
-    return success;
+    presence_->touch(user_id);
+    return true;
 }
 
 bool DatabaseManager::updateUserAvatar(const std::string& user_id, const std::string& avatar_url) {
     const char* param_values[2] = {avatar_url.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("update_user_avatar", 2, param_values);
+    public_user_cache_.erase(user_id);
     if (!res) {
         return false;
     }
@@ -1754,6 +1060,7 @@ bool DatabaseManager::setUserPremium(const std::string& user_id, bool is_premium
         plan.c_str()
     };
     PGresult* res = db_->executePrepared("set_user_premium", 3, params);
+    user_cache_.erase(user_id);
     if (!res) return false;
     bool ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
     PQclear(res);
@@ -1893,34 +1200,66 @@ std::vector<AdminPremiumPayment> DatabaseManager::listPremiumPayments(const std:
 }
 
 std::string DatabaseManager::getUserLastActivity(const std::string& user_id) {
-    const char* param_values[1] = {user_id.c_str()};
-    PGresult* res = db_->executePrepared("get_user_last_activity", 1, param_values);
-    if (!res || PQntuples(res) == 0) {
-        if (res) PQclear(res);
-        return "";
-    }
-    
-    std::string last_activity = "";
-    if (!PQgetisnull(res, 0, 0)) {
-        last_activity = PQgetvalue(res, 0, 0);
-    }
-    
-    PQclear(res);
-    return last_activity;
+    const PresenceTracker::Micros seen = lastSeenOf({user_id})[0];
+    return seen > 0 ? PresenceTracker::format(seen) : "";
 }
 
 bool DatabaseManager::isUserOnline(const std::string& user_id, int threshold_seconds) {
-    const std::string threshold_str = std::to_string(threshold_seconds);
-    const char* param_values[2] = {user_id.c_str(), threshold_str.c_str()};
-    PGresult* res = db_->executePrepared("check_user_online", 2, param_values);
-    if (!res || PQntuples(res) == 0) {
-        if (res) PQclear(res);
-        return false;
+    const PresenceTracker::Micros seen = lastSeenOf({user_id})[0];
+    return seen > 0 && PresenceTracker::now() - seen < static_cast<int64_t>(threshold_seconds) * 1000000;
+}
+
+std::vector<PresenceTracker::Micros> DatabaseManager::lastSeenOf(const std::vector<std::string>& user_ids) {
+    std::vector<PresenceTracker::Micros> seen(user_ids.size(), 0);
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < user_ids.size(); ++i) {
+        if (!user_ids[i].empty() && !presence_->lastSeen(user_ids[i], &seen[i])) {
+            missing.push_back(i);
+        }
+    }
+    if (missing.empty()) {
+        return seen;
+    }
+
+    // Ids come from our own tables and tokens; anything else would break
+    // the array literal, so it is left at "never seen"
+    std::string ids = "{";
+    for (size_t i : missing) {
+        const std::string& id = user_ids[i];
+        if (id.size() > 36 || id.find_first_not_of("0123456789abcdefABCDEF-") != std::string::npos) {
+            continue;
+        }
+        if (ids.size() > 1) ids += ',';
+        ids += id;
+    }
+    if (ids.size() == 1) {
+        return seen;
+    }
+    ids += '}';
+    PgParams<1> params;
+    params.add(ids);
+    PGresult* res = db_->executePrepared("get_users_last_seen", params);
+    if (!res) {
+        return seen;
+    }
+    std::unordered_map<std::string, PresenceTracker::Micros> loaded;
+    for (int row = 0; row < PQntuples(res); ++row) {
+        std::string id;
+        PresenceTracker::Micros micros = 0;
+        pgDecode(res, row, 0, id);
+        pgDecode(res, row, 1, micros);
+        loaded[id] = micros;
     }
-    
-    bool is_online = (strcmp(PQgetvalue(res, 0, 0), "t") == 0);
     PQclear(res);
-    return is_online;
+    for (size_t i : missing) {
+        auto it = loaded.find(user_ids[i]);
+        if (it == loaded.end()) {
+            continue;
+        }
+        presence_->remember(user_ids[i], it->second);
+        presence_->lastSeen(user_ids[i], &seen[i]);
+    }
+    return seen;
 }
 
 bool DatabaseManager::upsertUserProfile(const UserProfile& profile) {
@@ -1937,6 +1276,7 @@ bool DatabaseManager::upsertUserProfile(const UserProfile& profile) {
         by.c_str()
     };
     PGresult* res = db_->executePrepared("upsert_user_profile", 7, params);
+    profile_cache_.erase(profile.user_id);
     if (!res) return false;
     bool ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
     PQclear(res);
@@ -1944,38 +1284,27 @@ bool DatabaseManager::upsertUserProfile(const UserProfile& profile) {
 }
 
 bool DatabaseManager::getUserProfile(const std::string& user_id, UserProfile& out_profile) {
+    uint64_t ticket = 0;
+    if (profile_cache_.get(user_id, &out_profile, &ticket)) {
+        return true;
+    }
     const char* params[1] = {user_id.c_str()};
     PGresult* res = db_->executePrepared("get_user_profile", 1, params);
     if (!res) return false;
-    if (PQntuples(res) == 0) {
-        PQclear(res);
-        out_profile.user_id = user_id;
-        out_profile.first_name = "";
-        out_profile.last_name = "";
-        out_profile.bio = "";
-        out_profile.birth_day = 0;
-        out_profile.birth_month = 0;
-        out_profile.birth_year = 0;
-        out_profile.linked_channel_id = "";
-        out_profile.business_hours_json = "";
-        return true;
-    }
+    out_profile = UserProfile();
     out_profile.user_id = user_id;
-    out_profile.first_name = PQgetvalue(res, 0, 0);
-    out_profile.last_name = PQgetvalue(res, 0, 1);
-    out_profile.bio = PQgetvalue(res, 0, 2);
-    out_profile.birth_day = atoi(PQgetvalue(res, 0, 3));
-    out_profile.birth_month = atoi(PQgetvalue(res, 0, 4));
-    out_profile.birth_year = atoi(PQgetvalue(res, 0, 5));
-    out_profile.linked_channel_id = PQgetvalue(res, 0, 6);
-    out_profile.business_hours_json = PQgetvalue(res, 0, 7);
+    if (PQntuples(res) > 0) {
+        kUserProfileRow.read(res, 0, out_profile);
+    }
     PQclear(res);
+    profile_cache_.put(user_id, out_profile, &ticket);
     return true;
 }
 
 bool DatabaseManager::setUserLinkedChannel(const std::string& user_id, const std::string& channel_id) {
     const char* params[2] = {user_id.c_str(), channel_id.c_str()};
     PGresult* res = db_->executePrepared("upsert_user_linked_channel", 2, params);
+    profile_cache_.erase(user_id);
     if (!res) return false;
     bool ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
     PQclear(res);
@@ -1985,6 +1314,7 @@ bool DatabaseManager::setUserLinkedChannel(const std::string& user_id, const std
 bool DatabaseManager::setUserBusinessHours(const std::string& user_id, const std::string& business_hours_json) {
     const char* params[2] = {user_id.c_str(), business_hours_json.c_str()};
     PGresult* res = db_->executePrepared("set_user_business_hours", 2, params);
+    profile_cache_.erase(user_id);
     if (!res) return false;
     bool ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
     PQclear(res);
@@ -2002,6 +1332,7 @@ bool DatabaseManager::upsertUserPrivacy(const std::string& user_id, const UserPr
         send_read_receipts.c_str()
     };
     PGresult* res = db_->executePrepared("upsert_user_privacy", 6, params);
+    privacy_cache_.erase(user_id);
     if (!res) return false;
     bool ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
     PQclear(res);
@@ -2009,6 +1340,10 @@ bool DatabaseManager::upsertUserPrivacy(const std::string& user_id, const UserPr
 }
 
 bool DatabaseManager::getUserPrivacy(const std::string& user_id, UserPrivacySettings& out_settings) {
+    uint64_t ticket = 0;
+    if (privacy_cache_.get(user_id, &out_settings, &ticket)) {
+        return true;
+    }
     const char* params[1] = {user_id.c_str()};
     PGresult* res = db_->executePrepared("get_user_privacy", 1, params);
     if (!res) return false;
@@ -2020,6 +1355,7 @@ bool DatabaseManager::getUserPrivacy(const std::string& user_id, UserPrivacySett
         out_settings.last_seen_visibility = "contacts";
         out_settings.avatar_visibility = "everyone";
         out_settings.send_read_receipts = true;
+        privacy_cache_.put(user_id, out_settings, &ticket);
         return true;
     }
     out_settings.bio_visibility = PQgetvalue(res, 0, 0);
@@ -2028,10 +1364,18 @@ bool DatabaseManager::getUserPrivacy(const std::string& user_id, UserPrivacySett
     out_settings.avatar_visibility = PQgetvalue(res, 0, 3);
     out_settings.send_read_receipts = (strcmp(PQgetvalue(res, 0, 4), "t") == 0);
     PQclear(res);
+    privacy_cache_.put(user_id, out_settings, &ticket);
     return true;
 }
 
 bool DatabaseManager::getUserPublic(const std::string& user_id, std::string& out_username, std::string& out_avatar_url) {
+    PublicUser cached;
+    uint64_t ticket = 0;
+    if (public_user_cache_.get(user_id, &cached, &ticket)) {
+        out_username = cached.username;
+        out_avatar_url = cached.avatar_url;
+        return true;
+    }
     const char* params[1] = {user_id.c_str()};
     PGresult* res = db_->executePrepared("get_user_public", 1, params);
     if (!res || PQntuples(res) == 0) {
@@ -2041,9 +1385,32 @@ bool DatabaseManager::getUserPublic(const std::string& user_id, std::string& out
     out_username = PQgetvalue(res, 0, 1);
     out_avatar_url = PQgetvalue(res, 0, 2);
     PQclear(res);
+    public_user_cache_.put(user_id, PublicUser{out_username, out_avatar_url}, &ticket);
     return true;
 }
 
+DatabaseManager::EntityCacheStats DatabaseManager::entityCacheStats() const {
+    EntityCacheStats stats;
+    stats.users = user_cache_.stats();
+    stats.profiles = profile_cache_.stats();
+    stats.privacy = privacy_cache_.stats();
+    stats.public_users = public_user_cache_.stats();
+    return stats;
+}
+
+DatabaseManager::MembershipCacheStats DatabaseManager::membershipCacheStats() const {
+    MembershipCacheStats stats;
+    stats.chat_permissions = chat_permission_cache_.stats();
+    stats.group_members = group_member_cache_.stats();
+    stats.channel_members = channel_member_cache_.stats();
+    return stats;
+}
+
+std::string DatabaseManager::membershipKey(const std::string& chat_id, const std::string& user_id) {
+    // '\n' never occurs in ids or usernames
+    return chat_id + '\n' + user_id;
+}
+
 int DatabaseManager::countUserChannelsV2(const std::string& user_id) {
     const char* params[1] = {user_id.c_str()};
     PGresult* res = db_->executePrepared("count_user_channels_v2", 1, params);
@@ -2262,6 +1629,7 @@ bool DatabaseManager::areFriends(const std::string& user1_id, const std::string&
 bool DatabaseManager::setUserActive(const std::string& user_id, bool is_active) {
     const char* param_values[2] = {user_id.c_str(), is_active ? "true" : "false"};
     PGresult* res = db_->executePrepared("set_user_active", 2, param_values);
+    user_cache_.erase(user_id);
     if (!res) {
         return false;
     }
@@ -2273,6 +1641,7 @@ bool DatabaseManager::setUserActive(const std::string& user_id, bool is_active)
 bool DatabaseManager::updateUserPasswordHash(const std::string& user_id, const std::string& password_hash) {
     const char* param_values[2] = {user_id.c_str(), password_hash.c_str()};
     PGresult* res = db_->executePrepared("update_user_password_hash", 2, param_values);
+    user_cache_.erase(user_id);
     if (!res) {
         return false;
     }
@@ -2281,6 +1650,20 @@ bool DatabaseManager::updateUserPasswordHash(const std::string& user_id, const s
     return success;
 }
 
+bool DatabaseManager::replaceUserPasswordHash(const std::string& user_id,
+                                              const std::string& old_hash,
+                                              const std::string& new_hash) {
+    const char* param_values[3] = {user_id.c_str(), old_hash.c_str(), new_hash.c_str()};
+    PGresult* res = db_->executePrepared("replace_user_password_hash", 3, param_values);
+    user_cache_.erase(user_id);
+    if (!res) {
+        return false;
+    }
+    bool success = std::string(PQcmdTuples(res)) != "0";
+    PQclear(res);
+    return success;
+}
+
 bool DatabaseManager::deleteMessagesByUser(const std::string& user_id) {
     const char* param_values[1] = {user_id.c_str()};
     PGresult* res = db_->executePrepared("delete_messages_by_user", 1, param_values);
@@ -2339,9 +1722,10 @@ bool DatabaseManager::upsertUserSession(const std::string& token,
     return ok;
 }
 
-std::string DatabaseManager::getUserIdBySessionToken(const std::string& token) {
+std::string DatabaseManager::getUserIdBySessionToken(const std::string& token, bool* lookup_failed) {
     const char* params[1] = {token.c_str()};
     PGresult* res = db_->executePrepared("get_user_id_by_session", 1, params);
+    if (lookup_failed) *lookup_failed = (res == nullptr);
     if (!res || PQntuples(res) == 0) {
         if (res) PQclear(res);
         return "";
@@ -2363,6 +1747,45 @@ bool DatabaseManager::deleteUserSession(const std::string& token) {
     return ok;
 }
 
+bool DatabaseManager::revokeSessionId(const std::string& session_id, int64_t expires_at) {
+    PgParams<2> params;
+    params.add(session_id).addInt8(expires_at);
+    PGresult* res = db_->executePrepared("revoke_session_id", params);
+    if (!res) return false;
+    bool ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
+    PQclear(res);
+    return ok;
+}
+
+bool DatabaseManager::getRevokedSessionsSince(int64_t since_us, std::vector<RevokedSession>& out) {
+    PgParams<1> params;
+    params.addInt8(since_us);
+    PGresult* res = db_->executePrepared("get_revoked_sessions_since", params);
+    if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
+        if (res) PQclear(res);
+        return false;
+    }
+    const int rows = PQntuples(res);
+    out.reserve(out.size() + rows);
+    for (int i = 0; i < rows; ++i) {
+        RevokedSession revoked;
+        revoked.session_id = PQgetvalue(res, i, 0);
+        revoked.expires_at = std::atoll(PQgetvalue(res, i, 1));
+        revoked.revoked_at_us = std::atoll(PQgetvalue(res, i, 2));
+        out.push_back(std::move(revoked));
+    }
+    PQclear(res);
+    return true;
+}
+
+bool DatabaseManager::purgeExpiredRevokedSessions() {
+    PGresult* res = db_->executePrepared("purge_revoked_sessions", 0, nullptr);
+    if (!res) return false;
+    bool ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
+    PQclear(res);
+    return ok;
+}
+
 std::vector<UserSession> DatabaseManager::getUserSessions(const std::string& user_id) {
     std::vector<UserSession> sessions;
     const char* params[1] = {user_id.c_str()};
@@ -2449,6 +1872,8 @@ bool DatabaseManager::createChannelV2(const std::string& title,
         if (rb) PQclear(rb);
     };
 
+    auto tx = db_->pin();
+    if (!tx) return false;
     res = db_->executeQuery("BEGIN");
     if (!res) {
         return false;
@@ -2522,6 +1947,11 @@ bool DatabaseManager::createChannelV2(const std::string& title,
         return false;
     }
     PQclear(res);
+    if (!username.empty()) {
+        // "Unknown chat" answers cached under the new name
+        forgetChatMembers(chat_permission_cache_, username);
+        forgetChatMembers(chat_permission_cache_, "@" + username);
+    }
     return true;
 }
 
@@ -2548,6 +1978,8 @@ bool DatabaseManager::linkChat(const std::string& channel_id, const std::string&
         return false;
     }
 
+    auto tx = db_->pin();
+    if (!tx) return false;
     PGresult* beginRes = db_->executeQuery("BEGIN");
     if (!beginRes) {
         return false;
@@ -2578,6 +2010,8 @@ bool DatabaseManager::promoteAdmin(const std::string& chat_id,
                                    const std::string& user_id,
                                    uint64_t perms,
                                    const std::string& title) {
+    auto tx = db_->pin();
+    if (!tx) return false;
     PGresult* res = db_->executeQuery("BEGIN");
     if (!res) {
         return false;
@@ -2613,10 +2047,31 @@ bool DatabaseManager::promoteAdmin(const std::string& chat_id,
         return false;
     }
     PQclear(res);
+    // Every admin holding a role with this title got the new perms
+    forgetChatMembers(chat_permission_cache_, chat_id);
     return true;
 }
 
 ChatPermissions DatabaseManager::getChatPermissions(const std::string& chat_id, const std::string& user_id) {
+    const std::string key = membershipKey(chat_id, user_id);
+    ChatPermissions permissions;
+    uint64_t ticket = 0;
+    if (chat_permission_cache_.get(key, &permissions, &ticket)) {
+        return permissions;
+    }
+    bool cacheable = false;
+    permissions = loadChatPermissions(chat_id, user_id, &cacheable);
+    if (cacheable) {
+        chat_permission_cache_.put(key, permissions, &ticket);
+    }
+    return permissions;
+}
+
+// `cacheable` is false when chat_id was a username: writes only know the
+// chat by id and could not drop that entry.
+ChatPermissions DatabaseManager::loadChatPermissions(const std::string& chat_id,
+                                                     const std::string& user_id,
+                                                     bool* cacheable) {
     ChatPermissions permissions;
     Chat chat_meta;
     std::string resolved_chat_id = chat_id;
@@ -2657,14 +2112,19 @@ ChatPermissions DatabaseManager::getChatPermissions(const std::string& chat_id,
 
     ensureChatLoaded();
     if (chat_meta.id.empty()) {
-        // Unknown chat; return default (not found)
+        // Unknown chat; return default (not found). Kept until a chat takes
+        // this name (see updateChatUsernameV2).
+        *cacheable = true;
         return permissions;
     }
+    *cacheable = (resolved_chat_id == chat_id);
 
     const char* params[2] = {resolved_chat_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("get_participant_role_v2", 2, params);
     if (!res || PQntuples(res) == 0) {
         if (res) PQclear(res);
+        // A failed query is not an answer worth keeping
+        if (!res) *cacheable = false;
         // If the participant row is missing, fall back to creator ownership
         applyOwnerOverride();
         return permissions;
@@ -2775,6 +2235,8 @@ bool DatabaseManager::sendChannelMessageWithDiscussion(const std::string& channe
                                                        std::string* out_channel_message_id,
                                                        std::string* out_discussion_message_id) {
     // Start transaction
+    auto tx = db_->pin();
+    if (!tx) return false;
     PGresult* res = db_->executeQuery("BEGIN");
     if (!res) {
         return false;
@@ -2896,6 +2358,8 @@ bool DatabaseManager::addMessageReactionV2(const std::string& message_id,
     try { msgId = std::stoll(message_id); } catch (...) { return false; }
     const int shard = static_cast<int>((std::hash<std::string>{}(user_id) % 16));
 
+    auto tx = db_->pin();
+    if (!tx) return false;
     PGresult* res = db_->executeQuery("BEGIN");
     if (!res) return false;
     PQclear(res);
@@ -2928,6 +2392,8 @@ bool DatabaseManager::removeMessageReactionV2(const std::string& message_id,
     try { msgId = std::stoll(message_id); } catch (...) { return false; }
     const int shard = static_cast<int>((std::hash<std::string>{}(user_id) % 16));
 
+    auto tx = db_->pin();
+    if (!tx) return false;
     PGresult* res = db_->executeQuery("BEGIN");
     if (!res) return false;
     PQclear(res);
@@ -3171,6 +2637,7 @@ bool DatabaseManager::joinChannelByInviteToken(const std::string& token,
     if (is_v2_invite) {
         const char* memberParams[2] = {channel_id.c_str(), user_id.c_str()};
         PGresult* addRes = db_->executePrepared("upsert_chat_member_v2", 2, memberParams);
+        chat_permission_cache_.erase(membershipKey(channel_id, user_id));
         added = (addRes != nullptr);
         if (addRes) PQclear(addRes);
     } else {
@@ -3184,16 +2651,28 @@ bool DatabaseManager::joinChannelByInviteToken(const std::string& token,
 }
 
 std::vector<std::string> DatabaseManager::getChannelSubscriberIds(const std::string& chat_id) {
+    // Text results on purpose: formatting binary uuids client-side costs
+    // more than copying the server's text (bench/db_row_bench.cpp)
+    PgParams<1> params;
+    params.add(chat_id);
+    PGresult* res = db_->executePrepared("get_channel_subscribers_v2", params);
+    std::vector<std::string> ids = channelSubscriberIdsFromResult(res);
+    if (res) PQclear(res);
+    return ids;
+}
+
+size_t DatabaseManager::queueChannelSubscriberIds(PipelineBatch& batch, const std::string& chat_id) {
+    return batch.addPrepared("get_channel_subscribers_v2", {chat_id});
+}
+
+std::vector<std::string> DatabaseManager::channelSubscriberIdsFromResult(const PGresult* res) {
     std::vector<std::string> ids;
-    const char* params[1] = {chat_id.c_str()};
-    PGresult* res = db_->executePrepared("get_channel_subscribers_v2", 1, params);
-    if (!res) return ids;
+    if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) return ids;
     int rows = PQntuples(res);
-    ids.reserve(rows);
+    ids.resize(rows);
     for (int i = 0; i < rows; ++i) {
-        ids.emplace_back(PQgetvalue(res, i, 0));
+        pgDecode(res, i, 0, ids[i]);
     }
-    PQclear(res);
     return ids;
 }
 
@@ -3261,6 +2740,11 @@ bool DatabaseManager::updateChatUsernameV2(const std::string& chat_id, const std
     if (!res) return false;
     bool ok = std::string(PQcmdTuples(res)) != "0";
     PQclear(res);
+    if (ok && !username.empty()) {
+        // "Unknown chat" answers cached under the new name
+        forgetChatMembers(chat_permission_cache_, username);
+        forgetChatMembers(chat_permission_cache_, "@" + username);
+    }
     return ok;
 }
 
@@ -3294,6 +2778,7 @@ bool DatabaseManager::updateChatAvatarV2(const std::string& chat_id, const std::
 bool DatabaseManager::upsertChatMemberV2(const std::string& chat_id, const std::string& user_id) {
     const char* params[2] = {chat_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("upsert_chat_member_v2", 2, params);
+    chat_permission_cache_.erase(membershipKey(chat_id, user_id));
     if (!res) return false;
     bool ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
     PQclear(res);
@@ -3303,6 +2788,7 @@ bool DatabaseManager::upsertChatMemberV2(const std::string& chat_id, const std::
 bool DatabaseManager::leaveChatV2(const std::string& chat_id, const std::string& user_id) {
     const char* params[2] = {chat_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("leave_chat_v2", 2, params);
+    chat_permission_cache_.erase(membershipKey(chat_id, user_id));
     if (!res) return false;
     bool ok = std::string(PQcmdTuples(res)) != "0";
     PQclear(res);
@@ -3312,6 +2798,7 @@ bool DatabaseManager::leaveChatV2(const std::string& chat_id, const std::string&
 bool DatabaseManager::demoteChatAdminV2(const std::string& chat_id, const std::string& user_id) {
     const char* params[2] = {chat_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("demote_chat_admin_v2", 2, params);
+    chat_permission_cache_.erase(membershipKey(chat_id, user_id));
     if (!res) return false;
     bool ok = std::string(PQcmdTuples(res)) != "0";
     PQclear(res);
@@ -3338,6 +2825,7 @@ ChatParticipant DatabaseManager::getChatParticipantV2(const std::string& chat_id
 bool DatabaseManager::updateChatParticipantStatusV2(const std::string& chat_id, const std::string& user_id, const std::string& status) {
     const char* params[3] = {chat_id.c_str(), user_id.c_str(), status.c_str()};
     PGresult* res = db_->executePrepared("update_chat_participant_status_v2", 3, params);
+    chat_permission_cache_.erase(membershipKey(chat_id, user_id));
     if (!res) return false;
     bool ok = std::string(PQcmdTuples(res)) != "0";
     PQclear(res);
@@ -3408,6 +2896,7 @@ std::vector<DatabaseManager::ChannelMember> DatabaseManager::getChannelMembersV2
 bool DatabaseManager::deleteChatV2(const std::string& chat_id) {
     const char* params[1] = {chat_id.c_str()};
     PGresult* res = db_->executePrepared("delete_chat_v2", 1, params);
+    forgetChatMembers(chat_permission_cache_, chat_id);
     if (!res) return false;
     bool ok = std::string(PQcmdTuples(res)) != "0";
     PQclear(res);
@@ -3499,6 +2988,8 @@ bool DatabaseManager::createPollV2(const std::string& message_id,
                                    const std::vector<std::string>& options,
                                    const std::string& closes_at_iso) {
     if (options.empty()) return false;
+    auto tx = db_->pin();
+    if (!tx) return false;
     PGresult* res = db_->executeQuery("BEGIN");
     if (!res) return false;
     PQclear(res);
@@ -3532,6 +3023,8 @@ bool DatabaseManager::createPollV2(const std::string& message_id,
 bool DatabaseManager::votePollV2(const std::string& poll_id,
                                  const std::string& option_id,
                                  const std::string& user_id) {
+    auto tx = db_->pin();
+    if (!tx) return false;
     PGresult* res = db_->executeQuery("BEGIN");
     if (!res) return false;
     PQclear(res);
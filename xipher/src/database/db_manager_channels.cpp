@@ -1,8 +1,10 @@
 #include "../include/database/db_manager.hpp"
+#include "../include/database/db_rows.hpp"
 #include "../include/utils/logger.hpp"
 #include <sstream>
 #include <cstring>
 #include <map>
+#include <algorithm>
 
 namespace xipher {
 
@@ -72,16 +74,7 @@ DatabaseManager::Channel DatabaseManager::getChannelById(const std::string& chan
     PGresult* res = db_->executePrepared("get_channel_by_id", 1, param_values);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
-        channel.id = std::string(PQgetvalue(res, 0, 0));
-        channel.name = std::string(PQgetvalue(res, 0, 1));
-        channel.description = PQgetisnull(res, 0, 2) ? "" : std::string(PQgetvalue(res, 0, 2));
-        channel.creator_id = std::string(PQgetvalue(res, 0, 3));
-        channel.custom_link = PQgetisnull(res, 0, 4) ? "" : std::string(PQgetvalue(res, 0, 4));
-        channel.avatar_url = PQgetisnull(res, 0, 5) ? "" : std::string(PQgetvalue(res, 0, 5));
-        channel.is_private = PQgetvalue(res, 0, 6)[0] == 't';
-        channel.show_author = PQgetvalue(res, 0, 7)[0] == 't';
-        channel.created_at = std::string(PQgetvalue(res, 0, 8));
-        channel.is_verified = !PQgetisnull(res, 0, 9) && PQgetvalue(res, 0, 9)[0] == 't';
+        kChannelRow.read(res, 0, channel);
     }
     
     if (res) PQclear(res);
@@ -94,16 +87,7 @@ DatabaseManager::Channel DatabaseManager::getChannelByCustomLink(const std::stri
     PGresult* res = db_->executePrepared("get_channel_by_custom_link", 1, param_values);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
-        channel.id = std::string(PQgetvalue(res, 0, 0));
-        channel.name = std::string(PQgetvalue(res, 0, 1));
-        channel.description = PQgetisnull(res, 0, 2) ? "" : std::string(PQgetvalue(res, 0, 2));
-        channel.creator_id = std::string(PQgetvalue(res, 0, 3));
-        channel.custom_link = std::string(PQgetvalue(res, 0, 4));
-        channel.avatar_url = PQgetisnull(res, 0, 5) ? "" : std::string(PQgetvalue(res, 0, 5));
-        channel.is_private = PQgetvalue(res, 0, 6)[0] == 't';
-        channel.show_author = PQgetvalue(res, 0, 7)[0] == 't';
-        channel.created_at = std::string(PQgetvalue(res, 0, 8));
-        channel.is_verified = !PQgetisnull(res, 0, 9) && PQgetvalue(res, 0, 9)[0] == 't';
+        kChannelRow.read(res, 0, channel);
     }
     
     if (res) PQclear(res);
@@ -115,22 +99,7 @@ std::vector<DatabaseManager::Channel> DatabaseManager::getUserChannels(const std
     const char* param_values[1] = {user_id.c_str()};
     PGresult* res = db_->executePrepared("get_user_channels", 1, param_values);
     
-    if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
-        for (int i = 0; i < PQntuples(res); i++) {
-            Channel channel;
-            channel.id = std::string(PQgetvalue(res, i, 0));
-            channel.name = std::string(PQgetvalue(res, i, 1));
-            channel.description = PQgetisnull(res, i, 2) ? "" : std::string(PQgetvalue(res, i, 2));
-            channel.creator_id = std::string(PQgetvalue(res, i, 3));
-            channel.custom_link = PQgetisnull(res, i, 4) ? "" : std::string(PQgetvalue(res, i, 4));
-            channel.avatar_url = PQgetisnull(res, i, 5) ? "" : std::string(PQgetvalue(res, i, 5));
-            channel.is_private = PQgetvalue(res, i, 6)[0] == 't';
-            channel.show_author = PQgetvalue(res, i, 7)[0] == 't';
-            channel.created_at = std::string(PQgetvalue(res, i, 8));
-            channel.is_verified = !PQgetisnull(res, i, 9) && PQgetvalue(res, i, 9)[0] == 't';
-            channels.push_back(channel);
-        }
-    }
+    channels = kChannelRow.all(res);
     
     if (res) PQclear(res);
     return channels;
@@ -139,6 +108,7 @@ std::vector<DatabaseManager::Channel> DatabaseManager::getUserChannels(const std
 bool DatabaseManager::addChannelMember(const std::string& channel_id, const std::string& user_id, const std::string& role) {
     const char* param_values[3] = {channel_id.c_str(), user_id.c_str(), role.c_str()};
     PGresult* res = db_->executePrepared("add_channel_member", 3, param_values);
+    channel_member_cache_.erase(membershipKey(channel_id, user_id));
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         if (res) PQclear(res);
@@ -174,11 +144,16 @@ bool DatabaseManager::sendChannelMessage(const std::string& channel_id, const st
     return true;
 }
 
-std::vector<DatabaseManager::ChannelMessage> DatabaseManager::getChannelMessages(const std::string& channel_id, int limit) {
+std::vector<DatabaseManager::ChannelMessage> DatabaseManager::getChannelMessages(const std::string& channel_id, int limit,
+                                                                               const std::string& before_id,
+                                                                               const std::string& after_id) {
     std::vector<ChannelMessage> messages;
-    const std::string limit_str = std::to_string(limit);
-    const char* param_values[2] = {channel_id.c_str(), limit_str.c_str()};
-    PGresult* res = db_->executePrepared("get_channel_messages", 2, param_values);
+    const std::string& cursor = !before_id.empty() ? before_id : after_id;
+    const char* suffix = !before_id.empty() ? "_before" : (!after_id.empty() ? "_after" : "");
+    PgParams<3> params;
+    params.add(channel_id).addInt8(limit);
+    if (!cursor.empty()) params.add(cursor);
+    PGresult* res = db_->executePrepared(std::string("get_channel_messages") + suffix, params);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
         for (int i = 0; i < PQntuples(res); i++) {
@@ -200,6 +175,10 @@ std::vector<DatabaseManager::ChannelMessage> DatabaseManager::getChannelMessages
     }
     
     if (res) PQclear(res);
+    if (before_id.empty() && !after_id.empty()) {
+        // _after pages come oldest first
+        std::reverse(messages.begin(), messages.end());
+    }
     return messages;
 }
 
@@ -290,6 +269,7 @@ int DatabaseManager::getMessageViewsCount(const std::string& message_id) {
 bool DatabaseManager::removeChannelMember(const std::string& channel_id, const std::string& user_id) {
     const char* param_values[2] = {channel_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("remove_channel_member", 2, param_values);
+    channel_member_cache_.erase(membershipKey(channel_id, user_id));
     bool success = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
     if (res) PQclear(res);
     return success;
@@ -298,6 +278,7 @@ bool DatabaseManager::removeChannelMember(const std::string& channel_id, const s
 bool DatabaseManager::updateChannelMemberRole(const std::string& channel_id, const std::string& user_id, const std::string& role) {
     const char* param_values[3] = {role.c_str(), channel_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("update_channel_member_role", 3, param_values);
+    channel_member_cache_.erase(membershipKey(channel_id, user_id));
     bool success = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
     if (res) PQclear(res);
     return success;
@@ -306,6 +287,7 @@ bool DatabaseManager::updateChannelMemberRole(const std::string& channel_id, con
 bool DatabaseManager::banChannelMember(const std::string& channel_id, const std::string& user_id, bool banned) {
     const char* param_values[3] = {banned ? "true" : "false", channel_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("ban_channel_member", 3, param_values);
+    channel_member_cache_.erase(membershipKey(channel_id, user_id));
     bool success = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
     if (res) PQclear(res);
     return success;
@@ -335,7 +317,12 @@ std::vector<DatabaseManager::ChannelMember> DatabaseManager::getChannelMembers(c
 }
 
 DatabaseManager::ChannelMember DatabaseManager::getChannelMember(const std::string& channel_id, const std::string& user_id) {
+    const std::string key = membershipKey(channel_id, user_id);
     ChannelMember member;
+    uint64_t ticket = 0;
+    if (channel_member_cache_.get(key, &member, &ticket)) {
+        return member;
+    }
     const char* param_values[2] = {channel_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("get_channel_member", 2, param_values);
     
@@ -348,6 +335,10 @@ DatabaseManager::ChannelMember DatabaseManager::getChannelMember(const std::stri
         member.is_banned = PQgetvalue(res, 0, 5)[0] == 't';
         member.joined_at = std::string(PQgetvalue(res, 0, 6));
     }
+    if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
+        // An empty member (not subscribed) is cached too
+        channel_member_cache_.put(key, member, &ticket);
+    }
     
     if (res) PQclear(res);
     return member;
@@ -588,6 +579,7 @@ bool DatabaseManager::updateChannelAvatar(const std::string& channel_id, const s
 bool DatabaseManager::deleteChannelLegacy(const std::string& channel_id) {
     const char* params[1] = {channel_id.c_str()};
     PGresult* res = db_->executePrepared("delete_channel_legacy", 1, params);
+    forgetChatMembers(channel_member_cache_, channel_id);
     if (!res) return false;
     bool ok = std::string(PQcmdTuples(res)) != "0";
     PQclear(res);
@@ -630,10 +622,8 @@ std::vector<DatabaseManager::Channel> DatabaseManager::getPublicChannels(const s
         params.push_back(p.c_str());
     }
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 
-                                  static_cast<int>(params.size()), nullptr, 
-                                  params.empty() ? nullptr : params.data(), 
-                                  nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, static_cast<int>(params.size()),
+                                        params.empty() ? nullptr : params.data());
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
         for (int i = 0; i < PQntuples(res); i++) {
@@ -660,7 +650,7 @@ int DatabaseManager::getChannelSubscribersCount(const std::string& channel_id) {
     // channel_members is the table for subscribers (not channel_subscribers)
     std::string query = "SELECT COUNT(*) FROM channel_members WHERE channel_id = $1 AND is_banned = false";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 1, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 1, params);
     
     int count = 0;
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
@@ -678,7 +668,7 @@ bool DatabaseManager::isChannelSubscriber(const std::string& channel_id, const s
     // channel_members is the table for subscribers (not channel_subscribers)
     std::string query = "SELECT 1 FROM channel_members WHERE channel_id = $1 AND user_id = $2 AND is_banned = false LIMIT 1";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, params);
     
     bool is_subscriber = (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0);
     
@@ -692,7 +682,7 @@ bool DatabaseManager::setChannelPublicDirectory(const std::string& channel_id, b
     std::string query = "UPDATE channels SET is_private = " + is_private_str + ", category = $1 WHERE id = $2";
     
     const char* params[2] = {category.c_str(), channel_id.c_str()};
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, params);
     
     bool success = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
     if (res) PQclear(res);
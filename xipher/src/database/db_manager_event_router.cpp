@@ -121,10 +121,9 @@ std::optional<DatabaseManager::TriggerRule> DatabaseManager::getTriggerRuleById(
     
     const char* param_values[1] = {rule_id.c_str()};
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 1, nullptr, 
-                                  param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 1, param_values);
     if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
-        Logger::getInstance().error("Failed to get trigger rule by id: " + std::string(PQerrorMessage(db_->getConnection())));
+        Logger::getInstance().error("Failed to get trigger rule by id: " + db_->getLastError());
         if (res) PQclear(res);
         return std::nullopt;
     }
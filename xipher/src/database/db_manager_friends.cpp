@@ -1,12 +1,58 @@
 #include "../include/database/db_manager.hpp"
+#include "../include/database/db_rows.hpp"
 #include "../include/utils/logger.hpp"
 #include <sstream>
+#include <cctype>
 #include <cstring>
 #include <algorithm>
 #include <cstdlib>
 
 namespace xipher {
 
+namespace {
+
+// Columns of get_message_reports_paginated / get_message_reports_before
+std::vector<Report> reportsFromResult(PGresult* res) {
+    std::vector<Report> reports;
+    int rows = PQntuples(res);
+    for (int i = 0; i < rows; ++i) {
+        Report r;
+        r.id = PQgetvalue(res, i, 0);
+        r.reporter_id = PQgetvalue(res, i, 1);
+        r.reporter_username = PQgetvalue(res, i, 2);
+        r.reported_user_id = PQgetvalue(res, i, 3);
+        r.reported_username = PQgetvalue(res, i, 4);
+        r.message_id = PQgetvalue(res, i, 5);
+        r.message_type = PQgetisnull(res, i, 6) ? "direct" : std::string(PQgetvalue(res, i, 6));
+        r.message_content = PQgetvalue(res, i, 7);
+        r.reason = PQgetvalue(res, i, 8);
+        r.comment = PQgetvalue(res, i, 9);
+        r.context_json = PQgetisnull(res, i, 10) ? "[]" : std::string(PQgetvalue(res, i, 10));
+        r.status = PQgetvalue(res, i, 11);
+        r.resolution_note = PQgetvalue(res, i, 12);
+        r.resolved_by = PQgetisnull(res, i, 13) ? "" : std::string(PQgetvalue(res, i, 13));
+        r.resolved_at = PQgetisnull(res, i, 14) ? "" : std::string(PQgetvalue(res, i, 14));
+        r.created_at = PQgetvalue(res, i, 15);
+        reports.push_back(r);
+    }
+    return reports;
+}
+
+bool looksLikeUuid(const std::string& text) {
+    if (text.size() != 36) {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        const bool dash = (i == 8 || i == 13 || i == 18 || i == 23);
+        if (dash ? text[i] != '-' : !std::isxdigit(static_cast<unsigned char>(text[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 std::vector<Friend> DatabaseManager::getFriends(const std::string& user_id) {
     std::vector<Friend> friends;
     
@@ -96,46 +142,58 @@ bool DatabaseManager::sendMessage(const std::string& sender_id, const std::strin
     return success;
 }
 
-std::vector<Message> DatabaseManager::getMessages(const std::string& user1_id, const std::string& user2_id, int limit) {
-    std::vector<Message> messages;
-    
-    std::string limit_str = std::to_string(limit);
+std::vector<Message> DatabaseManager::getMessages(const std::string& user1_id, const std::string& user2_id, int limit,
+                                                  const std::string& before_id, const std::string& after_id) {
     PGresult* res = nullptr;
+    const std::string& cursor = !before_id.empty() ? before_id : after_id;
+    const char* suffix = !before_id.empty() ? "_before" : (!after_id.empty() ? "_after" : "");
     
+    // LIMIT $n is bigint: sent in binary, no to_string
     // Если это избранные сообщения (user1_id == user2_id), используем специальный запрос
     if (user1_id == user2_id) {
-        const char* param_values[2] = {user1_id.c_str(), limit_str.c_str()};
-        res = db_->executePrepared("get_saved_messages", 2, param_values);
+        PgParams<3> params;
+        params.add(user1_id).addInt8(limit);
+        if (!cursor.empty()) params.add(cursor);
+        res = db_->executePrepared(std::string("get_saved_messages") + suffix, params);
     } else {
-        const char* param_values[3] = {user1_id.c_str(), user2_id.c_str(), limit_str.c_str()};
-        res = db_->executePrepared("get_messages", 3, param_values);
+        PgParams<4> params;
+        params.add(user1_id).add(user2_id).addInt8(limit);
+        if (!cursor.empty()) params.add(cursor);
+        res = db_->executePrepared(std::string("get_messages") + suffix, params);
     }
     
-    if (!res) {
-        return messages;
+    std::vector<Message> messages = kPinnedMessageRow.all(res);
+    if (res) PQclear(res);
+    if (before_id.empty() && !after_id.empty()) {
+        // _after pages come oldest first
+        std::reverse(messages.begin(), messages.end());
     }
-    
-    int rows = PQntuples(res);
-    for (int i = 0; i < rows; i++) {
-        Message msg;
-        msg.id = PQgetvalue(res, i, 0);
-        msg.sender_id = PQgetvalue(res, i, 1);
-        msg.receiver_id = PQgetvalue(res, i, 2);
-        msg.content = PQgetvalue(res, i, 3);
-        msg.created_at = PQgetvalue(res, i, 4);
-        msg.is_read = (strcmp(PQgetvalue(res, i, 5), "t") == 0);
-        msg.is_delivered = (strcmp(PQgetvalue(res, i, 6), "t") == 0);
-        msg.message_type = (PQgetisnull(res, i, 7)) ? "text" : std::string(PQgetvalue(res, i, 7));
-        msg.file_path = (PQgetisnull(res, i, 8)) ? "" : std::string(PQgetvalue(res, i, 8));
-        msg.file_name = (PQgetisnull(res, i, 9)) ? "" : std::string(PQgetvalue(res, i, 9));
-        msg.file_size = (PQgetisnull(res, i, 10)) ? 0 : std::stoll(PQgetvalue(res, i, 10));
-        msg.reply_to_message_id = (PQgetisnull(res, i, 11)) ? "" : std::string(PQgetvalue(res, i, 11));
-        msg.reply_markup = (PQgetisnull(res, i, 12)) ? "" : std::string(PQgetvalue(res, i, 12));
-        msg.is_pinned = (PQgetisnull(res, i, 13)) ? false : (PQgetvalue(res, i, 13)[0] == 't');
-        messages.push_back(msg);
+    return messages;
+}
+
+std::vector<Message> DatabaseManager::searchMessagesInChat(const std::string& user1_id, const std::string& user2_id,
+                                                           const std::string& query, int limit,
+                                                           const std::string& cursor_id) {
+    const std::string ts_query = searchQueryFor(query);
+    if (ts_query.empty()) {
+        return {};
+    }
+    PgParams<5> params;
+    params.add(user1_id);
+    if (!user2_id.empty()) {
+        params.add(user2_id);
     }
+    params.add(ts_query);
+    if (cursor_id.empty()) {
+        params.addNull();
+    } else {
+        params.add(cursor_id);
+    }
+    params.addInt8(limit);
+    PGresult* res = db_->executePrepared(user2_id.empty() ? "search_user_messages" : "search_direct_messages", params);
     
-    PQclear(res);
+    std::vector<Message> messages = kMessageRow.all(res);
+    if (res) PQclear(res);
     return messages;
 }
 
@@ -187,19 +245,7 @@ Message DatabaseManager::getLastMessage(const std::string& user1_id, const std::
         return msg;
     }
     
-    msg.id = PQgetvalue(res, 0, 0);
-    msg.sender_id = PQgetvalue(res, 0, 1);
-    msg.receiver_id = PQgetvalue(res, 0, 2);
-    msg.content = PQgetvalue(res, 0, 3);
-    msg.created_at = PQgetvalue(res, 0, 4);
-    msg.is_read = (strcmp(PQgetvalue(res, 0, 5), "t") == 0);
-    msg.is_delivered = (strcmp(PQgetvalue(res, 0, 6), "t") == 0);
-    msg.message_type = (PQgetisnull(res, 0, 7)) ? "text" : std::string(PQgetvalue(res, 0, 7));
-    msg.file_path = (PQgetisnull(res, 0, 8)) ? "" : std::string(PQgetvalue(res, 0, 8));
-    msg.file_name = (PQgetisnull(res, 0, 9)) ? "" : std::string(PQgetvalue(res, 0, 9));
-    msg.file_size = (PQgetisnull(res, 0, 10)) ? 0 : std::stoll(PQgetvalue(res, 0, 10));
-    msg.reply_to_message_id = (PQgetisnull(res, 0, 11)) ? "" : std::string(PQgetvalue(res, 0, 11));
-    msg.reply_markup = (PQgetisnull(res, 0, 12)) ? "" : std::string(PQgetvalue(res, 0, 12));
+    kMessageRow.read(res, 0, msg);
     
     PQclear(res);
     return msg;
@@ -214,24 +260,86 @@ Message DatabaseManager::getMessageById(const std::string& message_id) {
         return msg;
     }
 
-    msg.id = PQgetvalue(res, 0, 0);
-    msg.sender_id = PQgetvalue(res, 0, 1);
-    msg.receiver_id = PQgetvalue(res, 0, 2);
-    msg.content = PQgetvalue(res, 0, 3);
-    msg.created_at = PQgetvalue(res, 0, 4);
-    msg.is_read = (strcmp(PQgetvalue(res, 0, 5), "t") == 0);
-    msg.is_delivered = (strcmp(PQgetvalue(res, 0, 6), "t") == 0);
-    msg.message_type = (PQgetisnull(res, 0, 7)) ? "text" : std::string(PQgetvalue(res, 0, 7));
-    msg.file_path = (PQgetisnull(res, 0, 8)) ? "" : std::string(PQgetvalue(res, 0, 8));
-    msg.file_name = (PQgetisnull(res, 0, 9)) ? "" : std::string(PQgetvalue(res, 0, 9));
-    msg.file_size = (PQgetisnull(res, 0, 10)) ? 0 : std::stoll(PQgetvalue(res, 0, 10));
-    msg.reply_to_message_id = (PQgetisnull(res, 0, 11)) ? "" : std::string(PQgetvalue(res, 0, 11));
-    msg.reply_markup = (PQgetisnull(res, 0, 12)) ? "" : std::string(PQgetvalue(res, 0, 12));
+    kMessageRow.read(res, 0, msg);
 
     PQclear(res);
     return msg;
 }
 
+std::vector<Message> DatabaseManager::getMessagesByIds(const std::vector<std::string>& message_ids) {
+    PipelineBatch batch;
+    for (const auto& id : message_ids) {
+        batch.addPrepared("get_message_by_id", {id});
+    }
+    PipelineResults results;
+    if (!db_->executePipeline(batch, results)) {
+        Logger::getInstance().error("Failed to fetch messages: " + db_->getLastError());
+    }
+    std::vector<Message> messages(message_ids.size());
+    for (size_t i = 0; i < results.size() && i < messages.size(); ++i) {
+        if (pipelineRowsOk(results[i]) && PQntuples(results[i].get()) > 0) {
+            kMessageRow.read(results[i].get(), 0, messages[i]);
+        }
+    }
+    return messages;
+}
+
+std::vector<DatabaseManager::PeerSummary> DatabaseManager::getPeerSummaries(const std::vector<std::string>& peer_ids,
+                                                                           int online_threshold_seconds) {
+    // Per peer: user and profile, from the entity caches where possible;
+    // the misses go out in one pipeline. Presence comes from PresenceTracker.
+    std::vector<PeerSummary> summaries(peer_ids.size());
+    const size_t kNotQueued = static_cast<size_t>(-1);
+    std::vector<size_t> user_query(peer_ids.size(), kNotQueued);
+    std::vector<size_t> profile_query(peer_ids.size(), kNotQueued);
+    std::vector<uint64_t> user_ticket(peer_ids.size(), 0);
+    std::vector<uint64_t> profile_ticket(peer_ids.size(), 0);
+    PipelineBatch batch;
+    for (size_t i = 0; i < peer_ids.size(); ++i) {
+        const std::string& peer_id = peer_ids[i];
+        if (!user_cache_.get(peer_id, &summaries[i].user, &user_ticket[i])) {
+            user_query[i] = queueUserById(batch, peer_id);
+        }
+        if (!profile_cache_.get(peer_id, &summaries[i].profile, &profile_ticket[i])) {
+            profile_query[i] = batch.addPrepared("get_user_profile", {peer_id});
+        }
+    }
+    PipelineResults results;
+    if (!batch.empty() && !db_->executePipeline(batch, results)) {
+        Logger::getInstance().error("Failed to fetch peer summaries: " + db_->getLastError());
+    }
+    results.resize(batch.size());
+
+    for (size_t i = 0; i < peer_ids.size(); ++i) {
+        PeerSummary& summary = summaries[i];
+        if (user_query[i] != kNotQueued) {
+            summary.user = userFromResult(results[user_query[i]].get());
+            if (!summary.user.id.empty()) {
+                user_cache_.put(peer_ids[i], summary.user, &user_ticket[i]);
+            }
+        }
+        if (profile_query[i] != kNotQueued) {
+            const PgResult& res = results[profile_query[i]];
+            summary.profile.user_id = peer_ids[i];
+            if (pipelineRowsOk(res)) {
+                if (PQntuples(res.get()) > 0) {
+                    kUserProfileRow.read(res.get(), 0, summary.profile);
+                }
+                profile_cache_.put(peer_ids[i], summary.profile, &profile_ticket[i]);
+            }
+        }
+    }
+    const std::vector<PresenceTracker::Micros> seen = lastSeenOf(peer_ids);
+    const PresenceTracker::Micros now = PresenceTracker::now();
+    for (size_t i = 0; i < peer_ids.size(); ++i) {
+        if (seen[i] > 0) {
+            summaries[i].online = now - seen[i] < static_cast<int64_t>(online_threshold_seconds) * 1000000;
+            summaries[i].last_activity = PresenceTracker::format(seen[i]);
+        }
+    }
+    return summaries;
+}
+
 bool DatabaseManager::deleteMessageById(const std::string& message_id) {
     const char* params[1] = { message_id.c_str() };
     PGresult* res = db_->executePrepared("delete_message_by_id", 1, params);
@@ -245,14 +353,11 @@ bool DatabaseManager::deleteMessageById(const std::string& message_id) {
 }
 
 int DatabaseManager::getUnreadCount(const std::string& user_id, const std::string& sender_id) {
-    const char* param_values[2] = {user_id.c_str(), sender_id.c_str()};
-    PGresult* res = db_->executePrepared("get_unread_count", 2, param_values);
-    if (!res) {
-        return 0;
-    }
-    
-    int count = atoi(PQgetvalue(res, 0, 0));
-    PQclear(res);
+    PgParams<2> params;
+    params.add(user_id).add(sender_id);
+    PGresult* res = db_->executePrepared("get_unread_count", params, PgFormat::Binary);
+    const int count = static_cast<int>(pgScalar<int64_t>(res));
+    if (res) PQclear(res);
     return count;
 }
 
@@ -316,6 +421,56 @@ std::vector<Friend> DatabaseManager::getChatPartners(const std::string& user_id)
     return partners;
 }
 
+std::vector<DatabaseManager::ChatSummary> DatabaseManager::getChatSummaries(const std::string& user_id,
+                                                                           int online_threshold_seconds) {
+    std::vector<ChatSummary> chats;
+    PgParams<2> params;
+    params.add(user_id).addInt4(online_threshold_seconds);
+    PGresult* res = db_->executePrepared("get_chat_summaries", params);
+    if (!res) {
+        return chats;
+    }
+    
+    // Columns 0-12 are the last message, in kMessageRow order
+    int rows = PQntuples(res);
+    chats.reserve(rows);
+    for (int i = 0; i < rows; i++) {
+        ChatSummary chat;
+        if (!PQgetisnull(res, i, 0)) {
+            kMessageRow.read(res, i, chat.last_message);
+        }
+        pgDecode(res, i, 13, chat.partner.id);
+        chat.partner.user_id = chat.partner.id;
+        pgDecode(res, i, 14, chat.partner.username);
+        pgDecode(res, i, 15, chat.partner.avatar_url);
+        pgDecode(res, i, 16, chat.partner.created_at);
+        pgDecode(res, i, 17, chat.unread);
+        pgDecode(res, i, 18, chat.is_bot);
+        pgDecode(res, i, 19, chat.is_premium);
+        pgDecode(res, i, 20, chat.online);
+        if (!PQgetisnull(res, i, 21)) {
+            pgDecode(res, i, 21, chat.last_activity);
+        }
+        pgDecode(res, i, 22, chat.first_name);
+        pgDecode(res, i, 23, chat.last_name);
+        chats.push_back(std::move(chat));
+    }
+    
+    PQclear(res);
+
+    // The query sees last_activity as of the last presence flush; activity
+    // this process already knows about is newer
+    const PresenceTracker::Micros now = PresenceTracker::now();
+    for (auto& chat : chats) {
+        PresenceTracker::Micros seen = 0;
+        if (presence_->lastSeen(chat.partner.id, &seen) && seen > 0) {
+            chat.online = now - seen < static_cast<int64_t>(online_threshold_seconds) * 1000000;
+            chat.last_activity = PresenceTracker::format(seen);
+        }
+    }
+    return chats;
+}
+
 bool DatabaseManager::hasSavedMessages(const std::string& user_id) {
     const char* param_values[1] = {user_id.c_str()};
     PGresult* res = db_->executePrepared("has_saved_messages", 1, param_values);
@@ -337,32 +492,11 @@ std::vector<Message> DatabaseManager::getMessageContext(const std::string& user1
         return messages;
     }
 
-    const std::string limitStr = std::to_string(limit);
-    const char* params[4] = {user1_id.c_str(), user2_id.c_str(), message_id.c_str(), limitStr.c_str()};
-    PGresult* res = db_->executePrepared("get_message_context", 4, params);
-    if (!res) {
-        return messages;
-    }
-
-    int rows = PQntuples(res);
-    for (int i = 0; i < rows; ++i) {
-        Message msg;
-        msg.id = PQgetvalue(res, i, 0);
-        msg.sender_id = PQgetvalue(res, i, 1);
-        msg.receiver_id = PQgetvalue(res, i, 2);
-        msg.content = PQgetvalue(res, i, 3);
-        msg.created_at = PQgetvalue(res, i, 4);
-        msg.is_read = (strcmp(PQgetvalue(res, i, 5), "t") == 0);
-        msg.is_delivered = (strcmp(PQgetvalue(res, i, 6), "t") == 0);
-        msg.message_type = (PQgetisnull(res, i, 7)) ? "text" : std::string(PQgetvalue(res, i, 7));
-        msg.file_path = (PQgetisnull(res, i, 8)) ? "" : std::string(PQgetvalue(res, i, 8));
-        msg.file_name = (PQgetisnull(res, i, 9)) ? "" : std::string(PQgetvalue(res, i, 9));
-        msg.file_size = (PQgetisnull(res, i, 10)) ? 0 : std::stoll(PQgetvalue(res, i, 10));
-        msg.reply_to_message_id = (PQgetisnull(res, i, 11)) ? "" : std::string(PQgetvalue(res, i, 11));
-        messages.push_back(msg);
-    }
-
-    PQclear(res);
+    PgParams<4> params;
+    params.add(user1_id).add(user2_id).add(message_id).addInt8(limit);
+    PGresult* res = db_->executePrepared("get_message_context", params);
+    messages = kMessageContextRow.all(res);
+    if (res) PQclear(res);
     return messages;
 }
 
@@ -395,6 +529,23 @@ bool DatabaseManager::createReport(const std::string& reporter_id,
     return true;
 }
 
+std::vector<Report> DatabaseManager::getReportsBefore(const std::string& before_id,
+                                                      int limit,
+                                                      const std::string& status_filter) {
+    std::vector<Report> reports;
+    if (limit < 1) limit = 10;
+
+    PgParams<3> params;
+    params.addInt8(limit).add(before_id).add(status_filter);
+    PGresult* res = db_->executePrepared("get_message_reports_before", params);
+    if (!res) {
+        return reports;
+    }
+    reports = reportsFromResult(res);
+    PQclear(res);
+    return reports;
+}
+
 std::vector<Report> DatabaseManager::getReportsPaginated(int page,
                                                          int page_size,
                                                          const std::string& status_filter) {
@@ -410,27 +561,7 @@ std::vector<Report> DatabaseManager::getReportsPaginated(int page,
         return reports;
     }
 
-    int rows = PQntuples(res);
-    for (int i = 0; i < rows; ++i) {
-        Report r;
-        r.id = PQgetvalue(res, i, 0);
-        r.reporter_id = PQgetvalue(res, i, 1);
-        r.reporter_username = PQgetvalue(res, i, 2);
-        r.reported_user_id = PQgetvalue(res, i, 3);
-        r.reported_username = PQgetvalue(res, i, 4);
-        r.message_id = PQgetvalue(res, i, 5);
-        r.message_type = PQgetisnull(res, i, 6) ? "direct" : std::string(PQgetvalue(res, i, 6));
-        r.message_content = PQgetvalue(res, i, 7);
-        r.reason = PQgetvalue(res, i, 8);
-        r.comment = PQgetvalue(res, i, 9);
-        r.context_json = PQgetisnull(res, i, 10) ? "[]" : std::string(PQgetvalue(res, i, 10));
-        r.status = PQgetvalue(res, i, 11);
-        r.resolution_note = PQgetvalue(res, i, 12);
-        r.resolved_by = PQgetisnull(res, i, 13) ? "" : std::string(PQgetvalue(res, i, 13));
-        r.resolved_at = PQgetisnull(res, i, 14) ? "" : std::string(PQgetvalue(res, i, 14));
-        r.created_at = PQgetvalue(res, i, 15);
-        reports.push_back(r);
-    }
+    reports = reportsFromResult(res);
 
     PQclear(res);
     return reports;
@@ -500,6 +631,7 @@ bool DatabaseManager::updateReportStatus(const std::string& report_id,
 bool DatabaseManager::setUserRole(const std::string& user_id, const std::string& role) {
     const char* params[2] = {user_id.c_str(), role.c_str()};
     PGresult* res = db_->executePrepared("set_user_role", 2, params);
+    user_cache_.erase(user_id);
     if (!res) {
         return false;
     }
@@ -512,6 +644,7 @@ bool DatabaseManager::setUserAdminFlag(const std::string& user_id, bool is_admin
     const std::string adminStr = is_admin ? "true" : "false";
     const char* params[2] = {user_id.c_str(), adminStr.c_str()};
     PGresult* res = db_->executePrepared("set_user_admin_flag", 2, params);
+    user_cache_.erase(user_id);
     if (!res) {
         return false;
     }
@@ -675,32 +808,60 @@ std::vector<AdminUserSummary> DatabaseManager::searchUsers(const std::string& qu
     return users;
 }
 
-std::vector<AdminMessageSummary> DatabaseManager::searchMessages(const std::string& query, int limit) {
+std::vector<AdminMessageSummary> DatabaseManager::searchMessages(const std::string& query, int limit,
+                                                                 const std::string& cursor_id) {
     std::vector<AdminMessageSummary> messages;
     if (query.empty()) {
         return messages;
     }
     if (limit < 1) limit = 20;
-    std::string pattern = "%" + query + "%";
-    std::string limitStr = std::to_string(limit);
-    const char* params[3] = {pattern.c_str(), query.c_str(), limitStr.c_str()};
-    PGresult* res = db_->executePrepared("admin_search_messages", 3, params);
-    if (!res) {
+    auto append = [&messages](PGresult* res) {
+        int rows = PQntuples(res);
+        for (int i = 0; i < rows; ++i) {
+            AdminMessageSummary m;
+            m.id = PQgetvalue(res, i, 0);
+            m.sender_id = PQgetvalue(res, i, 1);
+            m.sender_username = PQgetvalue(res, i, 2);
+            m.receiver_id = PQgetvalue(res, i, 3);
+            m.receiver_username = PQgetvalue(res, i, 4);
+            m.content = PQgetvalue(res, i, 5);
+            m.message_type = PQgetvalue(res, i, 6);
+            m.created_at = PQgetvalue(res, i, 7);
+            if (!messages.empty() && messages.front().id == m.id) {
+                continue;  // the exact-id hit, already listed
+            }
+            messages.push_back(m);
+        }
+    };
+
+    // An exact id goes first, looked up by primary key
+    if (cursor_id.empty() && looksLikeUuid(query)) {
+        PgParams<1> params;
+        params.add(query);
+        PGresult* res = db_->executePrepared("admin_get_message_summary", params);
+        if (res) {
+            append(res);
+            PQclear(res);
+        }
+    }
+
+    const std::string ts_query = searchQueryFor(query);
+    if (ts_query.empty()) {
         return messages;
     }
-    int rows = PQntuples(res);
-    for (int i = 0; i < rows; ++i) {
-        AdminMessageSummary m;
-        m.id = PQgetvalue(res, i, 0);
-        m.sender_id = PQgetvalue(res, i, 1);
-        m.sender_username = PQgetvalue(res, i, 2);
-        m.receiver_id = PQgetvalue(res, i, 3);
-        m.receiver_username = PQgetvalue(res, i, 4);
-        m.content = PQgetvalue(res, i, 5);
-        m.message_type = PQgetvalue(res, i, 6);
-        m.created_at = PQgetvalue(res, i, 7);
-        messages.push_back(m);
+    PgParams<3> params;
+    params.add(ts_query);
+    if (cursor_id.empty()) {
+        params.addNull();
+    } else {
+        params.add(cursor_id);
+    }
+    params.addInt8(limit);
+    PGresult* res = db_->executePrepared("admin_search_messages", params);
+    if (!res) {
+        return messages;
     }
+    append(res);
     PQclear(res);
     return messages;
 }
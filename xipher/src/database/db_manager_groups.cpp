@@ -1,9 +1,11 @@
 #include "../include/database/db_manager.hpp"
+#include "../include/database/db_rows.hpp"
 #include "../include/utils/logger.hpp"
 #include <sstream>
 #include <cstring>
 #include <random>
 #include <ctime>
+#include <algorithm>
 
 namespace xipher {
 
@@ -97,6 +99,7 @@ std::vector<DatabaseManager::Group> DatabaseManager::getUserGroups(const std::st
 bool DatabaseManager::addGroupMember(const std::string& group_id, const std::string& user_id, const std::string& role) {
     const char* param_values[3] = {group_id.c_str(), user_id.c_str(), role.c_str()};
     PGresult* res = db_->executePrepared("add_group_member", 3, param_values);
+    group_member_cache_.erase(membershipKey(group_id, user_id));
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         if (res) PQclear(res);
@@ -139,11 +142,16 @@ bool DatabaseManager::sendGroupMessage(const std::string& group_id, const std::s
     return true;
 }
 
-std::vector<DatabaseManager::GroupMessage> DatabaseManager::getGroupMessages(const std::string& group_id, int limit) {
+std::vector<DatabaseManager::GroupMessage> DatabaseManager::getGroupMessages(const std::string& group_id, int limit,
+                                                                           const std::string& before_id,
+                                                                           const std::string& after_id) {
     std::vector<GroupMessage> messages;
-    const std::string limit_str = std::to_string(limit);
-    const char* param_values[2] = {group_id.c_str(), limit_str.c_str()};
-    PGresult* res = db_->executePrepared("get_group_messages", 2, param_values);
+    const std::string& cursor = !before_id.empty() ? before_id : after_id;
+    const char* suffix = !before_id.empty() ? "_before" : (!after_id.empty() ? "_after" : "");
+    PgParams<3> params;
+    params.add(group_id).addInt8(limit);
+    if (!cursor.empty()) params.add(cursor);
+    PGresult* res = db_->executePrepared(std::string("get_group_messages") + suffix, params);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
         for (int i = 0; i < PQntuples(res); i++) {
@@ -168,6 +176,10 @@ std::vector<DatabaseManager::GroupMessage> DatabaseManager::getGroupMessages(con
     }
     
     if (res) PQclear(res);
+    if (before_id.empty() && !after_id.empty()) {
+        // _after pages come oldest first
+        std::reverse(messages.begin(), messages.end());
+    }
     return messages;
 }
 
@@ -258,6 +270,7 @@ bool DatabaseManager::pinGroupMessage(const std::string& group_id, const std::st
 bool DatabaseManager::removeGroupMember(const std::string& group_id, const std::string& user_id) {
     const char* param_values[2] = {group_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("remove_group_member", 2, param_values);
+    group_member_cache_.erase(membershipKey(group_id, user_id));
     bool success = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
     if (res) PQclear(res);
     return success;
@@ -266,6 +279,7 @@ bool DatabaseManager::removeGroupMember(const std::string& group_id, const std::
 bool DatabaseManager::updateGroupMemberRole(const std::string& group_id, const std::string& user_id, const std::string& role) {
     const char* param_values[3] = {role.c_str(), group_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("update_group_member_role", 3, param_values);
+    group_member_cache_.erase(membershipKey(group_id, user_id));
     bool success = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
     if (res) PQclear(res);
     return success;
@@ -274,6 +288,7 @@ bool DatabaseManager::updateGroupMemberRole(const std::string& group_id, const s
 bool DatabaseManager::muteGroupMember(const std::string& group_id, const std::string& user_id, bool muted) {
     const char* param_values[3] = {muted ? "true" : "false", group_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("mute_group_member", 3, param_values);
+    group_member_cache_.erase(membershipKey(group_id, user_id));
     bool success = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
     if (res) PQclear(res);
     return success;
@@ -287,51 +302,44 @@ bool DatabaseManager::banGroupMember(const std::string& group_id, const std::str
         user_id.c_str()
     };
     PGresult* res = db_->executePrepared("ban_group_member", 4, param_values);
+    group_member_cache_.erase(membershipKey(group_id, user_id));
     bool success = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
     if (res) PQclear(res);
     return success;
 }
 
 std::vector<DatabaseManager::GroupMember> DatabaseManager::getGroupMembers(const std::string& group_id) {
-    std::vector<GroupMember> members;
     const char* param_values[1] = {group_id.c_str()};
     PGresult* res = db_->executePrepared("get_group_members", 1, param_values);
-    
-    if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
-        for (int i = 0; i < PQntuples(res); i++) {
-            GroupMember member;
-            member.id = std::string(PQgetvalue(res, i, 0));
-            member.group_id = std::string(PQgetvalue(res, i, 1));
-            member.user_id = std::string(PQgetvalue(res, i, 2));
-            member.username = std::string(PQgetvalue(res, i, 3));
-            member.role = std::string(PQgetvalue(res, i, 4));
-            member.is_muted = PQgetvalue(res, i, 5)[0] == 't';
-            member.is_banned = PQgetvalue(res, i, 6)[0] == 't';
-            member.joined_at = std::string(PQgetvalue(res, i, 7));
-            member.permissions = std::string(PQgetvalue(res, i, 8));
-            members.push_back(member);
-        }
-    }
-    
+    std::vector<GroupMember> members = groupMembersFromResult(res);
     if (res) PQclear(res);
     return members;
 }
 
+size_t DatabaseManager::queueGroupMembers(PipelineBatch& batch, const std::string& group_id) {
+    return batch.addPrepared("get_group_members", {group_id});
+}
+
+std::vector<DatabaseManager::GroupMember> DatabaseManager::groupMembersFromResult(const PGresult* res) {
+    return kGroupMemberRow.all(res);
+}
+
 DatabaseManager::GroupMember DatabaseManager::getGroupMember(const std::string& group_id, const std::string& user_id) {
+    const std::string key = membershipKey(group_id, user_id);
     GroupMember member;
+    uint64_t ticket = 0;
+    if (group_member_cache_.get(key, &member, &ticket)) {
+        return member;
+    }
     const char* param_values[2] = {group_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("get_group_member", 2, param_values);
     
-    if (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
-        member.id = std::string(PQgetvalue(res, 0, 0));
-        member.group_id = std::string(PQgetvalue(res, 0, 1));
-        member.user_id = std::string(PQgetvalue(res, 0, 2));
-        member.username = std::string(PQgetvalue(res, 0, 3));
-        member.role = std::string(PQgetvalue(res, 0, 4));
-        member.is_muted = PQgetvalue(res, 0, 5)[0] == 't';
-        member.is_banned = PQgetvalue(res, 0, 6)[0] == 't';
-        member.joined_at = std::string(PQgetvalue(res, 0, 7));
-        member.permissions = std::string(PQgetvalue(res, 0, 8));
+    if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
+        if (PQntuples(res) > 0) {
+            kGroupMemberRow.read(res, 0, member);
+        }
+        // An empty member (not in the group) is cached too
+        group_member_cache_.put(key, member, &ticket);
     }
     
     if (res) PQclear(res);
@@ -341,6 +349,7 @@ DatabaseManager::GroupMember DatabaseManager::getGroupMember(const std::string&
 bool DatabaseManager::updateAdminPermissions(const std::string& group_id, const std::string& user_id, const std::string& permissions_json) {
     const char* param_values[3] = {permissions_json.c_str(), group_id.c_str(), user_id.c_str()};
     PGresult* res = db_->executePrepared("update_admin_permissions", 3, param_values);
+    group_member_cache_.erase(membershipKey(group_id, user_id));
     bool success = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
     if (res) PQclear(res);
     return success;
@@ -415,6 +424,7 @@ bool DatabaseManager::deleteGroup(const std::string& group_id) {
     
     res = db_->executePrepared("delete_group_members", 1, params);
     if (res) PQclear(res);
+    forgetChatMembers(group_member_cache_, group_id);
     
     res = db_->executePrepared("delete_group_invites", 1, params);
     if (res) PQclear(res);
@@ -430,14 +440,23 @@ bool DatabaseManager::deleteGroup(const std::string& group_id) {
     return success;
 }
 
-std::vector<DatabaseManager::GroupMessage> DatabaseManager::searchGroupMessages(const std::string& group_id, const std::string& query_text, int limit) {
+std::vector<DatabaseManager::GroupMessage> DatabaseManager::searchGroupMessages(const std::string& group_id, const std::string& query_text, int limit,
+                                                                               const std::string& cursor_id) {
     std::vector<GroupMessage> messages;
     
-    std::string search_pattern = "%" + query_text + "%";
-    std::string limit_str = std::to_string(limit);
-    
-    const char* params[3] = {group_id.c_str(), search_pattern.c_str(), limit_str.c_str()};
-    PGresult* res = db_->executePrepared("search_group_messages", 3, params);
+    const std::string ts_query = searchQueryFor(query_text);
+    if (ts_query.empty()) {
+        return messages;
+    }
+    PgParams<4> params;
+    params.add(group_id).add(ts_query);
+    if (cursor_id.empty()) {
+        params.addNull();
+    } else {
+        params.add(cursor_id);
+    }
+    params.addInt8(limit);
+    PGresult* res = db_->executePrepared("search_group_messages", params);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
         for (int i = 0; i < PQntuples(res); i++) {
@@ -511,10 +530,8 @@ std::vector<DatabaseManager::Group> DatabaseManager::getPublicGroups(const std::
         params.push_back(p.c_str());
     }
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 
-                                  static_cast<int>(params.size()), nullptr, 
-                                  params.empty() ? nullptr : params.data(), 
-                                  nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, static_cast<int>(params.size()),
+                                        params.empty() ? nullptr : params.data());
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
         for (int i = 0; i < PQntuples(res); i++) {
@@ -539,7 +556,7 @@ int DatabaseManager::getGroupMembersCount(const std::string& group_id) {
     const char* params[1] = {group_id.c_str()};
     std::string query = "SELECT COUNT(*) FROM group_members WHERE group_id = $1 AND is_banned = false";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 1, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 1, params);
     
     int count = 0;
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
@@ -556,7 +573,7 @@ bool DatabaseManager::isGroupMember(const std::string& group_id, const std::stri
     const char* params[2] = {group_id.c_str(), user_id.c_str()};
     std::string query = "SELECT 1 FROM group_members WHERE group_id = $1 AND user_id = $2 AND is_banned = false LIMIT 1";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, params);
     
     bool is_member = (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0);
     
@@ -569,7 +586,7 @@ bool DatabaseManager::setGroupPublic(const std::string& group_id, bool is_public
     std::string query = "UPDATE groups SET is_public = " + is_public_str + ", category = $1 WHERE id = $2";
     
     const char* params[2] = {category.c_str(), group_id.c_str()};
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, params);
     
     bool success = (res && PQresultStatus(res) == PGRES_COMMAND_OK);
     if (res) PQclear(res);
@@ -11,7 +11,7 @@ bool DatabaseManager::setGroupForumMode(const std::string& group_id, bool enable
     const char* param_values[2] = {enabled_str.c_str(), group_id.c_str()};
     
     std::string query = "UPDATE groups SET forum_mode = $1 WHERE id = $2";
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         Logger::getInstance().error("setGroupForumMode failed: " + std::string(PQresultErrorMessage(res)));
@@ -26,7 +26,7 @@ bool DatabaseManager::setGroupForumMode(const std::string& group_id, bool enable
         // Check if General topic exists
         const char* check_params[1] = {group_id.c_str()};
         std::string check_query = "SELECT id FROM group_topics WHERE group_id = $1 AND is_general = true";
-        PGresult* check_res = PQexecParams(db_->getConnection(), check_query.c_str(), 1, nullptr, check_params, nullptr, nullptr, 0);
+        PGresult* check_res = db_->executeParams(check_query, 1, check_params);
         
         if (check_res && PQresultStatus(check_res) == PGRES_TUPLES_OK && PQntuples(check_res) == 0) {
             // Create General topic
@@ -43,7 +43,7 @@ bool DatabaseManager::setGroupForumMode(const std::string& group_id, bool enable
 bool DatabaseManager::isGroupForumMode(const std::string& group_id) {
     const char* param_values[1] = {group_id.c_str()};
     std::string query = "SELECT COALESCE(forum_mode, false) FROM groups WHERE id = $1";
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 1, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         if (res) PQclear(res);
@@ -74,7 +74,7 @@ bool DatabaseManager::createGroupTopic(const std::string& group_id, const std::s
         RETURNING id
     )";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 6, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 6, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         Logger::getInstance().error("createGroupTopic failed: " + std::string(res ? PQresultErrorMessage(res) : "null result"));
@@ -95,7 +95,7 @@ bool DatabaseManager::updateGroupTopic(const std::string& topic_id, const std::s
     const char* param_values[5] = {name.c_str(), icon_emoji.c_str(), icon_color.c_str(), is_closed_str.c_str(), topic_id.c_str()};
     
     std::string query = "UPDATE group_topics SET name = $1, icon_emoji = $2, icon_color = $3, is_closed = $4 WHERE id = $5";
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 5, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 5, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         Logger::getInstance().error("updateGroupTopic failed: " + std::string(PQresultErrorMessage(res)));
@@ -111,7 +111,7 @@ bool DatabaseManager::deleteGroupTopic(const std::string& topic_id) {
     // Don't allow deleting General topic
     const char* check_params[1] = {topic_id.c_str()};
     std::string check_query = "SELECT is_general FROM group_topics WHERE id = $1";
-    PGresult* check_res = PQexecParams(db_->getConnection(), check_query.c_str(), 1, nullptr, check_params, nullptr, nullptr, 0);
+    PGresult* check_res = db_->executeParams(check_query, 1, check_params);
     
     if (check_res && PQresultStatus(check_res) == PGRES_TUPLES_OK && PQntuples(check_res) > 0) {
         if (PQgetvalue(check_res, 0, 0)[0] == 't') {
@@ -124,7 +124,7 @@ bool DatabaseManager::deleteGroupTopic(const std::string& topic_id) {
     
     const char* param_values[1] = {topic_id.c_str()};
     std::string query = "DELETE FROM group_topics WHERE id = $1";
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 1, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         Logger::getInstance().error("deleteGroupTopic failed: " + std::string(PQresultErrorMessage(res)));
@@ -141,7 +141,7 @@ bool DatabaseManager::pinGroupTopic(const std::string& topic_id, int order) {
     const char* param_values[2] = {order_str.c_str(), topic_id.c_str()};
     
     std::string query = "UPDATE group_topics SET pinned_order = $1 WHERE id = $2";
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         if (res) PQclear(res);
@@ -173,7 +173,7 @@ std::vector<DatabaseManager::GroupTopic> DatabaseManager::getGroupTopics(const s
         ORDER BY is_general DESC, pinned_order DESC, last_message_at DESC
     )";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 1, param_values);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
         for (int i = 0; i < PQntuples(res); i++) {
@@ -219,7 +219,7 @@ DatabaseManager::GroupTopic DatabaseManager::getGroupTopicById(const std::string
         WHERE id = $1
     )";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 1, param_values);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
         topic.id = std::string(PQgetvalue(res, 0, 0));
@@ -268,7 +268,7 @@ bool DatabaseManager::sendGroupMessageToTopic(const std::string& group_id, const
         VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9)
     )";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 9, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 9, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         Logger::getInstance().error("sendGroupMessageToTopic failed: " + std::string(res ? PQresultErrorMessage(res) : "null result"));
@@ -304,7 +304,7 @@ std::vector<DatabaseManager::GroupMessage> DatabaseManager::getTopicMessages(con
         LIMIT $2
     )";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, param_values);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
         for (int i = 0; i < PQntuples(res); i++) {
@@ -361,7 +361,7 @@ bool DatabaseManager::updateTopicMessageCount(const std::string& topic_id) {
         WHERE gt.id = $1
     )";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 1, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         if (res) PQclear(res);
@@ -382,7 +382,7 @@ bool DatabaseManager::setTopicHidden(const std::string& topic_id, bool is_hidden
         WHERE id = $2 AND is_general = true
     )";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         if (res) PQclear(res);
@@ -403,7 +403,7 @@ bool DatabaseManager::setTopicClosed(const std::string& topic_id, bool is_closed
         WHERE id = $2
     )";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         if (res) PQclear(res);
@@ -429,7 +429,7 @@ bool DatabaseManager::reorderPinnedTopics(const std::string& group_id, const std
             WHERE id = $2 AND group_id = $3
         )";
         
-        PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 3, nullptr, param_values, nullptr, nullptr, 0);
+        PGresult* res = db_->executeParams(query, 3, param_values);
         
         if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
             if (res) PQclear(res);
@@ -461,7 +461,7 @@ std::vector<DatabaseManager::GroupTopic> DatabaseManager::searchTopics(const std
         ORDER BY is_general DESC, pinned_order DESC, last_message_at DESC
     )";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, param_values);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
         for (int i = 0; i < PQntuples(res); i++) {
@@ -504,7 +504,7 @@ bool DatabaseManager::setTopicNotifications(const std::string& topic_id, const s
         DO UPDATE SET notification_mode = $3
     )";
     
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 3, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 3, param_values);
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         // Table might not exist, try to create it
@@ -520,11 +520,11 @@ bool DatabaseManager::setTopicNotifications(const std::string& topic_id, const s
             )
         )";
         
-        PGresult* create_res = PQexec(db_->getConnection(), create_table.c_str());
+        PGresult* create_res = db_->executeQuery(create_table);
         if (create_res) PQclear(create_res);
         
         // Retry the insert
-        res = PQexecParams(db_->getConnection(), query.c_str(), 3, nullptr, param_values, nullptr, nullptr, 0);
+        res = db_->executeParams(query, 3, param_values);
         
         if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
             if (res) PQclear(res);
@@ -556,7 +556,7 @@ DatabaseManager::UserChatStats DatabaseManager::getUserChatStats(const std::stri
     )";
     
     const char* param_values[2] = {viewer_id.c_str(), target_id.c_str()};
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 2, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 2, param_values);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
         stats.photo_count = atoll(PQgetvalue(res, 0, 0));
@@ -576,7 +576,7 @@ DatabaseManager::UserChatStats DatabaseManager::getUserChatStats(const std::stri
             WHERE sender_id = $1 AND receiver_id = $1 AND is_deleted = false
         )";
         const char* saved_params[1] = {viewer_id.c_str()};
-        PGresult* saved_res = PQexecParams(db_->getConnection(), saved_query.c_str(), 1, nullptr, saved_params, nullptr, nullptr, 0);
+        PGresult* saved_res = db_->executeParams(saved_query, 1, saved_params);
         if (saved_res && PQresultStatus(saved_res) == PGRES_TUPLES_OK && PQntuples(saved_res) > 0) {
             stats.saved_count = atoll(PQgetvalue(saved_res, 0, 0));
         }
@@ -600,7 +600,7 @@ std::vector<DatabaseManager::Group> DatabaseManager::getCommonGroups(const std::
     
     std::string limit_str = std::to_string(limit);
     const char* param_values[3] = {user1_id.c_str(), user2_id.c_str(), limit_str.c_str()};
-    PGresult* res = PQexecParams(db_->getConnection(), query.c_str(), 3, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = db_->executeParams(query, 3, param_values);
     
     if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
         int rows = PQntuples(res);
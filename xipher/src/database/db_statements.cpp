@@ -0,0 +1,1265 @@
+#include "../include/database/db_statements.hpp"
+
+namespace xipher {
+
+// Name and SQL of every statement DatabaseManager runs with executePrepared.
+// Registered with the pool in one go at startup; each statement is prepared
+// on a connection the first time it runs there (XIPHER_DB_PREPARE=eager
+// prepares them all up front, one pipelined batch per connection).
+constexpr PreparedStatementDef kPreparedStatements[] = {
+    {"get_user_by_username",
+        "SELECT id, username, password_hash, created_at, is_active, "
+        "COALESCE(is_admin, FALSE), COALESCE(role, 'user'), "
+        "COALESCE(totp_secret, ''), COALESCE(admin_ip_whitelist, ''), COALESCE(is_bot, FALSE), "
+        "CASE WHEN COALESCE(is_premium, FALSE) AND (premium_expires_at IS NULL OR premium_expires_at > now()) "
+        "THEN TRUE ELSE FALSE END, "
+        "COALESCE(premium_plan, ''), "
+        "COALESCE(premium_expires_at::text, '') "
+        "FROM users WHERE username = $1"},
+    
+    {"get_user_by_id",
+        "SELECT id, username, password_hash, created_at, is_active, "
+        "COALESCE(is_admin, FALSE), COALESCE(role, 'user'), "
+        "COALESCE(totp_secret, ''), COALESCE(admin_ip_whitelist, ''), COALESCE(is_bot, FALSE), "
+        "CASE WHEN COALESCE(is_premium, FALSE) AND (premium_expires_at IS NULL OR premium_expires_at > now()) "
+        "THEN TRUE ELSE FALSE END, "
+        "COALESCE(premium_plan, ''), "
+        "COALESCE(premium_expires_at::text, '') "
+        "FROM users WHERE id = $1"},
+
+    // Lightweight public profile lookup
+    {"get_user_public",
+        "SELECT id::text, username, COALESCE(avatar_url, '') "
+        "FROM users WHERE id = $1::uuid"},
+    
+    {"check_username_exists",
+        "SELECT COUNT(*) FROM users WHERE username = $1"},
+    
+    {"are_friends",
+        "SELECT COUNT(*) FROM friends WHERE (user1_id = $1 AND user2_id = $2) OR (user1_id = $2 AND user2_id = $1)"},
+    
+    // Prepared statements prevent SQL injection for auth flows.
+    {"create_user",
+        "INSERT INTO users (username, password_hash) VALUES ($1, $2)"},
+
+    {"create_bot_user",
+        "INSERT INTO users (username, password_hash, is_active, is_bot) "
+        "VALUES ($1, $2, TRUE, TRUE) RETURNING id"},
+    
+    {"update_last_login",
+        "UPDATE users SET last_login = CURRENT_TIMESTAMP WHERE id = $1"},
+    
+    {"update_last_activity",
+        "UPDATE users SET last_activity = CURRENT_TIMESTAMP WHERE id = $1"},
+    // PresenceTracker write-behind: $1 ids, $2 last-seen times (microseconds
+    // since the epoch), one row per user; never moves last_activity back
+    {"flush_last_activity",
+        "UPDATE users AS u SET last_activity = to_timestamp(v.seen / 1000000.0) "
+        "FROM unnest($1::uuid[], $2::bigint[]) AS v(id, seen) "
+        "WHERE u.id = v.id AND (u.last_activity IS NULL OR u.last_activity < to_timestamp(v.seen / 1000000.0))"},
+    {"get_users_last_seen",
+        "SELECT id::text, COALESCE((EXTRACT(EPOCH FROM last_activity) * 1000000)::bigint, 0) "
+        "FROM users WHERE id = ANY($1::uuid[])"},
+
+    // Persistent sessions (survive restarts)
+    {"upsert_user_session",
+        "INSERT INTO user_sessions (token, user_id, expires_at) "
+        "VALUES ($1, $2::uuid, now() + ($3::text || ' seconds')::interval) "
+        "ON CONFLICT (token) DO UPDATE SET user_id = EXCLUDED.user_id, expires_at = EXCLUDED.expires_at, last_seen = now()"},
+    {"get_user_id_by_session",
+        "SELECT user_id FROM user_sessions WHERE token = $1 AND (expires_at IS NULL OR expires_at > now())"},
+    {"touch_user_session",
+        "UPDATE user_sessions SET last_seen = now() WHERE token = $1"},
+    {"delete_user_session",
+        "DELETE FROM user_sessions WHERE token = $1"},
+    {"list_user_sessions",
+        "SELECT token, COALESCE(created_at::text, ''), COALESCE(last_seen::text, ''), "
+        "COALESCE(user_agent, '') "
+        "FROM user_sessions "
+        "WHERE user_id = $1::uuid AND (expires_at IS NULL OR expires_at > now()) "
+        "ORDER BY last_seen DESC"},
+    {"update_user_session_user_agent",
+        "UPDATE user_sessions SET user_agent = $2 WHERE token = $1"},
+    {"revoke_session_id",
+        "INSERT INTO revoked_sessions (session_id, expires_at) VALUES ($1, to_timestamp($2::bigint)) "
+        "ON CONFLICT (session_id) DO NOTHING"},
+    {"get_revoked_sessions_since",
+        "SELECT session_id, EXTRACT(EPOCH FROM expires_at)::bigint, "
+        "(EXTRACT(EPOCH FROM revoked_at) * 1000000)::bigint "
+        "FROM revoked_sessions "
+        "WHERE revoked_at > to_timestamp($1::bigint / 1000000.0) AND expires_at > now()"},
+    {"purge_revoked_sessions",
+        "DELETE FROM revoked_sessions WHERE expires_at <= now()"},
+
+    {"upsert_push_token",
+        "INSERT INTO user_push_tokens (user_id, device_token, platform) "
+        "VALUES ($1::uuid, $2, $3) "
+        "ON CONFLICT (user_id, device_token) DO UPDATE "
+        "SET platform = EXCLUDED.platform, updated_at = now()"},
+    {"delete_push_token",
+        "DELETE FROM user_push_tokens WHERE user_id = $1::uuid AND device_token = $2"},
+    {"get_push_tokens",
+        "SELECT device_token, platform FROM user_push_tokens WHERE user_id = $1::uuid"},
+    
+    {"set_user_active",
+        "UPDATE users SET is_active = $2 WHERE id = $1"},
+    
+    {"update_user_password_hash",
+        "UPDATE users SET password_hash = $2 WHERE id = $1"},
+    {"replace_user_password_hash",
+        "UPDATE users SET password_hash = $3 WHERE id = $1 AND password_hash = $2"},
+
+    {"set_user_role",
+        "UPDATE users SET role = $2 WHERE id = $1::uuid"},
+
+    {"set_user_admin_flag",
+        "UPDATE users SET is_admin = $2 WHERE id = $1::uuid"},
+
+    {"delete_user_sessions_by_user",
+        "DELETE FROM user_sessions WHERE user_id = $1::uuid"},
+
+    {"count_banned_users",
+        "SELECT COUNT(*) FROM users WHERE is_active = FALSE"},
+
+    {"count_active_users_since",
+        "SELECT COUNT(*) FROM users WHERE last_activity IS NOT NULL "
+        "AND last_activity > (now() - ($1::text || ' seconds')::interval)"},
+
+    {"count_groups",
+        "SELECT COUNT(*) FROM groups"},
+
+    {"count_channels",
+        "SELECT COUNT(*) FROM channels"},
+
+    {"count_bots",
+        "SELECT COUNT(*) FROM bot_builder_bots"},
+
+    {"count_reports_by_status",
+        "SELECT COUNT(*) FROM message_reports WHERE ($1 = '' OR status = $1)"},
+
+    {"upsert_admin_setting",
+        "INSERT INTO admin_settings (key, value) VALUES ($1, $2) "
+        "ON CONFLICT (key) DO UPDATE SET value = EXCLUDED.value, updated_at = now()"},
+
+    {"get_admin_setting",
+        "SELECT value FROM admin_settings WHERE key = $1"},
+    
+    {"delete_messages_by_user",
+        "DELETE FROM messages WHERE sender_id = $1 OR receiver_id = $1"},
+    
+    {"count_users",
+        "SELECT COUNT(*) FROM users"},
+    
+    {"count_messages_today",
+        "SELECT COUNT(*) FROM messages WHERE created_at::date = CURRENT_DATE"},
+    
+    {"count_online_users",
+        "SELECT COUNT(*) FROM users WHERE last_activity IS NOT NULL "
+        "AND (EXTRACT(EPOCH FROM (CURRENT_TIMESTAMP - last_activity))::int < $1)"},
+
+    {"admin_search_users",
+        "SELECT id::text, username, COALESCE(is_active, TRUE), COALESCE(is_admin, FALSE), "
+        "COALESCE(is_bot, FALSE), COALESCE(role, 'user'), COALESCE(last_login::text,''), "
+        "COALESCE(last_activity::text,''), created_at::text "
+        "FROM users "
+        "WHERE username ILIKE $1 OR id::text = $2 "
+        "ORDER BY CASE "
+        "WHEN id::text = $2 THEN 0 "
+        "WHEN lower(username) = lower($3) THEN 1 "
+        "WHEN lower(username) LIKE lower($3) || '%' THEN 2 "
+        "ELSE 3 END, username "
+        "LIMIT $4"},
+
+    // Message search: the query parameter is a to_tsquery() string built by
+    // DatabaseManager::searchQueryFor, matched against the GIN indexes on
+    // to_tsvector('simple', content) (migration 4). Results are ranked by
+    // ts_rank, then newest first; the optional cursor is the id of the last
+    // hit of the previous page, whose rank is recomputed server-side so no
+    // float goes through the client. The cursor is NULL on the first page.
+    {"admin_search_messages",
+        "SELECT m.id::text, m.sender_id::text, COALESCE(s.username,''), "
+        "m.receiver_id::text, COALESCE(r.username,''), m.content, "
+        "COALESCE(m.message_type,'text'), m.created_at::text "
+        "FROM messages m "
+        "CROSS JOIN to_tsquery('simple', $1) q "
+        "CROSS JOIN LATERAL ts_rank(to_tsvector('simple', m.content), q) score "
+        "LEFT JOIN users s ON s.id = m.sender_id "
+        "LEFT JOIN users r ON r.id = m.receiver_id "
+        "WHERE to_tsvector('simple', m.content) @@ q "
+        "AND ($2::uuid IS NULL OR (score, m.created_at, m.id) < ("
+        "SELECT ts_rank(to_tsvector('simple', c.content), to_tsquery('simple', $1)), c.created_at, c.id "
+        "FROM messages c WHERE c.id = $2::uuid)) "
+        "ORDER BY score DESC, m.created_at DESC, m.id DESC "
+        "LIMIT $3"},
+    {"admin_get_message_summary",
+        "SELECT m.id::text, m.sender_id::text, COALESCE(s.username,''), "
+        "m.receiver_id::text, COALESCE(r.username,''), m.content, "
+        "COALESCE(m.message_type,'text'), m.created_at::text "
+        "FROM messages m "
+        "LEFT JOIN users s ON s.id = m.sender_id "
+        "LEFT JOIN users r ON r.id = m.receiver_id "
+        "WHERE m.id = $1::uuid"},
+    {"search_direct_messages",
+        "SELECT m.id, m.sender_id, m.receiver_id, m.content, m.created_at, m.is_read, m.is_delivered, m.message_type, "
+        "m.file_path, m.file_name, m.file_size, m.reply_to_message_id, "
+        "COALESCE(m.reply_markup::text, '') as reply_markup "
+        "FROM messages m "
+        "CROSS JOIN to_tsquery('simple', $3) q "
+        "CROSS JOIN LATERAL ts_rank(to_tsvector('simple', m.content), q) score "
+        "WHERE ((m.sender_id = $1 AND m.receiver_id = $2) OR (m.sender_id = $2 AND m.receiver_id = $1)) "
+        "AND to_tsvector('simple', m.content) @@ q "
+        "AND ($4::uuid IS NULL OR (score, m.created_at, m.id) < ("
+        "SELECT ts_rank(to_tsvector('simple', c.content), to_tsquery('simple', $3)), c.created_at, c.id "
+        "FROM messages c WHERE c.id = $4::uuid)) "
+        "ORDER BY score DESC, m.created_at DESC, m.id DESC LIMIT $5"},
+    {"search_user_messages",
+        "SELECT m.id, m.sender_id, m.receiver_id, m.content, m.created_at, m.is_read, m.is_delivered, m.message_type, "
+        "m.file_path, m.file_name, m.file_size, m.reply_to_message_id, "
+        "COALESCE(m.reply_markup::text, '') as reply_markup "
+        "FROM messages m "
+        "CROSS JOIN to_tsquery('simple', $2) q "
+        "CROSS JOIN LATERAL ts_rank(to_tsvector('simple', m.content), q) score "
+        "WHERE (m.sender_id = $1 OR m.receiver_id = $1) "
+        "AND to_tsvector('simple', m.content) @@ q "
+        "AND ($3::uuid IS NULL OR (score, m.created_at, m.id) < ("
+        "SELECT ts_rank(to_tsvector('simple', c.content), to_tsquery('simple', $2)), c.created_at, c.id "
+        "FROM messages c WHERE c.id = $3::uuid)) "
+        "ORDER BY score DESC, m.created_at DESC, m.id DESC LIMIT $4"},
+
+    {"admin_search_groups",
+        "SELECT id::text, name, COALESCE(description,''), creator_id::text, "
+        "COALESCE(invite_link,''), created_at::text "
+        "FROM groups "
+        "WHERE name ILIKE $1 OR id::text = $2 "
+        "ORDER BY name "
+        "LIMIT $3"},
+
+    {"admin_search_channels",
+        "SELECT id::text, name, COALESCE(description,''), creator_id::text, "
+        "COALESCE(custom_link,''), created_at::text "
+        "FROM channels "
+        "WHERE name ILIKE $1 OR custom_link ILIKE $1 OR id::text = $2 "
+        "ORDER BY name "
+        "LIMIT $3"},
+    
+    {"update_user_avatar",
+        "UPDATE users SET avatar_url = $1 WHERE id = $2"},
+
+    {"set_user_premium",
+        "UPDATE users SET is_premium = $2::boolean, premium_plan = NULLIF($3, ''), "
+        "premium_expires_at = CASE "
+        "WHEN $2::boolean THEN "
+        "CASE "
+        "WHEN $3 = 'year' THEN "
+        "  (CASE WHEN premium_expires_at IS NOT NULL AND premium_expires_at > now() "
+        "        THEN premium_expires_at ELSE now() END) + interval '1 year' "
+        "WHEN $3 = 'half' THEN "
+        "  (CASE WHEN premium_expires_at IS NOT NULL AND premium_expires_at > now() "
+        "        THEN premium_expires_at ELSE now() END) + interval '6 months' "
+        "WHEN $3 = 'month' THEN "
+        "  (CASE WHEN premium_expires_at IS NOT NULL AND premium_expires_at > now() "
+        "        THEN premium_expires_at ELSE now() END) + interval '1 month' "
+        "WHEN $3 = 'trial' THEN "
+        "  (CASE WHEN premium_expires_at IS NOT NULL AND premium_expires_at > now() "
+        "        THEN premium_expires_at ELSE now() END) + interval '7 days' "
+        "ELSE NULL "
+        "END "
+        "ELSE NULL "
+        "END "
+        "WHERE id = $1::uuid"},
+
+    {"create_premium_payment",
+        "INSERT INTO premium_payments (user_id, plan, amount, label) "
+        "VALUES ($1::uuid, $2, $3::numeric, 'pp_' || uuid_generate_v4()) "
+        "RETURNING id::text, label, plan, amount::text, status"},
+
+    {"create_premium_gift_payment",
+        "INSERT INTO premium_payments (user_id, plan, amount, label, gift_receiver_id) "
+        "VALUES ($1::uuid, $2, $3::numeric, 'pp_' || uuid_generate_v4(), $4::uuid) "
+        "RETURNING id::text, label, plan, amount::text, status, COALESCE(gift_receiver_id::text, '')"},
+
+    {"get_premium_payment_by_label",
+        "SELECT id::text, user_id::text, plan, amount::text, status, "
+        "COALESCE(operation_id, ''), COALESCE(payment_type, ''), "
+        "COALESCE(gift_receiver_id::text, ''), "
+        "created_at::text, COALESCE(paid_at::text, '') "
+        "FROM premium_payments WHERE label = $1"},
+
+    {"mark_premium_payment_paid",
+        "UPDATE premium_payments "
+        "SET status = 'paid', operation_id = $2, payment_type = $3, paid_at = now() "
+        "WHERE label = $1 AND status <> 'paid' "
+        "RETURNING id"},
+
+    {"reset_premium_payment_status",
+        "UPDATE premium_payments "
+        "SET status = 'pending', operation_id = '', payment_type = '', paid_at = NULL "
+        "WHERE label = $1 AND status = 'paid' "
+        "RETURNING id"},
+
+    {"has_trial_payment",
+        "SELECT 1 FROM premium_payments WHERE user_id = $1::uuid AND plan = 'trial' AND status = 'paid' LIMIT 1"},
+
+    {"admin_list_premium_payments",
+        "SELECT p.id::text, p.label, p.plan, p.amount::text, p.status, "
+        "COALESCE(p.operation_id, ''), COALESCE(p.payment_type, ''), "
+        "p.created_at::text, COALESCE(p.paid_at::text, ''), "
+        "u.id::text, u.username "
+        "FROM premium_payments p "
+        "JOIN users u ON u.id = p.user_id "
+        "WHERE ($1 = '' OR p.status = $1) "
+        "ORDER BY p.created_at DESC "
+        "LIMIT $2"},
+    
+    // Profile + privacy
+    {"get_user_profile",
+        "SELECT COALESCE(first_name,''), COALESCE(last_name,''), COALESCE(bio,''), "
+        "COALESCE(birth_day,0), COALESCE(birth_month,0), COALESCE(birth_year,0), "
+        "COALESCE(linked_channel_id::text, ''), COALESCE(business_hours_json::text, '') "
+        "FROM user_profiles WHERE user_id = $1::uuid"},
+    {"upsert_user_profile",
+        "INSERT INTO user_profiles (user_id, first_name, last_name, bio, birth_day, birth_month, birth_year) "
+        "VALUES ($1::uuid, $2, $3, $4, NULLIF($5::int,0), NULLIF($6::int,0), NULLIF($7::int,0)) "
+        "ON CONFLICT (user_id) DO UPDATE SET first_name = EXCLUDED.first_name, last_name = EXCLUDED.last_name, "
+        "bio = EXCLUDED.bio, birth_day = EXCLUDED.birth_day, birth_month = EXCLUDED.birth_month, birth_year = EXCLUDED.birth_year"},
+    {"upsert_user_linked_channel",
+        "INSERT INTO user_profiles (user_id, linked_channel_id) "
+        "VALUES ($1::uuid, NULLIF($2,'')::uuid) "
+        "ON CONFLICT (user_id) DO UPDATE SET linked_channel_id = EXCLUDED.linked_channel_id"},
+    {"set_user_business_hours",
+        "INSERT INTO user_profiles (user_id, business_hours_json) "
+        "VALUES ($1::uuid, NULLIF($2,'')::jsonb) "
+        "ON CONFLICT (user_id) DO UPDATE SET business_hours_json = EXCLUDED.business_hours_json"},
+    {"get_user_privacy",
+        "SELECT bio_visibility, birth_visibility, last_seen_visibility, avatar_visibility, send_read_receipts "
+        "FROM user_privacy_settings WHERE user_id = $1::uuid"},
+    {"upsert_user_privacy",
+        "INSERT INTO user_privacy_settings (user_id, bio_visibility, birth_visibility, last_seen_visibility, avatar_visibility, send_read_receipts) "
+        "VALUES ($1::uuid, $2, $3, $4, $5, $6) "
+        "ON CONFLICT (user_id) DO UPDATE SET bio_visibility = EXCLUDED.bio_visibility, "
+        "birth_visibility = EXCLUDED.birth_visibility, last_seen_visibility = EXCLUDED.last_seen_visibility, "
+        "avatar_visibility = EXCLUDED.avatar_visibility, send_read_receipts = EXCLUDED.send_read_receipts"},
+
+    {"get_chat_pins",
+        "SELECT chat_type, chat_id FROM user_chat_pins WHERE user_id = $1::uuid ORDER BY created_at ASC"},
+    {"pin_chat",
+        "INSERT INTO user_chat_pins (user_id, chat_type, chat_id) VALUES ($1::uuid, $2, $3::uuid) "
+        "ON CONFLICT (user_id, chat_type, chat_id) DO NOTHING"},
+    {"unpin_chat",
+        "DELETE FROM user_chat_pins WHERE user_id = $1::uuid AND chat_type = $2 AND chat_id = $3::uuid"},
+
+    {"get_chat_folders",
+        "SELECT COALESCE(folders::text, '[]') FROM user_chat_folders WHERE user_id = $1::uuid"},
+    {"set_chat_folders",
+        "INSERT INTO user_chat_folders (user_id, folders) VALUES ($1::uuid, $2::jsonb) "
+        "ON CONFLICT (user_id) DO UPDATE SET folders = EXCLUDED.folders, updated_at = now()"},
+
+    {"count_user_channels_v2",
+        "SELECT COUNT(*) FROM chats WHERE type = 'channel' AND created_by = $1::uuid"},
+    {"count_user_channels_legacy",
+        "SELECT COUNT(*) FROM channels WHERE creator_id = $1"},
+    {"count_user_public_links_v2",
+        "SELECT COUNT(*) FROM chats WHERE type = 'channel' AND created_by = $1::uuid "
+        "AND COALESCE(username, '') <> ''"},
+    {"count_user_public_links_legacy",
+        "SELECT COUNT(*) FROM channels WHERE creator_id = $1 AND COALESCE(custom_link, '') <> ''"},
+    
+    {"create_friend_request",
+        "INSERT INTO friend_requests (sender_id, receiver_id) VALUES ($1, $2)"},
+    
+    {"get_friend_request",
+        "SELECT id, sender_id, receiver_id FROM friend_requests WHERE id = $1"},
+    
+    {"update_friend_request_status",
+        "UPDATE friend_requests SET status = $1 WHERE id = $2"},
+    
+    {"create_friendship",
+        "INSERT INTO friends (user1_id, user2_id) VALUES ($1, $2)"},
+    {"create_friendship_pair",
+        "INSERT INTO friends (user1_id, user2_id) VALUES (LEAST($1::uuid, $2::uuid), GREATEST($1::uuid, $2::uuid)) "
+        "ON CONFLICT (user1_id, user2_id) DO NOTHING"},
+    
+    {"get_friend_requests",
+        "SELECT id, sender_id, receiver_id, status, created_at FROM friend_requests WHERE receiver_id = $1 AND status = 'pending'"},
+    
+    {"get_friends",
+        "SELECT u.id, u.username, COALESCE(u.avatar_url, '') as avatar_url, f.created_at FROM friends f "
+        "JOIN users u ON (u.id = CASE WHEN f.user1_id = $1 THEN f.user2_id ELSE f.user1_id END) "
+        "WHERE f.user1_id = $1 OR f.user2_id = $1"},
+    
+    {"send_message",
+        "INSERT INTO messages (sender_id, receiver_id, content, message_type, file_path, file_name, file_size, reply_to_message_id, reply_markup) VALUES ($1, $2, $3, $4, $5, $6, $7, $8, CASE WHEN $9 = '' THEN NULL ELSE $9::jsonb END)"},
+    
+    // Message history pages, newest first, keyset on (created_at, id): each
+    // direction is its own range scan of idx_messages_pair_keyset, so a page
+    // costs the same at any depth. _before/_after take the cursor message id.
+    {"get_messages",
+        "SELECT m.id, m.sender_id, m.receiver_id, m.content, m.created_at, m.is_read, m.is_delivered, m.message_type, "
+        "m.file_path, m.file_name, m.file_size, m.reply_to_message_id, "
+        "COALESCE(m.reply_markup::text, '') as reply_markup, "
+        "COALESCE(dp.message_id = m.id, FALSE) AS is_pinned "
+        "FROM ("
+        "(SELECT * FROM messages WHERE sender_id = $1 AND receiver_id = $2 ORDER BY created_at DESC, id DESC LIMIT $3) "
+        "UNION ALL "
+        "(SELECT * FROM messages WHERE sender_id = $2 AND receiver_id = $1 ORDER BY created_at DESC, id DESC LIMIT $3)"
+        ") m "
+        "LEFT JOIN direct_pins dp ON dp.user_low = LEAST($1::uuid, $2::uuid) AND dp.user_high = GREATEST($1::uuid, $2::uuid) "
+        "ORDER BY m.created_at DESC, m.id DESC LIMIT $3"},
+    {"get_messages_before",
+        "SELECT m.id, m.sender_id, m.receiver_id, m.content, m.created_at, m.is_read, m.is_delivered, m.message_type, "
+        "m.file_path, m.file_name, m.file_size, m.reply_to_message_id, "
+        "COALESCE(m.reply_markup::text, '') as reply_markup, "
+        "COALESCE(dp.message_id = m.id, FALSE) AS is_pinned "
+        "FROM ("
+        "(SELECT * FROM messages WHERE sender_id = $1 AND receiver_id = $2 "
+        "AND (created_at, id) < (SELECT created_at, id FROM messages WHERE id = $4) "
+        "ORDER BY created_at DESC, id DESC LIMIT $3) "
+        "UNION ALL "
+        "(SELECT * FROM messages WHERE sender_id = $2 AND receiver_id = $1 "
+        "AND (created_at, id) < (SELECT created_at, id FROM messages WHERE id = $4) "
+        "ORDER BY created_at DESC, id DESC LIMIT $3)"
+        ") m "
+        "LEFT JOIN direct_pins dp ON dp.user_low = LEAST($1::uuid, $2::uuid) AND dp.user_high = GREATEST($1::uuid, $2::uuid) "
+        "ORDER BY m.created_at DESC, m.id DESC LIMIT $3"},
+    // Oldest first: the page right after the cursor (callers reverse it)
+    {"get_messages_after",
+        "SELECT m.id, m.sender_id, m.receiver_id, m.content, m.created_at, m.is_read, m.is_delivered, m.message_type, "
+        "m.file_path, m.file_name, m.file_size, m.reply_to_message_id, "
+        "COALESCE(m.reply_markup::text, '') as reply_markup, "
+        "COALESCE(dp.message_id = m.id, FALSE) AS is_pinned "
+        "FROM ("
+        "(SELECT * FROM messages WHERE sender_id = $1 AND receiver_id = $2 "
+        "AND (created_at, id) > (SELECT created_at, id FROM messages WHERE id = $4) "
+        "ORDER BY created_at ASC, id ASC LIMIT $3) "
+        "UNION ALL "
+        "(SELECT * FROM messages WHERE sender_id = $2 AND receiver_id = $1 "
+        "AND (created_at, id) > (SELECT created_at, id FROM messages WHERE id = $4) "
+        "ORDER BY created_at ASC, id ASC LIMIT $3)"
+        ") m "
+        "LEFT JOIN direct_pins dp ON dp.user_low = LEAST($1::uuid, $2::uuid) AND dp.user_high = GREATEST($1::uuid, $2::uuid) "
+        "ORDER BY m.created_at ASC, m.id ASC LIMIT $3"},
+    
+    // Special query for saved messages (when user_id == friend_id)
+    {"get_saved_messages",
+        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id, "
+        "COALESCE(reply_markup::text, '') as reply_markup, "
+        "FALSE AS is_pinned "
+        "FROM messages "
+        "WHERE sender_id = $1 AND receiver_id = $1 "
+        "ORDER BY created_at DESC, id DESC LIMIT $2"},
+    {"get_saved_messages_before",
+        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id, "
+        "COALESCE(reply_markup::text, '') as reply_markup, "
+        "FALSE AS is_pinned "
+        "FROM messages "
+        "WHERE sender_id = $1 AND receiver_id = $1 "
+        "AND (created_at, id) < (SELECT created_at, id FROM messages WHERE id = $3) "
+        "ORDER BY created_at DESC, id DESC LIMIT $2"},
+    {"get_saved_messages_after",
+        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id, "
+        "COALESCE(reply_markup::text, '') as reply_markup, "
+        "FALSE AS is_pinned "
+        "FROM messages "
+        "WHERE sender_id = $1 AND receiver_id = $1 "
+        "AND (created_at, id) > (SELECT created_at, id FROM messages WHERE id = $3) "
+        "ORDER BY created_at ASC, id ASC LIMIT $2"},
+    
+    {"get_last_message",
+        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id, "
+        "COALESCE(reply_markup::text, '') as reply_markup "
+        "FROM messages "
+        "WHERE (sender_id = $1 AND receiver_id = $2) OR (sender_id = $2 AND receiver_id = $1) "
+        "ORDER BY created_at DESC LIMIT 1"},
+    
+    // Special query for saved messages last message
+    {"get_last_saved_message",
+        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id, "
+        "COALESCE(reply_markup::text, '') as reply_markup "
+        "FROM messages "
+        "WHERE sender_id = $1 AND receiver_id = $1 "
+        "ORDER BY created_at DESC LIMIT 1"},
+    
+    {"get_message_by_id",
+        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id, "
+        "COALESCE(reply_markup::text, '') as reply_markup "
+        "FROM messages WHERE id = $1"},
+
+    {"delete_message_by_id",
+        "DELETE FROM messages WHERE id = $1"},
+    
+    {"get_unread_count",
+        "SELECT COUNT(*) FROM messages WHERE receiver_id = $1 AND sender_id = $2 AND is_read = false"},
+    
+    {"mark_messages_read",
+        "UPDATE messages SET is_read = true WHERE receiver_id = $1 AND sender_id = $2 AND is_read = false"},
+
+    {"mark_messages_delivered",
+        "UPDATE messages SET is_delivered = true WHERE receiver_id = $1 AND sender_id = $2 AND is_delivered = false"},
+
+    {"mark_message_delivered_by_id",
+        "UPDATE messages SET is_delivered = true WHERE id = $1::uuid AND is_delivered = false"},
+    
+    {"get_chat_partners",
+        "SELECT u.id, u.username, COALESCE(u.avatar_url, '') as avatar_url, COALESCE(MAX(m.created_at)::text, '') as last_message_time "
+        "FROM messages m "
+        "JOIN users u ON (u.id = CASE WHEN m.sender_id = $1 THEN m.receiver_id ELSE m.sender_id END) "
+        "WHERE (m.sender_id = $1 OR m.receiver_id = $1) "
+        "GROUP BY u.id, u.username, u.avatar_url "
+        "ORDER BY MAX(m.created_at) DESC NULLS LAST"},
+    
+    // Chat list in one query: partners with their last message, unread
+    // count, presence and profile name. The partner equal to $1 is the
+    // saved-messages conversation.
+    {"get_chat_summaries",
+        "WITH partners AS ("
+        "  SELECT CASE WHEN m.sender_id = $1 THEN m.receiver_id ELSE m.sender_id END AS partner_id, "
+        "         MAX(m.created_at) AS last_at "
+        "  FROM messages m WHERE m.sender_id = $1 OR m.receiver_id = $1 "
+        "  GROUP BY 1"
+        "), unread AS ("
+        "  SELECT sender_id, COUNT(*) AS cnt FROM messages "
+        "  WHERE receiver_id = $1 AND is_read = false GROUP BY sender_id"
+        ") "
+        "SELECT lm.id, lm.sender_id, lm.receiver_id, lm.content, lm.created_at, lm.is_read, lm.is_delivered, "
+        "lm.message_type, lm.file_path, lm.file_name, lm.file_size, lm.reply_to_message_id, "
+        "COALESCE(lm.reply_markup::text, ''), "
+        "u.id, u.username, COALESCE(u.avatar_url, ''), COALESCE(p.last_at::text, ''), "
+        "COALESCE(ur.cnt, 0), COALESCE(u.is_bot, FALSE), "
+        "CASE WHEN COALESCE(u.is_premium, FALSE) AND (u.premium_expires_at IS NULL OR u.premium_expires_at > now()) "
+        "THEN TRUE ELSE FALSE END, "
+        "CASE WHEN u.last_activity IS NOT NULL AND (EXTRACT(EPOCH FROM (CURRENT_TIMESTAMP - u.last_activity))::int < $2) "
+        "THEN true ELSE false END, "
+        "u.last_activity, COALESCE(up.first_name, ''), COALESCE(up.last_name, '') "
+        "FROM partners p "
+        "JOIN users u ON u.id = p.partner_id "
+        "LEFT JOIN user_profiles up ON up.user_id = u.id "
+        "LEFT JOIN unread ur ON ur.sender_id = u.id "
+        "LEFT JOIN LATERAL ("
+        "  SELECT * FROM messages m2 "
+        "  WHERE (m2.sender_id = $1 AND m2.receiver_id = u.id) OR (m2.sender_id = u.id AND m2.receiver_id = $1) "
+        "  ORDER BY m2.created_at DESC LIMIT 1"
+        ") lm ON TRUE "
+        "ORDER BY p.last_at DESC NULLS LAST"},
+    
+    // Check if user has saved messages
+    {"has_saved_messages",
+        "SELECT COUNT(*) > 0 FROM messages WHERE sender_id = $1 AND receiver_id = $1"},
+    {"pin_direct_message",
+        "INSERT INTO direct_pins (user_low, user_high, message_id, pinned_by) "
+        "VALUES (LEAST($1::uuid, $2::uuid), GREATEST($1::uuid, $2::uuid), $3::uuid, $4::uuid) "
+        "ON CONFLICT (user_low, user_high) DO UPDATE SET message_id = EXCLUDED.message_id, pinned_by = EXCLUDED.pinned_by, pinned_at = now()"},
+    {"unpin_direct_message",
+        "DELETE FROM direct_pins WHERE user_low = LEAST($1::uuid, $2::uuid) AND user_high = GREATEST($1::uuid, $2::uuid)"},
+    {"get_direct_pinned_message",
+        "SELECT message_id FROM direct_pins WHERE user_low = LEAST($1::uuid, $2::uuid) AND user_high = GREATEST($1::uuid, $2::uuid) LIMIT 1"},
+    
+    // Group statements
+    {"create_group",
+        "INSERT INTO groups (name, description, creator_id) VALUES ($1, $2, $3) RETURNING id"},
+    {"get_group_by_id",
+        "SELECT id, name, description, creator_id, invite_link, created_at FROM groups WHERE id = $1"},
+    {"get_user_groups",
+        "SELECT g.id, g.name, g.description, g.creator_id, g.invite_link, g.created_at "
+        "FROM groups g JOIN group_members gm ON g.id = gm.group_id "
+        "WHERE gm.user_id = $1 AND gm.is_banned = FALSE ORDER BY g.created_at DESC"},
+    {"add_group_member",
+        "INSERT INTO group_members (group_id, user_id, role) VALUES ($1, $2, $3) "
+        "ON CONFLICT (group_id, user_id) DO UPDATE SET is_banned = FALSE, role = $3"},
+    {"send_group_message",
+        "INSERT INTO group_messages (group_id, sender_id, content, message_type, file_path, file_name, file_size, "
+        "reply_to_message_id, forwarded_from_user_id, forwarded_from_username, forwarded_from_message_id) "
+        "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11)"},
+    {"get_group_messages",
+        "SELECT gm.id, gm.group_id, gm.sender_id, u.username, gm.content, gm.message_type, "
+        "gm.file_path, gm.file_name, gm.file_size, gm.reply_to_message_id, "
+        "gm.forwarded_from_user_id, gm.forwarded_from_username, gm.forwarded_from_message_id, "
+        "gm.is_pinned, gm.created_at "
+        "FROM group_messages gm JOIN users u ON gm.sender_id = u.id "
+        "WHERE gm.group_id = $1 AND gm.topic_id IS NULL ORDER BY gm.created_at DESC, gm.id DESC LIMIT $2"},
+    {"get_group_messages_before",
+        "SELECT gm.id, gm.group_id, gm.sender_id, u.username, gm.content, gm.message_type, "
+        "gm.file_path, gm.file_name, gm.file_size, gm.reply_to_message_id, "
+        "gm.forwarded_from_user_id, gm.forwarded_from_username, gm.forwarded_from_message_id, "
+        "gm.is_pinned, gm.created_at "
+        "FROM group_messages gm JOIN users u ON gm.sender_id = u.id "
+        "WHERE gm.group_id = $1 AND gm.topic_id IS NULL "
+        "AND (gm.created_at, gm.id) < (SELECT created_at, id FROM group_messages WHERE id = $3) "
+        "ORDER BY gm.created_at DESC, gm.id DESC LIMIT $2"},
+    {"get_group_messages_after",
+        "SELECT gm.id, gm.group_id, gm.sender_id, u.username, gm.content, gm.message_type, "
+        "gm.file_path, gm.file_name, gm.file_size, gm.reply_to_message_id, "
+        "gm.forwarded_from_user_id, gm.forwarded_from_username, gm.forwarded_from_message_id, "
+        "gm.is_pinned, gm.created_at "
+        "FROM group_messages gm JOIN users u ON gm.sender_id = u.id "
+        "WHERE gm.group_id = $1 AND gm.topic_id IS NULL "
+        "AND (gm.created_at, gm.id) > (SELECT created_at, id FROM group_messages WHERE id = $3) "
+        "ORDER BY gm.created_at ASC, gm.id ASC LIMIT $2"},
+    {"create_group_invite",
+        "INSERT INTO group_invites (group_id, invite_link, created_by, expires_at) VALUES ($1, $2, $3, $4)"},
+    {"update_group_name",
+        "UPDATE groups SET name = $1 WHERE id = $2"},
+    {"update_group_description",
+        "UPDATE groups SET description = $1 WHERE id = $2"},
+    {"pin_group_message",
+        "INSERT INTO pinned_messages (group_id, message_id, pinned_by) VALUES ($1, $2, $3) "
+        "ON CONFLICT (group_id, message_id) DO NOTHING"},
+    {"update_message_pinned",
+        "UPDATE group_messages SET is_pinned = TRUE WHERE id = $1"},
+    {"remove_group_member",
+        "DELETE FROM group_members WHERE group_id = $1 AND user_id = $2"},
+    {"update_group_member_role",
+        "UPDATE group_members SET role = $1 WHERE group_id = $2 AND user_id = $3"},
+    {"mute_group_member",
+        "UPDATE group_members SET is_muted = $1 WHERE group_id = $2 AND user_id = $3"},
+    {"ban_group_member",
+        "UPDATE group_members SET is_banned = $1, banned_until = $2 WHERE group_id = $3 AND user_id = $4"},
+    {"get_group_members",
+        "SELECT gm.id, gm.group_id, gm.user_id, u.username, gm.role, gm.is_muted, gm.is_banned, gm.joined_at, COALESCE(gm.permissions::text, '{}') "
+        "FROM group_members gm JOIN users u ON gm.user_id = u.id WHERE gm.group_id = $1"},
+    {"get_group_member",
+        "SELECT gm.id, gm.group_id, gm.user_id, u.username, gm.role, gm.is_muted, gm.is_banned, gm.joined_at, COALESCE(gm.permissions::text, '{}') "
+        "FROM group_members gm JOIN users u ON gm.user_id = u.id WHERE gm.group_id = $1 AND gm.user_id = $2"},
+    {"update_admin_permissions",
+        "UPDATE group_members SET permissions = $1::jsonb WHERE group_id = $2 AND user_id = $3"},
+    {"get_invite_info",
+        "SELECT group_id, expires_at, max_uses, current_uses FROM group_invites WHERE invite_link = $1"},
+    {"unpin_group_message",
+        "DELETE FROM pinned_messages WHERE group_id = $1 AND message_id = $2"},
+    {"update_message_unpinned",
+        "UPDATE group_messages SET is_pinned = FALSE WHERE id = $1"},
+    
+    // Group management statements
+    {"delete_group",
+        "DELETE FROM groups WHERE id = $1"},
+    {"delete_group_messages",
+        "DELETE FROM group_messages WHERE group_id = $1"},
+    {"delete_group_members",
+        "DELETE FROM group_members WHERE group_id = $1"},
+    {"delete_group_invites",
+        "DELETE FROM group_invites WHERE group_id = $1"},
+    {"delete_group_pinned",
+        "DELETE FROM pinned_messages WHERE group_id = $1"},
+    // Ranked like admin_search_messages; $3 is the cursor
+    {"search_group_messages",
+        "SELECT gm.id, gm.group_id, gm.sender_id, u.username, gm.content, gm.message_type, "
+        "COALESCE(gm.file_path, ''), COALESCE(gm.file_name, ''), COALESCE(gm.file_size, 0), "
+        "gm.created_at, COALESCE(gm.is_pinned, false) "
+        "FROM group_messages gm JOIN users u ON gm.sender_id = u.id "
+        "CROSS JOIN to_tsquery('simple', $2) q "
+        "CROSS JOIN LATERAL ts_rank(to_tsvector('simple', gm.content), q) score "
+        "WHERE gm.group_id = $1 AND to_tsvector('simple', gm.content) @@ q "
+        "AND ($3::uuid IS NULL OR (score, gm.created_at, gm.id) < ("
+        "SELECT ts_rank(to_tsvector('simple', c.content), to_tsquery('simple', $2)), c.created_at, c.id "
+        "FROM group_messages c WHERE c.id = $3::uuid)) "
+        "ORDER BY score DESC, gm.created_at DESC, gm.id DESC LIMIT $4"},
+    {"update_group_permissions",
+        "UPDATE groups SET permissions = COALESCE(permissions, '{}'::jsonb) || $1::jsonb WHERE id = $2"},
+    
+    // Channel statements
+    {"create_channel",
+        "INSERT INTO channels (name, description, creator_id, custom_link) VALUES ($1, $2, $3, $4) RETURNING id"},
+    {"check_channel_custom_link",
+        "SELECT COUNT(*) FROM channels WHERE custom_link = $1"},
+    {"get_channel_by_id",
+        "SELECT id, name, description, creator_id, custom_link, COALESCE(avatar_url, ''), is_private, show_author, created_at, COALESCE(is_verified, false) FROM channels WHERE id = $1"},
+    {"get_channel_by_custom_link",
+        "SELECT id, name, description, creator_id, custom_link, COALESCE(avatar_url, ''), is_private, show_author, created_at, COALESCE(is_verified, false) FROM channels WHERE custom_link = $1"},
+    {"get_user_channels",
+        "SELECT c.id, c.name, c.description, c.creator_id, c.custom_link, COALESCE(c.avatar_url, ''), c.is_private, c.show_author, c.created_at, COALESCE(c.is_verified, false) "
+        "FROM channels c JOIN channel_members cm ON c.id = cm.channel_id "
+        "WHERE cm.user_id = $1 AND cm.is_banned = FALSE ORDER BY c.created_at DESC"},
+    {"add_channel_member",
+        "INSERT INTO channel_members (channel_id, user_id, role) VALUES ($1, $2, $3) "
+        "ON CONFLICT (channel_id, user_id) DO UPDATE SET is_banned = FALSE, role = $3"},
+    {"send_channel_message",
+        "INSERT INTO channel_messages (channel_id, sender_id, content, message_type, file_path, file_name, file_size) "
+        "VALUES ($1, $2, $3, $4, $5, $6, $7)"},
+    {"get_channel_messages",
+        "SELECT cm.id, cm.channel_id, cm.sender_id, u.username, cm.content, cm.message_type, "
+        "cm.file_path, cm.file_name, cm.file_size, cm.is_pinned, "
+        "COALESCE((SELECT COUNT(*) FROM channel_message_views WHERE message_id = cm.id), 0) as views_count, "
+        "cm.created_at "
+        "FROM channel_messages cm JOIN users u ON cm.sender_id = u.id "
+        "WHERE cm.channel_id = $1 ORDER BY cm.created_at DESC, cm.id DESC LIMIT $2"},
+    {"get_channel_messages_before",
+        "SELECT cm.id, cm.channel_id, cm.sender_id, u.username, cm.content, cm.message_type, "
+        "cm.file_path, cm.file_name, cm.file_size, cm.is_pinned, "
+        "COALESCE((SELECT COUNT(*) FROM channel_message_views WHERE message_id = cm.id), 0) as views_count, "
+        "cm.created_at "
+        "FROM channel_messages cm JOIN users u ON cm.sender_id = u.id "
+        "WHERE cm.channel_id = $1 "
+        "AND (cm.created_at, cm.id) < (SELECT created_at, id FROM channel_messages WHERE id = $3) "
+        "ORDER BY cm.created_at DESC, cm.id DESC LIMIT $2"},
+    {"get_channel_messages_after",
+        "SELECT cm.id, cm.channel_id, cm.sender_id, u.username, cm.content, cm.message_type, "
+        "cm.file_path, cm.file_name, cm.file_size, cm.is_pinned, "
+        "COALESCE((SELECT COUNT(*) FROM channel_message_views WHERE message_id = cm.id), 0) as views_count, "
+        "cm.created_at "
+        "FROM channel_messages cm JOIN users u ON cm.sender_id = u.id "
+        "WHERE cm.channel_id = $1 "
+        "AND (cm.created_at, cm.id) > (SELECT created_at, id FROM channel_messages WHERE id = $3) "
+        "ORDER BY cm.created_at ASC, cm.id ASC LIMIT $2"},
+    {"add_message_reaction",
+        "INSERT INTO channel_message_reactions (message_id, user_id, reaction) VALUES ($1, $2, $3) "
+        "ON CONFLICT (message_id, user_id, reaction) DO NOTHING"},
+    {"remove_message_reaction",
+        "DELETE FROM channel_message_reactions WHERE message_id = $1 AND user_id = $2 AND reaction = $3"},
+    {"get_message_reactions",
+        "SELECT reaction FROM channel_message_reactions WHERE message_id = $1"},
+    {"add_message_view",
+        "INSERT INTO channel_message_views (message_id, user_id) VALUES ($1, $2) "
+        "ON CONFLICT (message_id, user_id) DO NOTHING"},
+    {"get_message_views_count",
+        "SELECT COUNT(*) FROM channel_message_views WHERE message_id = $1"},
+    {"update_channel_message_views",
+        "UPDATE channel_messages SET views_count = (SELECT COUNT(*) FROM channel_message_views WHERE message_id = $1) WHERE id = $1"},
+    {"remove_channel_member",
+        "DELETE FROM channel_members WHERE channel_id = $1 AND user_id = $2"},
+    {"update_channel_member_role",
+        "UPDATE channel_members SET role = $1 WHERE channel_id = $2 AND user_id = $3"},
+    {"ban_channel_member",
+        "UPDATE channel_members SET is_banned = $1 WHERE channel_id = $2 AND user_id = $3"},
+    {"get_channel_members",
+        "SELECT cm.id, cm.channel_id, cm.user_id, u.username, cm.role, cm.is_banned, cm.joined_at "
+        "FROM channel_members cm JOIN users u ON cm.user_id = u.id WHERE cm.channel_id = $1"},
+    {"count_channel_subscribers",
+        "SELECT COUNT(*) FROM channel_members WHERE channel_id = $1 AND role = 'subscriber'"},
+    {"count_channel_members",
+        "SELECT COUNT(*) FROM channel_members WHERE channel_id = $1"},
+    {"get_channel_member",
+        "SELECT cm.id, cm.channel_id, cm.user_id, u.username, cm.role, cm.is_banned, cm.joined_at "
+        "FROM channel_members cm JOIN users u ON cm.user_id = u.id WHERE cm.channel_id = $1 AND cm.user_id = $2"},
+    // Legacy pin/unpin must be scoped to channel_id and match callers' param counts
+    {"pin_channel_message",
+        "UPDATE channel_messages SET is_pinned = TRUE WHERE channel_id = $1 AND id = $2"},
+    {"unpin_channel_message",
+        "UPDATE channel_messages SET is_pinned = FALSE WHERE channel_id = $1 AND id = $2"},
+    {"get_channel_message_meta",
+        "SELECT channel_id::text, sender_id::text FROM channel_messages WHERE id = $1"},
+    {"delete_channel_message",
+        "DELETE FROM channel_messages WHERE id = $1 AND channel_id = $2"},
+    {"get_group_message_meta",
+        "SELECT group_id::text, sender_id::text FROM group_messages WHERE id = $1"},
+    {"delete_group_message",
+        "DELETE FROM group_messages WHERE id = $1 AND group_id = $2"},
+    {"set_channel_custom_link",
+        "UPDATE channels SET custom_link = NULLIF($1, '') WHERE id = $2"},
+    {"update_channel_name",
+        "UPDATE channels SET name = $1 WHERE id = $2"},
+    {"update_channel_description",
+        "UPDATE channels SET description = $1 WHERE id = $2"},
+    {"set_channel_privacy",
+        "UPDATE channels SET is_private = $1 WHERE id = $2"},
+    {"set_channel_show_author",
+        "UPDATE channels SET show_author = $1 WHERE id = $2"},
+    {"delete_channel_legacy",
+        "DELETE FROM channels WHERE id = $1"},
+    {"add_allowed_reaction",
+        "INSERT INTO channel_allowed_reactions (channel_id, reaction) VALUES ($1, $2) "
+        "ON CONFLICT (channel_id, reaction) DO NOTHING"},
+    {"remove_allowed_reaction",
+        "DELETE FROM channel_allowed_reactions WHERE channel_id = $1 AND reaction = $2"},
+    {"get_allowed_reactions",
+        "SELECT reaction FROM channel_allowed_reactions WHERE channel_id = $1"},
+    {"create_channel_join_request",
+        "INSERT INTO channel_join_requests (channel_id, user_id) VALUES ($1, $2) "
+        "ON CONFLICT (channel_id, user_id) DO NOTHING"},
+    {"accept_channel_join_request",
+        "UPDATE channel_join_requests SET status = 'accepted' WHERE channel_id = $1 AND user_id = $2"},
+    {"reject_channel_join_request",
+        "UPDATE channel_join_requests SET status = 'rejected' WHERE channel_id = $1 AND user_id = $2"},
+    {"get_channel_join_requests",
+        "SELECT cjr.id, cjr.channel_id, cjr.user_id, u.username, cjr.created_at "
+        "FROM channel_join_requests cjr JOIN users u ON cjr.user_id = u.id "
+        "WHERE cjr.channel_id = $1 AND cjr.status = 'pending'"},
+    {"create_channel_chat",
+        "INSERT INTO channel_chats (channel_id, group_id) VALUES ($1, $2) "
+        "ON CONFLICT (channel_id) DO UPDATE SET group_id = EXCLUDED.group_id"},
+    
+    // Marketplace statements
+    {"create_market_product",
+        "INSERT INTO market_products (owner_chat_id, owner_type, title, description, price_amount, price_currency, product_type, image_path, stock_quantity, created_by) "
+        "VALUES ($1, $2, $3, $4, $5, $6, $7, NULLIF($8, ''), NULLIF($9::integer, NULL), $10) RETURNING id"},
+    {"update_market_product",
+        "UPDATE market_products SET title = $1, description = $2, price_amount = $3, price_currency = $4, image_path = NULLIF($5, ''), stock_quantity = NULLIF($6::integer, NULL), is_active = $7 WHERE id = $8"},
+    {"delete_market_product",
+        "DELETE FROM market_products WHERE id = $1"},
+    {"get_market_products",
+        "SELECT id, owner_chat_id, owner_type, title, description, price_amount, price_currency, product_type, image_path, is_active, stock_quantity, created_at, created_by "
+        "FROM market_products WHERE owner_chat_id = $1 AND owner_type = $2 AND is_active = TRUE ORDER BY created_at DESC"},
+    {"get_market_product_by_id",
+        "SELECT id, owner_chat_id, owner_type, title, description, price_amount, price_currency, product_type, image_path, is_active, stock_quantity, created_at, created_by "
+        "FROM market_products WHERE id = $1"},
+    {"add_product_key",
+        "INSERT INTO product_keys (product_id, key_value) VALUES ($1, $2)"},
+    {"get_unused_product_key",
+        "SELECT id, key_value FROM product_keys WHERE product_id = $1 AND is_used = FALSE LIMIT 1 FOR UPDATE SKIP LOCKED"},
+    {"mark_product_key_used",
+        "UPDATE product_keys SET is_used = TRUE, used_by = $2, used_at = CURRENT_TIMESTAMP WHERE id = $1"},
+    {"create_product_purchase",
+        "INSERT INTO product_purchases (product_id, buyer_id, seller_id, price_amount, price_currency, platform_fee, invoice_id, status) "
+        "VALUES ($1, $2, $3, $4, $5, $4 * 0.05, $6, 'paid') RETURNING id"},
+    {"update_purchase_key",
+        "UPDATE product_purchases SET key_id = $2, status = 'delivered', delivered_at = CURRENT_TIMESTAMP WHERE id = $1"},
+    {"get_user_purchases",
+        "SELECT id, product_id, buyer_id, seller_id, price_amount, price_currency, platform_fee, status, invoice_id, key_id, created_at "
+        "FROM product_purchases WHERE buyer_id = $1 ORDER BY created_at DESC"},
+    
+    // Integration statements
+    {"create_integration_binding",
+        "INSERT INTO integration_bindings (chat_id, chat_type, service_name, external_token, config_json, created_by) "
+        "VALUES ($1, $2, $3, $4, $5::jsonb, $6) RETURNING id"},
+    {"update_integration_binding",
+        "UPDATE integration_bindings SET config_json = $1::jsonb, is_active = $2 WHERE id = $3"},
+    {"delete_integration_binding",
+        "DELETE FROM integration_bindings WHERE id = $1"},
+    {"get_integration_bindings",
+        "SELECT id, chat_id, chat_type, service_name, config_json, is_active, created_at, created_by "
+        "FROM integration_bindings WHERE chat_id = $1 AND chat_type = $2"},
+    {"get_integration_binding_by_id",
+        "SELECT id, chat_id, chat_type, service_name, config_json, is_active, created_at, created_by "
+        "FROM integration_bindings WHERE id = $1"},
+    
+    // Bot Builder statements
+    {"create_bot_builder_bot",
+        "INSERT INTO bot_builder_bots (user_id, bot_user_id, bot_token, bot_username, bot_name, flow_json) "
+        "VALUES ($1, $2::uuid, $3, $4, $5, $6::jsonb) RETURNING id"},
+    {"update_bot_builder_bot",
+        "UPDATE bot_builder_bots SET flow_json = $1::jsonb, is_active = $2, updated_at = CURRENT_TIMESTAMP WHERE id = $3"},
+    {"delete_bot_builder_bot",
+        "DELETE FROM bot_builder_bots WHERE id = $1"},
+    
+    // Bot developers
+    {"add_bot_developer",
+        "INSERT INTO bot_developers (bot_id, developer_user_id, added_by_user_id) "
+        "VALUES ($1::uuid, $2::uuid, $3::uuid) "
+        "ON CONFLICT (bot_id, developer_user_id) DO NOTHING"},
+    {"remove_bot_developer",
+        "DELETE FROM bot_developers WHERE bot_id = $1::uuid AND developer_user_id = $2::uuid"},
+    {"get_bot_developers",
+        "SELECT d.developer_user_id, u.username, d.added_by_user_id, d.added_at "
+        "FROM bot_developers d "
+        "JOIN users u ON u.id = d.developer_user_id "
+        "WHERE d.bot_id = $1::uuid "
+        "ORDER BY d.added_at ASC"},
+    {"is_bot_developer",
+        "SELECT 1 FROM bot_developers WHERE bot_id = $1::uuid AND developer_user_id = $2::uuid LIMIT 1"},
+    
+    // Bot files
+    {"upsert_bot_file",
+        "INSERT INTO bot_files (bot_id, file_path, file_content) "
+        "VALUES ($1::uuid, $2, $3) "
+        "ON CONFLICT (bot_id, file_path) "
+        "DO UPDATE SET file_content = $3, updated_at = CURRENT_TIMESTAMP"},
+    {"get_bot_file",
+        "SELECT file_content FROM bot_files WHERE bot_id = $1::uuid AND file_path = $2"},
+    {"delete_bot_file",
+        "DELETE FROM bot_files WHERE bot_id = $1::uuid AND file_path = $2"},
+    {"list_bot_files",
+        "SELECT id, file_path, file_content, created_at, updated_at "
+        "FROM bot_files WHERE bot_id = $1::uuid ORDER BY file_path ASC"},
+    
+    {"get_user_bots",
+        "SELECT id, user_id, COALESCE(bot_user_id::text, ''), bot_token, bot_username, bot_name, flow_json, is_active, created_at, deployed_at, "
+        "COALESCE(bot_description, ''), COALESCE(bot_avatar_url, '') "
+        "FROM bot_builder_bots WHERE user_id = $1 ORDER BY created_at DESC"},
+    {"get_bot_builder_bot_by_token",
+        "SELECT id, user_id, COALESCE(bot_user_id::text, ''), bot_token, bot_username, bot_name, flow_json, is_active, created_at, deployed_at, "
+        "COALESCE(bot_description, ''), COALESCE(bot_avatar_url, '') "
+        "FROM bot_builder_bots WHERE bot_token = $1"},
+    {"get_bot_builder_bot_by_username",
+        "SELECT id, user_id, COALESCE(bot_user_id::text, ''), bot_token, bot_username, bot_name, flow_json, is_active, created_at, deployed_at, "
+        "COALESCE(bot_description, ''), COALESCE(bot_avatar_url, '') "
+        "FROM bot_builder_bots WHERE bot_username = $1"},
+    {"get_bot_builder_bot_by_id",
+        "SELECT id, user_id, COALESCE(bot_user_id::text, ''), bot_token, bot_username, bot_name, flow_json, is_active, created_at, deployed_at, "
+        "COALESCE(bot_description, ''), COALESCE(bot_avatar_url, '') "
+        "FROM bot_builder_bots WHERE id = $1"},
+    {"get_bot_builder_bot_by_user_id",
+        "SELECT id, user_id, COALESCE(bot_user_id::text, ''), bot_token, bot_username, bot_name, flow_json, is_active, created_at, deployed_at, "
+        "COALESCE(bot_description, ''), COALESCE(bot_avatar_url, '') "
+        "FROM bot_builder_bots WHERE bot_user_id = $1::uuid"},
+    {"update_bot_builder_profile",
+        "UPDATE bot_builder_bots SET bot_name = $1, bot_description = $2, updated_at = CURRENT_TIMESTAMP WHERE id = $3"},
+    {"update_bot_builder_avatar",
+        "UPDATE bot_builder_bots SET bot_avatar_url = $1, updated_at = CURRENT_TIMESTAMP WHERE id = $2"},
+    {"get_bot_builder_script_by_bot_user_id",
+        "SELECT COALESCE(script_lang, 'lite'), COALESCE(script_enabled, FALSE), COALESCE(script_code, '') "
+        "FROM bot_builder_bots WHERE bot_user_id = $1::uuid LIMIT 1"},
+    {"get_bot_builder_script_by_id",
+        "SELECT COALESCE(script_lang, 'lite'), COALESCE(script_enabled, FALSE), COALESCE(script_code, '') "
+        "FROM bot_builder_bots WHERE id = $1::uuid LIMIT 1"},
+    {"update_bot_builder_script",
+        "UPDATE bot_builder_bots SET script_lang = $1, script_enabled = $2::boolean, script_code = $3, updated_at = CURRENT_TIMESTAMP "
+        "WHERE id = $4::uuid"},
+    {"log_bot_execution",
+        "INSERT INTO bot_execution_logs (bot_id, update_id, user_id, chat_id, node_id, node_type, execution_result, execution_time_ms, error_message) "
+        "VALUES ($1, $2, $3, $4, $5, $6, $7::jsonb, $8, $9)"},
+
+    // Bot runtime: notes
+    {"upsert_bot_note",
+        "INSERT INTO bot_notes (bot_user_id, scope_type, scope_id, note_key, note_value, created_by) "
+        "VALUES ($1::uuid, $2, $3::uuid, $4, $5, NULLIF($6,'')::uuid) "
+        "ON CONFLICT (bot_user_id, scope_type, scope_id, note_key) "
+        "DO UPDATE SET note_value = EXCLUDED.note_value, updated_at = now(), created_by = EXCLUDED.created_by"},
+    {"get_bot_note",
+        "SELECT note_value FROM bot_notes "
+        "WHERE bot_user_id = $1::uuid AND scope_type = $2 AND scope_id = $3::uuid AND note_key = $4 "
+        "LIMIT 1"},
+    {"list_bot_notes",
+        "SELECT note_key FROM bot_notes "
+        "WHERE bot_user_id = $1::uuid AND scope_type = $2 AND scope_id = $3::uuid "
+        "ORDER BY note_key ASC LIMIT 200"},
+    {"delete_bot_note",
+        "DELETE FROM bot_notes "
+        "WHERE bot_user_id = $1::uuid AND scope_type = $2 AND scope_id = $3::uuid AND note_key = $4"},
+
+    // Bot runtime: reminders
+    {"create_bot_reminder",
+        "INSERT INTO bot_reminders (bot_user_id, scope_type, scope_id, target_user_id, reminder_text, due_at) "
+        "VALUES ($1::uuid, $2, $3::uuid, NULLIF($4,'')::uuid, $5, now() + ($6::text || ' seconds')::interval) "
+        "RETURNING id::text"},
+    {"claim_due_bot_reminders",
+        "WITH due AS ("
+        "  SELECT id FROM bot_reminders "
+        "  WHERE sent_at IS NULL AND due_at <= now() "
+        "  ORDER BY due_at ASC "
+        "  LIMIT $1"
+        ") "
+        "UPDATE bot_reminders br "
+        "SET sent_at = now() "
+        "WHERE br.id IN (SELECT id FROM due) "
+        "RETURNING br.id::text, br.bot_user_id::text, br.scope_type, br.scope_id::text, COALESCE(br.target_user_id::text,''), br.reminder_text"},
+
+    // Bot runtime: group bots (members)
+    {"get_group_bot_user_ids",
+        "SELECT gm.user_id::text "
+        "FROM group_members gm "
+        "JOIN bot_builder_bots b ON b.bot_user_id = gm.user_id "
+        "WHERE gm.group_id = $1::uuid AND b.is_active = TRUE"},
+    
+    // Event Router statements
+    {"create_trigger_rule",
+        "INSERT INTO trigger_rules (chat_id, chat_type, rule_name, trigger_conditions, actions, rate_limit_per_second, created_by) "
+        "VALUES ($1, $2, $3, $4::jsonb, $5::jsonb, $6, $7) RETURNING id"},
+    {"update_trigger_rule",
+        "UPDATE trigger_rules SET trigger_conditions = $1::jsonb, actions = $2::jsonb, is_active = $3, rate_limit_per_second = $4 WHERE id = $5"},
+    {"delete_trigger_rule",
+        "DELETE FROM trigger_rules WHERE id = $1"},
+    {"get_trigger_rules",
+        "SELECT id, chat_id, chat_type, rule_name, trigger_conditions, actions, is_active, rate_limit_per_second, created_at, created_by "
+        "FROM trigger_rules WHERE chat_id = $1 AND chat_type = $2 AND is_active = TRUE"},
+    {"create_event_webhook",
+        "INSERT INTO event_webhooks (trigger_rule_id, webhook_url, secret_token, http_method, headers_json) "
+        "VALUES ($1, $2, $3, $4, $5::jsonb) RETURNING id"},
+    {"log_trigger_execution",
+        "INSERT INTO trigger_executions (trigger_rule_id, event_type, event_data, execution_result, status, error_message) "
+        "VALUES ($1, $2, $3::jsonb, $4::jsonb, $5, $6)"},
+
+    // Advanced chats/supergroups (v2 unified)
+    {"create_chat_v2",
+        "INSERT INTO chats (type, title, username, about, is_public, slow_mode_sec, sign_messages, created_by) "
+        "VALUES ($1::chat_type, $2, NULLIF($3, ''), NULLIF($4, ''), $5::boolean, NULLIF($6, '0')::integer, $7::boolean, $8::uuid) "
+        "RETURNING id"},
+    {"update_chat_title_v2",
+        "UPDATE chats SET title = $1 WHERE id = $2::uuid"},
+    {"update_chat_about_v2",
+        "UPDATE chats SET about = $1 WHERE id = $2::uuid"},
+    {"update_chat_username_v2",
+        "UPDATE chats SET username = NULLIF($1, '') WHERE id = $2::uuid"},
+    {"update_chat_is_public_v2",
+        "UPDATE chats SET is_public = $1::boolean WHERE id = $2::uuid"},
+    {"update_chat_sign_messages_v2",
+        "UPDATE chats SET sign_messages = $1::boolean WHERE id = $2::uuid"},
+    {"insert_chat_sequence_v2",
+        "INSERT INTO chat_sequences (chat_id, next_local) VALUES ($1::uuid, 1) ON CONFLICT (chat_id) DO NOTHING"},
+    {"insert_chat_participant_owner_v2",
+        "INSERT INTO chat_participants (chat_id, user_id, status) VALUES ($1::uuid, $2::uuid, 'owner') "
+        "ON CONFLICT (chat_id, user_id) DO UPDATE SET status = 'owner', admin_role_id = NULL"},
+    {"upsert_chat_member_v2",
+        "INSERT INTO chat_participants (chat_id, user_id, status) VALUES ($1::uuid, $2::uuid, 'member') "
+        "ON CONFLICT (chat_id, user_id) DO UPDATE SET status = 'member', admin_role_id = NULL"},
+    {"leave_chat_v2",
+        "UPDATE chat_participants SET status = 'left', admin_role_id = NULL WHERE chat_id = $1::uuid AND user_id = $2::uuid"},
+    {"get_chat_type_v2",
+        "SELECT type FROM chats WHERE id = $1::uuid"},
+    {"insert_chat_link_v2",
+        "INSERT INTO chat_links (channel_id, discussion_id) VALUES ($1::uuid, $2::uuid) "
+        "ON CONFLICT (channel_id) DO UPDATE SET discussion_id = EXCLUDED.discussion_id"},
+    {"upsert_admin_role_v2",
+        "INSERT INTO admin_roles (chat_id, title, perms) VALUES ($1::uuid, $2, $3::bigint) "
+        "ON CONFLICT (chat_id, title) DO UPDATE SET perms = EXCLUDED.perms "
+        "RETURNING id, perms"},
+    {"upsert_participant_admin_v2",
+        "INSERT INTO chat_participants (chat_id, user_id, status, admin_role_id) VALUES ($1::uuid, $2::uuid, 'admin', $3::uuid) "
+        "ON CONFLICT (chat_id, user_id) DO UPDATE SET status = 'admin', admin_role_id = EXCLUDED.admin_role_id"},
+    {"set_owner_adminrole_v2",
+        "UPDATE chat_participants SET admin_role_id = $2::uuid WHERE chat_id = $1::uuid AND user_id = $3::uuid"},
+    {"get_participant_role_v2",
+        "SELECT status, admin_role_id FROM chat_participants WHERE chat_id = $1::uuid AND user_id = $2::uuid"},
+    {"get_admin_role_perms_v2",
+        "SELECT perms FROM admin_roles WHERE id = $1::uuid"},
+    {"get_participant_restriction_v2",
+        "SELECT can_send_messages, can_send_media, can_add_links, can_invite_users, until "
+        "FROM participant_restrictions "
+        "WHERE chat_id = $1::uuid AND user_id = $2::uuid AND (until IS NULL OR until > now())"},
+    {"get_chat_v2",
+        "SELECT id, type, title, COALESCE(username, ''), COALESCE(about, ''), COALESCE(avatar_url, ''), is_public, "
+        "COALESCE(sign_messages, true), COALESCE(slow_mode_sec, 0), created_by, created_at, COALESCE(is_verified, false) "
+        "FROM chats WHERE id = $1::uuid"},
+    {"get_chat_by_username_v2",
+        "SELECT id, type, title, COALESCE(username, ''), COALESCE(about, ''), COALESCE(avatar_url, ''), is_public, "
+        "COALESCE(sign_messages, true), COALESCE(slow_mode_sec, 0), created_by, created_at, COALESCE(is_verified, false) "
+        "FROM chats WHERE username = $1"},
+    {"get_user_channels_v2",
+        "SELECT c.id, c.title, COALESCE(c.about, ''), COALESCE(c.username, ''), COALESCE(c.avatar_url, ''), c.is_public, "
+        "COALESCE(c.sign_messages, true), c.created_by, c.created_at, COALESCE(c.is_verified, false) "
+        "FROM chats c "
+        "JOIN chat_participants cp ON cp.chat_id = c.id "
+        "WHERE c.type = 'channel' AND cp.user_id = $1::uuid AND cp.status NOT IN ('kicked','left') "
+        "ORDER BY c.created_at DESC"},
+    {"get_channel_members_v2",
+        "SELECT cp.user_id, COALESCE(u.username, ''), cp.status::text, cp.joined_at::text, "
+        "       COALESCE(ar.perms, 0), COALESCE(ar.title, '') "
+        "FROM chat_participants cp "
+        "LEFT JOIN users u ON u.id = cp.user_id "
+        "LEFT JOIN admin_roles ar ON ar.id = cp.admin_role_id "
+        "WHERE cp.chat_id = $1::uuid AND cp.status != 'left'"},
+    {"get_chat_link_v2",
+        "SELECT discussion_id FROM chat_links WHERE channel_id = $1::uuid"},
+    {"get_chat_participant_v2",
+        "SELECT status::text, admin_role_id::text, joined_at::text "
+        "FROM chat_participants WHERE chat_id = $1::uuid AND user_id = $2::uuid"},
+    {"update_chat_participant_status_v2",
+        "UPDATE chat_participants SET status = $3::participant_status, admin_role_id = NULL "
+        "WHERE chat_id = $1::uuid AND user_id = $2::uuid"},
+    {"demote_chat_admin_v2",
+        "UPDATE chat_participants SET status = 'member', admin_role_id = NULL "
+        "WHERE chat_id = $1::uuid AND user_id = $2::uuid"},
+    {"update_chat_avatar_v2",
+        "UPDATE chats SET avatar_url = NULLIF($1, '') WHERE id = $2::uuid"},
+    {"delete_chat_v2",
+        "DELETE FROM chats WHERE id = $1::uuid"},
+    {"update_channel_avatar",
+        "UPDATE channels SET avatar_url = NULLIF($1, '') WHERE id = $2"},
+    {"inc_local_id_v2",
+        "UPDATE chat_sequences SET next_local = next_local + 1 WHERE chat_id = $1::uuid RETURNING next_local"},
+    {"insert_chat_message_v2",
+        "INSERT INTO chat_messages (chat_id, local_id, sender_id, replied_to, thread_root_id, content_type, content, is_silent) "
+        "VALUES ($1::uuid, $2::bigint, $3::uuid, $4::bigint, $5::bigint, $6, $7::jsonb, $8::boolean) "
+        "RETURNING id"},
+    // Reactions v2
+    {"insert_reaction_counts_v2",
+        "INSERT INTO message_reaction_counts (message_id, counts) VALUES ($1::bigint, '{}'::jsonb) ON CONFLICT DO NOTHING"},
+    {"insert_reaction_shard_v2",
+        "INSERT INTO message_reactions_shard (shard, message_id, user_id, reaction) VALUES ($1::smallint, $2::bigint, $3::uuid, $4) "
+        "ON CONFLICT DO NOTHING"},
+    {"delete_reaction_shard_v2",
+        "DELETE FROM message_reactions_shard WHERE shard = $1::smallint AND message_id = $2::bigint AND user_id = $3::uuid AND reaction = $4"},
+    {"update_reaction_count_v2",
+        "UPDATE message_reaction_counts SET counts = jsonb_set(COALESCE(counts, '{}'::jsonb), "
+        "ARRAY[$2], to_jsonb(GREATEST(0, COALESCE((counts->>$2)::bigint, 0) + $3))) "
+        "WHERE message_id = $1::bigint RETURNING counts"},
+    {"get_reaction_counts_v2",
+        "SELECT counts FROM message_reaction_counts WHERE message_id = $1::bigint"},
+    {"get_reaction_counts_kv_v2",
+        "SELECT key, (value)::bigint FROM message_reaction_counts, LATERAL jsonb_each(counts) WHERE message_id = $1::bigint"},
+    {"get_chat_messages_v2",
+        "SELECT m.id, m.local_id, m.sender_id, COALESCE(u.username, ''), m.content, m.content_type, m.is_silent, m.created_at, "
+        "       (cp.message_id IS NOT NULL) AS is_pinned "
+        "FROM chat_messages m "
+        "LEFT JOIN users u ON u.id = m.sender_id "
+        "LEFT JOIN chat_pins cp ON cp.chat_id = m.chat_id AND cp.message_id = m.id "
+        "WHERE m.chat_id = $1::uuid "
+        "AND ($2::bigint = 0 OR local_id < $2::bigint) "
+        "ORDER BY local_id DESC LIMIT $3"},
+
+    {"pin_chat_message_v2",
+        "INSERT INTO chat_pins (chat_id, message_id, pinned_by) "
+        "VALUES ($1::uuid, $2::bigint, $3::uuid) "
+        "ON CONFLICT (chat_id) DO UPDATE "
+        "SET message_id = EXCLUDED.message_id, pinned_by = EXCLUDED.pinned_by, pinned_at = now()"},
+    {"unpin_chat_message_v2",
+        "DELETE FROM chat_pins WHERE chat_id = $1::uuid"},
+    {"get_chat_message_meta_v2",
+        "SELECT chat_id::text, COALESCE(sender_id::text, '') "
+        "FROM chat_messages WHERE id = $1::bigint"},
+    {"delete_chat_message_v2",
+        "DELETE FROM chat_messages WHERE id = $1::bigint AND chat_id = $2::uuid"},
+
+    {"upsert_channel_read_state_v2",
+        "INSERT INTO channel_read_states (channel_id, user_id, max_read_local) "
+        "VALUES ($1::uuid, $2::uuid, $3::bigint) "
+        "ON CONFLICT (channel_id, user_id) "
+        "DO UPDATE SET max_read_local = GREATEST(channel_read_states.max_read_local, EXCLUDED.max_read_local), "
+        "updated_at = now()"},
+
+    {"get_channel_unread_v2",
+        "SELECT (COALESCE(cs.next_local,1)-1) - COALESCE(crs.max_read_local,0) AS unread "
+        "FROM channel_sequences cs "
+        "LEFT JOIN channel_read_states crs ON crs.channel_id = cs.channel_id AND crs.user_id = $2::uuid "
+        "WHERE cs.channel_id = $1::uuid"},
+
+    // Join requests + reactions (v2 chats)
+    {"create_chat_join_request",
+        "INSERT INTO chat_join_requests (chat_id, user_id) VALUES ($1::uuid, $2::uuid) "
+        "ON CONFLICT (chat_id, user_id) DO NOTHING"},
+    {"accept_chat_join_request",
+        "UPDATE chat_join_requests SET status = 'accepted' WHERE chat_id = $1::uuid AND user_id = $2::uuid"},
+    {"reject_chat_join_request",
+        "UPDATE chat_join_requests SET status = 'rejected' WHERE chat_id = $1::uuid AND user_id = $2::uuid"},
+    {"get_chat_join_requests",
+        "SELECT cjr.id, cjr.chat_id, cjr.user_id, COALESCE(u.username, ''), cjr.created_at "
+        "FROM chat_join_requests cjr JOIN users u ON u.id = cjr.user_id "
+        "WHERE cjr.chat_id = $1::uuid AND cjr.status = 'pending'"},
+    {"add_chat_allowed_reaction",
+        "INSERT INTO chat_allowed_reactions (chat_id, reaction) VALUES ($1::uuid, $2) "
+        "ON CONFLICT (chat_id, reaction) DO NOTHING"},
+    {"remove_chat_allowed_reaction",
+        "DELETE FROM chat_allowed_reactions WHERE chat_id = $1::uuid AND reaction = $2"},
+    {"get_chat_allowed_reactions",
+        "SELECT reaction FROM chat_allowed_reactions WHERE chat_id = $1::uuid"},
+
+    // Chat invites (v2)
+    {"create_chat_invite_v2",
+        "INSERT INTO chat_invite_links (chat_id, token, expire_at, usage_limit, created_by) "
+        "VALUES ($1::uuid, uuid_generate_v4()::text, "
+        "CASE WHEN $3::int > 0 THEN now() + ($3::text || ' seconds')::interval ELSE NULL END, "
+        "NULLIF($4::int, 0), $2::uuid) RETURNING token"},
+    {"revoke_chat_invite_v2",
+        "UPDATE chat_invite_links SET is_revoked = TRUE WHERE token = $1"},
+    {"get_chat_invite_v2",
+        "SELECT chat_id, expire_at, usage_limit, usage_count, is_revoked FROM chat_invite_links WHERE token = $1"},
+    {"inc_chat_invite_usage_v2",
+        "UPDATE chat_invite_links SET usage_count = usage_count + 1 WHERE token = $1"},
+
+    // Channel invites (legacy)
+    {"create_channel_invite_legacy",
+        "INSERT INTO channel_invite_links (channel_id, token, expire_at, usage_limit, created_by) "
+        "VALUES ($1::uuid, uuid_generate_v4()::text, "
+        "CASE WHEN $3::int > 0 THEN now() + ($3::text || ' seconds')::interval ELSE NULL END, "
+        "NULLIF($4::int, 0), $2::uuid) RETURNING token"},
+    {"revoke_channel_invite_legacy",
+        "UPDATE channel_invite_links SET is_revoked = TRUE WHERE token = $1"},
+    {"get_channel_invite_legacy",
+        "SELECT channel_id, expire_at, usage_limit, usage_count, is_revoked FROM channel_invite_links WHERE token = $1"},
+    {"inc_channel_invite_usage_legacy",
+        "UPDATE channel_invite_links SET usage_count = usage_count + 1 WHERE token = $1"},
+    {"get_channel_subscribers_v2",
+        "SELECT user_id FROM chat_participants WHERE chat_id = $1::uuid AND status IN ('owner','admin','member')"},
+    {"count_chat_subscribers_v2",
+        "SELECT COUNT(*) FROM chat_participants WHERE chat_id = $1::uuid AND status IN ('owner','admin','member')"},
+    {"count_chat_members_v2",
+        "SELECT COUNT(*) FROM chat_participants WHERE chat_id = $1::uuid AND status != 'left'"},
+
+    // Polls v2 (supports chat, channel, group)
+    {"insert_poll_v2",
+        "INSERT INTO polls (message_id, message_type, question, is_anonymous, allows_multiple, closes_at) "
+        "VALUES ($1::bigint, $2, $3, $4::boolean, $5::boolean, NULLIF($6,'')::timestamptz) RETURNING id"},
+    {"insert_poll_option_v2",
+        "INSERT INTO poll_options (poll_id, option_text) VALUES ($1::bigint, $2) RETURNING id"},
+    {"vote_poll_v2",
+        "INSERT INTO poll_votes (poll_id, option_id, user_id) VALUES ($1::bigint, $2::bigint, $3::uuid) "
+        "ON CONFLICT DO NOTHING"},
+    {"inc_poll_option_v2",
+        "UPDATE poll_options SET vote_count = vote_count + 1 WHERE id = $1::bigint RETURNING vote_count"},
+    {"get_poll_v2",
+        "SELECT p.id, p.message_id, p.message_type, p.question, p.is_anonymous, p.allows_multiple, p.closes_at, "
+        "po.id, po.option_text, po.vote_count "
+        "FROM polls p JOIN poll_options po ON p.id = po.poll_id WHERE p.id = $1::bigint"},
+    {"get_poll_by_message",
+        "SELECT p.id, p.message_id, p.message_type, p.question, p.is_anonymous, p.allows_multiple, p.closes_at, "
+        "po.id, po.option_text, po.vote_count "
+        "FROM polls p JOIN poll_options po ON p.id = po.poll_id "
+        "WHERE p.message_type = $1 AND p.message_id = $2::bigint"},
+
+    // Moderation reports
+    {"create_message_report",
+        "INSERT INTO message_reports (reporter_id, reported_user_id, message_id, message_type, message_content, reason, comment, context_json) "
+        "VALUES ($1::uuid, $2::uuid, $3, $4, $5, $6, NULLIF($7, ''), COALESCE($8::jsonb, '[]'::jsonb)) RETURNING id"},
+    {"get_message_reports_paginated",
+        "SELECT r.id, r.reporter_id, COALESCE(rep.username, '') as reporter_username, "
+        "r.reported_user_id, COALESCE(u.username, '') as reported_username, "
+        "r.message_id, r.message_type, r.message_content, r.reason, COALESCE(r.comment,''), "
+        "r.context_json, r.status, COALESCE(r.resolution_note,''), r.resolved_by, "
+        "r.resolved_at, r.created_at "
+        "FROM message_reports r "
+        "LEFT JOIN users u ON u.id = r.reported_user_id "
+        "LEFT JOIN users rep ON rep.id = r.reporter_id "
+        "WHERE ($3 = '' OR r.status = $3) "
+        "ORDER BY r.created_at DESC, r.id DESC "
+        "LIMIT $1 OFFSET $2"},
+    // Keyset variant of the above: the page after report $2
+    {"get_message_reports_before",
+        "SELECT r.id, r.reporter_id, COALESCE(rep.username, '') as reporter_username, "
+        "r.reported_user_id, COALESCE(u.username, '') as reported_username, "
+        "r.message_id, r.message_type, r.message_content, r.reason, COALESCE(r.comment,''), "
+        "r.context_json, r.status, COALESCE(r.resolution_note,''), r.resolved_by, "
+        "r.resolved_at, r.created_at "
+        "FROM message_reports r "
+        "LEFT JOIN users u ON u.id = r.reported_user_id "
+        "LEFT JOIN users rep ON rep.id = r.reporter_id "
+        "WHERE ($3 = '' OR r.status = $3) "
+        "AND (r.created_at, r.id) < (SELECT created_at, id FROM message_reports WHERE id = $2::uuid) "
+        "ORDER BY r.created_at DESC, r.id DESC "
+        "LIMIT $1"},
+    {"count_message_reports",
+        "SELECT COUNT(*) FROM message_reports WHERE ($1 = '' OR status = $1)"},
+    {"count_reports_for_user_window",
+        "SELECT COUNT(*) FROM message_reports "
+        "WHERE reported_user_id = $1::uuid "
+        "AND ($2 = '' OR reason = $2) "
+        "AND status <> 'dismissed' "
+        "AND created_at >= (now() - ($3::text || ' minutes')::interval)"},
+    {"get_message_report_by_id",
+        "SELECT r.id, r.reporter_id, COALESCE(rep.username, '') as reporter_username, "
+        "r.reported_user_id, COALESCE(u.username, '') as reported_username, "
+        "r.message_id, r.message_type, r.message_content, r.reason, COALESCE(r.comment,''), "
+        "r.context_json, r.status, COALESCE(r.resolution_note,''), r.resolved_by, "
+        "r.resolved_at, r.created_at "
+        "FROM message_reports r "
+        "LEFT JOIN users u ON u.id = r.reported_user_id "
+        "LEFT JOIN users rep ON rep.id = r.reporter_id "
+        "WHERE r.id = $1::uuid"},
+    {"update_message_report_status",
+        "UPDATE message_reports SET status = $2, resolved_by = NULLIF($3, '')::uuid, "
+        "resolution_note = NULLIF($4, ''), "
+        "resolved_at = CASE WHEN $2 IN ('resolved','dismissed') THEN NOW() ELSE resolved_at END "
+        "WHERE id = $1::uuid"},
+    {"get_message_context",
+        "SELECT id, sender_id, receiver_id, content, created_at, is_read, is_delivered, message_type, file_path, file_name, file_size, reply_to_message_id "
+        "FROM messages "
+        "WHERE ((sender_id = $1::uuid AND receiver_id = $2::uuid) OR (sender_id = $2::uuid AND receiver_id = $1::uuid)) "
+        "AND created_at BETWEEN (SELECT created_at FROM messages WHERE id = $3::uuid) - INTERVAL '15 minutes' "
+        "AND (SELECT created_at FROM messages WHERE id = $3::uuid) + INTERVAL '15 minutes' "
+        "ORDER BY created_at ASC LIMIT $4"},
+};
+
+constexpr size_t kPreparedStatementCount = sizeof(kPreparedStatements) / sizeof(kPreparedStatements[0]);
+
+namespace {
+
+constexpr bool sameName(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return *a == *b;
+}
+
+constexpr bool namesAreUnique() {
+    for (size_t i = 0; i < kPreparedStatementCount; ++i) {
+        for (size_t j = i + 1; j < kPreparedStatementCount; ++j) {
+            if (sameName(kPreparedStatements[i].name, kPreparedStatements[j].name)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(namesAreUnique(), "two prepared statements share a name");
+
+} // namespace
+
+} // namespace xipher
@@ -0,0 +1,219 @@
+#include "../include/database/presence_tracker.hpp"
+#include "../include/database/connection_pool.hpp"
+#include "../include/utils/env.hpp"
+#include "../include/utils/logger.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+
+namespace xipher {
+
+namespace {
+
+// Ids go into an array literal, so only uuid characters are accepted
+bool isUuidText(const std::string& id) {
+    if (id.empty() || id.size() > 36) {
+        return false;
+    }
+    return std::all_of(id.begin(), id.end(), [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || c == '-';
+    });
+}
+
+} // namespace
+
+PresenceTracker::Config PresenceTracker::configFromEnv() {
+    Config config;
+    const size_t flush_ms = readEnvSize("XIPHER_PRESENCE_FLUSH_MS", 0);
+    if (flush_ms > 0) {
+        config.flush_interval = std::chrono::milliseconds(flush_ms);
+    }
+    return config;
+}
+
+PresenceTracker::PresenceTracker(ConnectionPool& pool, Config config)
+    : pool_(pool), config_(config) {
+    config_.shards = std::max<size_t>(1, config_.shards);
+    config_.max_batch = std::max<size_t>(1, config_.max_batch);
+    shards_.reset(new Shard[config_.shards]);
+}
+
+PresenceTracker::~PresenceTracker() {
+    stop();
+}
+
+void PresenceTracker::start() {
+    std::lock_guard<std::mutex> lock(stop_mutex_);
+    if (flush_thread_.joinable()) {
+        return;
+    }
+    stopping_ = false;
+    flush_thread_ = std::thread([this]() { flushLoop(); });
+}
+
+void PresenceTracker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        stopping_ = true;
+    }
+    stop_cv_.notify_all();
+    if (flush_thread_.joinable()) {
+        flush_thread_.join();
+    }
+    flush();
+}
+
+PresenceTracker::Shard& PresenceTracker::shardFor(const std::string& user_id) const {
+    return shards_[std::hash<std::string>()(user_id) % config_.shards];
+}
+
+void PresenceTracker::touch(const std::string& user_id) {
+    if (user_id.empty()) {
+        return;
+    }
+    const Micros seen = now();
+    Shard& shard = shardFor(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Entry& entry = shard.entries[user_id];
+    entry.seen = std::max(entry.seen, seen);
+    entry.checked = seen;
+    entry.dirty = true;
+}
+
+bool PresenceTracker::lastSeen(const std::string& user_id, Micros* out) const {
+    const Shard& shard = shardFor(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(user_id);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    const Entry& entry = it->second;
+    if (now() - entry.checked > config_.reload_after.count() * 1000000LL) {
+        return false;
+    }
+    *out = entry.seen;
+    return true;
+}
+
+void PresenceTracker::remember(const std::string& user_id, Micros seen) {
+    if (user_id.empty()) {
+        return;
+    }
+    Shard& shard = shardFor(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // A pending touch of ours is newer than anything flushed, so max() keeps it
+    Entry& entry = shard.entries[user_id];
+    entry.seen = std::max(entry.seen, seen);
+    entry.checked = now();
+}
+
+size_t PresenceTracker::flush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+
+    // Clean entries past reload_after would be re-read on their next lookup
+    // anyway; dropping them keeps the map to recently active users.
+    const Micros stale_before = now() - config_.reload_after.count() * 1000000LL;
+    std::vector<std::pair<std::string, Micros>> pending;
+    size_t evicted = 0;
+    for (size_t i = 0; i < config_.shards; ++i) {
+        Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            Entry& entry = it->second;
+            if (entry.dirty) {
+                entry.dirty = false;
+                pending.emplace_back(it->first, entry.seen);
+            } else if (entry.checked < stale_before) {
+                it = shard.entries.erase(it);
+                evicted++;
+                continue;
+            }
+            ++it;
+        }
+    }
+
+    size_t written = 0;
+    for (size_t begin = 0; begin < pending.size(); begin += config_.max_batch) {
+        const size_t end = std::min(pending.size(), begin + config_.max_batch);
+        std::vector<std::pair<std::string, Micros>> batch(pending.begin() + begin, pending.begin() + end);
+        if (writeBatch(batch)) {
+            written += batch.size();
+            continue;
+        }
+        // Retried with the next flush
+        for (const auto& item : batch) {
+            Shard& shard = shardFor(item.first);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.entries[item.first].dirty = true;
+        }
+    }
+    if (written > 0 || evicted > 0) {
+        XIPHER_LOG_DEBUG("Presence: flushed last activity of " + std::to_string(written) + " users, dropped " +
+                         std::to_string(evicted) + " stale entries");
+    }
+    return written;
+}
+
+bool PresenceTracker::writeBatch(const std::vector<std::pair<std::string, Micros>>& batch) {
+    std::string ids = "{";
+    std::string seen = "{";
+    for (const auto& item : batch) {
+        if (!isUuidText(item.first)) {
+            continue;
+        }
+        if (ids.size() > 1) {
+            ids += ',';
+            seen += ',';
+        }
+        ids += item.first;
+        seen += std::to_string(item.second);
+    }
+    if (ids.size() == 1) {
+        return true;
+    }
+    ids += '}';
+    seen += '}';
+
+    PgParams<2> params;
+    params.add(ids).add(seen);
+    PGresult* res = pool_.executePrepared("flush_last_activity", params);
+    const bool ok = res && PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (res) PQclear(res);
+    if (!ok) {
+        Logger::getInstance().warning("Presence: failed to flush last activity: " + pool_.getLastError());
+    }
+    return ok;
+}
+
+void PresenceTracker::flushLoop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(stop_mutex_);
+            stop_cv_.wait_for(lock, config_.flush_interval, [this]() { return stopping_; });
+            if (stopping_) {
+                return;
+            }
+        }
+        flush();
+    }
+}
+
+PresenceTracker::Micros PresenceTracker::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string PresenceTracker::format(Micros seen) {
+    const std::time_t seconds = static_cast<std::time_t>(seen / 1000000);
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d.%06lld+00",
+                  tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+                  static_cast<long long>(seen % 1000000));
+    return buf;
+}
+
+} // namespace xipher
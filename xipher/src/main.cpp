@@ -39,10 +39,21 @@ int main(int argc, char* argv[]) {
         address = std::string(env_address);
     }
     
+    // io thread count (0 = one per hardware thread)
+    unsigned int io_threads = 0;
+    const char* env_io_threads = std::getenv("XIPHER_IO_THREADS");
+    if (env_io_threads && *env_io_threads) {
+        try {
+            io_threads = static_cast<unsigned int>(std::stoul(env_io_threads));
+        } catch (...) {
+            io_threads = 0;
+        }
+    }
+    
     xipher::Logger::getInstance().info("Server will listen on " + address + ":" + std::to_string(port));
     
     // Create and start server
-    xipher::HttpServer server(address, port);
+    xipher::HttpServer server(address, port, io_threads);
     g_server = &server;
     
     if (!server.start()) {
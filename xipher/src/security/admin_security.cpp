@@ -20,6 +20,7 @@ bool RateLimiter::allow(const std::string& key, std::string& ban_reason) {
     using clock = std::chrono::steady_clock;
     const auto now = clock::now();
 
+    std::lock_guard<std::mutex> lock(mutex_);
     auto& entry = entries_[key];
 
     if (entry.banned_until.time_since_epoch().count() > 0 && now < entry.banned_until) {
@@ -45,6 +46,7 @@ bool RateLimiter::allow(const std::string& key, std::string& ban_reason) {
 }
 
 void RateLimiter::clear(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
     entries_.erase(key);
 }
 
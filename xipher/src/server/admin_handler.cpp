@@ -1,7 +1,7 @@
 #include "../../include/server/admin_handler.hpp"
 #include "../../include/utils/json_parser.hpp"
 #include "../../include/utils/logger.hpp"
-#include "../../include/auth/password_hash.hpp"
+#include "../../include/auth/password_hasher.hpp"
 #include <algorithm>
 #include <cctype>
 #include <iomanip>
@@ -187,17 +187,13 @@ std::string AdminHandler::hashContext(const std::string& input) const {
     return oss.str();
 }
 
-std::string AdminHandler::buildHttpJson(const std::string& body, const std::map<std::string, std::string>& extra_headers) {
-    std::ostringstream oss;
-    oss << "HTTP/1.1 200 OK\r\n";
-    oss << "Content-Type: application/json\r\n";
-    oss << "Cache-Control: no-store\r\n";
+HttpResponse AdminHandler::buildHttpJson(const std::string& body, const std::map<std::string, std::string>& extra_headers) {
+    HttpResponse res = HttpResponse::json(body);
+    res.setHeader("Cache-Control", "no-store");
     for (const auto& kv : extra_headers) {
-        oss << kv.first << ": " << kv.second << "\r\n";
+        res.addHeader(kv.first, kv.second);
     }
-    oss << "Content-Length: " << body.size() << "\r\n\r\n";
-    oss << body;
-    return oss.str();
+    return res;
 }
 
 bool AdminHandler::validateAdminSession(const std::string& token, const std::string& ip, const std::string& user_agent) {
@@ -231,7 +227,7 @@ bool AdminHandler::validateAdminSession(const std::string& token, const std::str
     return true;
 }
 
-std::string AdminHandler::handleLogin(const std::map<std::string, std::string>& headers, const std::string& body) {
+HttpResponse AdminHandler::handleLogin(const std::map<std::string, std::string>& headers, const std::string& body) {
     auto data = JsonParser::parse(body);
     const std::string ip = extractClientIp(headers);
     const std::string* user_agent_header = findHeaderValueCI(headers, "User-Agent");
@@ -273,7 +269,12 @@ std::string AdminHandler::handleLogin(const std::map<std::string, std::string>&
     }
 
     const std::string password = data.count("password") ? data.at("password") : "";
-    if (!PasswordHash::verify(password, user.password_hash)) {
+    bool password_ok = false;
+    if (auth_manager_.passwordHasher().verify(password, user.password_hash, &password_ok) ==
+        PasswordHasher::Status::Busy) {
+        return buildHttpJson(JsonParser::createErrorResponse("Server is busy, please try again later"));
+    }
+    if (!password_ok) {
         return buildHttpJson(JsonParser::createErrorResponse("Invalid credentials"));
     }
 
@@ -314,7 +315,7 @@ std::string AdminHandler::handleLogin(const std::map<std::string, std::string>&
     return buildHttpJson(JsonParser::createSuccessResponse("Admin session issued", response_data), headers_out);
 }
 
-std::string AdminHandler::handleAction(const std::map<std::string, std::string>& headers, const std::string& body) {
+HttpResponse AdminHandler::handleAction(const std::map<std::string, std::string>& headers, const std::string& body) {
     const std::string ip = extractClientIp(headers);
     const std::string* user_agent_header = findHeaderValueCI(headers, "User-Agent");
     const std::string user_agent = user_agent_header ? *user_agent_header : "";
@@ -394,7 +395,12 @@ std::string AdminHandler::handleAction(const std::map<std::string, std::string>&
         }
 
         if (need_messages) {
-            auto messages = db_manager_.searchMessages(query, limit);
+            // Ranked pages: pass messages_cursor back to get the next one
+            const std::string cursor = data.count("messages_cursor") ? data.at("messages_cursor") : "";
+            auto messages = db_manager_.searchMessages(query, limit, cursor);
+            if (static_cast<int>(messages.size()) >= limit) {
+                oss << ",\"messages_cursor\":\"" << JsonParser::escapeJson(messages.back().id) << "\"";
+            }
             oss << ",\"messages\":[";
             bool first = true;
             for (const auto& m : messages) {
@@ -505,7 +511,7 @@ std::string AdminHandler::handleAction(const std::map<std::string, std::string>&
         if (user_id.empty()) {
             return buildHttpJson(JsonParser::createErrorResponse("user_id required"));
         }
-        if (!db_manager_.deleteUserSessionsByUser(user_id)) {
+        if (!auth_manager_.revokeUserSessions(user_id)) {
             return buildHttpJson(JsonParser::createErrorResponse("Failed to revoke sessions"));
         }
         return buildHttpJson(JsonParser::createSuccessResponse("Sessions revoked"));
@@ -733,8 +739,12 @@ std::string AdminHandler::handleAction(const std::map<std::string, std::string>&
     }
 
     if (action == "reset_password") {
-        std::string new_hash = PasswordHash::hash(data["new_password"]);
-        if (new_hash.empty()) {
+        std::string new_hash;
+        const auto hashed = auth_manager_.passwordHasher().hash(data["new_password"], &new_hash);
+        if (hashed == PasswordHasher::Status::Busy) {
+            return buildHttpJson(JsonParser::createErrorResponse("Server is busy, please try again later"));
+        }
+        if (hashed != PasswordHasher::Status::Ok) {
             return buildHttpJson(JsonParser::createErrorResponse("Failed to hash password"));
         }
         if (!db_manager_.updateUserPasswordHash(data["user_id"], new_hash)) {
@@ -768,6 +778,27 @@ std::string AdminHandler::handleAction(const std::map<std::string, std::string>&
         stats["channels"] = std::to_string(db_manager_.countChannels());
         stats["bots"] = std::to_string(db_manager_.countBots());
         stats["reports_pending"] = std::to_string(db_manager_.countReportsByStatus("pending"));
+        const auto caches = db_manager_.entityCacheStats();
+        auto hitRate = [](const LruCacheStats& cache) {
+            return std::to_string(static_cast<int>(cache.hitRate() * 100.0 + 0.5)) + "%";
+        };
+        stats["user_cache_hit_rate"] = hitRate(caches.users);
+        stats["profile_cache_hit_rate"] = hitRate(caches.profiles);
+        stats["privacy_cache_hit_rate"] = hitRate(caches.privacy);
+        stats["public_user_cache_hit_rate"] = hitRate(caches.public_users);
+        stats["user_cache_size"] = std::to_string(caches.users.size);
+        const auto memberships = db_manager_.membershipCacheStats();
+        stats["chat_permission_cache_hit_rate"] = hitRate(memberships.chat_permissions);
+        stats["group_member_cache_hit_rate"] = hitRate(memberships.group_members);
+        stats["channel_member_cache_hit_rate"] = hitRate(memberships.channel_members);
+        const auto sessions = auth_manager_.sessionCacheStats();
+        stats["session_cache_hit_rate"] = hitRate(sessions.sessions);
+        stats["session_cache_size"] = std::to_string(sessions.sessions.size);
+        stats["unknown_token_cache_hits"] = std::to_string(sessions.unknown_tokens.hits);
+        const auto hasher = auth_manager_.passwordHasher().stats();
+        stats["password_hash_queue"] = std::to_string(hasher.queued);
+        stats["password_hash_memory_kib"] = std::to_string(hasher.memory_in_use_kib);
+        stats["password_hash_rejected"] = std::to_string(hasher.rejected);
         return buildHttpJson(JsonParser::createSuccessResponse("stats", stats));
     }
 
@@ -0,0 +1,92 @@
+#include "../include/server/http_response.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace xipher {
+
+namespace {
+
+bool equalsIgnoreCase(const std::string& a, const std::string& b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](unsigned char x, unsigned char y) {
+               return std::tolower(x) == std::tolower(y);
+           });
+}
+
+} // namespace
+
+HttpResponse::HttpResponse() : status_(200), body_(std::string()) {
+}
+
+HttpResponse HttpResponse::json(std::string body, int status) {
+    HttpResponse res;
+    res.status_ = status;
+    res.headers_.emplace_back("Content-Type", "application/json");
+    res.body_ = std::move(body);
+    return res;
+}
+
+HttpResponse HttpResponse::text(int status, const std::string& content_type, std::string body) {
+    HttpResponse res;
+    res.status_ = status;
+    res.headers_.emplace_back("Content-Type", content_type);
+    res.body_ = std::move(body);
+    return res;
+}
+
+HttpResponse HttpResponse::file(std::string path, const std::string& content_type, int status) {
+    HttpResponse res;
+    res.status_ = status;
+    res.headers_.emplace_back("Content-Type", content_type);
+    res.body_ = FileBody{std::move(path)};
+    return res;
+}
+
+HttpResponse HttpResponse::fileRange(std::string path, const std::string& content_type,
+                                     std::uint64_t offset, std::uint64_t length, int status) {
+    HttpResponse res = file(std::move(path), content_type, status);
+    auto& body = std::get<FileBody>(res.body_);
+    body.offset = offset;
+    body.length = length;
+    return res;
+}
+
+HttpResponse HttpResponse::shared(int status, const std::string& content_type,
+                                  std::shared_ptr<const std::string> data) {
+    HttpResponse res;
+    res.status_ = status;
+    res.headers_.emplace_back("Content-Type", content_type);
+    res.body_ = SharedBody{std::move(data)};
+    return res;
+}
+
+HttpResponse HttpResponse::redirect(const std::string& location, int status) {
+    HttpResponse res;
+    res.status_ = status;
+    res.headers_.emplace_back("Location", location);
+    return res;
+}
+
+void HttpResponse::setHeader(const std::string& name, const std::string& value) {
+    headers_.erase(std::remove_if(headers_.begin(), headers_.end(),
+                                  [&name](const std::pair<std::string, std::string>& header) {
+                                      return equalsIgnoreCase(header.first, name);
+                                  }),
+                   headers_.end());
+    headers_.emplace_back(name, value);
+}
+
+void HttpResponse::addHeader(const std::string& name, const std::string& value) {
+    headers_.emplace_back(name, value);
+}
+
+const std::string* HttpResponse::findHeader(const std::string& name) const {
+    for (const auto& header : headers_) {
+        if (equalsIgnoreCase(header.first, name)) {
+            return &header.second;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace xipher
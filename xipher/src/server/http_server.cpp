@@ -1,11 +1,18 @@
 #include "../include/server/http_server.hpp"
+#include "../include/server/http_body_reader.hpp"
+#include "../include/server/file_range_body.hpp"
+#include "../include/server/shared_buffer_body.hpp"
+#include "../include/database/async_pipeline.hpp"
 #include "../include/utils/logger.hpp"
+#include "../include/utils/env.hpp"
 #include "../include/utils/json_parser.hpp"
+#include "../include/utils/json_writer.hpp"
 #include "../include/voip/voip_access_control.hpp"
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
 #include <boost/beast/websocket.hpp>
 #include <sstream>
+#include <csignal>
 #include <algorithm>
 
 namespace {
@@ -13,6 +20,11 @@ constexpr const char* kSessionTokenCookieName = "xipher_token";
 const std::string kSessionTokenPlaceholder = "cookie";
 // Allow ~10 GB uploads after base64 overhead.
 constexpr auto kMaxRequestBodySize = 16ULL * 1024 * 1024 * 1024; // 16 GB
+// Keep-alive defaults (overridable via XIPHER_HTTP_IDLE_TIMEOUT_SEC / XIPHER_HTTP_MAX_REQUESTS).
+constexpr unsigned int kDefaultHttpIdleTimeoutSec = 30;
+constexpr unsigned int kDefaultHttpMaxRequestsPerConnection = 1000;
+constexpr unsigned int kDefaultWsQueueMaxKb = 4096;
+constexpr unsigned int kDefaultWsQueueMaxFrames = 1024;
 
 std::string extractCookieValue(const std::string& cookie_header, const std::string& name) {
     const std::string needle = name + "=";
@@ -31,15 +43,138 @@ std::string extractCookieValue(const std::string& cookie_header, const std::stri
 
 namespace xipher {
 
-HttpServer::HttpServer(const std::string& address, unsigned short port)
-    : address_(address), port_(port), running_(false) {
+namespace {
+
+constexpr unsigned int kRetryAfterSeconds = 1;
+constexpr unsigned int kDefaultWorkerQueueDepth = 1024;
+
+// Route classes with their own concurrency ceiling, so that one slow upstream
+// (CoinGecko, AI proxy, FCM) cannot occupy every worker thread. Which class a
+// request belongs to comes from its RouteInfo in the RequestHandler route table.
+struct RouteClassLimit {
+    const char* route_class;
+    const char* limit_env;
+    unsigned int default_limit;
+};
+
+constexpr RouteClassLimit kRouteClassLimits[] = {
+    {"ai", "XIPHER_ROUTE_LIMIT_AI", 8},
+    {"wallet", "XIPHER_ROUTE_LIMIT_WALLET", 16},
+    {"upload", "XIPHER_ROUTE_LIMIT_UPLOAD", 8},
+    {"auth", "XIPHER_ROUTE_LIMIT_AUTH", 8},
+    {"bot_api", "XIPHER_ROUTE_LIMIT_BOT_API", 32},
+};
+
+bool isSecureRequest(const http::request<http::string_body>& req) {
+    auto it = req.find("X-Forwarded-Proto");
+    if (it != req.end()) {
+        std::string value = std::string(it->value());
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        if (value.find("https") != std::string::npos) return true;
+    }
+    it = req.find("X-Forwarded-Scheme");
+    if (it != req.end()) {
+        std::string value = std::string(it->value());
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        if (value.find("https") != std::string::npos) return true;
+    }
+    it = req.find("X-Forwarded-SSL");
+    if (it != req.end()) {
+        std::string value = std::string(it->value());
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        if (value == "on" || value == "1" || value == "true") return true;
+    }
+    it = req.find("Forwarded");
+    if (it != req.end()) {
+        std::string value = std::string(it->value());
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        if (value.find("proto=https") != std::string::npos) return true;
+    }
+    return false;
+}
+
+void applySecurityHeaders(http::fields& res, bool secure) {
+    const std::string csp =
+        "default-src 'self'; "
+        "base-uri 'self'; "
+        "object-src 'none'; "
+        "frame-ancestors 'none'; "
+        "script-src 'self' 'unsafe-inline' https://cdnjs.cloudflare.com https://unpkg.com https://cdn.jsdelivr.net https://www.gstatic.com; "
+        "style-src 'self' 'unsafe-inline' https://fonts.googleapis.com https://cdnjs.cloudflare.com https://cdn.jsdelivr.net; "
+        "font-src 'self' https://fonts.gstatic.com https://r2cdn.perplexity.ai data:; "
+        "img-src 'self' data: blob:; "
+        "connect-src 'self' wss: ws: https://cdn.jsdelivr.net https://unpkg.com https://fcmregistrations.googleapis.com https://firebaseinstallations.googleapis.com; "
+        "form-action 'self' https://yoomoney.ru https://checkout.stripe.com; "
+        "media-src 'self' blob:; ";
+
+    res.set("Content-Security-Policy", csp);
+    res.set("X-Content-Type-Options", "nosniff");
+    res.set("X-Frame-Options", "DENY");
+    res.set("X-XSS-Protection", "1; mode=block");
+    res.set("Referrer-Policy", "strict-origin-when-cross-origin");
+    res.set("Permissions-Policy", "geolocation=(), microphone=(self), camera=(self), display-capture=(self)");
+    if (secure) {
+        res.set("Strict-Transport-Security", "max-age=31536000; includeSubDomains");
+    }
+}
+
+http::response<http::string_body> buildErrorResponse(http::status status, const std::string& message,
+                                                     bool secure, bool keep_alive) {
+    http::response<http::string_body> res;
+    res.result(status);
+    res.set(http::field::content_type, "application/json");
+    res.set(http::field::access_control_allow_origin, "*");
+    res.body() = JsonParser::createErrorResponse(message);
+    res.keep_alive(keep_alive);
+    res.prepare_payload();
+    applySecurityHeaders(res, secure);
+    return res;
+}
+
+// Copies status and handler headers onto a Beast message; length and
+// connection management stay with the server.
+template <class Body>
+void applyHandlerResponse(const HttpResponse& response, http::response<Body>& res, bool secure, bool keep_alive) {
+    res.result(static_cast<http::status>(response.status()));
+    for (const auto& header : response.headers()) {
+        res.insert(header.first, header.second);
+    }
+    applySecurityHeaders(res, secure);
+    res.keep_alive(keep_alive);
+}
+
+} // namespace
+
+HttpServer::HttpServer(const std::string& address, unsigned short port, unsigned int io_threads)
+    : address_(address), port_(port), io_threads_(io_threads), running_(false),
+      http_idle_timeout_(readEnvSize("XIPHER_HTTP_IDLE_TIMEOUT_SEC", kDefaultHttpIdleTimeoutSec)),
+      http_max_requests_per_connection_(static_cast<unsigned int>(
+          readEnvSize("XIPHER_HTTP_MAX_REQUESTS", kDefaultHttpMaxRequestsPerConnection))) {
+    if (http_max_requests_per_connection_ == 0) {
+        http_max_requests_per_connection_ = 1;
+    }
+    if (io_threads_ == 0) {
+        io_threads_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+    ws_limits_.max_queued_bytes = readEnvSize("XIPHER_WS_QUEUE_MAX_KB", kDefaultWsQueueMaxKb) * 1024;
+    ws_limits_.max_queued_frames = std::max<size_t>(1, readEnvSize("XIPHER_WS_QUEUE_MAX_FRAMES", kDefaultWsQueueMaxFrames));
+    const char* ws_policy = std::getenv("XIPHER_WS_SLOW_CONSUMER");
+    if (ws_policy && std::string(ws_policy) == "drop") {
+        ws_limits_.policy = WebSocketSession::SlowConsumerPolicy::Drop;
+    }
 }
 
 HttpServer::~HttpServer() {
     stop();
+    for (auto& worker : io_workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
 }
 
 bool HttpServer::start() {
+    started_at_ = std::chrono::steady_clock::now();
     try {
         // Initialize database (use env overrides, fallback to sane defaults)
         const char* env_host = std::getenv("XIPHER_DB_HOST");
@@ -85,17 +220,59 @@ bool HttpServer::start() {
             this->sendToUser(user_id, message);
         });
         
+        // Blocking handlers (libpq, curl, Argon2) run here instead of on io threads
+        size_t worker_threads = readEnvSize("XIPHER_WORKER_THREADS", 0);
+        if (worker_threads == 0) {
+            worker_threads = std::max(4u, 2 * std::max(1u, std::thread::hardware_concurrency()));
+        }
+        worker_pool_ = std::make_unique<WorkerPool>(
+            worker_threads, readEnvSize("XIPHER_WORKER_QUEUE_MAX", kDefaultWorkerQueueDepth));
+        for (const auto& rule : kRouteClassLimits) {
+            worker_pool_->setRouteLimit(rule.route_class, readEnvSize(rule.limit_env, rule.default_limit));
+        }
+        worker_pool_->start();
+        
+        // SIGHUP reloads the static asset cache without a restart
+        reload_signals_ = std::make_unique<net::signal_set>(ioc_, SIGHUP);
+        waitForReloadSignal();
+        
         // Create acceptor
         tcp::endpoint endpoint(net::ip::make_address(address_), port_);
         acceptor_ = std::make_unique<tcp::acceptor>(ioc_, endpoint);
         
         running_ = true;
-        Logger::getInstance().info("HTTP Server started on " + address_ + ":" + std::to_string(port_));
+        Logger::getInstance().info("HTTP Server started on " + address_ + ":" + std::to_string(port_) +
+                                   " with " + std::to_string(io_threads_) + " io threads in " +
+                                   std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                       std::chrono::steady_clock::now() - started_at_).count()) + " ms");
         
         acceptConnections();
         
-        // Run IO context
-        ioc_.run();
+        // Run IO context on a pool of threads; the calling thread is the last member.
+        auto runLoop = [this]() {
+            for (;;) {
+                try {
+                    ioc_.run();
+                    return;
+                } catch (const std::exception& e) {
+                    Logger::getInstance().error("Unhandled exception in io thread: " + std::string(e.what()));
+                } catch (...) {
+                    Logger::getInstance().error("Unhandled unknown exception in io thread");
+                }
+            }
+        };
+        io_workers_.reserve(io_threads_ - 1);
+        for (unsigned int i = 1; i < io_threads_; ++i) {
+            io_workers_.emplace_back(runLoop);
+        }
+        runLoop();
+        
+        for (auto& worker : io_workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        io_workers_.clear();
         
         return true;
     } catch (const std::exception& e) {
@@ -105,18 +282,39 @@ bool HttpServer::start() {
 }
 
 void HttpServer::stop() {
-    if (running_) {
-        running_ = false;
+    if (running_.exchange(false)) {
         bot_scheduler_.stop();
         ioc_.stop();
+        if (worker_pool_) {
+            worker_pool_->stop();
+        }
         Logger::getInstance().info("HTTP Server stopped");
     }
 }
 
+void HttpServer::waitForReloadSignal() {
+    reload_signals_->async_wait([this](beast::error_code ec, int) {
+        if (ec) {
+            return;
+        }
+        Logger::getInstance().info("SIGHUP received, reloading static assets");
+        // Re-reading and compressing files blocks, keep it off the io threads
+        auto submitted = worker_pool_->submit("default", [this]() {
+            request_handler_->reloadStaticAssets();
+        });
+        if (submitted != WorkerPool::SubmitResult::Accepted) {
+            Logger::getInstance().warning("Static asset reload skipped: worker pool is busy");
+        }
+        waitForReloadSignal();
+    });
+}
+
 void HttpServer::acceptConnections() {
     if (!running_) return;
     
-    auto socket = std::make_shared<tcp::socket>(ioc_);
+    // Each connection gets its own strand: handlers of one socket never run
+    // concurrently, while different sockets are spread across io threads.
+    auto socket = std::make_shared<tcp::socket>(net::make_strand(ioc_));
     
     acceptor_->async_accept(*socket,
         [this, socket](beast::error_code ec) {
@@ -130,123 +328,84 @@ void HttpServer::acceptConnections() {
 }
 
 void HttpServer::handleConnection(std::shared_ptr<tcp::socket> socket) {
-    auto buffer = std::make_shared<beast::flat_buffer>();
-    auto parser = std::make_shared<http::request_parser<http::string_body>>();
-    parser->body_limit(kMaxRequestBodySize);
-
-    http::async_read(*socket, *buffer, *parser,
-        [this, socket, buffer, parser](beast::error_code ec, std::size_t) {
-            if (!ec) {
-                try {
-                    processRequest(socket, parser->release());
-                } catch (const std::exception& e) {
-                    Logger::getInstance().error("Unhandled exception in handleConnection: " + std::string(e.what()));
-                } catch (...) {
-                    Logger::getInstance().error("Unhandled unknown exception in handleConnection");
-                }
-                return;
-            }
-            if (ec == http::error::body_limit) {
-                Logger::getInstance().warning("Request body too large");
-                http::response<http::string_body> res;
-                res.result(http::status::payload_too_large);
-                res.set(http::field::content_type, "application/json");
-                res.set(http::field::access_control_allow_origin, "*");
-                res.body() = JsonParser::createErrorResponse("Request body too large");
-                res.prepare_payload();
-                sendResponse(socket, res);
-                return;
-            }
-            Logger::getInstance().error("Read error: " + ec.message());
-        });
+    auto conn = std::make_shared<HttpConnection>(std::move(*socket));
+    readRequest(conn);
 }
 
-void HttpServer::readRequest(std::shared_ptr<tcp::socket> socket,
-                            std::shared_ptr<beast::flat_buffer> buffer) {
+void HttpServer::readRequest(std::shared_ptr<HttpConnection> conn) {
     auto parser = std::make_shared<http::request_parser<http::string_body>>();
     parser->body_limit(kMaxRequestBodySize);
 
-    http::async_read(*socket, *buffer, *parser,
-        [this, socket, buffer, parser](beast::error_code ec, std::size_t) {
-            if (!ec) {
-                try {
-                    processRequest(socket, parser->release());
-                } catch (const std::exception& e) {
-                    Logger::getInstance().error("Unhandled exception in readRequest: " + std::string(e.what()));
-                } catch (...) {
-                    Logger::getInstance().error("Unhandled unknown exception in readRequest");
-                }
+    // Idle timeout for the wait on the next keep-alive request and its header;
+    // the body read re-arms it per chunk (asyncReadBody).
+    conn->stream.expires_after(http_idle_timeout_);
+
+    // Read the header first: the route decides how large a body we accept.
+    http::async_read_header(conn->stream, conn->buffer, *parser,
+        [this, conn, parser](beast::error_code ec, std::size_t) {
+            if (ec) {
+                handleReadError(conn, ec);
                 return;
             }
-            if (ec == http::error::body_limit) {
-                Logger::getInstance().warning("Request body too large");
-                http::response<http::string_body> res;
-                res.result(http::status::payload_too_large);
-                res.set(http::field::content_type, "application/json");
-                res.set(http::field::access_control_allow_origin, "*");
-                res.body() = JsonParser::createErrorResponse("Request body too large");
-                res.prepare_payload();
-                sendResponse(socket, res);
-                return;
+            RouteInfo info;
+            try {
+                const auto& header = parser->get();
+                info = request_handler_->routeInfo(std::string(to_string(header.method())),
+                                                   std::string(header.target()));
+            } catch (const std::exception& e) {
+                Logger::getInstance().error("Route lookup failed: " + std::string(e.what()));
             }
-            Logger::getInstance().error("Read error: " + ec.message());
+            parser->body_limit(info.body_limit ? info.body_limit : kMaxRequestBodySize);
+
+            asyncReadBody(conn->stream, conn->buffer, *parser, http_idle_timeout_,
+                [this, conn, parser, info](beast::error_code ec) {
+                    if (ec) {
+                        handleReadError(conn, ec);
+                        return;
+                    }
+                    try {
+                        processRequest(conn, parser->release(), info);
+                    } catch (const std::exception& e) {
+                        Logger::getInstance().error("Unhandled exception in readRequest: " + std::string(e.what()));
+                        closeConnection(conn);
+                    } catch (...) {
+                        Logger::getInstance().error("Unhandled unknown exception in readRequest");
+                        closeConnection(conn);
+                    }
+                });
         });
 }
 
-void HttpServer::processRequest(std::shared_ptr<tcp::socket> socket,
-                               http::request<http::string_body> req) {
-    auto isSecureRequest = [&req]() -> bool {
-        auto it = req.find("X-Forwarded-Proto");
-        if (it != req.end()) {
-            std::string value = std::string(it->value());
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if (value.find("https") != std::string::npos) return true;
-        }
-        it = req.find("X-Forwarded-Scheme");
-        if (it != req.end()) {
-            std::string value = std::string(it->value());
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if (value.find("https") != std::string::npos) return true;
-        }
-        it = req.find("X-Forwarded-SSL");
-        if (it != req.end()) {
-            std::string value = std::string(it->value());
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if (value == "on" || value == "1" || value == "true") return true;
-        }
-        it = req.find("Forwarded");
-        if (it != req.end()) {
-            std::string value = std::string(it->value());
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if (value.find("proto=https") != std::string::npos) return true;
-        }
-        return false;
-    };
-
-    auto applySecurityHeaders = [&](http::response<http::string_body>& res) {
-        const std::string csp =
-            "default-src 'self'; "
-            "base-uri 'self'; "
-            "object-src 'none'; "
-            "frame-ancestors 'none'; "
-            "script-src 'self' 'unsafe-inline' https://cdnjs.cloudflare.com https://unpkg.com https://cdn.jsdelivr.net https://www.gstatic.com; "
-            "style-src 'self' 'unsafe-inline' https://fonts.googleapis.com https://cdnjs.cloudflare.com https://cdn.jsdelivr.net; "
-            "font-src 'self' https://fonts.gstatic.com https://r2cdn.perplexity.ai data:; "
-            "img-src 'self' data: blob:; "
-            "connect-src 'self' wss: ws: https://cdn.jsdelivr.net https://unpkg.com https://fcmregistrations.googleapis.com https://firebaseinstallations.googleapis.com; "
-            "form-action 'self' https://yoomoney.ru https://checkout.stripe.com; "
-            "media-src 'self' blob:; ";
-
-        res.set("Content-Security-Policy", csp);
-        res.set("X-Content-Type-Options", "nosniff");
-        res.set("X-Frame-Options", "DENY");
-        res.set("X-XSS-Protection", "1; mode=block");
-        res.set("Referrer-Policy", "strict-origin-when-cross-origin");
-        res.set("Permissions-Policy", "geolocation=(), microphone=(self), camera=(self), display-capture=(self)");
-        if (isSecureRequest()) {
-            res.set("Strict-Transport-Security", "max-age=31536000; includeSubDomains");
-        }
-    };
+void HttpServer::handleReadError(std::shared_ptr<HttpConnection> conn, beast::error_code ec) {
+    if (ec == http::error::end_of_stream || ec == beast::error::timeout) {
+        // Client finished with the connection or left it idle for too long.
+        closeConnection(conn);
+        return;
+    }
+    if (ec == http::error::body_limit) {
+        Logger::getInstance().warning("Request body too large");
+        http::response<http::string_body> res;
+        res.result(http::status::payload_too_large);
+        res.set(http::field::content_type, "application/json");
+        res.set(http::field::access_control_allow_origin, "*");
+        res.body() = JsonParser::createErrorResponse("Request body too large");
+        res.keep_alive(false);
+        res.prepare_payload();
+        sendResponse(conn, std::move(res));
+        return;
+    }
+    Logger::getInstance().error("Read error: " + ec.message());
+    closeConnection(conn);
+}
+
+void HttpServer::processRequest(std::shared_ptr<HttpConnection> conn,
+                               http::request<http::string_body> req,
+                               const RouteInfo& info) {
+    // Persistent connection unless the client opted out or the per-connection cap is reached.
+    conn->requests_served++;
+    const bool keep_alive = req.keep_alive() &&
+                            conn->requests_served < http_max_requests_per_connection_;
+    const bool secure = isSecureRequest(req);
 
     try {
     // Check for WebSocket upgrade request
@@ -269,14 +428,14 @@ void HttpServer::processRequest(std::shared_ptr<tcp::socket> socket,
         
         if (is_websocket) {
             // Handle WebSocket upgrade
-            handleWebSocketUpgrade(socket, req);
+            handleWebSocketUpgrade(conn, req);
             return;
         }
     }
     
     std::string client_ip;
     try {
-        client_ip = socket->remote_endpoint().address().to_string();
+        client_ip = conn->stream.socket().remote_endpoint().address().to_string();
     } catch (...) {
         client_ip = "";
     }
@@ -292,139 +451,145 @@ void HttpServer::processRequest(std::shared_ptr<tcp::socket> socket,
     
     // Convert method to string
     std::string method = std::string(to_string(req.method()));
-    std::string body = req.body();
-    
-    // Handle request
-    std::string response_str = request_handler_->handleRequest(method, path, headers, body);
-    
-    // Parse response
-    http::response<http::string_body> res;
-    
-    // Check if response is already a full HTTP response (for static files)
-    if (response_str.find("HTTP/1.1") == 0) {
-        // Parse the HTTP response string
-        std::istringstream response_stream(response_str);
-        std::string line;
-        
-        // Read status line (e.g. "HTTP/1.1 404 Not Found")
-        std::getline(response_stream, line);
-        int status_code = 200;
-        try {
-            std::istringstream status_stream(line);
-            std::string http_version;
-            status_stream >> http_version >> status_code;
-            if (!status_stream || status_code < 100 || status_code > 599) {
-                status_code = 200;
-            }
-        } catch (...) {
-            status_code = 200;
-        }
-        
-        // Read headers
-        std::map<std::string, std::string> response_headers;
-        while (std::getline(response_stream, line) && line != "\r" && !line.empty()) {
-            size_t colon_pos = line.find(':');
-            if (colon_pos != std::string::npos) {
-                std::string key = line.substr(0, colon_pos);
-                std::string value = line.substr(colon_pos + 1);
-                // Trim whitespace
-                value.erase(0, value.find_first_not_of(" \t\r\n"));
-                value.erase(value.find_last_not_of(" \t\r\n") + 1);
-                response_headers[key] = value;
-            }
-        }
-        
-        // Read body
-        std::ostringstream body_stream;
-        body_stream << response_stream.rdbuf();
-        std::string response_body = body_stream.str();
-        
-        // Build Beast response (preserve status code from status line)
-        res.result(static_cast<http::status>(status_code));
-        for (const auto& header : response_headers) {
-            if (header.first == "Content-Type") {
-                res.set(http::field::content_type, header.second);
-            } else if (header.first == "Content-Length") {
-                // Will be set by prepare_payload
-            } else if (header.first == "Location") {
-                res.set(http::field::location, header.second);
-            } else if (header.first == "Cache-Control") {
-                res.set(http::field::cache_control, header.second);
-            } else if (header.first == "Access-Control-Allow-Origin") {
-                res.set(http::field::access_control_allow_origin, header.second);
-            } else {
-                // Set custom headers
-                res.set(header.first, header.second);
-            }
-        }
-        
-        applySecurityHeaders(res);
-        
-        res.body() = response_body;
-        res.prepare_payload();
-        
-        sendResponse(socket, res);
+
+    // Cached static pages and other non-blocking routes are answered inline on the io thread.
+    if (!info.blocking) {
+        deliverResponse(conn, request_handler_->handleRequest(method, path, headers, req.body()), secure, keep_alive);
         return;
     }
     
-    // It's a JSON response, wrap it in HTTP
-    res.result(http::status::ok);
-    res.set(http::field::content_type, "application/json");
-    
-    // Security headers (OWASP 2025 best practices)
-    res.set(http::field::access_control_allow_origin, "*");
-    applySecurityHeaders(res);
-    
-    res.body() = response_str;
-    res.prepare_payload();
+    // Handlers may block (libpq, curl, Argon2): run them on the worker pool and
+    // hop back onto the connection's strand only to write the response.
+    auto submitted = worker_pool_->submit(info.route_class,
+        [this, conn, method, path, headers = std::move(headers), body = std::move(req.body()), secure, keep_alive]() {
+            try {
+                deliverResponse(conn, request_handler_->handleRequest(method, path, headers, body), secure, keep_alive);
+                return;
+            } catch (const std::exception& e) {
+                Logger::getInstance().error("Unhandled exception in request handler: " + std::string(e.what()));
+            } catch (...) {
+                Logger::getInstance().error("Unhandled unknown exception in request handler");
+            }
+            auto res = std::make_shared<http::response<http::string_body>>(
+                buildErrorResponse(http::status::internal_server_error, "Internal server error", secure, false));
+            net::post(conn->stream.get_executor(), [this, conn, res]() {
+                sendResponse(conn, std::move(*res));
+            });
+        });
     
-    sendResponse(socket, res);
+    if (submitted != WorkerPool::SubmitResult::Accepted) {
+        Logger::getInstance().warning("Rejecting " + path + " (" + info.route_class + "): " +
+                                      (submitted == WorkerPool::SubmitResult::RouteLimited ? "route limit reached" : "worker queue full"));
+        auto res = buildErrorResponse(http::status::service_unavailable, "Server busy, retry later", secure, keep_alive);
+        res.set(http::field::retry_after, std::to_string(kRetryAfterSeconds));
+        sendResponse(conn, std::move(res));
+    }
     } catch (const std::exception& e) {
         Logger::getInstance().error("Unhandled exception in processRequest: " + std::string(e.what()));
-        http::response<http::string_body> res;
-        res.result(http::status::internal_server_error);
-        res.set(http::field::content_type, "application/json");
-        res.set(http::field::access_control_allow_origin, "*");
-        res.body() = JsonParser::createErrorResponse("Internal server error");
-        res.prepare_payload();
-        applySecurityHeaders(res);
-        sendResponse(socket, res);
+        sendResponse(conn, buildErrorResponse(http::status::internal_server_error, "Internal server error", secure, false));
     } catch (...) {
         Logger::getInstance().error("Unhandled unknown exception in processRequest");
-        http::response<http::string_body> res;
-        res.result(http::status::internal_server_error);
-        res.set(http::field::content_type, "application/json");
-        res.set(http::field::access_control_allow_origin, "*");
-        res.body() = JsonParser::createErrorResponse("Internal server error");
-        res.prepare_payload();
-        applySecurityHeaders(res);
-        sendResponse(socket, res);
+        sendResponse(conn, buildErrorResponse(http::status::internal_server_error, "Internal server error", secure, false));
+    }
+}
+
+void HttpServer::deliverResponse(std::shared_ptr<HttpConnection> conn, HttpResponse response,
+                                 bool secure, bool keep_alive) {
+    // Runs on a worker thread: build the Beast message here (opening files
+    // may block) and hop onto the connection's strand only for the write.
+    auto executor = conn->stream.get_executor();
+    if (!first_response_logged_.exchange(true)) {
+        // Time to first request: startup plus the first handler, including
+        // the statements it prepared on first use
+        Logger::getInstance().info("First response ready " +
+                                   std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                       std::chrono::steady_clock::now() - started_at_).count()) +
+                                   " ms after start");
     }
+
+    if (auto* text = std::get_if<std::string>(&response.body())) {
+        auto res = std::make_shared<http::response<http::string_body>>();
+        applyHandlerResponse(response, *res, secure, keep_alive);
+        res->body() = std::move(*text);
+        res->prepare_payload();
+        net::post(executor, [this, conn, res]() {
+            sendResponse(conn, std::move(*res));
+        });
+        return;
+    }
+
+    if (auto* file = std::get_if<HttpResponse::FileBody>(&response.body())) {
+        FileRangeBody::value_type body;
+        beast::error_code ec;
+        body.open(file->path.c_str(), file->offset, file->length, ec);
+        if (ec) {
+            Logger::getInstance().warning("Failed to open " + file->path + ": " + ec.message());
+            auto res = std::make_shared<http::response<http::string_body>>(
+                buildErrorResponse(http::status::not_found, "File not found", secure, keep_alive));
+            net::post(executor, [this, conn, res]() {
+                sendResponse(conn, std::move(*res));
+            });
+            return;
+        }
+        auto res = std::make_shared<http::response<FileRangeBody>>();
+        applyHandlerResponse(response, *res, secure, keep_alive);
+        res->body() = std::move(body);
+        res->prepare_payload();
+        net::post(executor, [this, conn, res]() {
+            sendResponse(conn, std::move(*res));
+        });
+        return;
+    }
+
+    auto& shared = std::get<HttpResponse::SharedBody>(response.body());
+    auto res = std::make_shared<http::response<SharedBufferBody>>();
+    applyHandlerResponse(response, *res, secure, keep_alive);
+    res->body() = std::move(shared.data);
+    res->prepare_payload();
+    net::post(executor, [this, conn, res]() {
+        sendResponse(conn, std::move(*res));
+    });
 }
 
-void HttpServer::sendResponse(std::shared_ptr<tcp::socket> socket,
-                              http::response<http::string_body> res) {
-    auto sp = std::make_shared<http::response<http::string_body>>(std::move(res));
+template <class Body>
+void HttpServer::sendResponse(std::shared_ptr<HttpConnection> conn,
+                              http::response<Body> res) {
+    auto sp = std::make_shared<http::response<Body>>(std::move(res));
     
-    http::async_write(*socket, *sp,
-        [this, socket, sp](beast::error_code ec, std::size_t) {
+    // Large downloads may legitimately take longer than the idle timeout.
+    conn->stream.expires_never();
+    http::async_write(conn->stream, *sp,
+        [this, conn, sp](beast::error_code ec, std::size_t) {
             if (ec) {
                 Logger::getInstance().error("Write error: " + ec.message());
+                closeConnection(conn);
+                return;
+            }
+            if (sp->need_eof()) {
+                closeConnection(conn);
+                return;
             }
-            socket->shutdown(tcp::socket::shutdown_send, ec);
+            // Responses are written one at a time, so pipelined requests are answered in order.
+            readRequest(conn);
         });
 }
 
-void HttpServer::handleWebSocketUpgrade(std::shared_ptr<tcp::socket> socket,
+void HttpServer::closeConnection(std::shared_ptr<HttpConnection> conn) {
+    beast::error_code ec;
+    conn->stream.socket().shutdown(tcp::socket::shutdown_send, ec);
+}
+
+void HttpServer::handleWebSocketUpgrade(std::shared_ptr<HttpConnection> conn,
                                         http::request<http::string_body> req) {
-    // Создаем WebSocket stream из сокета
-    auto ws = std::make_shared<websocket::stream<beast::tcp_stream>>(beast::tcp_stream(std::move(*socket)));
+    // Создаем WebSocket stream из сокета (websocket управляет таймаутами сам)
+    conn->stream.expires_never();
+    auto ws = std::make_shared<WebSocketSession>(std::move(conn->stream), ws_limits_);
     
     // Устанавливаем таймауты
-    ws->set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+    ws->stream().set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
     
     // Принимаем WebSocket handshake
-    ws->async_accept(req,
+    ws->stream().async_accept(req,
         [this, ws, req](beast::error_code ec) {
             if (ec) {
                 Logger::getInstance().error("WebSocket accept error: " + ec.message());
@@ -439,44 +604,45 @@ void HttpServer::handleWebSocketUpgrade(std::shared_ptr<tcp::socket> socket,
                 cookie_header = std::string(cookie_it->value());
             }
             std::string token = extractCookieValue(cookie_header, kSessionTokenCookieName);
-            if (!token.empty() && token != kSessionTokenPlaceholder) {
+            if (token.empty() || token == kSessionTokenPlaceholder) {
+                // Начинаем чтение сообщений
+                doReadWebSocket(ws);
+                return;
+            }
+            
+            // Проверка токена может пойти в БД — на worker pool, не на io-потоке.
+            // Чтение начинаем после регистрации, чтобы первые сообщения уже видели user_id.
+            auto submitted = worker_pool_->submit("ws", [this, ws, token]() {
                 std::string user_id = auth_manager_->getUserIdFromToken(token);
                 if (!user_id.empty()) {
                     registerWebSocketConnection(user_id, ws);
                 }
+                net::post(ws->stream().get_executor(), [this, ws]() {
+                    doReadWebSocket(ws);
+                });
+            });
+            if (submitted != WorkerPool::SubmitResult::Accepted) {
+                // Клиент может авторизоваться сообщением "auth"
+                Logger::getInstance().warning("Skipping WebSocket cookie auth: worker pool is busy");
+                doReadWebSocket(ws);
             }
-            
-            // Начинаем чтение сообщений
-            doReadWebSocket(ws);
         });
 }
 
-void HttpServer::doReadWebSocket(std::shared_ptr<websocket::stream<beast::tcp_stream>> ws) {
+void HttpServer::doReadWebSocket(std::shared_ptr<WebSocketSession> ws) {
     auto buffer = std::make_shared<beast::flat_buffer>();
     
-    ws->async_read(*buffer,
+    ws->stream().async_read(*buffer,
         [this, ws, buffer](beast::error_code ec, std::size_t) {
-            if (ec == websocket::error::closed) {
-                Logger::getInstance().info("WebSocket connection closed");
-                const std::string user_id = getWebSocketUserId(ws);
-                if (!user_id.empty()) {
-                    unregisterWebSocketConnection(user_id);
+            if (ec) {
+                if (ec == websocket::error::closed) {
+                    Logger::getInstance().info("WebSocket connection closed");
                 } else {
-                    std::lock_guard<std::mutex> lock(ws_connections_mutex_);
-                    for (auto it = ws_connections_.begin(); it != ws_connections_.end();) {
-                        if (it->second.lock() == ws) {
-                            ws_connections_.erase(it++);
-                        } else {
-                            ++it;
-                        }
-                    }
-                    std::lock_guard<std::mutex> lock_users(ws_user_ids_mutex_);
-                    ws_user_ids_.erase(ws.get());
+                    Logger::getInstance().error("WebSocket read error: " + ec.message());
                 }
-                return;
-            }
-            if (ec) {
-                Logger::getInstance().error("WebSocket read error: " + ec.message());
+                // Any read error ends the session (including a slow consumer we
+                // disconnected), so it must leave the registry either way.
+                unregisterWebSocketConnection(ws);
                 return;
             }
             
@@ -484,27 +650,42 @@ void HttpServer::doReadWebSocket(std::shared_ptr<websocket::stream<beast::tcp_st
             std::string message(static_cast<const char*>(buffer->data().data()), buffer->data().size());
             buffer->consume(buffer->size());
             
-            Logger::getInstance().info("WebSocket message received: " + message);
+            // Любой кадр от авторизованного сокета — активность (в памяти, без записи в БД)
+            if (db_manager_) {
+                const std::string user_id = ws->userId();
+                if (!user_id.empty()) {
+                    db_manager_->updateLastActivity(user_id);
+                }
+            }
             
-            // Обрабатываем сообщение
-            handleWebSocketMessage(ws, message);
+            XIPHER_LOG_DEBUG("WebSocket message received: " + message);
             
-            // Продолжаем чтение
-            doReadWebSocket(ws);
+            // Обрабатываем сообщение на worker pool; следующее чтение начинаем только
+            // после обработки, чтобы сообщения одного сокета шли по порядку.
+            auto submitted = worker_pool_->submit("ws", [this, ws, message]() {
+                handleWebSocketMessage(ws, message);
+                net::post(ws->stream().get_executor(), [this, ws]() {
+                    doReadWebSocket(ws);
+                });
+            });
+            if (submitted != WorkerPool::SubmitResult::Accepted) {
+                Logger::getInstance().warning("Rejecting WebSocket message: worker pool is busy");
+                ws->send("{\"type\":\"error\",\"error\":\"Server busy, retry later\"}");
+                doReadWebSocket(ws);
+            }
         });
 }
 
-void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast::tcp_stream>> ws,
+void HttpServer::handleWebSocketMessage(std::shared_ptr<WebSocketSession> ws,
                                         const std::string& message) {
     try {
-        Logger::getInstance().info("========== WebSocket message received ==========");
-        Logger::getInstance().info("Raw message: " + message);
+        XIPHER_LOG_DEBUG("Raw WebSocket message: " + message);
         
         // Парсим JSON
         auto data = JsonParser::parse(message);
         std::string type = data["type"];
         
-        Logger::getInstance().info("Message type: " + type);
+        XIPHER_LOG_DEBUG("Message type: " + type);
         
         if (type == "auth") {
             std::string token = data["token"];
@@ -529,18 +710,16 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
 
                 // Регистрируем соединение
                 registerWebSocketConnection(user_id, ws);
+                // Web client splits concatenated JSON objects, so it can take coalesced frames
+                if (data.count("coalesce") && data["coalesce"] == "true") {
+                    ws->setCoalescing(true);
+                }
                 
                 std::string response = "{\"type\":\"auth_success\",\"user_id\":\"" + user_id + "\"}";
-                ws->async_write(net::buffer(response),
-                    [](beast::error_code ec, std::size_t) {
-                        if (ec) {
-                            Logger::getInstance().error("WebSocket write error: " + ec.message());
-                        }
-                    });
+                ws->send(std::move(response));
             } else {
                 std::string response = "{\"type\":\"auth_error\",\"error\":\"Invalid token\"}";
-                ws->async_write(net::buffer(response),
-                    [](beast::error_code, std::size_t) {});
+                ws->send(std::move(response));
             }
         } else if (type == "call_init" || type == "call_offer" || type == "call_answer" || type == "call_ice_candidate" || type == "call_end") {
             // Обрабатываем звонки через WebSocket
@@ -557,8 +736,7 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
             
             if (user_id.empty()) {
                 std::string error_response = "{\"type\":\"call_error\",\"error_code\":1002,\"error_message\":\"Not authenticated\"}";
-                ws->async_write(net::buffer(error_response),
-                    [](beast::error_code, std::size_t) {});
+                ws->send(std::move(error_response));
                 return;
             }
             
@@ -566,8 +744,7 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
             // Check if user has access to VoIP features (Loyalty Beta)
             if (voip_access_control_ && !voip_access_control_->checkUserAccess(user_id, *db_manager_)) {
                 std::string error_response = "{\"type\":\"call_error\",\"error_code\":1001,\"error_message\":\"VoIP feature is currently in Loyalty Beta. This feature is not available for your account.\"}";
-                ws->async_write(net::buffer(error_response),
-                    [](beast::error_code, std::size_t) {});
+                ws->send(std::move(error_response));
                 Logger::getInstance().info("VoIP access DENIED for user: " + user_id);
                 return;
             }
@@ -576,10 +753,10 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
             std::string target_user_id;
             if (data.count("target_user_id")) {
                 target_user_id = data["target_user_id"];
-                Logger::getInstance().info("Found target_user_id in message: " + target_user_id);
+                XIPHER_LOG_DEBUG("Found target_user_id in message: " + target_user_id);
             } else if (data.count("receiver_id")) {
                 target_user_id = data["receiver_id"];
-                Logger::getInstance().info("Found receiver_id in message: " + target_user_id);
+                XIPHER_LOG_DEBUG("Found receiver_id in message: " + target_user_id);
             } else {
                 Logger::getInstance().warning("No target_user_id or receiver_id in " + type + " message");
                 Logger::getInstance().warning("Message keys: " + [&data]() {
@@ -591,8 +768,8 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
                 }());
             }
             
-            Logger::getInstance().info("Target user ID: " + target_user_id);
-            Logger::getInstance().info("From user ID: " + user_id);
+            XIPHER_LOG_DEBUG("Target user ID: " + target_user_id);
+            XIPHER_LOG_DEBUG("From user ID: " + user_id);
             
             if (!target_user_id.empty()) {
                 // Получаем имя пользователя из базы данных
@@ -624,30 +801,29 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
                 };
 
                 auto buildCallMessage = [&](const std::string& payload_type, std::string& out_decoded) {
-                    std::string result = "{\"type\":\"" + payload_type + "\"";
-                    result += ",\"token\":\"" + JsonParser::escapeJson(token) + "\"";
-                    result += ",\"target_user_id\":\"" + JsonParser::escapeJson(target_user_id) + "\"";
-                    result += ",\"receiver_id\":\"" + JsonParser::escapeJson(target_user_id) + "\"";
-                    result += ",\"from_user_id\":\"" + JsonParser::escapeJson(user_id) + "\"";
-                    result += ",\"from_username\":\"" + JsonParser::escapeJson(from_username) + "\"";
-                    result += ",\"call_type\":\"" + JsonParser::escapeJson(call_type) + "\"";
+                    JsonWriter out(256);
+                    out.beginObject()
+                        .field("type", payload_type)
+                        .field("token", token)
+                        .field("target_user_id", target_user_id)
+                        .field("receiver_id", target_user_id)
+                        .field("from_user_id", user_id)
+                        .field("from_username", from_username)
+                        .field("call_type", call_type);
 
                     if (payload_type == "call_offer" && data.count("offer")) {
-                        std::string decoded = decodePayload(data.at("offer"), "offer_encoding");
-                        out_decoded = decoded;
-                        result += ",\"offer\":\"" + JsonParser::escapeJson(decoded) + "\"";
+                        out_decoded = decodePayload(data.at("offer"), "offer_encoding");
+                        out.field("offer", out_decoded);
                     } else if (payload_type == "call_answer" && data.count("answer")) {
-                        std::string decoded = decodePayload(data.at("answer"), "answer_encoding");
-                        out_decoded = decoded;
-                        result += ",\"answer\":\"" + JsonParser::escapeJson(decoded) + "\"";
+                        out_decoded = decodePayload(data.at("answer"), "answer_encoding");
+                        out.field("answer", out_decoded);
                     } else if (payload_type == "call_ice_candidate" && data.count("candidate")) {
-                        std::string decoded = decodePayload(data.at("candidate"), "candidate_encoding");
-                        out_decoded = decoded;
-                        result += ",\"candidate\":\"" + JsonParser::escapeJson(decoded) + "\"";
+                        out_decoded = decodePayload(data.at("candidate"), "candidate_encoding");
+                        out.field("candidate", out_decoded);
                     }
 
-                    result += "}";
-                    return result;
+                    out.endObject();
+                    return out.take();
                 };
 
                 std::string decoded_payload;
@@ -666,13 +842,12 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
                 }
 
                 Logger::getInstance().info("Forwarding " + type + " from user " + user_id + " to user " + target_user_id);
-                Logger::getInstance().info("Forwarded JSON: " + forwarded_json);
+                XIPHER_LOG_DEBUG("Forwarded JSON: " + forwarded_json);
                 sendToUser(target_user_id, forwarded_json);
                 
                 // Отправляем подтверждение отправителю
                 std::string response = "{\"success\":true,\"type\":\"" + type + "_sent\"}";
-                ws->async_write(net::buffer(response),
-                    [](beast::error_code, std::size_t) {});
+                ws->send(std::move(response));
             } else {
                 // Если нет target_user_id, просто логируем ошибку
                 Logger::getInstance().warning("No target_user_id in " + type + " message from user " + user_id);
@@ -708,24 +883,32 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
                 // Одиночный звонок - пересылаем собеседнику
                 std::string target_user_id = data.count("target_user_id") ? data["target_user_id"] : "";
                 if (!target_user_id.empty()) {
-                    std::string payload = "{\"type\":\"call_media_state\","
-                        "\"from_user_id\":\"" + JsonParser::escapeJson(user_id) + "\","
-                        "\"from_username\":\"" + JsonParser::escapeJson(from_username) + "\","
-                        "\"media_type\":\"" + JsonParser::escapeJson(media_type) + "\","
-                        "\"enabled\":" + enabled + "}";
+                    JsonWriter out(160);
+                    out.beginObject()
+                        .field("type", "call_media_state")
+                        .field("from_user_id", user_id)
+                        .field("from_username", from_username)
+                        .field("media_type", media_type)
+                        .field("enabled", enabled != "false" && enabled != "0")
+                        .endObject();
+                    std::string payload = out.take();
                     sendToUser(target_user_id, payload);
-                    Logger::getInstance().debug("Forwarded call_media_state from " + user_id + " to " + target_user_id);
+                    XIPHER_LOG_DEBUG("Forwarded call_media_state from " + user_id + " to " + target_user_id);
                 }
             } else {
                 // Групповой звонок - пересылаем всем участникам группы
                 std::string group_id = data.count("group_id") ? data["group_id"] : "";
                 if (!group_id.empty()) {
-                    std::string payload = "{\"type\":\"group_call_media_state\","
-                        "\"from_user_id\":\"" + JsonParser::escapeJson(user_id) + "\","
-                        "\"from_username\":\"" + JsonParser::escapeJson(from_username) + "\","
-                        "\"group_id\":\"" + JsonParser::escapeJson(group_id) + "\","
-                        "\"media_type\":\"" + JsonParser::escapeJson(media_type) + "\","
-                        "\"enabled\":" + enabled + "}";
+                    JsonWriter out(192);
+                    out.beginObject()
+                        .field("type", "group_call_media_state")
+                        .field("from_user_id", user_id)
+                        .field("from_username", from_username)
+                        .field("group_id", group_id)
+                        .field("media_type", media_type)
+                        .field("enabled", enabled != "false" && enabled != "0")
+                        .endObject();
+                    std::string payload = out.take();
                     // Рассылаем всем участникам группы
                     try {
                         auto members = db_manager_->getGroupMembers(group_id);
@@ -734,7 +917,7 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
                                 sendToUser(member.user_id, payload);
                             }
                         }
-                        Logger::getInstance().debug("Broadcasted group_call_media_state from " + user_id + " to group " + group_id);
+                        XIPHER_LOG_DEBUG("Broadcasted group_call_media_state from " + user_id + " to group " + group_id);
                     } catch (...) {
                         Logger::getInstance().warning("Failed to get group members for media state broadcast");
                     }
@@ -752,8 +935,7 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
 
             if (user_id.empty()) {
                 std::string error_response = "{\"type\":\"error\",\"error\":\"Not authenticated\"}";
-                ws->async_write(net::buffer(error_response),
-                    [](beast::error_code, std::size_t) {});
+                ws->send(std::move(error_response));
                 return;
             }
 
@@ -771,41 +953,53 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
                 normalized_type = "chat";
             }
 
-            std::string from_username = "Пользователь";
-            try {
-                auto user = db_manager_->getUserById(user_id);
-                if (!user.id.empty()) {
-                    from_username = user.username;
-                }
-            } catch (...) {
-                Logger::getInstance().warning("Could not get username for user: " + user_id);
-            }
-
-            std::string payload = "{\"type\":\"typing\","
-                "\"chat_type\":\"" + JsonParser::escapeJson(normalized_type) + "\","
-                "\"chat_id\":\"" + JsonParser::escapeJson(chat_id) + "\","
-                "\"from_user_id\":\"" + JsonParser::escapeJson(user_id) + "\","
-                "\"from_username\":\"" + JsonParser::escapeJson(from_username) + "\","
-                "\"is_typing\":\"" + JsonParser::escapeJson(is_typing) + "\"}";
-
+            // Typing events are frequent and fire-and-forget: the sender's
+            // username and the audience are fetched in one pipeline driven by
+            // the io reactor, so this worker does not wait on PostgreSQL.
+            PipelineBatch batch;
+            const size_t user_query = DatabaseManager::queueUserById(batch, user_id);
             if (normalized_type == "group") {
-                auto members = db_manager_->getGroupMembers(chat_id);
-                for (const auto& member : members) {
-                    if (member.user_id.empty() || member.user_id == user_id) continue;
-                    sendToUser(member.user_id, payload);
-                }
+                DatabaseManager::queueGroupMembers(batch, chat_id);
             } else if (normalized_type == "channel") {
-                auto subscribers = db_manager_->getChannelSubscriberIds(chat_id);
-                for (const auto& uid : subscribers) {
-                    if (uid.empty() || uid == user_id) continue;
-                    sendToUser(uid, payload);
-                }
-            } else {
-                std::string target_user_id = chat_id;
-                if (!target_user_id.empty() && target_user_id != user_id) {
-                    sendToUser(target_user_id, payload);
-                }
+                DatabaseManager::queueChannelSubscriberIds(batch, chat_id);
             }
+            asyncExecutePipeline(*db_manager_->getDb(), ioc_.get_executor(), std::move(batch),
+                [this, user_id, chat_id, normalized_type, is_typing, user_query](bool ok, PipelineResults results) {
+                    if (!ok) {
+                        Logger::getInstance().warning("Could not resolve typing audience for user: " + user_id);
+                    }
+                    std::string from_username = "Пользователь";
+                    auto user = DatabaseManager::userFromResult(user_query < results.size() ? results[user_query].get() : nullptr);
+                    if (!user.id.empty()) {
+                        from_username = user.username;
+                    }
+
+                    JsonWriter out(192);
+                    out.beginObject()
+                        .field("type", "typing")
+                        .field("chat_type", normalized_type)
+                        .field("chat_id", chat_id)
+                        .field("from_user_id", user_id)
+                        .field("from_username", from_username)
+                        .field("is_typing", is_typing)
+                        .endObject();
+                    const std::string payload = out.take();
+
+                    const PGresult* audience = results.size() > 1 ? results[1].get() : nullptr;
+                    if (normalized_type == "group") {
+                        for (const auto& member : DatabaseManager::groupMembersFromResult(audience)) {
+                            if (member.user_id.empty() || member.user_id == user_id) continue;
+                            sendToUser(member.user_id, payload);
+                        }
+                    } else if (normalized_type == "channel") {
+                        for (const auto& uid : DatabaseManager::channelSubscriberIdsFromResult(audience)) {
+                            if (uid.empty() || uid == user_id) continue;
+                            sendToUser(uid, payload);
+                        }
+                    } else if (chat_id != user_id) {
+                        sendToUser(chat_id, payload);
+                    }
+                });
         } else if (type == "message_delivered" || type == "message_read") {
             std::string token = data["token"];
             if (token == kSessionTokenPlaceholder) {
@@ -817,8 +1011,7 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
             }
             if (user_id.empty()) {
                 std::string error_response = "{\"type\":\"error\",\"error\":\"Not authenticated\"}";
-                ws->async_write(net::buffer(error_response),
-                    [](beast::error_code, std::size_t) {});
+                ws->send(std::move(error_response));
                 return;
             }
 
@@ -853,10 +1046,14 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
             }
 
             if (!msg.sender_id.empty() && (type != "message_read" || allow_read_receipts)) {
-                std::string payload = "{\"type\":\"" + JsonParser::escapeJson(type) + "\","
-                    "\"message_id\":\"" + JsonParser::escapeJson(message_id) + "\","
-                    "\"chat_id\":\"" + JsonParser::escapeJson(user_id) + "\","
-                    "\"from_user_id\":\"" + JsonParser::escapeJson(user_id) + "\"}";
+                JsonWriter out(160);
+                out.beginObject()
+                    .field("type", type)
+                    .field("message_id", message_id)
+                    .field("chat_id", user_id)
+                    .field("from_user_id", user_id)
+                    .endObject();
+                std::string payload = out.take();
                 sendToUser(msg.sender_id, payload);
             }
         } else if (type == "group_call_offer" || type == "group_call_answer" || 
@@ -876,8 +1073,7 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
             
             if (user_id.empty()) {
                 std::string error_response = "{\"type\":\"error\",\"error\":\"Not authenticated\"}";
-                ws->async_write(net::buffer(error_response),
-                    [](beast::error_code, std::size_t) {});
+                ws->send(std::move(error_response));
                 return;
             }
             
@@ -920,27 +1116,26 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
                 
                 std::string call_type = data.count("call_type") ? data["call_type"] : "video";
                 
+                // Payload одинаковый для всех участников - собираем один раз
+                JsonWriter out(192 + members.size() * 40);
+                out.beginObject()
+                    .field("type", "group_call_notification")
+                    .field("group_id", group_id)
+                    .field("group_name", group_name)
+                    .field("from_user_id", user_id)
+                    .field("from_username", from_username)
+                    .field("call_type", call_type)
+                    .key("members").beginArray();
+                for (const auto& m : members) {
+                    // Отправляем как строку, чтобы фронтенд мог правильно сравнить
+                    out.value(m.user_id);
+                }
+                out.endArray().endObject();
+                const std::string notification_json = out.take();
+
                 // Отправляем всем участникам группы
                 for (const auto& member : members) {
                     if (member.user_id != user_id) { // Не отправляем себе
-                        // Формируем JSON для каждого участника отдельно
-                        std::string notification_json = "{\"type\":\"group_call_notification\","
-                            "\"group_id\":\"" + JsonParser::escapeJson(group_id) + "\","
-                            "\"group_name\":\"" + JsonParser::escapeJson(group_name) + "\","
-                            "\"from_user_id\":\"" + user_id + "\","
-                            "\"from_username\":\"" + JsonParser::escapeJson(from_username) + "\","
-                            "\"call_type\":\"" + call_type + "\","
-                            "\"members\":[";
-                        
-                        bool first = true;
-                        for (const auto& m : members) {
-                            if (!first) notification_json += ",";
-                            first = false;
-                            // Отправляем как строку, чтобы фронтенд мог правильно сравнить
-                            notification_json += "\"" + JsonParser::escapeJson(m.user_id) + "\"";
-                        }
-                        notification_json += "]}";
-                        
                         Logger::getInstance().info("Sending group call notification to user: " + member.user_id);
                         sendToUser(member.user_id, notification_json);
                     }
@@ -972,10 +1167,14 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
                 } else if (type == "group_call_end") {
                     // Отправляем всем участникам группы о завершении звонка
                     auto members = db_manager_->getGroupMembers(group_id);
-                    std::string end_json = "{\"type\":\"group_call_end\","
-                        "\"group_id\":\"" + JsonParser::escapeJson(group_id) + "\","
-                        "\"user_id\":\"" + user_id + "\","
-                        "\"from_user_id\":\"" + user_id + "\"}";
+                    JsonWriter out(128);
+                    out.beginObject()
+                        .field("type", "group_call_end")
+                        .field("group_id", group_id)
+                        .field("user_id", user_id)
+                        .field("from_user_id", user_id)
+                        .endObject();
+                    const std::string end_json = out.take();
                     
                     for (const auto& member : members) {
                         if (member.user_id != user_id) {
@@ -987,8 +1186,7 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
             
             // Отправляем подтверждение отправителю
             std::string response = "{\"success\":true,\"type\":\"" + type + "_sent\"}";
-            ws->async_write(net::buffer(response),
-                [](beast::error_code, std::size_t) {});
+            ws->send(std::move(response));
         }
     } catch (const std::exception& e) {
         Logger::getInstance().error("Error processing WebSocket message: " + std::string(e.what()));
@@ -998,88 +1196,44 @@ void HttpServer::handleWebSocketMessage(std::shared_ptr<websocket::stream<beast:
 }
 
 void HttpServer::registerWebSocketConnection(const std::string& user_id, 
-                                             std::shared_ptr<websocket::stream<beast::tcp_stream>> ws) {
-    {
-        std::lock_guard<std::mutex> lock(ws_connections_mutex_);
-        ws_connections_[user_id] = ws;
-    }
-    {
-        std::lock_guard<std::mutex> lock(ws_user_ids_mutex_);
-        ws_user_ids_[ws.get()] = user_id;
-    }
-    Logger::getInstance().info("========== WebSocket connection registered ==========");
-    Logger::getInstance().info("User ID: " + user_id);
-    Logger::getInstance().info("Total connections now: " + std::to_string(ws_connections_.size()));
-    
-    // Выводим список всех подключенных пользователей
-    std::string connected_users = "All connected users: ";
-    for (const auto& pair : ws_connections_) {
-        connected_users += pair.first + " ";
-    }
-    Logger::getInstance().info(connected_users);
+                                             std::shared_ptr<WebSocketSession> ws) {
+    ws_registry_.add(user_id, ws);
+    Logger::getInstance().info("WebSocket connection registered for user: " + user_id +
+                               " (sessions: " + std::to_string(ws_registry_.sessionCount()) +
+                               ", users: " + std::to_string(ws_registry_.userCount()) + ")");
 }
 
-void HttpServer::unregisterWebSocketConnection(const std::string& user_id) {
-    {
-        std::lock_guard<std::mutex> lock(ws_connections_mutex_);
-        ws_connections_.erase(user_id);
+void HttpServer::unregisterWebSocketConnection(std::shared_ptr<WebSocketSession> ws) {
+    const std::string user_id = ws->userId();
+    ws_registry_.remove(ws);
+    if (!user_id.empty()) {
+        Logger::getInstance().info("WebSocket connection unregistered for user: " + user_id);
     }
-    {
-        std::lock_guard<std::mutex> lock(ws_user_ids_mutex_);
-        for (auto it = ws_user_ids_.begin(); it != ws_user_ids_.end();) {
-            if (it->second == user_id) {
-                it = ws_user_ids_.erase(it);
-            } else {
-                ++it;
-            }
-        }
-    }
-    Logger::getInstance().info("WebSocket connection unregistered for user: " + user_id);
 }
 
-std::string HttpServer::getWebSocketUserId(std::shared_ptr<websocket::stream<beast::tcp_stream>> ws) {
-    std::lock_guard<std::mutex> lock(ws_user_ids_mutex_);
-    auto it = ws_user_ids_.find(ws.get());
-    if (it == ws_user_ids_.end()) {
-        return "";
-    }
-    return it->second;
+std::string HttpServer::getWebSocketUserId(std::shared_ptr<WebSocketSession> ws) {
+    return ws->userId();
 }
 
 void HttpServer::sendToUser(const std::string& user_id, const std::string& message) {
-    std::lock_guard<std::mutex> lock(ws_connections_mutex_);
-    
-    // Логируем все подключенные пользователи для отладки
-    Logger::getInstance().info("sendToUser called for user: " + user_id);
-    Logger::getInstance().info("Total WebSocket connections: " + std::to_string(ws_connections_.size()));
-    
-    // Выводим список всех подключенных пользователей
-    std::string connected_users = "Connected users: ";
-    for (const auto& pair : ws_connections_) {
-        connected_users += pair.first + " ";
+    // Every device of the user gets the message; only the user's shard is locked,
+    // and only while the session list is copied.
+    const auto sessions = ws_registry_.sessionsFor(user_id);
+    if (sessions.empty()) {
+        XIPHER_LOG_RATE_LIMITED(LogLevel::WARNING, 10, "No WebSocket connection found for user: " + user_id);
+        return;
     }
-    Logger::getInstance().info(connected_users);
-    
-    auto it = ws_connections_.find(user_id);
-    if (it != ws_connections_.end()) {
-        auto ws = it->second.lock();
-        if (ws) {
-            Logger::getInstance().info("Sending WebSocket message to user: " + user_id + ", message: " + message);
-            ws->async_write(net::buffer(message),
-                [user_id, message](beast::error_code ec, std::size_t) {
-                    if (ec) {
-                        Logger::getInstance().error("Error sending WebSocket message to user " + user_id + ": " + ec.message());
-                    } else {
-                        Logger::getInstance().info("WebSocket message sent successfully to user: " + user_id);
-                    }
-                });
-        } else {
-            // Соединение закрыто, удаляем из списка
-            Logger::getInstance().warning("WebSocket connection expired for user: " + user_id);
-            ws_connections_.erase(it);
+    XIPHER_LOG_DEBUG("Sending WebSocket message to user: " + user_id + " (" +
+                     std::to_string(sessions.size()) + " sessions), message: " + message);
+    for (const auto& ws : sessions) {
+        // Queued on the session; its write loop runs on the target stream's strand.
+        if (!ws->send(message)) {
+            const auto stats = ws->queueStats();
+            XIPHER_LOG_RATE_LIMITED(LogLevel::WARNING, 10,
+                                    "WebSocket message to user " + user_id + " not queued (" +
+                                    std::to_string(stats.queued_frames) + " frames, " +
+                                    std::to_string(stats.queued_bytes) + " bytes pending)");
         }
-    } else {
-        Logger::getInstance().warning("No WebSocket connection found for user: " + user_id + " (total connections: " + std::to_string(ws_connections_.size()) + ")");
     }
 }
 
@@ -1,6 +1,10 @@
 #include "../include/server/request_handler.hpp"
 #include "../include/utils/json_parser.hpp"
+#include "../include/utils/json_view.hpp"
+#include "../include/utils/json_writer.hpp"
 #include "../include/utils/logger.hpp"
+#include "../include/utils/env.hpp"
+#include "../include/utils/http_utils.hpp"
 #include "../include/bots/lite_bot_runtime.hpp"
 #include <fstream>
 #include <sstream>
@@ -70,12 +74,6 @@ std::string urlDecode(const std::string& value) {
     return result;
 }
 
-std::string toLowerCopy(std::string input) {
-    std::transform(input.begin(), input.end(), input.begin(),
-                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
-    return input;
-}
-
 std::string toUpperCopy(std::string input) {
     std::transform(input.begin(), input.end(), input.begin(),
                    [](unsigned char ch) { return static_cast<char>(std::toupper(ch)); });
@@ -293,28 +291,6 @@ bool isAllowedFileExtension(const std::string& extension) {
     return kAllowedFileExtensions.count(ext_lower) > 0;
 }
 
-std::string statusReasonPhrase(int status) {
-    switch (status) {
-        case 200: return "OK";
-        case 400: return "Bad Request";
-        case 401: return "Unauthorized";
-        case 403: return "Forbidden";
-        case 404: return "Not Found";
-        case 500: return "Internal Server Error";
-        default: return "OK";
-    }
-}
-
-std::string buildHttpResponse(int status, const std::string& body, const std::string& content_type) {
-    std::ostringstream oss;
-    oss << "HTTP/1.1 " << status << " " << statusReasonPhrase(status) << "\r\n";
-    oss << "Content-Type: " << content_type << "\r\n";
-    oss << "Content-Length: " << body.size() << "\r\n";
-    oss << "\r\n";
-    oss << body;
-    return oss.str();
-}
-
 bool shouldDeletePushToken(const std::string& error_code) {
     if (error_code.empty()) return false;
     return error_code == "UNREGISTERED"
@@ -325,7 +301,7 @@ bool shouldDeletePushToken(const std::string& error_code) {
 
 bool isRuStorePlatform(const std::string& platform) {
     if (platform.empty()) return false;
-    std::string lower = toLowerCopy(platform);
+    std::string lower = xipher::toLowerCopy(platform);
     return lower == "rustore" || lower == "ru_store";
 }
 
@@ -1005,13 +981,89 @@ bool verifyStripeSignature(const std::string& payload, const std::string& header
     const std::string signed_payload = timestamp + "." + payload;
     const std::string expected = hmacSha256Hex(secret, signed_payload);
     for (const auto& sig : signatures) {
-        if (timingSafeEqual(toLowerCopy(sig), toLowerCopy(expected))) {
+        if (timingSafeEqual(xipher::toLowerCopy(sig), xipher::toLowerCopy(expected))) {
             return true;
         }
     }
     return false;
 }
 
+// Paging of the message history endpoints: `limit` (1..100, default 50)
+// and an optional cursor, before_id (older page) or after_id (newer page)
+struct HistoryPage {
+    int limit = 50;
+    std::string before_id;
+    std::string after_id;
+};
+
+HistoryPage parseHistoryPage(std::map<std::string, std::string>& data) {
+    HistoryPage page;
+    if (data.find("limit") != data.end()) {
+        try {
+            page.limit = std::stoi(data["limit"]);
+            if (page.limit < 1 || page.limit > 100) page.limit = 50;
+        } catch (...) {
+            page.limit = 50;
+        }
+    }
+    if (data.find("before_id") != data.end()) {
+        page.before_id = data["before_id"];
+    }
+    if (page.before_id.empty() && data.find("after_id") != data.end()) {
+        page.after_id = data["after_id"];
+    }
+    return page;
+}
+
+// Handlers fetch limit + 1 messages (newest first); the extra one only
+// tells whether there is another page in the requested direction.
+template <class MessageT>
+bool trimHistoryPage(std::vector<MessageT>& messages, const HistoryPage& page) {
+    if (messages.size() <= static_cast<size_t>(page.limit)) {
+        return false;
+    }
+    if (!page.after_id.empty()) {
+        messages.erase(messages.begin());
+    } else {
+        messages.pop_back();
+    }
+    return true;
+}
+
+// Paging of the message search endpoints: `limit` (1..100, default 50) and
+// `cursor`, the id of the last hit of the previous page (next_cursor)
+struct SearchPage {
+    int limit = 50;
+    std::string cursor;
+};
+
+SearchPage parseSearchPage(std::map<std::string, std::string>& data) {
+    SearchPage page;
+    if (data.find("limit") != data.end()) {
+        try {
+            page.limit = std::stoi(data["limit"]);
+            if (page.limit < 1 || page.limit > 100) page.limit = 50;
+        } catch (...) {
+            page.limit = 50;
+        }
+    }
+    if (data.find("cursor") != data.end()) {
+        page.cursor = data["cursor"];
+    }
+    return page;
+}
+
+// Handlers fetch limit + 1 hits; returns the cursor of the next page
+// (empty on the last one) after dropping the extra hit.
+template <class MessageT>
+std::string trimSearchPage(std::vector<MessageT>& messages, const SearchPage& page) {
+    if (messages.size() <= static_cast<size_t>(page.limit)) {
+        return "";
+    }
+    messages.resize(static_cast<size_t>(page.limit));
+    return messages.back().id;
+}
+
 } // namespace
 
 namespace xipher {
@@ -1059,6 +1111,47 @@ void RequestHandler::storeCallIce(const std::string& sender_id, const std::strin
 
 namespace {
 
+HttpResponse buildHttpResponse(int status, const std::string& body, const std::string& content_type) {
+    return HttpResponse::text(status, content_type, body);
+}
+
+// Most handlers still return the JSON document as std::string; it goes out
+// as 200 application/json with CORS open, as the API always answered.
+HttpResponse apiResponse(std::string json_body) {
+    HttpResponse res = HttpResponse::json(std::move(json_body));
+    res.setHeader("Access-Control-Allow-Origin", "*");
+    return res;
+}
+
+HttpResponse apiResponse(HttpResponse res) {
+    return res;
+}
+
+// Route metadata presets. Body limits are enforced by HttpServer before the
+// body is read; 0 falls back to the server-wide maximum (Bot API files).
+constexpr std::size_t kJsonBodyLimit = 16 * 1024 * 1024;
+constexpr std::size_t kPageBodyLimit = 64 * 1024;
+// Upload bodies are indexed by JsonDocument; larger ones get 413 up front
+constexpr std::size_t kUploadBodyLimit = JsonDocument::kMaxSize;
+
+const RouteInfo kStaticPage{false, kPageBodyLimit, "default"};
+const RouteInfo kSessionPage{true, kPageBodyLimit, "default"};
+const RouteInfo kPublicPage{true, kPageBodyLimit, "default"};
+const RouteInfo kFileRoute{true, kPageBodyLimit, "default"};
+const RouteInfo kPublicApi{true, kJsonBodyLimit, "default"};
+const RouteInfo kSessionApi{true, kJsonBodyLimit, "default"};
+const RouteInfo kAuthApi{true, kJsonBodyLimit, "auth"};
+const RouteInfo kUploadApi{true, kUploadBodyLimit, "upload"};
+const RouteInfo kAiApi{true, kJsonBodyLimit, "ai"};
+const RouteInfo kWalletApi{true, kJsonBodyLimit, "wallet"};
+const RouteInfo kBotApi{true, 0, "bot_api"};
+const RouteInfo kWebhook{true, kJsonBodyLimit, "default"};
+const RouteInfo kPreflight{false, kPageBodyLimit, "default"};
+// Unknown paths only ever produce a 404, don't buffer large bodies for them
+const RouteInfo kUnknownRoute{false, kPageBodyLimit, "default"};
+
+const std::string kEmptyBody;
+
 bool roleHasChannelPermission(const std::string& role, RequestHandler::ChannelPermission permission) {
     if (role == "creator") {
         return true; // creator has all permissions
@@ -1116,13 +1209,6 @@ std::string normalizeChatType(std::string type) {
     return type;
 }
 
-std::string toLowerCopy(std::string value) {
-    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
-        return static_cast<char>(std::tolower(c));
-    });
-    return value;
-}
-
 bool parseBoolValue(const std::string& value, bool fallback) {
     if (value.empty()) {
         return fallback;
@@ -1249,6 +1335,21 @@ RequestHandler::RequestHandler(DatabaseManager& db_manager, AuthManager& auth_ma
                       ? std::getenv("XIPHER_RUSTORE_BASE_URL")
                       : ""),
       report_rate_limiter_(5, 60, 60) {
+    // web/ is served from memory; files above the cap stay on the disk path
+    static_assets_ = std::make_unique<StaticAssetCache>(
+        "/root/xipher/web",
+        [this](const std::string& extension) { return getMimeType(extension); },
+        static_cast<std::uint64_t>(readEnvSize("XIPHER_STATIC_CACHE_MAX_FILE_KB", 4096)) * 1024,
+        std::chrono::seconds(readEnvSize("XIPHER_STATIC_RECHECK_SEC", 2)));
+    static_assets_->start();
+
+    registerRoutes();
+}
+
+void RequestHandler::reloadStaticAssets() {
+    if (static_assets_) {
+        static_assets_->reload();
+    }
 }
 
 void RequestHandler::setWebSocketSender(std::function<void(const std::string&, const std::string&)> sender) {
@@ -1347,15 +1448,8 @@ bool RequestHandler::checkPermission(const std::string& user_id,
                                      const std::string& chat_id,
                                      uint64_t required_mask,
                                      std::string* error) {
+    // Cached; already reports the creator as owner without a participant row
     ChatPermissions perms = db_manager_.getChatPermissions(chat_id, user_id);
-    if (!perms.found) {
-        Chat chat = db_manager_.getChatV2(chat_id);
-        if (!chat.id.empty() && chat.created_by == user_id) {
-            perms.found = true;
-            perms.status = "owner";
-            perms.perms = kAllAdminPerms;
-        }
-    }
     if (!perms.found) {
         if (error) *error = "not a participant";
         return false;
@@ -1427,98 +1521,87 @@ bool RequestHandler::checkRestriction(const std::string& chat_id,
     return true;
 }
 
-std::string RequestHandler::handleRequest(const std::string& method,
-                                         const std::string& path,
-                                         const std::map<std::string, std::string>& headers,
-                                         const std::string& body) {
+std::string RequestHandler::normalizeRoutePath(const std::string& method, const std::string& path) {
     // Strip query string for routing
-    std::string clean_path = path;
-    size_t qpos = clean_path.find('?');
+    std::string route_path = path;
+    size_t qpos = route_path.find('?');
     if (qpos != std::string::npos) {
-        clean_path = clean_path.substr(0, qpos);
+        route_path.resize(qpos);
     }
-
-    // Handle CORS preflight requests
-    if (method == "OPTIONS") {
-        return handleOptions(clean_path, headers);
-    } else if (method == "GET") {
-        return handleGet(clean_path, headers);
-    } else if (method == "POST") {
-        return handlePost(clean_path, body, headers);
-    } else {
-        return JsonParser::createErrorResponse("Method not allowed");
+    if (method == "GET" && route_path.size() > 1 && route_path.back() == '/') {
+        route_path.pop_back();
     }
+    return route_path;
 }
 
-std::string RequestHandler::handleGet(const std::string& path, const std::map<std::string, std::string>& headers) {
-    std::string route_path = path;
-    if (route_path.size() > 1 && route_path.back() == '/') {
-        route_path.pop_back();
+RouteInfo RequestHandler::routeInfo(const std::string& method, const std::string& path) const {
+    if (method == "OPTIONS") {
+        return kPreflight;
     }
+    const Route* route = router_.match(method, normalizeRoutePath(method, path));
+    return route ? route->info : kUnknownRoute;
+}
 
-    auto extractSessionToken = [&]() -> std::string {
-        return extractSessionTokenFromHeaders(headers);
+void RequestHandler::registerRoutes() {
+    auto page = [this](const std::string& path, const std::string& file) {
+        router_.add("GET", path, [this, file](const RouteRequest& req) -> HttpResponse {
+            return serveStaticFile(file, req.headers);
+        }, kStaticPage);
     };
-
-    auto isPrdSession = [&]() -> bool {
-        const std::string token = extractSessionToken();
-        if (token.empty() || !auth_manager_.validateSessionToken(token)) {
-            return false;
-        }
-        const std::string user_id = auth_manager_.getUserIdFromToken(token);
-        if (user_id.empty()) {
-            return false;
-        }
-        const User user = db_manager_.getUserById(user_id);
-        return !user.id.empty() && user.username == "prd";
+    auto adminPage = [this](const std::string& path, const std::string& file) {
+        router_.add("GET", path, [this, file](const RouteRequest& req) -> HttpResponse {
+            return serveAdminPage(file, req.headers);
+        }, kSessionPage);
     };
-
-    auto serveAdminPage = [&](const std::string& file_path) -> std::string {
-        if (!isPrdSession()) {
-            return serveStaticFileWithStatus("/root/xipher/web/404.html", "HTTP/1.1 404 Not Found");
-        }
-        return serveStaticFile(file_path);
+    auto webDir = [this](const std::string& prefix) {
+        router_.addPrefix("GET", prefix, [this](const RouteRequest& req) -> HttpResponse {
+            return serveStaticFile("/root/xipher/web" + req.path, req.headers);
+        }, kStaticPage);
+    };
+    // POST handlers taking the (session-injected) JSON body, optionally with headers
+    auto post = [this](const std::string& path, auto handler, const RouteInfo& info = kSessionApi) {
+        router_.add("POST", path, [this, handler](const RouteRequest& req) -> HttpResponse {
+            return apiResponse((this->*handler)(req.body));
+        }, info);
+    };
+    auto postWithHeaders = [this](const std::string& path, auto handler, const RouteInfo& info = kSessionApi) {
+        router_.add("POST", path, [this, handler](const RouteRequest& req) -> HttpResponse {
+            return apiResponse((this->*handler)(req.body, req.headers));
+        }, info);
     };
 
-    // Clean URL routing (without .html)
-    if (route_path == "/" || route_path == "/index" || route_path == "/index.html") {
-        return serveStaticFile("/root/xipher/web/index.html");
-    } else if (route_path == "/xipher.ico" || route_path == "/favicon.ico") {
-        return serveStaticFile("/root/xipher/web/xipher.ico");
-    } else if (route_path == "/register" || route_path == "/register.html") {
-        return serveStaticFile("/root/xipher/web/register.html");
-    } else if (route_path == "/login" || route_path == "/login.html") {
-        return serveStaticFile("/root/xipher/web/login.html");
-    } else if (route_path == "/privacy" || route_path == "/privacy.html") {
-        return serveStaticFile("/root/xipher/web/privacy.html");
-    } else if (route_path == "/terms" || route_path == "/terms.html") {
-        return serveStaticFile("/root/xipher/web/terms.html");
-    } else if (route_path == "/admin" || route_path == "/admin.html") {
-        return serveAdminPage("/root/xipher/web/admin-login.html");
-    } else if (route_path == "/admin/panel" || route_path == "/admin/panel.html") {
-        return serveAdminPage("/root/xipher/web/admin.html");
-    } else if (route_path == "/admin/reports" || route_path == "/admin/reports.html") {
-        return serveAdminPage("/root/xipher/web/admin-reports.html");
-    } else if (route_path == "/chat" || route_path == "/chat.html") {
-        // Serve chat shell; auth validation happens client-side via session cookie.
-        return serveStaticFile("/root/xipher/web/chat.html");
-    } else if (route_path.rfind("/chat/", 0) == 0) {
-        // Deep links like /chat/<id> should load the chat shell.
-        return serveStaticFile("/root/xipher/web/chat.html");
-    } else if (route_path == "/firebase-messaging-sw.js") {
-        // Firebase Cloud Messaging service worker must be served from the origin root.
-        return serveStaticFile("/root/xipher/web/firebase-messaging-sw.js");
-    } else if (route_path == "/bots" || route_path == "/bots.html") {
-        // Страница управления ботами: требует авторизации как /chat
-        std::string token = extractSessionTokenFromHeaders(headers);
-        if (token.empty() || !auth_manager_.validateSessionToken(token)) {
-            Logger::getInstance().warning("Unauthorized access to /bots. Token: " + (token.empty() ? "empty" : token.substr(0, 10) + "..."));
-            return "HTTP/1.1 302 Found\r\nLocation: /login\r\n\r\n";
-        }
-        return serveStaticFile("/root/xipher/web/bots.html");
-    } else if (route_path == "/api" || route_path == "/api.html") {
-        return serveStaticFile("/root/xipher/web/api.html");
-    } else if (route_path == "/api/ai-oauth-config") {
+    // ---- GET: clean URL routing (without .html) ----
+    for (const char* path : {"/", "/index", "/index.html"}) page(path, "/root/xipher/web/index.html");
+    for (const char* path : {"/xipher.ico", "/favicon.ico"}) page(path, "/root/xipher/web/xipher.ico");
+    for (const char* path : {"/register", "/register.html"}) page(path, "/root/xipher/web/register.html");
+    for (const char* path : {"/login", "/login.html"}) page(path, "/root/xipher/web/login.html");
+    for (const char* path : {"/privacy", "/privacy.html"}) page(path, "/root/xipher/web/privacy.html");
+    for (const char* path : {"/terms", "/terms.html"}) page(path, "/root/xipher/web/terms.html");
+    for (const char* path : {"/api", "/api.html"}) page(path, "/root/xipher/web/api.html");
+    for (const char* path : {"/bot-ide", "/bot-ide.html"}) page(path, "/root/xipher/web/bot-ide.html");
+    for (const char* path : {"/admin", "/admin.html"}) adminPage(path, "/root/xipher/web/admin-login.html");
+    for (const char* path : {"/admin/panel", "/admin/panel.html"}) adminPage(path, "/root/xipher/web/admin.html");
+    for (const char* path : {"/admin/reports", "/admin/reports.html"}) adminPage(path, "/root/xipher/web/admin-reports.html");
+    // Serve chat shell; auth validation happens client-side via session cookie.
+    for (const char* path : {"/chat", "/chat.html"}) page(path, "/root/xipher/web/chat.html");
+    // Firebase Cloud Messaging service worker must be served from the origin root.
+    page("/firebase-messaging-sw.js", "/root/xipher/web/firebase-messaging-sw.js");
+
+    // Страница управления ботами: требует авторизации как /chat
+    for (const char* path : {"/bots", "/bots.html"}) {
+        router_.add("GET", path, [this](const RouteRequest& req) -> HttpResponse {
+            std::string token = extractSessionTokenFromHeaders(req.headers);
+            if (token.empty() || !auth_manager_.validateSessionToken(token)) {
+                Logger::getInstance().warning("Unauthorized access to /bots. Token: " + (token.empty() ? "empty" : token.substr(0, 10) + "..."));
+                return HttpResponse::redirect("/login");
+            }
+            return serveStaticFile("/root/xipher/web/bots.html", req.headers);
+        }, kSessionPage);
+    }
+
+    RouteInfo env_config = kPublicApi;
+    env_config.blocking = false;
+    router_.add("GET", "/api/ai-oauth-config", [this](const RouteRequest&) -> HttpResponse {
         std::map<std::string, std::string> cfg;
         const char* authorize_env = std::getenv("XIPHER_AI_OAUTH_AUTHORIZE_URL");
         const char* token_env = std::getenv("XIPHER_AI_OAUTH_TOKEN_URL");
@@ -1533,86 +1616,387 @@ std::string RequestHandler::handleGet(const std::string& path, const std::map<st
         cfg["default_use_oauth"] = envFlagEnabled(use_env) ? "true" : "false";
 
         return buildHttpJson(JsonParser::createSuccessResponse("ok", cfg));
-    } else if (route_path == "/api/public-stats") {
+    }, env_config);
+    router_.add("GET", "/api/public-stats", [this](const RouteRequest&) -> HttpResponse {
         std::map<std::string, std::string> stats;
         stats["users"] = std::to_string(db_manager_.countUsers());
         stats["active_24h"] = std::to_string(db_manager_.countActiveUsersSince(24 * 3600));
         stats["messages_today"] = std::to_string(db_manager_.countMessagesToday());
         return buildHttpJson(JsonParser::createSuccessResponse("public_stats", stats));
-    } else if (route_path.find("/api/wallet/tokens") == 0) {
-        // Proxy CoinGecko tokens API
+    }, kPublicApi);
+
+    // Public CoinGecko proxies
+    router_.addPrefix("GET", "/api/wallet/tokens", [this](const RouteRequest& req) -> HttpResponse {
         std::string query = "";
-        size_t qpos = route_path.find('?');
+        size_t qpos = req.path.find('?');
         if (qpos != std::string::npos) {
-            query = route_path.substr(qpos + 1);
+            query = req.path.substr(qpos + 1);
         }
         return buildHttpJson(handleWalletTokens(query));
-    } else if (route_path.find("/api/wallet/prices") == 0) {
-        // Proxy CoinGecko prices API
+    }, kWalletApi);
+    router_.addPrefix("GET", "/api/wallet/prices", [this](const RouteRequest& req) -> HttpResponse {
         std::string query = "";
-        size_t qpos = route_path.find('?');
+        size_t qpos = req.path.find('?');
         if (qpos != std::string::npos) {
-            query = route_path.substr(qpos + 1);
+            query = req.path.substr(qpos + 1);
         }
         return buildHttpJson(handleWalletPrices(query));
-    } else if (route_path.find("/api/wallet/staking/products") == 0) {
-        // Get staking products list
+    }, kWalletApi);
+    router_.addPrefix("GET", "/api/wallet/staking/products", [this](const RouteRequest&) -> HttpResponse {
         return buildHttpJson(handleStakingProducts(""));
-    } else if (route_path.find("/css/") == 0) {
-        return serveStaticFile("/root/xipher/web" + route_path);
-    } else if (route_path.find("/js/") == 0) {
-        return serveStaticFile("/root/xipher/web" + route_path);
-    } else if (route_path.find("/images/") == 0) {
-        return serveStaticFile("/root/xipher/web" + route_path);
-    } else if (route_path.rfind("/app/", 0) == 0) {
-        if (route_path.find("..") != std::string::npos) {
-            return "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\n\r\n400 Bad Request";
-        }
-        return serveStaticFile("/root/strotage" + route_path);
-    } else if (route_path.rfind("/join/", 0) == 0) {
-        // Invite links route to chat UI; chat.js will process join code
-        return serveStaticFile("/root/xipher/web/chat.html");
-    } else if (route_path.find("/files/") == 0) {
-        return handleGetFile(route_path);
-    } else if (route_path.find("/avatars/") == 0) {
-        return handleGetAvatar(route_path);
-    } else if (route_path.length() > 1 && route_path[0] == '/' && route_path[1] == '@') {
+    }, kWalletApi);
+
+    webDir("/css/");
+    webDir("/js/");
+    webDir("/images/");
+    router_.addPrefix("GET", "/app/", [this](const RouteRequest& req) -> HttpResponse {
+        if (req.path.find("..") != std::string::npos) {
+            return HttpResponse::text(400, "text/plain", "400 Bad Request");
+        }
+        return serveStaticFile("/root/strotage" + req.path, req.headers);
+    }, kFileRoute);
+    // Deep links like /chat/<id> and invite links /join/<code> load the chat shell
+    for (const char* prefix : {"/chat/", "/join/"}) {
+        router_.addPrefix("GET", prefix, [this](const RouteRequest& req) -> HttpResponse {
+            return serveStaticFile("/root/xipher/web/chat.html", req.headers);
+        }, kStaticPage);
+    }
+    router_.addPrefix("GET", "/files/", [this](const RouteRequest& req) -> HttpResponse {
+        return handleGetFile(req.path, req.headers);
+    }, kFileRoute);
+    router_.addPrefix("GET", "/avatars/", [this](const RouteRequest& req) -> HttpResponse {
+        return handleGetAvatar(req.path, req.headers);
+    }, kFileRoute);
+
+    // ---- Shared by GET and POST ----
+    for (const char* method : {"GET", "POST"}) {
         // Универсальные ссылки /@username: каналы + пользователи + боты.
-        // Показываем красивую страницу предпросмотра
-        return handleChannelUrl(route_path);
-    } else if (route_path == "/bot-ide.html" || route_path == "/bot-ide") {
-        // Serve bot IDE page (must check before /bot* Bot API routes)
-        return serveStaticFile("/root/xipher/web/bot-ide.html");
-    } else if (route_path.length() > 4 && route_path.substr(0, 4) == "/bot") {
-        // Обработка Telegram Bot API запросов: /bot<token>/method_name (GET для getUpdates и getWebhookInfo)
-        // But exclude /bot-ide.html which is handled above
-        if (route_path.find("/bot-ide") == 0) {
-            return serveStaticFile("/root/xipher/web/bot-ide.html");
-        }
-        return handleBotApiRequest(route_path, "GET", "", headers);
+        router_.addPrefix(method, "/@", [this](const RouteRequest& req) -> HttpResponse {
+            return handleChannelUrl(req.path);
+        }, kPublicPage);
+        // /bot-ide* is the IDE page, must win over the Bot API prefix below
+        router_.addPrefix(method, "/bot-ide", [this](const RouteRequest& req) -> HttpResponse {
+            return serveStaticFile("/root/xipher/web/bot-ide.html", req.headers);
+        }, kStaticPage);
+        // Обработка Telegram Bot API запросов: /bot<token>/method_name
+        const std::string bot_method = method;
+        router_.addPrefix(method, "/bot", [this, bot_method](const RouteRequest& req) -> HttpResponse {
+            if (req.path.size() <= 4) {
+                if (bot_method == "GET") {
+                    return serveStaticFileWithStatus("/root/xipher/web/404.html", 404, req.headers);
+                }
+                return apiResponse(JsonParser::createErrorResponse("Not found"));
+            }
+            return apiResponse(handleBotApiRequest(req.path, bot_method, req.body, req.headers));
+        }, kBotApi);
+    }
+
+    // ---- POST API ----
+    post("/api/register", &RequestHandler::handleRegister, kAuthApi);
+    postWithHeaders("/api/login", &RequestHandler::handleLogin, kAuthApi);
+    postWithHeaders("/api/logout", &RequestHandler::handleLogout);
+    postWithHeaders("/api/refresh-session", &RequestHandler::handleRefreshSession);
+    post("/api/get-sessions", &RequestHandler::handleGetSessions);
+    post("/api/revoke-session", &RequestHandler::handleRevokeSession);
+    post("/api/revoke-selected-sessions", &RequestHandler::handleRevokeSelectedSessions);
+    post("/api/revoke-other-sessions", &RequestHandler::handleRevokeOtherSessions);
+    router_.add("POST", "/api/admin/login", [this](const RouteRequest& req) -> HttpResponse {
+        return admin_handler_.handleLogin(req.headers, req.body);
+    }, kAuthApi);
+    router_.add("POST", "/api/admin/action", [this](const RouteRequest& req) -> HttpResponse {
+        return admin_handler_.handleAction(req.headers, req.body);
+    }, kSessionApi);
+    postWithHeaders("/api/admin/reports/list", &RequestHandler::handleAdminGetReports);
+    postWithHeaders("/api/admin/reports/update", &RequestHandler::handleAdminUpdateReport);
+    post("/api/check-username", &RequestHandler::handleCheckUsername, kPublicApi);
+    post("/api/register-push-token", &RequestHandler::handleRegisterPushToken);
+    post("/api/delete-push-token", &RequestHandler::handleDeletePushToken);
+    post("/api/friends", &RequestHandler::handleGetFriends);
+    post("/api/chats", &RequestHandler::handleGetChats);
+    post("/api/get-chat-pins", &RequestHandler::handleGetChatPins);
+    post("/api/pin-chat", &RequestHandler::handlePinChat);
+    post("/api/unpin-chat", &RequestHandler::handleUnpinChat);
+    post("/api/get-chat-folders", &RequestHandler::handleGetChatFolders);
+    post("/api/set-chat-folders", &RequestHandler::handleSetChatFolders);
+    post("/api/set-premium", &RequestHandler::handleSetPremium);
+    post("/api/premium/create-payment", &RequestHandler::handleCreatePremiumPayment);
+    post("/api/premium/create-gift-payment", &RequestHandler::handleCreatePremiumGiftPayment);
+    postWithHeaders("/stripe/webhook", &RequestHandler::handleStripeWebhook, kWebhook);
+    postWithHeaders("/stripe/webhook/", &RequestHandler::handleStripeWebhook, kWebhook);
+    post("/api/messages", &RequestHandler::handleGetMessages);
+    post("/api/search-messages", &RequestHandler::handleSearchMessages);
+    post("/api/send-message", &RequestHandler::handleSendMessage);
+    post("/api/delete-message", &RequestHandler::handleDeleteMessage);
+    post("/api/delete-group-message", &RequestHandler::handleDeleteGroupMessage);
+    post("/api/delete-channel-message", &RequestHandler::handleDeleteChannelMessage);
+    post("/api/reports", &RequestHandler::handleCreateReport);
+    post("/api/unpin-message", &RequestHandler::handleUnpinMessage);
+    post("/api/friend-request", &RequestHandler::handleFriendRequest);
+    post("/api/accept-friend", &RequestHandler::handleAcceptFriend);
+    post("/api/reject-friend", &RequestHandler::handleRejectFriend);
+    post("/api/friend-requests", &RequestHandler::handleGetFriendRequests);
+    post("/api/find-user", &RequestHandler::handleFindUser);
+    post("/api/resolve-username", &RequestHandler::handleResolveUsername);
+    post("/api/bot-callback-query", &RequestHandler::handleBotCallbackQuery);
+    post("/api/get-user-profile", &RequestHandler::handleGetUserProfile);
+    post("/api/set-personal-channel", &RequestHandler::handleSetPersonalChannel);
+    post("/api/update-my-profile", &RequestHandler::handleUpdateMyProfile);
+    post("/api/update-my-privacy", &RequestHandler::handleUpdateMyPrivacy);
+    post("/api/set-business-hours", &RequestHandler::handleSetBusinessHours);
+    post("/api/validate-token", &RequestHandler::handleValidateToken, kPublicApi);
+    postWithHeaders("/api/ai-models", &RequestHandler::handleAiProxyModels, kAiApi);
+    postWithHeaders("/api/ai-chat", &RequestHandler::handleAiProxyChat, kAiApi);
+    postWithHeaders("/api/ai-oauth-exchange", &RequestHandler::handleAiOauthExchange, kAiApi);
+    post("/api/update-activity", &RequestHandler::handleUpdateActivity);
+    post("/api/user-status", &RequestHandler::handleUserStatus);
+    post("/api/turn-config", &RequestHandler::handleGetTurnConfig);
+    post("/api/sfu-config", &RequestHandler::handleGetSfuConfig);
+    post("/api/sfu-room", &RequestHandler::handleGetSfuRoom);
+    postWithHeaders("/api/upload-file", &RequestHandler::handleUploadFile, kUploadApi);
+    postWithHeaders("/api/upload-voice", &RequestHandler::handleUploadVoice, kUploadApi);
+    postWithHeaders("/api/upload-avatar", &RequestHandler::handleUploadAvatar, kUploadApi);
+    postWithHeaders("/api/upload_avatar", &RequestHandler::handleUploadAvatar, kUploadApi);
+    postWithHeaders("/api/upload-channel-avatar", &RequestHandler::handleUploadChannelAvatar, kUploadApi);
+    postWithHeaders("/api/upload_channel_avatar", &RequestHandler::handleUploadChannelAvatar, kUploadApi);
+    post("/notification", &RequestHandler::handleYooMoneyNotification, kWebhook);
+    post("/notification/", &RequestHandler::handleYooMoneyNotification, kWebhook);
+    post("/callback", &RequestHandler::handleYooMoneyNotification, kWebhook);
+    post("/callback/", &RequestHandler::handleYooMoneyNotification, kWebhook);
+    post("/api/call-notification", &RequestHandler::handleCallNotification);
+    post("/api/call-response", &RequestHandler::handleCallResponse);
+    post("/api/group-call-notification", &RequestHandler::handleGroupCallNotification);
+    post("/api/call-offer", &RequestHandler::handleCallOffer);
+    post("/api/call-answer", &RequestHandler::handleCallAnswer);
+    post("/api/call-ice", &RequestHandler::handleCallIce);
+    post("/api/call-end", &RequestHandler::handleCallEnd);
+    post("/api/check-incoming-calls", &RequestHandler::handleCheckIncomingCalls);
+    post("/api/check-call-response", &RequestHandler::handleCheckCallResponse);
+    post("/api/get-call-offer", &RequestHandler::handleGetCallOffer);
+    post("/api/get-call-answer", &RequestHandler::handleGetCallAnswer);
+    post("/api/get-call-ice", &RequestHandler::handleGetCallIce);
+    post("/api/create-group", &RequestHandler::handleCreateGroup);
+    post("/api/get-groups", &RequestHandler::handleGetGroups);
+    post("/api/get-group-members", &RequestHandler::handleGetGroupMembers);
+    post("/api/get-group-messages", &RequestHandler::handleGetGroupMessages);
+    post("/api/send-group-message", &RequestHandler::handleSendGroupMessage);
+    post("/api/create-group-invite", &RequestHandler::handleCreateGroupInvite);
+    post("/api/leave-group", &RequestHandler::handleLeaveGroup);
+    post("/api/join-group", &RequestHandler::handleJoinGroup);
+    post("/api/update-group-name", &RequestHandler::handleUpdateGroupName);
+    post("/api/update-group-description", &RequestHandler::handleUpdateGroupDescription);
+    post("/api/pin-message", &RequestHandler::handlePinMessage);
+    post("/api/ban-member", &RequestHandler::handleBanMember);
+    post("/api/mute-member", &RequestHandler::handleMuteMember);
+    post("/api/forward-message", &RequestHandler::handleForwardMessage);
+    post("/api/kick-member", &RequestHandler::handleKickMember);
+    post("/api/add-friend-to-group", &RequestHandler::handleAddFriendToGroup);
+    post("/api/set-admin-permissions", &RequestHandler::handleSetAdminPermissions);
+    post("/api/delete-group", &RequestHandler::handleDeleteGroup);
+    post("/api/search-group-messages", &RequestHandler::handleSearchGroupMessages);
+    post("/api/update-group-permissions", &RequestHandler::handleUpdateGroupPermissions);
+    // Group Topics (Forum mode) routes
+    post("/api/set-group-forum-mode", &RequestHandler::handleSetGroupForumMode);
+    post("/api/create-group-topic", &RequestHandler::handleCreateGroupTopic);
+    post("/api/update-group-topic", &RequestHandler::handleUpdateGroupTopic);
+    post("/api/delete-group-topic", &RequestHandler::handleDeleteGroupTopic);
+    post("/api/get-group-topics", &RequestHandler::handleGetGroupTopics);
+    post("/api/pin-group-topic", &RequestHandler::handlePinGroupTopic);
+    post("/api/unpin-group-topic", &RequestHandler::handleUnpinGroupTopic);
+    post("/api/get-topic-messages", &RequestHandler::handleGetTopicMessages);
+    post("/api/send-topic-message", &RequestHandler::handleSendTopicMessage);
+    post("/api/hide-general-topic", &RequestHandler::handleHideGeneralTopic);
+    post("/api/toggle-topic-closed", &RequestHandler::handleToggleTopicClosed);
+    post("/api/reorder-pinned-topics", &RequestHandler::handleReorderPinnedTopics);
+    post("/api/search-topics", &RequestHandler::handleSearchTopics);
+    post("/api/set-topic-notifications", &RequestHandler::handleSetTopicNotifications);
+    post("/api/create-channel", &RequestHandler::handleCreateChannel);
+    post("/api/get-channels", &RequestHandler::handleGetChannels);
+    post("/api/public-directory", &RequestHandler::handlePublicDirectory, kPublicApi);
+    post("/api/request-verification", &RequestHandler::handleRequestVerification);
+    post("/api/get-verification-requests", &RequestHandler::handleGetVerificationRequests);
+    post("/api/review-verification", &RequestHandler::handleReviewVerification);
+    post("/api/get-my-verification-requests", &RequestHandler::handleGetMyVerificationRequests);
+    post("/api/set-group-public", &RequestHandler::handleSetGroupPublic);
+    post("/api/set-channel-public", &RequestHandler::handleSetChannelPublic);
+    post("/api/get-channel-messages", &RequestHandler::handleGetChannelMessages);
+    post("/api/send-channel-message", &RequestHandler::handleSendChannelMessage);
+    post("/api/subscribe-channel", &RequestHandler::handleSubscribeChannel);
+    post("/api/create-channel-invite", &RequestHandler::handleCreateChannelInvite);
+    post("/api/revoke-channel-invite", &RequestHandler::handleRevokeChannelInvite);
+    post("/api/join-channel-by-invite", &RequestHandler::handleJoinChannelByInvite);
+    post("/api/add-message-reaction", &RequestHandler::handleAddMessageReaction);
+    post("/api/remove-message-reaction", &RequestHandler::handleRemoveMessageReaction);
+    post("/api/get-message-reactions", &RequestHandler::handleGetMessageReactions);
+    post("/api/read-channel", &RequestHandler::handleReadChannel);
+    post("/api/create-poll", &RequestHandler::handleCreatePoll);
+    post("/api/vote-poll", &RequestHandler::handleVotePoll);
+    post("/api/get-poll", &RequestHandler::handleGetPoll);
+    post("/api/add-message-view", &RequestHandler::handleAddMessageView);
+    post("/api/update-channel-name", &RequestHandler::handleUpdateChannelName);
+    post("/api/update-channel-description", &RequestHandler::handleUpdateChannelDescription);
+    post("/api/set-channel-custom-link", &RequestHandler::handleSetChannelCustomLink);
+    post("/api/set-channel-privacy", &RequestHandler::handleSetChannelPrivacy);
+    post("/api/set-channel-show-author", &RequestHandler::handleSetChannelShowAuthor);
+    post("/api/add-allowed-reaction", &RequestHandler::handleAddAllowedReaction);
+    post("/api/remove-allowed-reaction", &RequestHandler::handleRemoveAllowedReaction);
+    post("/api/get-channel-allowed-reactions", &RequestHandler::handleGetChannelAllowedReactions);
+    post("/api/get-channel-join-requests", &RequestHandler::handleGetChannelJoinRequests);
+    post("/api/accept-channel-join-request", &RequestHandler::handleAcceptChannelJoinRequest);
+    post("/api/reject-channel-join-request", &RequestHandler::handleRejectChannelJoinRequest);
+    post("/api/set-channel-admin-permissions", &RequestHandler::handleSetChannelAdminPermissions);
+    post("/api/ban-channel-member", &RequestHandler::handleBanChannelMember);
+    post("/api/get-channel-members", &RequestHandler::handleGetChannelMembers);
+    post("/api/search-channel", &RequestHandler::handleSearchChannel);
+    post("/api/get-channel-info", &RequestHandler::handleGetChannelInfo);
+    post("/api/unsubscribe-channel", &RequestHandler::handleUnsubscribeChannel);
+    post("/api/delete-channel", &RequestHandler::handleDeleteChannel);
+    post("/api/link-channel-discussion", &RequestHandler::handleLinkChannelDiscussion);
+    post("/api/create-store-item", &RequestHandler::handleCreateStoreItem);
+    post("/api/edit-store-item", &RequestHandler::handleEditStoreItem);
+    post("/api/delete-store-item", &RequestHandler::handleDeleteStoreItem);
+    post("/api/get-store-items", &RequestHandler::handleGetStoreItems);
+    post("/api/purchase-product", &RequestHandler::handlePurchaseProduct);
+    post("/api/create-integration", &RequestHandler::handleCreateIntegration);
+    post("/api/get-integrations", &RequestHandler::handleGetIntegrations);
+    post("/api/delete-integration", &RequestHandler::handleDeleteIntegration);
+    post("/api/create-bot", &RequestHandler::handleCreateBot);
+    post("/api/update-bot-profile", &RequestHandler::handleUpdateBotProfile);
+    post("/api/update-bot-flow", &RequestHandler::handleUpdateBotFlow);
+    post("/api/get-user-bots", &RequestHandler::handleGetUserBots);
+    post("/api/deploy-bot", &RequestHandler::handleDeployBot);
+    post("/api/delete-bot", &RequestHandler::handleDeleteBot);
+    postWithHeaders("/api/upload-bot-avatar", &RequestHandler::handleUploadBotAvatar, kUploadApi);
+    postWithHeaders("/api/upload_bot_avatar", &RequestHandler::handleUploadBotAvatar, kUploadApi);
+    post("/api/get-bot-logs", &RequestHandler::handleGetBotLogs);
+    post("/api/replay-webhook", &RequestHandler::handleReplayWebhook);
+    post("/api/reveal-bot-token", &RequestHandler::handleRevealBotToken);
+    post("/api/get-bot-script", &RequestHandler::handleGetBotScript);
+    post("/api/update-bot-script", &RequestHandler::handleUpdateBotScript);
+    post("/api/add-bot-developer", &RequestHandler::handleAddBotDeveloper);
+    post("/api/remove-bot-developer", &RequestHandler::handleRemoveBotDeveloper);
+    post("/api/get-bot-developers", &RequestHandler::handleGetBotDevelopers);
+    post("/api/list-bot-files", &RequestHandler::handleListBotFiles);
+    post("/api/get-bot-file", &RequestHandler::handleGetBotFile);
+    post("/api/save-bot-file", &RequestHandler::handleSaveBotFile);
+    post("/api/delete-bot-file", &RequestHandler::handleDeleteBotFile);
+    post("/api/build-bot-project", &RequestHandler::handleBuildBotProject);
+    post("/api/create-trigger-rule", &RequestHandler::handleCreateTriggerRule);
+    post("/api/update-trigger-rule", &RequestHandler::handleUpdateTriggerRule);
+    post("/api/delete-trigger-rule", &RequestHandler::handleDeleteTriggerRule);
+    post("/api/get-trigger-rules", &RequestHandler::handleGetTriggerRules);
+    post("/api/create-event-webhook", &RequestHandler::handleCreateEventWebhook);
+    // E2EE (End-to-End Encryption) API
+    post("/api/e2ee/register-key", &RequestHandler::handleE2EERegisterKey);
+    post("/api/e2ee/get-public-key", &RequestHandler::handleE2EEGetPublicKey);
+    post("/api/e2ee/get-public-keys", &RequestHandler::handleE2EEGetPublicKeys);
+    post("/api/e2ee/send-encrypted", &RequestHandler::handleE2EESendMessage);
+    post("/api/e2ee/status", &RequestHandler::handleE2EEStatus);
+    // Wallet API
+    post("/api/wallet/register", &RequestHandler::handleWalletRegister, kWalletApi);
+    post("/api/wallet/get-address", &RequestHandler::handleWalletGetAddress, kWalletApi);
+    post("/api/wallet/balance", &RequestHandler::handleWalletBalance, kWalletApi);
+    post("/api/wallet/relay-tx", &RequestHandler::handleWalletRelayTx, kWalletApi);
+    post("/api/wallet/history", &RequestHandler::handleWalletHistory, kWalletApi);
+    post("/api/wallet/send-to-user", &RequestHandler::handleWalletSendToUser, kWalletApi);
+    // Wallet sync API (server-side wallet storage)
+    post("/api/wallet/save", &RequestHandler::handleWalletSave, kWalletApi);
+    post("/api/wallet/get", &RequestHandler::handleWalletGet, kWalletApi);
+    post("/api/wallet/update", &RequestHandler::handleWalletUpdate, kWalletApi);
+    post("/api/wallet/delete", &RequestHandler::handleWalletDelete, kWalletApi);
+    // P2P Marketplace API
+    post("/api/wallet/p2p/offers", &RequestHandler::handleP2POffers, kWalletApi);
+    post("/api/wallet/p2p/create-offer", &RequestHandler::handleP2PCreateOffer, kWalletApi);
+    post("/api/wallet/p2p/start-trade", &RequestHandler::handleP2PStartTrade, kWalletApi);
+    post("/api/wallet/p2p/my-trades", &RequestHandler::handleP2PMyTrades, kWalletApi);
+    post("/api/wallet/p2p/update-trade", &RequestHandler::handleP2PUpdateTrade, kWalletApi);
+    // Vouchers API
+    post("/api/wallet/vouchers/create", &RequestHandler::handleVoucherCreate, kWalletApi);
+    post("/api/wallet/vouchers/claim", &RequestHandler::handleVoucherClaim, kWalletApi);
+    post("/api/wallet/vouchers/my", &RequestHandler::handleVouchersMy, kWalletApi);
+    // Staking API
+    post("/api/wallet/staking/stake", &RequestHandler::handleStakingStake, kWalletApi);
+    post("/api/wallet/staking/my-stakes", &RequestHandler::handleStakingMyStakes, kWalletApi);
+    post("/api/wallet/staking/unstake", &RequestHandler::handleStakingUnstake, kWalletApi);
+    // NFT API
+    post("/api/wallet/nft/my", &RequestHandler::handleNFTMy, kWalletApi);
+    post("/api/wallet/nft/refresh", &RequestHandler::handleNFTRefresh, kWalletApi);
+    // Security API
+    post("/api/wallet/security/get", &RequestHandler::handleSecurityGet, kWalletApi);
+    post("/api/wallet/security/update", &RequestHandler::handleSecurityUpdate, kWalletApi);
+    router_.addPrefix("POST", "/api/oauth-callback/", [this](const RouteRequest& req) -> HttpResponse {
+        return apiResponse(handleOAuthCallback(req.path, req.body));
+    }, kWebhook);
+}
+
+HttpResponse RequestHandler::handleRequest(const std::string& method,
+                                         const std::string& path,
+                                         const std::map<std::string, std::string>& headers,
+                                         const std::string& body) {
+    // Strip query string for routing
+    std::string clean_path = path;
+    size_t qpos = clean_path.find('?');
+    if (qpos != std::string::npos) {
+        clean_path = clean_path.substr(0, qpos);
+    }
+
+    // Handle CORS preflight requests
+    if (method == "OPTIONS") {
+        return handleOptions(clean_path, headers);
+    } else if (method == "GET") {
+        return handleGet(clean_path, headers);
+    } else if (method == "POST") {
+        return handlePost(clean_path, body, headers);
     } else {
-        // Keep JSON for API calls, but show a nice 404 page for browser navigation.
-        if (route_path.rfind("/api", 0) == 0) {
-            return JsonParser::createErrorResponse("Not found");
-        }
-        return serveStaticFileWithStatus("/root/xipher/web/404.html", "HTTP/1.1 404 Not Found");
+        return apiResponse(JsonParser::createErrorResponse("Method not allowed"));
     }
 }
 
-std::string RequestHandler::handleOptions(const std::string& /*path*/, const std::map<std::string, std::string>& /*headers*/) {
+HttpResponse RequestHandler::handleGet(const std::string& path, const std::map<std::string, std::string>& headers) {
+    const std::string route_path = normalizeRoutePath("GET", path);
+    if (const Route* route = router_.match("GET", route_path)) {
+        return route->handler(RouteRequest{route_path, kEmptyBody, headers});
+    }
+
+    // Keep JSON for API calls, but show a nice 404 page for browser navigation.
+    if (route_path.rfind("/api", 0) == 0) {
+        return apiResponse(JsonParser::createErrorResponse("Not found"));
+    }
+    return serveStaticFileWithStatus("/root/xipher/web/404.html", 404, headers);
+}
+
+bool RequestHandler::isPrdSession(const std::map<std::string, std::string>& headers) {
+    const std::string token = extractSessionTokenFromHeaders(headers);
+    if (token.empty() || !auth_manager_.validateSessionToken(token)) {
+        return false;
+    }
+    const std::string user_id = auth_manager_.getUserIdFromToken(token);
+    if (user_id.empty()) {
+        return false;
+    }
+    const User user = db_manager_.getUserById(user_id);
+    return !user.id.empty() && user.username == "prd";
+}
+
+HttpResponse RequestHandler::serveAdminPage(const std::string& file_path,
+                                            const std::map<std::string, std::string>& headers) {
+    if (!isPrdSession(headers)) {
+        return serveStaticFileWithStatus("/root/xipher/web/404.html", 404, headers);
+    }
+    return serveStaticFile(file_path, headers);
+}
+
+HttpResponse RequestHandler::handleOptions(const std::string& /*path*/, const std::map<std::string, std::string>& /*headers*/) {
     // Handle CORS preflight requests for Bot API
-    std::ostringstream oss;
-    oss << "HTTP/1.1 204 No Content\r\n";
-    oss << "Access-Control-Allow-Origin: *\r\n";
-    oss << "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n";
-    oss << "Access-Control-Allow-Headers: Content-Type, Authorization\r\n";
-    oss << "Access-Control-Max-Age: 86400\r\n";
-    oss << "Content-Length: 0\r\n";
-    oss << "\r\n";
-    return oss.str();
+    HttpResponse res;
+    res.setStatus(204);
+    res.setHeader("Access-Control-Allow-Origin", "*");
+    res.setHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+    res.setHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    res.setHeader("Access-Control-Max-Age", "86400");
+    return res;
 }
 
-std::string RequestHandler::handlePost(const std::string& path, const std::string& raw_body, const std::map<std::string, std::string>& headers) {
+HttpResponse RequestHandler::handlePost(const std::string& path, const std::string& raw_body, const std::map<std::string, std::string>& headers) {
     std::string body_storage;
     std::string content_type;
     auto content_type_it = headers.find("Content-Type");
@@ -1634,452 +2018,10 @@ std::string RequestHandler::handlePost(const std::string& path, const std::strin
     }
     const std::string& body = should_inject ? body_storage : raw_body;
 
-    if (path == "/api/register") {
-        return handleRegister(body);
-    } else if (path == "/api/login") {
-        return handleLogin(body, headers);
-    } else if (path == "/api/logout") {
-        return handleLogout(body, headers);
-    } else if (path == "/api/refresh-session") {
-        return handleRefreshSession(body, headers);
-    } else if (path == "/api/get-sessions") {
-        return handleGetSessions(body);
-    } else if (path == "/api/revoke-session") {
-        return handleRevokeSession(body);
-    } else if (path == "/api/revoke-selected-sessions") {
-        return handleRevokeSelectedSessions(body);
-    } else if (path == "/api/revoke-other-sessions") {
-        return handleRevokeOtherSessions(body);
-    } else if (path == "/api/admin/login") {
-        return admin_handler_.handleLogin(headers, body);
-    } else if (path == "/api/admin/action") {
-        return admin_handler_.handleAction(headers, body);
-    } else if (path == "/api/admin/reports/list") {
-        return handleAdminGetReports(body, headers);
-    } else if (path == "/api/admin/reports/update") {
-        return handleAdminUpdateReport(body, headers);
-    } else if (path == "/api/check-username") {
-        return handleCheckUsername(body);
-    } else if (path == "/api/register-push-token") {
-        return handleRegisterPushToken(body);
-    } else if (path == "/api/delete-push-token") {
-        return handleDeletePushToken(body);
-    } else if (path == "/api/friends") {
-        return handleGetFriends(body);
-    } else if (path == "/api/chats") {
-        return handleGetChats(body);
-    } else if (path == "/api/get-chat-pins") {
-        return handleGetChatPins(body);
-    } else if (path == "/api/pin-chat") {
-        return handlePinChat(body);
-    } else if (path == "/api/unpin-chat") {
-        return handleUnpinChat(body);
-    } else if (path == "/api/get-chat-folders") {
-        return handleGetChatFolders(body);
-    } else if (path == "/api/set-chat-folders") {
-        return handleSetChatFolders(body);
-    } else if (path == "/api/set-premium") {
-        return handleSetPremium(body);
-    } else if (path == "/api/premium/create-payment") {
-        return handleCreatePremiumPayment(body);
-    } else if (path == "/api/premium/create-gift-payment") {
-        return handleCreatePremiumGiftPayment(body);
-    } else if (path == "/stripe/webhook" || path == "/stripe/webhook/") {
-        return handleStripeWebhook(body, headers);
-    } else if (path == "/api/messages") {
-        return handleGetMessages(body);
-    } else if (path == "/api/send-message") {
-        return handleSendMessage(body);
-    } else if (path == "/api/delete-message") {
-        return handleDeleteMessage(body);
-    } else if (path == "/api/delete-group-message") {
-        return handleDeleteGroupMessage(body);
-    } else if (path == "/api/delete-channel-message") {
-        return handleDeleteChannelMessage(body);
-    } else if (path == "/api/reports") {
-        return handleCreateReport(body);
-    } else if (path == "/api/unpin-message") {
-        return handleUnpinMessage(body);
-    } else if (path == "/api/friend-request") {
-        return handleFriendRequest(body);
-    } else if (path == "/api/accept-friend") {
-        return handleAcceptFriend(body);
-    } else if (path == "/api/reject-friend") {
-        return handleRejectFriend(body);
-    } else if (path == "/api/friend-requests") {
-        return handleGetFriendRequests(body);
-    } else if (path == "/api/find-user") {
-        return handleFindUser(body);
-    } else if (path == "/api/resolve-username") {
-        return handleResolveUsername(body);
-    } else if (path == "/api/bot-callback-query") {
-        return handleBotCallbackQuery(body);
-    } else if (path == "/api/get-user-profile") {
-        return handleGetUserProfile(body);
-    } else if (path == "/api/set-personal-channel") {
-        return handleSetPersonalChannel(body);
-    } else if (path == "/api/update-my-profile") {
-        return handleUpdateMyProfile(body);
-    } else if (path == "/api/update-my-privacy") {
-        return handleUpdateMyPrivacy(body);
-    } else if (path == "/api/set-business-hours") {
-        return handleSetBusinessHours(body);
-    } else if (path == "/api/validate-token") {
-        return handleValidateToken(body);
-    } else if (path == "/api/ai-models") {
-        return handleAiProxyModels(body, headers);
-    } else if (path == "/api/ai-chat") {
-        return handleAiProxyChat(body, headers);
-    } else if (path == "/api/ai-oauth-exchange") {
-        return handleAiOauthExchange(body, headers);
-    } else if (path == "/api/update-activity") {
-        return handleUpdateActivity(body);
-    } else if (path == "/api/user-status") {
-        return handleUserStatus(body);
-    } else if (path == "/api/turn-config") {
-        return handleGetTurnConfig(body);
-    } else if (path == "/api/sfu-config") {
-        return handleGetSfuConfig(body);
-    } else if (path == "/api/sfu-room") {
-        return handleGetSfuRoom(body);
-    } else if (path == "/api/upload-file") {
-        return handleUploadFile(body, headers);
-    } else if (path == "/api/upload-voice") {
-        return handleUploadVoice(body, headers);
-    } else if (path == "/api/upload-avatar" || path == "/api/upload_avatar") {
-        return handleUploadAvatar(body, headers);
-    } else if (path == "/api/upload-channel-avatar" || path == "/api/upload_channel_avatar") {
-        return handleUploadChannelAvatar(body, headers);
-    } else if (path == "/notification" || path == "/notification/" || path == "/callback" || path == "/callback/") {
-        return handleYooMoneyNotification(body);
-    } else if (path == "/api/call-notification") {
-        return handleCallNotification(body);
-    } else if (path == "/api/call-response") {
-        return handleCallResponse(body);
-    } else if (path == "/api/group-call-notification") {
-        return handleGroupCallNotification(body);
-    } else if (path == "/api/call-offer") {
-        return handleCallOffer(body);
-    } else if (path == "/api/call-answer") {
-        return handleCallAnswer(body);
-    } else if (path == "/api/call-ice") {
-        return handleCallIce(body);
-    } else if (path == "/api/call-end") {
-        return handleCallEnd(body);
-    } else if (path == "/api/check-incoming-calls") {
-        return handleCheckIncomingCalls(body);
-    } else if (path == "/api/check-call-response") {
-        return handleCheckCallResponse(body);
-    } else if (path == "/api/get-call-offer") {
-        return handleGetCallOffer(body);
-    } else if (path == "/api/get-call-answer") {
-        return handleGetCallAnswer(body);
-    } else if (path == "/api/get-call-ice") {
-        return handleGetCallIce(body);
-    } else if (path == "/api/create-group") {
-        return handleCreateGroup(body);
-    } else if (path == "/api/get-groups") {
-        return handleGetGroups(body);
-    } else if (path == "/api/get-group-members") {
-        return handleGetGroupMembers(body);
-    } else if (path == "/api/get-group-messages") {
-        return handleGetGroupMessages(body);
-    } else if (path == "/api/send-group-message") {
-        return handleSendGroupMessage(body);
-    } else if (path == "/api/create-group-invite") {
-        return handleCreateGroupInvite(body);
-    } else if (path == "/api/leave-group") {
-        return handleLeaveGroup(body);
-    } else if (path == "/api/join-group") {
-        return handleJoinGroup(body);
-    } else if (path == "/api/update-group-name") {
-        return handleUpdateGroupName(body);
-    } else if (path == "/api/update-group-description") {
-        return handleUpdateGroupDescription(body);
-    } else if (path == "/api/pin-message") {
-        return handlePinMessage(body);
-    } else if (path == "/api/ban-member") {
-        return handleBanMember(body);
-    } else if (path == "/api/mute-member") {
-        return handleMuteMember(body);
-    } else if (path == "/api/forward-message") {
-        return handleForwardMessage(body);
-    } else if (path == "/api/kick-member") {
-        return handleKickMember(body);
-    } else if (path == "/api/add-friend-to-group") {
-        return handleAddFriendToGroup(body);
-    } else if (path == "/api/set-admin-permissions") {
-        return handleSetAdminPermissions(body);
-    } else if (path == "/api/delete-group") {
-        return handleDeleteGroup(body);
-    } else if (path == "/api/search-group-messages") {
-        return handleSearchGroupMessages(body);
-    } else if (path == "/api/update-group-permissions") {
-        return handleUpdateGroupPermissions(body);
-    // Group Topics (Forum mode) routes
-    } else if (path == "/api/set-group-forum-mode") {
-        return handleSetGroupForumMode(body);
-    } else if (path == "/api/create-group-topic") {
-        return handleCreateGroupTopic(body);
-    } else if (path == "/api/update-group-topic") {
-        return handleUpdateGroupTopic(body);
-    } else if (path == "/api/delete-group-topic") {
-        return handleDeleteGroupTopic(body);
-    } else if (path == "/api/get-group-topics") {
-        return handleGetGroupTopics(body);
-    } else if (path == "/api/pin-group-topic") {
-        return handlePinGroupTopic(body);
-    } else if (path == "/api/unpin-group-topic") {
-        return handleUnpinGroupTopic(body);
-    } else if (path == "/api/get-topic-messages") {
-        return handleGetTopicMessages(body);
-    } else if (path == "/api/send-topic-message") {
-        return handleSendTopicMessage(body);
-    } else if (path == "/api/hide-general-topic") {
-        return handleHideGeneralTopic(body);
-    } else if (path == "/api/toggle-topic-closed") {
-        return handleToggleTopicClosed(body);
-    } else if (path == "/api/reorder-pinned-topics") {
-        return handleReorderPinnedTopics(body);
-    } else if (path == "/api/search-topics") {
-        return handleSearchTopics(body);
-    } else if (path == "/api/set-topic-notifications") {
-        return handleSetTopicNotifications(body);
-    } else if (path == "/api/create-channel") {
-        return handleCreateChannel(body);
-    } else if (path == "/api/get-channels") {
-        return handleGetChannels(body);
-    } else if (path == "/api/public-directory") {
-        return handlePublicDirectory(body);
-    } else if (path == "/api/request-verification") {
-        return handleRequestVerification(body);
-    } else if (path == "/api/get-verification-requests") {
-        return handleGetVerificationRequests(body);
-    } else if (path == "/api/review-verification") {
-        return handleReviewVerification(body);
-    } else if (path == "/api/get-my-verification-requests") {
-        return handleGetMyVerificationRequests(body);
-    } else if (path == "/api/set-group-public") {
-        return handleSetGroupPublic(body);
-    } else if (path == "/api/set-channel-public") {
-        return handleSetChannelPublic(body);
-    } else if (path == "/api/get-channel-messages") {
-        return handleGetChannelMessages(body);
-    } else if (path == "/api/send-channel-message") {
-        return handleSendChannelMessage(body);
-    } else if (path == "/api/subscribe-channel") {
-        return handleSubscribeChannel(body);
-    } else if (path == "/api/create-channel-invite") {
-        return handleCreateChannelInvite(body);
-    } else if (path == "/api/revoke-channel-invite") {
-        return handleRevokeChannelInvite(body);
-    } else if (path == "/api/join-channel-by-invite") {
-        return handleJoinChannelByInvite(body);
-    } else if (path == "/api/add-message-reaction") {
-        return handleAddMessageReaction(body);
-    } else if (path == "/api/remove-message-reaction") {
-        return handleRemoveMessageReaction(body);
-    } else if (path == "/api/get-message-reactions") {
-        return handleGetMessageReactions(body);
-    } else if (path == "/api/read-channel") {
-        return handleReadChannel(body);
-    } else if (path == "/api/create-poll") {
-        return handleCreatePoll(body);
-    } else if (path == "/api/vote-poll") {
-        return handleVotePoll(body);
-    } else if (path == "/api/get-poll") {
-        return handleGetPoll(body);
-    } else if (path == "/api/add-message-view") {
-        return handleAddMessageView(body);
-    } else if (path == "/api/update-channel-name") {
-        return handleUpdateChannelName(body);
-    } else if (path == "/api/update-channel-description") {
-        return handleUpdateChannelDescription(body);
-    } else if (path == "/api/set-channel-custom-link") {
-        return handleSetChannelCustomLink(body);
-    } else if (path == "/api/set-channel-privacy") {
-        return handleSetChannelPrivacy(body);
-    } else if (path == "/api/set-channel-show-author") {
-        return handleSetChannelShowAuthor(body);
-    } else if (path == "/api/add-allowed-reaction") {
-        return handleAddAllowedReaction(body);
-    } else if (path == "/api/remove-allowed-reaction") {
-        return handleRemoveAllowedReaction(body);
-    } else if (path == "/api/get-channel-allowed-reactions") {
-        return handleGetChannelAllowedReactions(body);
-    } else if (path == "/api/get-channel-allowed-reactions") {
-        return handleGetChannelAllowedReactions(body);
-    } else if (path == "/api/get-channel-join-requests") {
-        return handleGetChannelJoinRequests(body);
-    } else if (path == "/api/accept-channel-join-request") {
-        return handleAcceptChannelJoinRequest(body);
-    } else if (path == "/api/reject-channel-join-request") {
-        return handleRejectChannelJoinRequest(body);
-    } else if (path == "/api/set-channel-admin-permissions") {
-        return handleSetChannelAdminPermissions(body);
-    } else if (path == "/api/ban-channel-member") {
-        return handleBanChannelMember(body);
-    } else if (path == "/api/get-channel-members") {
-        return handleGetChannelMembers(body);
-    } else if (path == "/api/search-channel") {
-        return handleSearchChannel(body);
-    } else if (path == "/api/get-channel-info") {
-        return handleGetChannelInfo(body);
-    } else if (path == "/api/unsubscribe-channel") {
-        return handleUnsubscribeChannel(body);
-    } else if (path == "/api/delete-channel") {
-        return handleDeleteChannel(body);
-    } else if (path == "/api/link-channel-discussion") {
-        return handleLinkChannelDiscussion(body);
-    } else if (path == "/api/create-store-item") {
-        return handleCreateStoreItem(body);
-    } else if (path == "/api/edit-store-item") {
-        return handleEditStoreItem(body);
-    } else if (path == "/api/delete-store-item") {
-        return handleDeleteStoreItem(body);
-    } else if (path == "/api/get-store-items") {
-        return handleGetStoreItems(body);
-    } else if (path == "/api/purchase-product") {
-        return handlePurchaseProduct(body);
-    } else if (path == "/api/create-integration") {
-        return handleCreateIntegration(body);
-    } else if (path == "/api/get-integrations") {
-        return handleGetIntegrations(body);
-    } else if (path == "/api/delete-integration") {
-        return handleDeleteIntegration(body);
-    } else if (path.find("/api/oauth-callback/") == 0) {
-        return handleOAuthCallback(path, body);
-    } else if (path == "/api/create-bot") {
-        return handleCreateBot(body);
-    } else if (path == "/api/update-bot-profile") {
-        return handleUpdateBotProfile(body);
-    } else if (path == "/api/update-bot-flow") {
-        return handleUpdateBotFlow(body);
-    } else if (path == "/api/get-user-bots") {
-        return handleGetUserBots(body);
-    } else if (path == "/api/deploy-bot") {
-        return handleDeployBot(body);
-    } else if (path == "/api/delete-bot") {
-        return handleDeleteBot(body);
-    } else if (path == "/api/upload-bot-avatar" || path == "/api/upload_bot_avatar") {
-        return handleUploadBotAvatar(body, headers);
-    } else if (path == "/api/get-bot-logs") {
-        return handleGetBotLogs(body);
-    } else if (path == "/api/replay-webhook") {
-        return handleReplayWebhook(body);
-    } else if (path == "/api/reveal-bot-token") {
-        return handleRevealBotToken(body);
-    } else if (path == "/api/get-bot-script") {
-        return handleGetBotScript(body);
-    } else if (path == "/api/update-bot-script") {
-        return handleUpdateBotScript(body);
-    } else if (path == "/api/add-bot-developer") {
-        return handleAddBotDeveloper(body);
-    } else if (path == "/api/remove-bot-developer") {
-        return handleRemoveBotDeveloper(body);
-    } else if (path == "/api/get-bot-developers") {
-        return handleGetBotDevelopers(body);
-    } else if (path == "/api/list-bot-files") {
-        return handleListBotFiles(body);
-    } else if (path == "/api/get-bot-file") {
-        return handleGetBotFile(body);
-    } else if (path == "/api/save-bot-file") {
-        return handleSaveBotFile(body);
-    } else if (path == "/api/delete-bot-file") {
-        return handleDeleteBotFile(body);
-    } else if (path == "/api/build-bot-project") {
-        return handleBuildBotProject(body);
-    } else if (path == "/api/create-trigger-rule") {
-        return handleCreateTriggerRule(body);
-    } else if (path == "/api/update-trigger-rule") {
-        return handleUpdateTriggerRule(body);
-    } else if (path == "/api/delete-trigger-rule") {
-        return handleDeleteTriggerRule(body);
-    } else if (path == "/api/get-trigger-rules") {
-        return handleGetTriggerRules(body);
-    } else if (path == "/api/create-event-webhook") {
-        return handleCreateEventWebhook(body);
-    // E2EE (End-to-End Encryption) API
-    } else if (path == "/api/e2ee/register-key") {
-        return handleE2EERegisterKey(body);
-    } else if (path == "/api/e2ee/get-public-key") {
-        return handleE2EEGetPublicKey(body);
-    } else if (path == "/api/e2ee/get-public-keys") {
-        return handleE2EEGetPublicKeys(body);
-    } else if (path == "/api/e2ee/send-encrypted") {
-        return handleE2EESendMessage(body);
-    } else if (path == "/api/e2ee/status") {
-        return handleE2EEStatus(body);
-    // Wallet API
-    } else if (path == "/api/wallet/register") {
-        return handleWalletRegister(body);
-    } else if (path == "/api/wallet/get-address") {
-        return handleWalletGetAddress(body);
-    } else if (path == "/api/wallet/balance") {
-        return handleWalletBalance(body);
-    } else if (path == "/api/wallet/relay-tx") {
-        return handleWalletRelayTx(body);
-    } else if (path == "/api/wallet/history") {
-        return handleWalletHistory(body);
-    } else if (path == "/api/wallet/send-to-user") {
-        return handleWalletSendToUser(body);
-    // Wallet sync API (server-side wallet storage)
-    } else if (path == "/api/wallet/save") {
-        return handleWalletSave(body);
-    } else if (path == "/api/wallet/get") {
-        return handleWalletGet(body);
-    } else if (path == "/api/wallet/update") {
-        return handleWalletUpdate(body);
-    } else if (path == "/api/wallet/delete") {
-        return handleWalletDelete(body);
-    // P2P Marketplace API
-    } else if (path == "/api/wallet/p2p/offers") {
-        return handleP2POffers(body);
-    } else if (path == "/api/wallet/p2p/create-offer") {
-        return handleP2PCreateOffer(body);
-    } else if (path == "/api/wallet/p2p/start-trade") {
-        return handleP2PStartTrade(body);
-    } else if (path == "/api/wallet/p2p/my-trades") {
-        return handleP2PMyTrades(body);
-    } else if (path == "/api/wallet/p2p/update-trade") {
-        return handleP2PUpdateTrade(body);
-    // Vouchers API
-    } else if (path == "/api/wallet/vouchers/create") {
-        return handleVoucherCreate(body);
-    } else if (path == "/api/wallet/vouchers/claim") {
-        return handleVoucherClaim(body);
-    } else if (path == "/api/wallet/vouchers/my") {
-        return handleVouchersMy(body);
-    // Staking API
-    } else if (path == "/api/wallet/staking/stake") {
-        return handleStakingStake(body);
-    } else if (path == "/api/wallet/staking/my-stakes") {
-        return handleStakingMyStakes(body);
-    } else if (path == "/api/wallet/staking/unstake") {
-        return handleStakingUnstake(body);
-    // NFT API
-    } else if (path == "/api/wallet/nft/my") {
-        return handleNFTMy(body);
-    } else if (path == "/api/wallet/nft/refresh") {
-        return handleNFTRefresh(body);
-    // Security API
-    } else if (path == "/api/wallet/security/get") {
-        return handleSecurityGet(body);
-    } else if (path == "/api/wallet/security/update") {
-        return handleSecurityUpdate(body);
-    } else if (path.length() > 1 && path[0] == '/' && path[1] == '@') {
-        // Обработка URL вида /@username для прямого доступа к каналу
-        return handleChannelUrl(path);
-    } else if (path.length() > 4 && path.substr(0, 4) == "/bot") {
-        // Обработка Telegram Bot API запросов: /bot<token>/method_name
-        // But exclude /bot-ide.html which should be GET only
-        if (path.find("/bot-ide") == 0) {
-            return serveStaticFile("/root/xipher/web/bot-ide.html");
-        }
-        return handleBotApiRequest(path, "POST", body, headers);
-    } else {
-        return JsonParser::createErrorResponse("Not found");
+    if (const Route* route = router_.match("POST", path)) {
+        return route->handler(RouteRequest{path, body, headers});
     }
+    return apiResponse(JsonParser::createErrorResponse("Not found"));
 }
 
 std::string RequestHandler::handleRegister(const std::string& body) {
@@ -2101,11 +2043,11 @@ std::string RequestHandler::handleRegister(const std::string& body) {
     }
 }
 
-std::string RequestHandler::handleLogin(const std::string& body, const std::map<std::string, std::string>& headers) {
+HttpResponse RequestHandler::handleLogin(const std::string& body, const std::map<std::string, std::string>& headers) {
     auto data = JsonParser::parse(body);
     
     if (data.find("username") == data.end() || data.find("password") == data.end()) {
-        return JsonParser::createErrorResponse("Username and password are required");
+        return apiResponse(JsonParser::createErrorResponse("Username and password are required"));
     }
     
     std::string username = data["username"];
@@ -2142,11 +2084,11 @@ std::string RequestHandler::handleLogin(const std::string& body, const std::map<
         return buildHttpJson(JsonParser::createSuccessResponse(result["message"], response_data), headers_out);
     } else {
         Logger::getInstance().warning("Login failed for user: " + username + ", reason: " + result["message"]);
-        return JsonParser::createErrorResponse(result["message"]);
+        return apiResponse(JsonParser::createErrorResponse(result["message"]));
     }
 }
 
-std::string RequestHandler::handleLogout(const std::string& body, const std::map<std::string, std::string>& headers) {
+HttpResponse RequestHandler::handleLogout(const std::string& body, const std::map<std::string, std::string>& headers) {
     std::string token = extractSessionTokenFromHeaders(headers);
     if (token.empty()) {
         auto data = JsonParser::parse(body);
@@ -2172,7 +2114,7 @@ std::string RequestHandler::handleLogout(const std::string& body, const std::map
     return buildHttpJson(JsonParser::createSuccessResponse("Logged out"), headers_out);
 }
 
-std::string RequestHandler::handleRefreshSession(const std::string& body, const std::map<std::string, std::string>& headers) {
+HttpResponse RequestHandler::handleRefreshSession(const std::string& body, const std::map<std::string, std::string>& headers) {
     std::string token = extractSessionTokenFromHeaders(headers);
     if (token.empty()) {
         auto data = JsonParser::parse(body);
@@ -2195,12 +2137,12 @@ std::string RequestHandler::handleRefreshSession(const std::string& body, const
         token = extractSessionTokenFromHeaders(headers);
     }
     if (token.empty()) {
-        return JsonParser::createErrorResponse("Token required");
+        return apiResponse(JsonParser::createErrorResponse("Token required"));
     }
 
     std::string new_token = auth_manager_.rotateSessionToken(token);
     if (new_token.empty()) {
-        return JsonParser::createErrorResponse("Invalid token");
+        return apiResponse(JsonParser::createErrorResponse("Invalid token"));
     }
 
     std::ostringstream cookie;
@@ -2436,70 +2378,152 @@ std::string RequestHandler::handleDeletePushToken(const std::string& body) {
     return JsonParser::createSuccessResponse("Push token deleted");
 }
 
-std::string RequestHandler::serveStaticFile(const std::string& path) {
-    // Prevent serving directories or special files (and keep behavior deterministic).
-    try {
-        fs::path p(path);
-        if (!fs::exists(p) || !fs::is_regular_file(p)) {
-            Logger::getInstance().warning("Static file not found or not a regular file: " + path);
-            return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n\r\n404 Not Found";
-        }
-    } catch (...) {
-        // If filesystem probing fails, fall back to trying to open the file.
+namespace {
+
+bool parseHttpDate(const std::string& value, std::time_t& out) {
+    std::tm tm_utc{};
+    const char* end = strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm_utc);
+    if (!end) {
+        return false;
     }
+    out = timegm(&tm_utc);
+    return true;
+}
 
-    std::ifstream file(path, std::ios::binary);
-    if (!file.is_open()) {
-        Logger::getInstance().warning("File not found: " + path);
-        return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n\r\n404 Not Found";
+// If-None-Match uses weak comparison: W/ prefixes are ignored.
+bool etagListMatches(const std::string& header, const std::string& etag) {
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t comma = header.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = header.size();
+        }
+        std::string candidate = header.substr(pos, comma - pos);
+        candidate.erase(0, candidate.find_first_not_of(" \t"));
+        candidate.erase(candidate.find_last_not_of(" \t") + 1);
+        if (candidate.rfind("W/", 0) == 0) {
+            candidate.erase(0, 2);
+        }
+        if (candidate == "*" || candidate == etag) {
+            return true;
+        }
+        pos = comma + 1;
     }
-    
-    std::ostringstream content;
-    content << file.rdbuf();
-    std::string file_content = content.str();
-    
-    // Determine MIME type (safe even when there's no extension)
-    std::string extension;
+    return false;
+}
+
+enum class ByteRangeResult {
+    None,
+    Satisfiable,
+    Unsatisfiable
+};
+
+// Only a single range is honoured; multi-range requests get the full body,
+// which RFC 9110 allows.
+ByteRangeResult parseByteRange(const std::string& header, std::uint64_t size,
+                               std::uint64_t& offset, std::uint64_t& length) {
+    if (header.rfind("bytes=", 0) != 0 || header.find(',') != std::string::npos) {
+        return ByteRangeResult::None;
+    }
+    const std::string spec = header.substr(6);
+    const size_t dash = spec.find('-');
+    if (dash == std::string::npos) {
+        return ByteRangeResult::None;
+    }
+    const std::string first = spec.substr(0, dash);
+    const std::string last = spec.substr(dash + 1);
+    auto isDigits = [](const std::string& v) {
+        return !v.empty() && std::all_of(v.begin(), v.end(), [](unsigned char c) { return std::isdigit(c); });
+    };
     try {
-        extension = fs::path(path).extension().string();
+        if (first.empty()) {
+            // Suffix range: last N bytes
+            if (!isDigits(last)) return ByteRangeResult::None;
+            const std::uint64_t suffix = std::stoull(last);
+            if (suffix == 0 || size == 0) return ByteRangeResult::Unsatisfiable;
+            length = std::min(suffix, size);
+            offset = size - length;
+            return ByteRangeResult::Satisfiable;
+        }
+        if (!isDigits(first) || (!last.empty() && !isDigits(last))) {
+            return ByteRangeResult::None;
+        }
+        const std::uint64_t start = std::stoull(first);
+        if (start >= size) {
+            return ByteRangeResult::Unsatisfiable;
+        }
+        std::uint64_t end = last.empty() ? size - 1 : std::stoull(last);
+        if (end < start) {
+            return ByteRangeResult::None;
+        }
+        end = std::min(end, size - 1);
+        offset = start;
+        length = end - start + 1;
+        return ByteRangeResult::Satisfiable;
     } catch (...) {
-        extension.clear();
+        return ByteRangeResult::None;
     }
-    std::string mime_type = getMimeType(extension);
-    
-    // Build HTTP response
-    std::ostringstream response;
-    response << "HTTP/1.1 200 OK\r\n";
-    response << "Content-Type: " << mime_type << "\r\n";
-    response << "Content-Length: " << file_content.length() << "\r\n";
-    response << "Connection: close\r\n\r\n";
-    response << file_content;
-    
-    return response.str();
 }
 
-std::string RequestHandler::serveStaticFileWithStatus(const std::string& path, const std::string& status_line) {
+} // namespace
+
+HttpResponse RequestHandler::serveStaticFile(const std::string& path,
+                                             const std::map<std::string, std::string>& headers) {
+    return serveStaticFileWithStatus(path, 200, headers);
+}
+
+HttpResponse RequestHandler::serveStaticFileWithStatus(const std::string& path, int status,
+                                                       const std::map<std::string, std::string>& headers) {
+    // Hot path: web/ assets come from memory, already compressed
+    if (auto asset = static_assets_ ? static_assets_->find(path) : nullptr) {
+        std::shared_ptr<const std::string> data = asset->identity;
+        std::string encoding;
+        const std::string* accept_encoding = findHeaderValueCI(headers, "Accept-Encoding");
+        if (accept_encoding) {
+            if (asset->brotli && StaticAssetCache::acceptsEncoding(*accept_encoding, "br")) {
+                data = asset->brotli;
+                encoding = "br";
+            } else if (asset->gzip && StaticAssetCache::acceptsEncoding(*accept_encoding, "gzip")) {
+                data = asset->gzip;
+                encoding = "gzip";
+            }
+        }
+        // Each encoding is a different representation and needs its own strong ETag
+        std::string etag = asset->etag;
+        if (!encoding.empty()) {
+            etag.insert(etag.size() - 1, encoding == "br" ? "-br" : "-gz");
+        }
+
+        const std::string* if_none_match = findHeaderValueCI(headers, "If-None-Match");
+        const bool not_modified = status == 200 && if_none_match && etagListMatches(*if_none_match, etag);
+
+        HttpResponse res = not_modified ? HttpResponse::text(304, asset->content_type, "")
+                                        : HttpResponse::shared(status, asset->content_type, data);
+        if (!encoding.empty() && !not_modified) {
+            res.setHeader("Content-Encoding", encoding);
+        }
+        if (asset->gzip || asset->brotli) {
+            res.setHeader("Vary", "Accept-Encoding");
+        }
+        if (status == 200) {
+            res.setHeader("ETag", etag);
+            res.setHeader("Last-Modified", asset->last_modified);
+            res.setHeader("Cache-Control", asset->cache_control);
+        }
+        return res;
+    }
+
     // Prevent serving directories or special files (and keep behavior deterministic).
     try {
         fs::path p(path);
         if (!fs::exists(p) || !fs::is_regular_file(p)) {
             Logger::getInstance().warning("Static file not found or not a regular file: " + path);
-            return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n\r\n404 Not Found";
+            return HttpResponse::text(404, "text/plain", "404 Not Found");
         }
     } catch (...) {
-        // If filesystem probing fails, fall back to trying to open the file.
+        // If filesystem probing fails, the server reports a missing file when opening it.
     }
 
-    std::ifstream file(path, std::ios::binary);
-    if (!file.is_open()) {
-        Logger::getInstance().warning("File not found: " + path);
-        return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n\r\n404 Not Found";
-    }
-
-    std::ostringstream content;
-    content << file.rdbuf();
-    std::string file_content = content.str();
-
     // Determine MIME type (safe even when there's no extension)
     std::string extension;
     try {
@@ -2507,17 +2531,9 @@ std::string RequestHandler::serveStaticFileWithStatus(const std::string& path, c
     } catch (...) {
         extension.clear();
     }
-    std::string mime_type = getMimeType(extension);
-
-    // Build HTTP response
-    std::ostringstream response;
-    response << status_line << "\r\n";
-    response << "Content-Type: " << mime_type << "\r\n";
-    response << "Content-Length: " << file_content.length() << "\r\n";
-    response << "Connection: close\r\n\r\n";
-    response << file_content;
 
-    return response.str();
+    // The body is streamed from disk by the server, no copy is made here
+    return HttpResponse::file(path, getMimeType(extension), status);
 }
 
 std::string RequestHandler::getMimeType(const std::string& extension) {
@@ -2585,24 +2601,61 @@ std::string RequestHandler::extractSessionTokenFromHeaders(const std::map<std::s
 
 std::string RequestHandler::maybeInjectSessionToken(const std::string& body,
                                                     const std::map<std::string, std::string>& headers) {
-    std::map<std::string, std::string> data = JsonParser::parse(body);
-    std::string token = data.count("token") ? data["token"] : "";
-    if (token == kSessionTokenPlaceholder) {
-        token.clear();
-    }
-
-    const std::string header_token = extractSessionTokenFromHeaders(headers);
-    if (!header_token.empty()) {
-        data["token"] = header_token;
+    const JsonDocument doc(body);
+    const JsonValue root = doc.root();
+    bool flat = root.isObject();
+    root.forEachMember([&](std::string_view, const JsonValue& value) {
+        flat = flat && !value.isObject() && !value.isArray();
+    });
+    if (!flat) {
+        // Nested or malformed bodies keep the old flatten-and-restringify path,
+        // handlers behind it were written against that shape.
+        std::map<std::string, std::string> data = JsonParser::parse(body);
+        std::string token = data.count("token") ? data["token"] : "";
+        if (token == kSessionTokenPlaceholder) {
+            token.clear();
+        }
+        const std::string header_token = extractSessionTokenFromHeaders(headers);
+        if (!header_token.empty()) {
+            data["token"] = header_token;
+            return JsonParser::stringify(data);
+        }
+        if (token.empty()) {
+            return body;
+        }
+        data["token"] = token;
         return JsonParser::stringify(data);
     }
 
+    // A flat body already parses to the same map it would be re-serialised to,
+    // so without a header token there is nothing to change.
+    const std::string token = extractSessionTokenFromHeaders(headers);
     if (token.empty()) {
         return body;
     }
+    const JsonValue existing = root["token"];
 
-    data["token"] = token;
-    return JsonParser::stringify(data);
+    // Splice the token into the original text instead of re-serialising the
+    // whole body (uploads carry megabytes of base64 next to it).
+    const std::string member_value = "\"" + JsonParser::escapeJson(token) + "\"";
+    std::string result;
+    result.reserve(body.size() + member_value.size() + 16);
+    if (existing.valid()) {
+        const std::string_view raw = existing.raw();
+        const size_t offset = static_cast<size_t>(raw.data() - body.data());
+        result.append(body, 0, offset);
+        result += member_value;
+        result.append(body, offset + raw.size(), std::string::npos);
+    } else {
+        const size_t brace = static_cast<size_t>(root.raw().data() - body.data());
+        result.append(body, 0, brace + 1);
+        result += "\"token\":" + member_value;
+        if (root.size() > 0) {
+            result += ',';
+        }
+        result.append(body, brace + 1, std::string::npos);
+    }
+    return result;
 }
 
 bool RequestHandler::isSecureRequest(const std::map<std::string, std::string>& headers) const {
@@ -2632,18 +2685,14 @@ bool RequestHandler::isSecureRequest(const std::map<std::string, std::string>& h
     return false;
 }
 
-std::string RequestHandler::buildHttpJson(const std::string& body,
-                                          const std::map<std::string, std::string>& extra_headers) {
-    std::ostringstream oss;
-    oss << "HTTP/1.1 200 OK\r\n";
-    oss << "Content-Type: application/json\r\n";
-    oss << "Cache-Control: no-store\r\n";
+HttpResponse RequestHandler::buildHttpJson(std::string body,
+                                           const std::map<std::string, std::string>& extra_headers) {
+    HttpResponse res = HttpResponse::json(std::move(body));
+    res.setHeader("Cache-Control", "no-store");
     for (const auto& kv : extra_headers) {
-        oss << kv.first << ": " << kv.second << "\r\n";
+        res.addHeader(kv.first, kv.second);
     }
-    oss << "Content-Length: " << body.size() << "\r\n\r\n";
-    oss << body;
-    return oss.str();
+    return res;
 }
 
 std::map<std::string, std::string> RequestHandler::parseFormData(const std::string& body) {
@@ -2701,7 +2750,10 @@ std::string RequestHandler::handleAdminGetReports(const std::string& body, const
     if (page < 1) page = 1;
     if (page_size < 1) page_size = 20;
 
-    auto reports = db_manager_.getReportsPaginated(page, page_size, status_filter);
+    // before_id (id of the last report shown) pages by keyset instead of OFFSET
+    const std::string before_id = data.count("before_id") ? data.at("before_id") : "";
+    auto reports = before_id.empty() ? db_manager_.getReportsPaginated(page, page_size, status_filter)
+                                     : db_manager_.getReportsBefore(before_id, page_size, status_filter);
     long long total = db_manager_.countReports(status_filter);
     int total_pages = static_cast<int>(std::ceil(total / static_cast<double>(page_size)));
 
@@ -2711,6 +2763,8 @@ std::string RequestHandler::handleAdminGetReports(const std::string& body, const
         << "\"page_size\":" << page_size << ","
         << "\"total\":" << total << ","
         << "\"total_pages\":" << (total_pages < 1 ? 1 : total_pages) << ","
+        << "\"next_before_id\":\""
+        << (static_cast<int>(reports.size()) == page_size ? JsonParser::escapeJson(reports.back().id) : "") << "\","
         << "\"items\":[";
 
     bool first = true;
@@ -2907,7 +2961,7 @@ std::string RequestHandler::handleAdminUpdateReport(const std::string& body, con
         if (!db_manager_.setUserActive(report.reported_user_id, false)) {
             return JsonParser::createErrorResponse("Failed to ban user");
         }
-        db_manager_.deleteUserSessionsByUser(report.reported_user_id);
+        auth_manager_.revokeUserSessions(report.reported_user_id);
         status_to_set = "resolved";
         if (resolution_note.empty()) resolution_note = "User banned";
     } else if (action == "delete_message") {
@@ -2949,20 +3003,23 @@ std::string RequestHandler::handleGetFriends(const std::string& body) {
     
     auto friends = db_manager_.getFriends(user_id);
     
-    std::ostringstream oss;
-    oss << "{\"success\":true,\"friends\":[";
-    
-    bool first = true;
+    // Профиль, онлайн-статус и is_bot всех друзей — одним пайплайном
+    std::vector<std::string> friend_ids;
+    friend_ids.reserve(friends.size());
     for (const auto& friend_ : friends) {
-        if (!first) oss << ",";
-        first = false;
-        
-        // Получаем полную информацию о пользователе для is_bot
-        auto user = db_manager_.getUserById(friend_.id);
-        bool is_online = db_manager_.isUserOnline(friend_.id, 300);
-        std::string last_activity = db_manager_.getUserLastActivity(friend_.id);
-        UserProfile profile;
-        db_manager_.getUserProfile(friend_.id, profile);
+        friend_ids.push_back(friend_.id);
+    }
+    auto summaries = db_manager_.getPeerSummaries(friend_ids, 300);
+    
+    JsonWriter out(64 + friends.size() * 320);
+    out.beginObject().field("success", true).key("friends").beginArray();
+    
+    for (size_t i = 0; i < friends.size(); ++i) {
+        const auto& friend_ = friends[i];
+        const auto& user = summaries[i].user;
+        const auto& profile = summaries[i].profile;
+        const bool is_online = summaries[i].online;
+        const std::string& last_activity = summaries[i].last_activity;
         std::string display_name = profile.first_name;
         if (!profile.last_name.empty()) {
             if (!display_name.empty()) display_name += " ";
@@ -2970,19 +3027,21 @@ std::string RequestHandler::handleGetFriends(const std::string& body) {
         }
         if (display_name.empty()) display_name = friend_.username;
         
-        oss << "{\"id\":\"" << JsonParser::escapeJson(friend_.id) << "\","
-            << "\"username\":\"" << JsonParser::escapeJson(friend_.username) << "\","
-            << "\"display_name\":\"" << JsonParser::escapeJson(display_name) << "\","
-            << "\"avatar_url\":\"" << JsonParser::escapeJson(friend_.avatar_url) << "\","
-            << "\"is_bot\":" << (user.is_bot ? "true" : "false") << ","
-            << "\"is_premium\":" << (user.is_premium ? "true" : "false") << ","
-            << "\"online\":" << (is_online ? "true" : "false") << ","
-            << "\"last_activity\":\"" << JsonParser::escapeJson(last_activity) << "\","
-            << "\"created_at\":\"" << JsonParser::escapeJson(friend_.created_at) << "\"}";
+        out.beginObject()
+            .field("id", friend_.id)
+            .field("username", friend_.username)
+            .field("display_name", display_name)
+            .field("avatar_url", friend_.avatar_url)
+            .field("is_bot", user.is_bot)
+            .field("is_premium", user.is_premium)
+            .field("online", is_online)
+            .field("last_activity", last_activity)
+            .field("created_at", friend_.created_at)
+            .endObject();
     }
     
-    oss << "]}";
-    return oss.str();
+    out.endArray().endObject();
+    return out.take();
 }
 
 std::string RequestHandler::handleGetChats(const std::string& body) {
@@ -2998,16 +3057,21 @@ std::string RequestHandler::handleGetChats(const std::string& body) {
         return JsonParser::createErrorResponse("Invalid token");
     }
     
-    // Получаем всех пользователей, с которыми есть переписка (не только друзей)
-    auto chatPartners = db_manager_.getChatPartners(user_id);
+    // Все переписки (не только с друзьями) вместе с последним сообщением,
+    // счётчиком непрочитанных, профилем и онлайн-статусом — одним запросом
+    auto chats = db_manager_.getChatSummaries(user_id, 300);  // 5 minutes threshold
     
-    std::ostringstream oss;
-    oss << "{\"success\":true,\"chats\":[";
-    
-    bool first = true;
+    JsonWriter out(320 + chats.size() * 384);
+    out.beginObject().field("success", true).key("chats").beginArray();
     
     // Всегда добавляем избранные сообщения в начало списка
-    auto lastSavedMsg = db_manager_.getLastMessage(user_id, user_id);
+    Message lastSavedMsg;
+    for (const auto& chat : chats) {
+        if (chat.partner.id == user_id) {
+            lastSavedMsg = chat.last_message;
+            break;
+        }
+    }
     std::string time = "Нет сообщений";
     std::string lastMessage = "Нет сообщений";
     if (!lastSavedMsg.id.empty() && lastSavedMsg.created_at.length() >= 16) {
@@ -3015,65 +3079,58 @@ std::string RequestHandler::handleGetChats(const std::string& body) {
         lastMessage = lastSavedMsg.content;
     }
     
-    oss << "{\"id\":\"" << JsonParser::escapeJson(user_id) << "\","
-        << "\"name\":\"Избранные\","
-        << "\"display_name\":\"Избранные\","
-        << "\"avatar\":\"⭐\","
-        << "\"avatar_url\":\"\","
-        << "\"lastMessage\":\"" << JsonParser::escapeJson(lastMessage) << "\","
-        << "\"time\":\"" << time << "\","
-        << "\"unread\":0,"
-        << "\"online\":false,"
-        << "\"last_activity\":\"\","
-        << "\"is_saved_messages\":true}";
-    first = false;
-    
-    for (const auto& partner : chatPartners) {
+    out.beginObject()
+        .field("id", user_id)
+        .field("name", "Избранные")
+        .field("display_name", "Избранные")
+        .field("avatar", "⭐")
+        .field("avatar_url", "")
+        .field("lastMessage", lastMessage)
+        .field("time", time)
+        .field("unread", 0)
+        .field("online", false)
+        .field("last_activity", "")
+        .field("is_saved_messages", true)
+        .endObject();
+    
+    for (const auto& chat : chats) {
+        const auto& partner = chat.partner;
         // Пропускаем собственный ID, чтобы не дублировать чат "Избранные"
         if (partner.id == user_id) {
             continue;
         }
-        if (!first) oss << ",";
-        first = false;
-        
-        auto lastMsg = db_manager_.getLastMessage(user_id, partner.id);
-        int unread = db_manager_.getUnreadCount(user_id, partner.id);
         
+        const Message& lastMsg = chat.last_message;
         std::string time = "Нет сообщений";
         if (!lastMsg.id.empty() && lastMsg.created_at.length() >= 16) {
             time = lastMsg.created_at.substr(11, 5);
         }
         
-        bool is_online = db_manager_.isUserOnline(partner.id, 300);  // 5 minutes threshold
-        std::string last_activity = db_manager_.getUserLastActivity(partner.id);
-        
-        // Получаем полную информацию о пользователе для is_bot
-        auto user = db_manager_.getUserById(partner.id);
-        UserProfile profile;
-        db_manager_.getUserProfile(partner.id, profile);
-        std::string display_name = profile.first_name;
-        if (!profile.last_name.empty()) {
+        std::string display_name = chat.first_name;
+        if (!chat.last_name.empty()) {
             if (!display_name.empty()) display_name += " ";
-            display_name += profile.last_name;
+            display_name += chat.last_name;
         }
         if (display_name.empty()) display_name = partner.username;
         
-        oss << "{\"id\":\"" << JsonParser::escapeJson(partner.id) << "\","
-            << "\"name\":\"" << JsonParser::escapeJson(partner.username) << "\","
-            << "\"display_name\":\"" << JsonParser::escapeJson(display_name) << "\","
-            << "\"avatar\":\"" << (partner.username.empty() ? "U" : std::string(1, partner.username[0])) << "\","
-            << "\"avatar_url\":\"" << JsonParser::escapeJson(partner.avatar_url) << "\","
-            << "\"lastMessage\":\"" << JsonParser::escapeJson(lastMsg.content) << "\","
-            << "\"time\":\"" << time << "\","
-            << "\"unread\":" << unread << ","
-            << "\"is_bot\":" << (user.is_bot ? "true" : "false") << ","
-            << "\"is_premium\":" << (user.is_premium ? "true" : "false") << ","
-            << "\"online\":" << (is_online ? "true" : "false") << ","
-            << "\"last_activity\":\"" << JsonParser::escapeJson(last_activity) << "\"}";
-    }
-    
-    oss << "]}";
-    return oss.str();
+        out.beginObject()
+            .field("id", partner.id)
+            .field("name", partner.username)
+            .field("display_name", display_name)
+            .field("avatar", partner.username.empty() ? std::string_view("U") : std::string_view(partner.username).substr(0, 1))
+            .field("avatar_url", partner.avatar_url)
+            .field("lastMessage", lastMsg.content)
+            .field("time", time)
+            .field("unread", chat.unread)
+            .field("is_bot", chat.is_bot)
+            .field("is_premium", chat.is_premium)
+            .field("online", chat.online)
+            .field("last_activity", chat.last_activity)
+            .endObject();
+    }
+    
+    out.endArray().endObject();
+    return out.take();
 }
 
 std::string RequestHandler::handleGetChatPins(const std::string& body) {
@@ -3709,7 +3766,7 @@ bool RequestHandler::sendPremiumGiftMessage(const PremiumPayment& payment) {
     return true;
 }
 
-std::string RequestHandler::handleYooMoneyNotification(const std::string& body) {
+HttpResponse RequestHandler::handleYooMoneyNotification(const std::string& body) {
     auto data = parseFormData(body);
     auto getField = [&](const std::string& key) -> std::string {
         auto it = data.find(key);
@@ -3806,7 +3863,7 @@ std::string RequestHandler::handleYooMoneyNotification(const std::string& body)
     return buildHttpResponse(200, JsonParser::createSuccessResponse("OK"), "application/json");
 }
 
-std::string RequestHandler::handleStripeWebhook(const std::string& body, const std::map<std::string, std::string>& headers) {
+HttpResponse RequestHandler::handleStripeWebhook(const std::string& body, const std::map<std::string, std::string>& headers) {
     const char* secret_env = std::getenv("XIPHER_STRIPE_WEBHOOK_SECRET");
     if (!secret_env || std::string(secret_env).empty()) {
         secret_env = std::getenv("STRIPE_WEBHOOK_SECRET");
@@ -3968,7 +4025,9 @@ std::string RequestHandler::handleGetMessages(const std::string& body) {
     //     return JsonParser::createErrorResponse("Cannot get messages with yourself");
     // }
     
-    auto messages = db_manager_.getMessages(user_id, friend_id, 50);
+    const HistoryPage page = parseHistoryPage(data);
+    auto messages = db_manager_.getMessages(user_id, friend_id, page.limit + 1, page.before_id, page.after_id);
+    const bool has_more = trimHistoryPage(messages, page);
     if (user_id != friend_id) {
         db_manager_.markMessagesAsDelivered(user_id, friend_id);
     }
@@ -3987,15 +4046,44 @@ std::string RequestHandler::handleGetMessages(const std::string& body) {
     for (const auto& msg : messages) {
         messageMap[msg.id] = &msg;
     }
+    // Replies to messages outside this page, fetched in one round-trip
+    std::vector<std::string> missing_reply_ids;
+    for (const auto& msg : messages) {
+        if (!msg.reply_to_message_id.empty() && messageMap.count(msg.reply_to_message_id) == 0 &&
+            std::find(missing_reply_ids.begin(), missing_reply_ids.end(), msg.reply_to_message_id) == missing_reply_ids.end()) {
+            missing_reply_ids.push_back(msg.reply_to_message_id);
+        }
+    }
+    std::vector<Message> fetchedReplies = db_manager_.getMessagesByIds(missing_reply_ids);
+    for (const auto& reply : fetchedReplies) {
+        if (!reply.id.empty()) {
+            messageMap.emplace(reply.id, &reply);
+        }
+    }
+    // Usernames of every replied-to sender, again in one round-trip
+    std::vector<std::string> reply_sender_ids;
+    for (const auto& msg : messages) {
+        if (msg.reply_to_message_id.empty()) continue;
+        auto it = messageMap.find(msg.reply_to_message_id);
+        if (it != messageMap.end() &&
+            std::find(reply_sender_ids.begin(), reply_sender_ids.end(), it->second->sender_id) == reply_sender_ids.end()) {
+            reply_sender_ids.push_back(it->second->sender_id);
+        }
+    }
+    std::unordered_map<std::string, std::string> replySenderNames;
+    {
+        auto replyUsers = db_manager_.getUsersByIds(reply_sender_ids);
+        for (size_t i = 0; i < replyUsers.size(); ++i) {
+            if (!replyUsers[i].id.empty()) {
+                replySenderNames[reply_sender_ids[i]] = replyUsers[i].username;
+            }
+        }
+    }
     
-    std::ostringstream oss;
-    oss << "{\"success\":true,\"messages\":[";
+    JsonWriter out(64 + messages.size() * 512);
+    out.beginObject().field("success", true).field("has_more", has_more).key("messages").beginArray();
     
-    bool first = true;
     for (const auto& msg : messages) {
-        if (!first) oss << ",";
-        first = false;
-        
         std::string time = msg.created_at.length() >= 16 ? msg.created_at.substr(11, 5) : "";
         bool isSent = (msg.sender_id == user_id);
         bool canExposeRead = !isSent || peer_allows_read_receipts;
@@ -4018,44 +4106,35 @@ std::string RequestHandler::handleGetMessages(const std::string& body) {
             if (it != messageMap.end()) {
                 const Message* replyMsg = it->second;
                 reply_content = replyMsg->content.length() > 100 ? replyMsg->content.substr(0, 100) + "..." : replyMsg->content;
-                // Get sender username
-                User replyUser = db_manager_.getUserById(replyMsg->sender_id);
-                if (!replyUser.id.empty()) {
-                    reply_sender_name = replyUser.username;
-                }
-            } else {
-                // Message not in current batch, fetch from DB
-                Message replyMsg = db_manager_.getMessageById(msg.reply_to_message_id);
-                if (!replyMsg.id.empty()) {
-                    reply_content = replyMsg.content.length() > 100 ? replyMsg.content.substr(0, 100) + "..." : replyMsg.content;
-                    User replyUser = db_manager_.getUserById(replyMsg.sender_id);
-                    if (!replyUser.id.empty()) {
-                        reply_sender_name = replyUser.username;
-                    }
+                auto name_it = replySenderNames.find(replyMsg->sender_id);
+                if (name_it != replySenderNames.end()) {
+                    reply_sender_name = name_it->second;
                 }
             }
         }
         
-        oss << "{\"id\":\"" << JsonParser::escapeJson(msg.id) << "\","
-            << "\"sender_id\":\"" << JsonParser::escapeJson(msg.sender_id) << "\","
-            << "\"sent\":" << (isSent ? "true" : "false") << ","
-            << "\"status\":\"" << JsonParser::escapeJson(status) << "\","
-            << "\"is_read\":" << ((canExposeRead && msg.is_read) ? "true" : "false") << ","
-            << "\"is_delivered\":" << (msg.is_delivered ? "true" : "false") << ","
-            << "\"content\":\"" << JsonParser::escapeJson(msg.content) << "\","
-            << "\"message_type\":\"" << JsonParser::escapeJson(msg.message_type) << "\","
-            << "\"file_path\":\"" << JsonParser::escapeJson(msg.file_path) << "\","
-            << "\"file_name\":\"" << JsonParser::escapeJson(msg.file_name) << "\","
-            << "\"file_size\":" << msg.file_size << ","
-            << "\"reply_to_message_id\":\"" << JsonParser::escapeJson(msg.reply_to_message_id) << "\","
-            << "\"reply_content\":\"" << JsonParser::escapeJson(reply_content) << "\","
-            << "\"reply_sender_name\":\"" << JsonParser::escapeJson(reply_sender_name) << "\","
-            << "\"time\":\"" << time << "\","
-            << "\"is_pinned\":" << (msg.is_pinned ? "true" : "false") << "}";
-    }
-    
-    oss << "]}";
-    return oss.str();
+        out.beginObject()
+            .field("id", msg.id)
+            .field("sender_id", msg.sender_id)
+            .field("sent", isSent)
+            .field("status", status)
+            .field("is_read", canExposeRead && msg.is_read)
+            .field("is_delivered", msg.is_delivered)
+            .field("content", msg.content)
+            .field("message_type", msg.message_type)
+            .field("file_path", msg.file_path)
+            .field("file_name", msg.file_name)
+            .field("file_size", msg.file_size)
+            .field("reply_to_message_id", msg.reply_to_message_id)
+            .field("reply_content", reply_content)
+            .field("reply_sender_name", reply_sender_name)
+            .field("time", time)
+            .field("is_pinned", msg.is_pinned)
+            .endObject();
+    }
+    
+    out.endArray().endObject();
+    return out.take();
 }
 
 std::string RequestHandler::handleSendMessage(const std::string& body) {
@@ -4566,7 +4645,7 @@ std::string RequestHandler::handleCreateReport(const std::string& body) {
             if (ban_on_threshold) {
                 banned = db_manager_.setUserActive(reported_user_id, false);
                 if (banned) {
-                    db_manager_.deleteUserSessionsByUser(reported_user_id);
+                    auth_manager_.revokeUserSessions(reported_user_id);
                 }
             }
 
@@ -5650,10 +5729,12 @@ std::string RequestHandler::handleGetSfuRoom(const std::string& body) {
 }
 
 std::string RequestHandler::handleUploadFile(const std::string& body, const std::map<std::string, std::string>& /*headers*/) {
-    auto data = JsonParser::parse(body);
-    std::string token = data["token"];
-    std::string file_data = data["file_data"];  // base64 encoded
-    std::string file_name = data["file_name"];
+    // Index only: the multi-megabyte file_data string is copied once, on read
+    const JsonDocument doc(body);
+    const JsonValue data = doc.root();
+    std::string token = data["token"].asString();
+    std::string file_data = data["file_data"].asString();  // base64 encoded
+    std::string file_name = data["file_name"].asString();
     
     if (token.empty() || file_data.empty() || file_name.empty()) {
         return JsonParser::createErrorResponse("Token, file_data and file_name required");
@@ -5769,9 +5850,10 @@ std::string RequestHandler::handleUploadFile(const std::string& body, const std:
 }
 
 std::string RequestHandler::handleUploadVoice(const std::string& body, const std::map<std::string, std::string>& /*headers*/) {
-    auto data = JsonParser::parse(body);
-    std::string token = data["token"];
-    std::string voice_data = data["voice_data"];  // base64 encoded
+    const JsonDocument doc(body);
+    const JsonValue data = doc.root();
+    std::string token = data["token"].asString();
+    std::string voice_data = data["voice_data"].asString();  // base64 encoded
     
     if (token.empty() || voice_data.empty()) {
         return JsonParser::createErrorResponse("Token and voice_data required");
@@ -5796,8 +5878,8 @@ std::string RequestHandler::handleUploadVoice(const std::string& body, const std
     
     // Determine file extension based on MIME type if provided, default to .ogg
     std::string file_ext = ".ogg";
-    if (data.find("mime_type") != data.end()) {
-        std::string mime_type = data["mime_type"];
+    if (data.has("mime_type")) {
+        std::string mime_type = data["mime_type"].asString();
         if (mime_type.find("webm") != std::string::npos) {
             file_ext = ".webm";
         } else if (mime_type.find("mp4") != std::string::npos) {
@@ -5879,38 +5961,99 @@ std::string RequestHandler::handleUploadVoice(const std::string& body, const std
     return oss.str();
 }
 
-std::string RequestHandler::handleGetFile(const std::string& path) {
+HttpResponse RequestHandler::serveFileWithValidators(const std::string& file_path,
+                                                     const std::string& mime_type,
+                                                     const std::map<std::string, std::string>& headers) {
+    boost::system::error_code ec;
+    const std::uint64_t size = fs::file_size(file_path, ec);
+    const std::time_t mtime = ec ? 0 : fs::last_write_time(file_path, ec);
+    if (ec) {
+        return HttpResponse::text(404, "text/plain", "File not found");
+    }
+
+    std::ostringstream etag_stream;
+    etag_stream << '"' << std::hex << size << '-' << static_cast<std::uint64_t>(mtime) << '"';
+    const std::string etag = etag_stream.str();
+    const std::string last_modified = formatHttpDate(mtime);
+
+    auto withValidators = [&](HttpResponse res) {
+        res.setHeader("ETag", etag);
+        res.setHeader("Last-Modified", last_modified);
+        res.setHeader("Accept-Ranges", "bytes");
+        res.setHeader("Access-Control-Allow-Origin", "*");
+        res.setHeader("Cache-Control", "public, max-age=31536000");
+        return res;
+    };
+
+    // Conditional GET: If-None-Match takes precedence over If-Modified-Since
+    const std::string* if_none_match = findHeaderValueCI(headers, "If-None-Match");
+    if (if_none_match) {
+        if (etagListMatches(*if_none_match, etag)) {
+            return withValidators(HttpResponse::text(304, mime_type, ""));
+        }
+    } else if (const std::string* if_modified_since = findHeaderValueCI(headers, "If-Modified-Since")) {
+        std::time_t since = 0;
+        if (parseHttpDate(*if_modified_since, since) && mtime <= since) {
+            return withValidators(HttpResponse::text(304, mime_type, ""));
+        }
+    }
+
+    const std::string* range = findHeaderValueCI(headers, "Range");
+    if (range) {
+        // If-Range: a stale validator means the client must get the whole file
+        bool range_allowed = true;
+        if (const std::string* if_range = findHeaderValueCI(headers, "If-Range")) {
+            std::time_t since = 0;
+            if (!if_range->empty() && (*if_range)[0] == '"') {
+                range_allowed = *if_range == etag;
+            } else {
+                range_allowed = parseHttpDate(*if_range, since) && mtime <= since;
+            }
+        }
+
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+        const ByteRangeResult result = range_allowed ? parseByteRange(*range, size, offset, length)
+                                                     : ByteRangeResult::None;
+        if (result == ByteRangeResult::Unsatisfiable) {
+            HttpResponse res = withValidators(HttpResponse::text(416, "text/plain", "Range Not Satisfiable"));
+            res.setHeader("Content-Range", "bytes */" + std::to_string(size));
+            return res;
+        }
+        if (result == ByteRangeResult::Satisfiable) {
+            HttpResponse res = withValidators(HttpResponse::fileRange(file_path, mime_type, offset, length));
+            res.setHeader("Content-Range", "bytes " + std::to_string(offset) + "-" +
+                                           std::to_string(offset + length - 1) + "/" + std::to_string(size));
+            return res;
+        }
+    }
+
+    return withValidators(HttpResponse::file(file_path, mime_type));
+}
+
+HttpResponse RequestHandler::handleGetFile(const std::string& path, const std::map<std::string, std::string>& headers) {
     // Path format: /files/filename
     std::string filename = path.substr(7);  // Remove "/files/"
     
     // Security: Validate filename to prevent path traversal
     if (!isValidFilename(filename)) {
         Logger::getInstance().warning("Path traversal attempt blocked in handleGetFile: " + filename);
-        return "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\n\r\nInvalid filename";
+        return HttpResponse::text(400, "text/plain", "Invalid filename");
     }
     
     std::string file_path = "/root/xipher/uploads/files/" + filename;
     bool is_voice_file = false;
     
     // Also check voices directory
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file.is_open()) {
+    boost::system::error_code ec;
+    if (!fs::is_regular_file(file_path, ec)) {
         file_path = "/root/xipher/uploads/voices/" + filename;
-        file.open(file_path, std::ios::binary);
-        if (file.is_open()) {
-            is_voice_file = true;
+        if (!fs::is_regular_file(file_path, ec)) {
+            return HttpResponse::text(404, "text/plain", "File not found");
         }
+        is_voice_file = true;
     }
     
-    if (!file.is_open()) {
-        return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n\r\nFile not found";
-    }
-    
-    std::ostringstream content;
-    content << file.rdbuf();
-    std::string file_content = content.str();
-    file.close();
-    
     // Determine MIME type
     std::string extension = "";
     size_t dot_pos = file_path.find_last_of('.');
@@ -5930,67 +6073,40 @@ std::string RequestHandler::handleGetFile(const std::string& path) {
         }
     }
     
-    // Build HTTP response with CORS headers for images/videos
-    std::ostringstream response;
-    response << "HTTP/1.1 200 OK\r\n";
-    response << "Content-Type: " << mime_type << "\r\n";
-    response << "Content-Length: " << file_content.length() << "\r\n";
-    response << "Access-Control-Allow-Origin: *\r\n";
-    response << "Cache-Control: public, max-age=31536000\r\n";
-    response << "Connection: close\r\n\r\n";
-    response << file_content;
-    
-    return response.str();
+    // Range requests let the web player seek inside voice and video files
+    return serveFileWithValidators(file_path, mime_type, headers);
 }
 
-std::string RequestHandler::handleGetAvatar(const std::string& path) {
+HttpResponse RequestHandler::handleGetAvatar(const std::string& path, const std::map<std::string, std::string>& headers) {
     // Path format: /avatars/filename
     std::string filename = path.substr(9);  // Remove "/avatars/"
     
     // Security: Validate filename to prevent path traversal
     if (!isValidFilename(filename)) {
         Logger::getInstance().warning("Path traversal attempt blocked in handleGetAvatar: " + filename);
-        return "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\n\r\nInvalid filename";
+        return HttpResponse::text(400, "text/plain", "Invalid filename");
     }
     
     // Try primary location first
     std::string file_path = "/var/www/xipher/uploads/avatars/" + filename;
-    std::ifstream file(file_path, std::ios::binary);
+    boost::system::error_code ec;
     
     // Fallback to alternative location
-    if (!file.is_open()) {
+    if (!fs::is_regular_file(file_path, ec)) {
         file_path = "/root/xipher/uploads/avatars/" + filename;
-        file.open(file_path, std::ios::binary);
-    }
-    
-    if (!file.is_open()) {
-        return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n\r\nAvatar not found";
+        if (!fs::is_regular_file(file_path, ec)) {
+            return HttpResponse::text(404, "text/plain", "Avatar not found");
+        }
     }
     
-    std::ostringstream content;
-    content << file.rdbuf();
-    std::string file_content = content.str();
-    file.close();
-    
     // Determine MIME type
     std::string extension = "";
     size_t dot_pos = file_path.find_last_of('.');
     if (dot_pos != std::string::npos) {
         extension = file_path.substr(dot_pos);
     }
-    std::string mime_type = getMimeType(extension);
-    
-    // Build HTTP response with CORS headers
-    std::ostringstream response;
-    response << "HTTP/1.1 200 OK\r\n";
-    response << "Content-Type: " << mime_type << "\r\n";
-    response << "Content-Length: " << file_content.length() << "\r\n";
-    response << "Access-Control-Allow-Origin: *\r\n";
-    response << "Cache-Control: public, max-age=31536000\r\n";
-    response << "Connection: close\r\n\r\n";
-    response << file_content;
     
-    return response.str();
+    return serveFileWithValidators(file_path, getMimeType(extension), headers);
 }
 
 std::string RequestHandler::base64Decode(const std::string& encoded) {
@@ -7319,28 +7435,26 @@ std::string RequestHandler::handleGetGroups(const std::string& body) {
     
     auto groups = db_manager_.getUserGroups(user_id);
     
-    std::ostringstream oss;
-    oss << "{\"success\":true,\"groups\":[";
+    JsonWriter out(64 + groups.size() * 256);
+    out.beginObject().field("success", true).key("groups").beginArray();
     
-    bool first = true;
     for (const auto& group : groups) {
-        if (!first) oss << ",";
-        first = false;
-        
         // Get user's role in this group
         auto member = db_manager_.getGroupMember(group.id, user_id);
         std::string user_role = member.user_id.empty() ? "none" : member.role;
         
-        oss << "{\"id\":\"" << JsonParser::escapeJson(group.id) << "\","
-            << "\"name\":\"" << JsonParser::escapeJson(group.name) << "\","
-            << "\"description\":\"" << JsonParser::escapeJson(group.description) << "\","
-            << "\"creator_id\":\"" << JsonParser::escapeJson(group.creator_id) << "\","
-            << "\"user_role\":\"" << JsonParser::escapeJson(user_role) << "\","
-            << "\"created_at\":\"" << JsonParser::escapeJson(group.created_at) << "\"}";
+        out.beginObject()
+            .field("id", group.id)
+            .field("name", group.name)
+            .field("description", group.description)
+            .field("creator_id", group.creator_id)
+            .field("user_role", user_role)
+            .field("created_at", group.created_at)
+            .endObject();
     }
     
-    oss << "]}";
-    return oss.str();
+    out.endArray().endObject();
+    return out.take();
 }
 
 std::string RequestHandler::handleGetGroupMembers(const std::string& body) {
@@ -7366,40 +7480,31 @@ std::string RequestHandler::handleGetGroupMembers(const std::string& body) {
     // Получаем список участников группы
     auto members = db_manager_.getGroupMembers(group_id);
     
-    std::ostringstream oss;
-    oss << "{\"success\":true,\"members\":[";
+    JsonWriter out(64 + members.size() * 256);
+    out.beginObject().field("success", true).key("members").beginArray();
     
-    bool first = true;
     for (const auto& m : members) {
-        if (!first) oss << ",";
-        first = false;
-        oss << "{\"id\":\"" << JsonParser::escapeJson(m.id) << "\","
-            << "\"user_id\":\"" << JsonParser::escapeJson(m.user_id) << "\","
-            << "\"username\":\"" << JsonParser::escapeJson(m.username) << "\","
-            << "\"role\":\"" << JsonParser::escapeJson(m.role) << "\","
-            << "\"permissions\":" << (m.permissions.empty() ? "{}" : m.permissions) << ","
-            << "\"is_muted\":" << (m.is_muted ? "true" : "false") << ","
-            << "\"is_banned\":" << (m.is_banned ? "true" : "false") << ","
-            << "\"joined_at\":\"" << JsonParser::escapeJson(m.joined_at) << "\"}";
+        out.beginObject()
+            .field("id", m.id)
+            .field("user_id", m.user_id)
+            .field("username", m.username)
+            .field("role", m.role)
+            .rawField("permissions", m.permissions.empty() ? std::string_view("{}") : std::string_view(m.permissions))
+            .field("is_muted", m.is_muted)
+            .field("is_banned", m.is_banned)
+            .field("joined_at", m.joined_at)
+            .endObject();
     }
     
-    oss << "]}";
-    return oss.str();
+    out.endArray().endObject();
+    return out.take();
 }
 
 std::string RequestHandler::handleGetGroupMessages(const std::string& body) {
     auto data = JsonParser::parse(body);
     std::string token = data["token"];
     std::string group_id = data["group_id"];
-    int limit = 50;
-    if (data.find("limit") != data.end()) {
-        try {
-            limit = std::stoi(data["limit"]);
-            if (limit < 1 || limit > 100) limit = 50;
-        } catch (...) {
-            limit = 50;
-        }
-    }
+    const HistoryPage page = parseHistoryPage(data);
     
     if (token.empty() || group_id.empty()) {
         return JsonParser::createErrorResponse("Token and group_id required");
@@ -7416,39 +7521,38 @@ std::string RequestHandler::handleGetGroupMessages(const std::string& body) {
         return JsonParser::createErrorResponse("You are not a member of this group");
     }
     
-    auto messages = db_manager_.getGroupMessages(group_id, limit);
+    auto messages = db_manager_.getGroupMessages(group_id, page.limit + 1, page.before_id, page.after_id);
+    const bool has_more = trimHistoryPage(messages, page);
     
-    std::ostringstream oss;
-    oss << "{\"success\":true,\"messages\":[";
+    JsonWriter out(64 + messages.size() * 512);
+    out.beginObject().field("success", true).field("has_more", has_more).key("messages").beginArray();
     
-    bool first = true;
     for (const auto& msg : messages) {
-        if (!first) oss << ",";
-        first = false;
-        
         std::string time = msg.created_at.length() >= 16 ? msg.created_at.substr(11, 5) : "";
         bool isSent = (msg.sender_id == user_id);
         
-        oss << "{\"id\":\"" << JsonParser::escapeJson(msg.id) << "\","
-            << "\"group_id\":\"" << JsonParser::escapeJson(msg.group_id) << "\","
-            << "\"sender_id\":\"" << JsonParser::escapeJson(msg.sender_id) << "\","
-            << "\"sender_username\":\"" << JsonParser::escapeJson(msg.sender_username) << "\","
-            << "\"sent\":" << (isSent ? "true" : "false") << ","
-            << "\"content\":\"" << JsonParser::escapeJson(msg.content) << "\","
-            << "\"message_type\":\"" << JsonParser::escapeJson(msg.message_type) << "\","
-            << "\"file_path\":\"" << JsonParser::escapeJson(msg.file_path) << "\","
-            << "\"file_name\":\"" << JsonParser::escapeJson(msg.file_name) << "\","
-            << "\"file_size\":" << msg.file_size << ","
-            << "\"reply_to_message_id\":\"" << JsonParser::escapeJson(msg.reply_to_message_id) << "\","
-            << "\"forwarded_from_user_id\":\"" << JsonParser::escapeJson(msg.forwarded_from_user_id) << "\","
-            << "\"forwarded_from_username\":\"" << JsonParser::escapeJson(msg.forwarded_from_username) << "\","
-            << "\"forwarded_from_message_id\":\"" << JsonParser::escapeJson(msg.forwarded_from_message_id) << "\","
-            << "\"is_pinned\":" << (msg.is_pinned ? "true" : "false") << ","
-            << "\"time\":\"" << time << "\"}";
-    }
-    
-    oss << "]}";
-    return oss.str();
+        out.beginObject()
+            .field("id", msg.id)
+            .field("group_id", msg.group_id)
+            .field("sender_id", msg.sender_id)
+            .field("sender_username", msg.sender_username)
+            .field("sent", isSent)
+            .field("content", msg.content)
+            .field("message_type", msg.message_type)
+            .field("file_path", msg.file_path)
+            .field("file_name", msg.file_name)
+            .field("file_size", msg.file_size)
+            .field("reply_to_message_id", msg.reply_to_message_id)
+            .field("forwarded_from_user_id", msg.forwarded_from_user_id)
+            .field("forwarded_from_username", msg.forwarded_from_username)
+            .field("forwarded_from_message_id", msg.forwarded_from_message_id)
+            .field("is_pinned", msg.is_pinned)
+            .field("time", time)
+            .endObject();
+    }
+    
+    out.endArray().endObject();
+    return out.take();
 }
 
 std::string RequestHandler::handleSendGroupMessage(const std::string& body) {
@@ -8228,26 +8332,25 @@ std::string RequestHandler::handleGetChannels(const std::string& body) {
         channels.push_back(c);
     }
     
-    std::ostringstream oss;
-    oss << "{\"success\":true,\"channels\":[";
+    JsonWriter out(64 + channels.size() * 320);
+    out.beginObject().field("success", true).key("channels").beginArray();
     
-    bool first = true;
     for (const auto& channel : channels) {
-        if (!first) oss << ",";
-        first = false;
-        oss << "{\"id\":\"" << JsonParser::escapeJson(channel.id) << "\","
-            << "\"name\":\"" << JsonParser::escapeJson(channel.name) << "\","
-            << "\"description\":\"" << JsonParser::escapeJson(channel.description) << "\","
-            << "\"custom_link\":\"" << JsonParser::escapeJson(channel.custom_link) << "\","
-            << "\"avatar_url\":\"" << JsonParser::escapeJson(channel.avatar_url) << "\","
-            << "\"is_private\":" << (channel.is_private ? "true" : "false") << ","
-            << "\"is_verified\":" << (channel.is_verified ? "true" : "false") << ","
-            << "\"show_author\":" << (channel.show_author ? "true" : "false") << ","
-            << "\"created_at\":\"" << JsonParser::escapeJson(channel.created_at) << "\"}";
+        out.beginObject()
+            .field("id", channel.id)
+            .field("name", channel.name)
+            .field("description", channel.description)
+            .field("custom_link", channel.custom_link)
+            .field("avatar_url", channel.avatar_url)
+            .field("is_private", channel.is_private)
+            .field("is_verified", channel.is_verified)
+            .field("show_author", channel.show_author)
+            .field("created_at", channel.created_at)
+            .endObject();
     }
     
-    oss << "]}";
-    return oss.str();
+    out.endArray().endObject();
+    return out.take();
 }
 
 std::string RequestHandler::handlePublicDirectory(const std::string& body) {
@@ -8423,16 +8526,9 @@ std::string RequestHandler::handleGetChannelMessages(const std::string& body) {
     auto data = JsonParser::parse(body);
     std::string token = data["token"];
     std::string channel_id = data["channel_id"];
-    int limit = 50;
+    const HistoryPage page = parseHistoryPage(data);
+    const int limit = page.limit;
     long long offset_local = 0;
-    if (data.find("limit") != data.end()) {
-        try {
-            limit = std::stoi(data["limit"]);
-            if (limit < 1 || limit > 100) limit = 50;
-        } catch (...) {
-            limit = 50;
-        }
-    }
     if (data.find("offset_id") != data.end()) {
         try {
             offset_local = std::stoll(data["offset_id"]);
@@ -8461,30 +8557,29 @@ std::string RequestHandler::handleGetChannelMessages(const std::string& body) {
             return JsonParser::createErrorResponse("You are not subscribed to this channel or are banned");
         }
         auto messages = db_manager_.getChannelMessagesV2(channel_id, offset_local, limit);
-        std::ostringstream oss;
-        oss << "{\"success\":true,\"messages\":[";
-        bool first = true;
+        JsonWriter out(64 + messages.size() * 448);
+        out.beginObject().field("success", true).key("messages").beginArray();
         for (const auto& msg : messages) {
-            if (!first) oss << ",";
-            first = false;
             std::string time = msg.created_at.length() >= 16 ? msg.created_at.substr(11, 5) : "";
-            oss << "{\"id\":\"" << JsonParser::escapeJson(msg.id) << "\","
-                << "\"local_id\":" << msg.local_id << ","
-                << "\"channel_id\":\"" << JsonParser::escapeJson(msg.channel_id) << "\","
-                << "\"sender_id\":\"" << JsonParser::escapeJson(msg.sender_id) << "\","
-                << "\"sender_username\":\"" << JsonParser::escapeJson(msg.sender_username) << "\","
-                << "\"content\":\"" << JsonParser::escapeJson(msg.content) << "\","
-                << "\"message_type\":\"" << JsonParser::escapeJson(msg.message_type) << "\","
-                << "\"file_path\":\"" << JsonParser::escapeJson(msg.file_path) << "\","
-                << "\"file_name\":\"" << JsonParser::escapeJson(msg.file_name) << "\","
-                << "\"file_size\":" << msg.file_size << ","
-                << "\"is_pinned\":" << (msg.is_pinned ? "true" : "false") << ","
-                << "\"views_count\":" << msg.views_count << ","
-                << "\"is_silent\":" << (msg.is_silent ? "true" : "false") << ","
-                << "\"time\":\"" << time << "\"}";
-        }
-        oss << "]}";
-        return oss.str();
+            out.beginObject()
+                .field("id", msg.id)
+                .field("local_id", msg.local_id)
+                .field("channel_id", msg.channel_id)
+                .field("sender_id", msg.sender_id)
+                .field("sender_username", msg.sender_username)
+                .field("content", msg.content)
+                .field("message_type", msg.message_type)
+                .field("file_path", msg.file_path)
+                .field("file_name", msg.file_name)
+                .field("file_size", msg.file_size)
+                .field("is_pinned", msg.is_pinned)
+                .field("views_count", msg.views_count)
+                .field("is_silent", msg.is_silent)
+                .field("time", time)
+                .endObject();
+        }
+        out.endArray().endObject();
+        return out.take();
     }
 
     // Legacy channel tables
@@ -8493,34 +8588,33 @@ std::string RequestHandler::handleGetChannelMessages(const std::string& body) {
         return JsonParser::createErrorResponse("You are not subscribed to this channel or are banned");
     }
     
-    auto messages = db_manager_.getChannelMessages(channel_id, limit);
+    auto messages = db_manager_.getChannelMessages(channel_id, limit + 1, page.before_id, page.after_id);
+    const bool has_more = trimHistoryPage(messages, page);
     
-    std::ostringstream oss;
-    oss << "{\"success\":true,\"messages\":[";
+    JsonWriter out(64 + messages.size() * 448);
+    out.beginObject().field("success", true).field("has_more", has_more).key("messages").beginArray();
     
-    bool first = true;
     for (const auto& msg : messages) {
-        if (!first) oss << ",";
-        first = false;
-        
         std::string time = msg.created_at.length() >= 16 ? msg.created_at.substr(11, 5) : "";
         
-        oss << "{\"id\":\"" << JsonParser::escapeJson(msg.id) << "\","
-            << "\"channel_id\":\"" << JsonParser::escapeJson(msg.channel_id) << "\","
-            << "\"sender_id\":\"" << JsonParser::escapeJson(msg.sender_id) << "\","
-            << "\"sender_username\":\"" << JsonParser::escapeJson(msg.sender_username) << "\","
-            << "\"content\":\"" << JsonParser::escapeJson(msg.content) << "\","
-            << "\"message_type\":\"" << JsonParser::escapeJson(msg.message_type) << "\","
-            << "\"file_path\":\"" << JsonParser::escapeJson(msg.file_path) << "\","
-            << "\"file_name\":\"" << JsonParser::escapeJson(msg.file_name) << "\","
-            << "\"file_size\":" << msg.file_size << ","
-            << "\"is_pinned\":" << (msg.is_pinned ? "true" : "false") << ","
-            << "\"views_count\":" << msg.views_count << ","
-            << "\"time\":\"" << time << "\"}";
-    }
-    
-    oss << "]}";
-    return oss.str();
+        out.beginObject()
+            .field("id", msg.id)
+            .field("channel_id", msg.channel_id)
+            .field("sender_id", msg.sender_id)
+            .field("sender_username", msg.sender_username)
+            .field("content", msg.content)
+            .field("message_type", msg.message_type)
+            .field("file_path", msg.file_path)
+            .field("file_name", msg.file_name)
+            .field("file_size", msg.file_size)
+            .field("is_pinned", msg.is_pinned)
+            .field("views_count", msg.views_count)
+            .field("time", time)
+            .endObject();
+    }
+    
+    out.endArray().endObject();
+    return out.take();
 }
 
 std::string RequestHandler::handleSendChannelMessage(const std::string& body) {
@@ -10231,13 +10325,13 @@ std::string RequestHandler::handleSearchChannel(const std::string& body) {
     return oss.str();
 }
 
-std::string RequestHandler::handleChannelUrl(const std::string& path) {
+HttpResponse RequestHandler::handleChannelUrl(const std::string& path) {
     // Извлекаем username из пути /@username
     std::string username = path.substr(2); // Убираем "/@"
     
     if (username.empty()) {
         // Редирект на главную страницу чата
-        return "HTTP/1.1 302 Found\r\nLocation: /chat\r\n\r\n";
+        return HttpResponse::redirect("/chat");
     }
     
     // Функция для получения первого UTF-8 символа (поддержка кириллицы и эмодзи)
@@ -10459,14 +10553,9 @@ std::string RequestHandler::handleChannelUrl(const std::string& path) {
         html << "<a class=\"btn btn-outline\" href=\"/\">ОТКРЫТЬ В ВЕБ</a>";
         html << "</div></div></main></body></html>";
         
-        const std::string htmlStr = html.str();
-        std::ostringstream resp;
-        resp << "HTTP/1.1 200 OK\r\n";
-        resp << "Content-Type: text/html; charset=utf-8\r\n";
-        resp << "Cache-Control: no-store, no-cache, must-revalidate\r\n";
-        resp << "Content-Length: " << htmlStr.size() << "\r\n\r\n";
-        resp << htmlStr;
-        return resp.str();
+        HttpResponse res = HttpResponse::text(200, "text/html; charset=utf-8", html.str());
+        res.setHeader("Cache-Control", "no-store, no-cache, must-revalidate");
+        return res;
     }
     
     // Проверяем, это пользователь?
@@ -10540,14 +10629,9 @@ std::string RequestHandler::handleChannelUrl(const std::string& path) {
         html << "<a class=\"btn btn-outline\" href=\"/\">ОТКРЫТЬ В ВЕБ</a>";
         html << "</div></div></main></body></html>";
         
-        const std::string htmlStr = html.str();
-        std::ostringstream resp;
-        resp << "HTTP/1.1 200 OK\r\n";
-        resp << "Content-Type: text/html; charset=utf-8\r\n";
-        resp << "Cache-Control: no-store, no-cache, must-revalidate\r\n";
-        resp << "Content-Length: " << htmlStr.size() << "\r\n\r\n";
-        resp << htmlStr;
-        return resp.str();
+        HttpResponse res = HttpResponse::text(200, "text/html; charset=utf-8", html.str());
+        res.setHeader("Cache-Control", "no-store, no-cache, must-revalidate");
+        return res;
     }
     
     // Ничего не найдено - страница 404
@@ -10566,14 +10650,9 @@ std::string RequestHandler::handleChannelUrl(const std::string& path) {
     notFoundHtml << "<a class=\"btn btn-outline\" href=\"/register\">РЕГИСТРАЦИЯ</a>";
     notFoundHtml << "</div></div></main></body></html>";
     
-    const std::string notFoundStr = notFoundHtml.str();
-    std::ostringstream resp;
-    resp << "HTTP/1.1 404 Not Found\r\n";
-    resp << "Content-Type: text/html; charset=utf-8\r\n";
-    resp << "Cache-Control: no-store, no-cache, must-revalidate\r\n";
-    resp << "Content-Length: " << notFoundStr.size() << "\r\n\r\n";
-    resp << notFoundStr;
-    return resp.str();
+    HttpResponse res = HttpResponse::text(404, "text/html; charset=utf-8", notFoundHtml.str());
+    res.setHeader("Cache-Control", "no-store, no-cache, must-revalidate");
+    return res;
 }
 
 std::string RequestHandler::handleKickMember(const std::string& body) {
@@ -10716,6 +10795,7 @@ std::string RequestHandler::handleSearchGroupMessages(const std::string& body) {
     std::string token = data["token"];
     std::string group_id = data["group_id"];
     std::string query = data["query"];
+    const SearchPage page = parseSearchPage(data);
     
     if (token.empty() || group_id.empty() || query.empty()) {
         return JsonParser::createErrorResponse("Token, group_id and query required");
@@ -10732,22 +10812,62 @@ std::string RequestHandler::handleSearchGroupMessages(const std::string& body) {
         return JsonParser::createErrorResponse("You are not a member of this group");
     }
     
-    auto messages = db_manager_.searchGroupMessages(group_id, query, 50);
+    auto messages = db_manager_.searchGroupMessages(group_id, query, page.limit + 1, page.cursor);
+    const std::string next_cursor = trimSearchPage(messages, page);
     
-    std::string result = "{\"success\":true,\"messages\":[";
-    bool first = true;
+    JsonWriter out(64 + messages.size() * 256);
+    out.beginObject().field("success", true).field("next_cursor", next_cursor).key("messages").beginArray();
     for (const auto& msg : messages) {
-        if (!first) result += ",";
-        first = false;
-        result += "{\"id\":\"" + msg.id + "\",";
-        result += "\"content\":\"" + JsonParser::escapeJson(msg.content) + "\",";
-        result += "\"sender_id\":\"" + msg.sender_id + "\",";
-        result += "\"sender_name\":\"" + JsonParser::escapeJson(msg.sender_username) + "\",";
-        result += "\"created_at\":\"" + msg.created_at + "\"}";
+        out.beginObject()
+            .field("id", msg.id)
+            .field("content", msg.content)
+            .field("sender_id", msg.sender_id)
+            .field("sender_name", msg.sender_username)
+            .field("created_at", msg.created_at)
+            .endObject();
     }
-    result += "]}";
+    out.endArray().endObject();
+    return out.take();
+}
+
+// Поиск по личным сообщениям: в одном диалоге (friend_id) или во всех
+std::string RequestHandler::handleSearchMessages(const std::string& body) {
+    auto data = JsonParser::parse(body);
+    std::string token = data["token"];
+    std::string query = data["query"];
+    std::string friend_id = data.find("friend_id") != data.end() ? data["friend_id"] : "";
+    const SearchPage page = parseSearchPage(data);
     
-    return result;
+    if (token.empty() || query.empty()) {
+        return JsonParser::createErrorResponse("Token and query required");
+    }
+    
+    std::string user_id = auth_manager_.getUserIdFromToken(token);
+    if (user_id.empty()) {
+        return JsonParser::createErrorResponse("Invalid token");
+    }
+    
+    // Only the caller's own conversations are searched, so no further checks
+    auto messages = db_manager_.searchMessagesInChat(user_id, friend_id, query, page.limit + 1, page.cursor);
+    const std::string next_cursor = trimSearchPage(messages, page);
+    
+    JsonWriter out(64 + messages.size() * 320);
+    out.beginObject().field("success", true).field("next_cursor", next_cursor).key("messages").beginArray();
+    for (const auto& msg : messages) {
+        const bool isSent = (msg.sender_id == user_id);
+        out.beginObject()
+            .field("id", msg.id)
+            .field("sender_id", msg.sender_id)
+            .field("receiver_id", msg.receiver_id)
+            .field("chat_id", isSent ? msg.receiver_id : msg.sender_id)
+            .field("sent", isSent)
+            .field("content", msg.content)
+            .field("message_type", msg.message_type)
+            .field("created_at", msg.created_at)
+            .endObject();
+    }
+    out.endArray().endObject();
+    return out.take();
 }
 
 std::string RequestHandler::handleUpdateGroupPermissions(const std::string& body) {
@@ -11240,7 +11360,7 @@ std::string RequestHandler::handleRequestVerification(const std::string& body) {
     // Check for existing pending request
     std::string check_sql = "SELECT id FROM verification_requests WHERE channel_id = $1::uuid AND status = 'pending'";
     const char* check_params[1] = {channel_id.c_str()};
-    PGresult* check_res = PQexecParams(db_manager_.getDb()->getConnection(), check_sql.c_str(), 1, nullptr, check_params, nullptr, nullptr, 0);
+    PGresult* check_res = db_manager_.getDb()->executeParams(check_sql, 1, check_params);
     if (check_res && PQntuples(check_res) > 0) {
         PQclear(check_res);
         return JsonParser::createErrorResponse("Заявка на верификацию уже подана");
@@ -11257,7 +11377,7 @@ std::string RequestHandler::handleRequestVerification(const std::string& body) {
                              "VALUES ($1::uuid, $2, $3, $4::uuid, $5, $6, $7)";
     const char* params[7] = {channel_id.c_str(), channel_username.c_str(), channel_name.c_str(), 
                              user_id.c_str(), owner_username.c_str(), subs_str.c_str(), reason.c_str()};
-    PGresult* res = PQexecParams(db_manager_.getDb()->getConnection(), insert_sql.c_str(), 7, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = db_manager_.getDb()->executeParams(insert_sql, 7, params);
     
     if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
         if (res) PQclear(res);
@@ -11292,7 +11412,7 @@ std::string RequestHandler::handleGetVerificationRequests(const std::string& bod
                       "subscribers_count, reason, status, admin_comment, created_at, reviewed_at "
                       "FROM verification_requests WHERE status = $1 ORDER BY created_at DESC LIMIT 100";
     const char* params[1] = {status_filter.c_str()};
-    PGresult* res = PQexecParams(db_manager_.getDb()->getConnection(), sql.c_str(), 1, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = db_manager_.getDb()->executeParams(sql, 1, params);
     
     if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
         if (res) PQclear(res);
@@ -11349,7 +11469,7 @@ std::string RequestHandler::handleReviewVerification(const std::string& body) {
     // Get request details
     std::string get_sql = "SELECT channel_id, status FROM verification_requests WHERE id = $1::uuid";
     const char* get_params[1] = {request_id.c_str()};
-    PGresult* get_res = PQexecParams(db_manager_.getDb()->getConnection(), get_sql.c_str(), 1, nullptr, get_params, nullptr, nullptr, 0);
+    PGresult* get_res = db_manager_.getDb()->executeParams(get_sql, 1, get_params);
     
     if (!get_res || PQntuples(get_res) == 0) {
         if (get_res) PQclear(get_res);
@@ -11369,7 +11489,7 @@ std::string RequestHandler::handleReviewVerification(const std::string& body) {
     // Update request status
     std::string update_sql = "UPDATE verification_requests SET status = $1, admin_comment = $2, reviewed_by = $3::uuid, reviewed_at = NOW() WHERE id = $4::uuid";
     const char* update_params[4] = {new_status.c_str(), comment.c_str(), user_id.c_str(), request_id.c_str()};
-    PGresult* update_res = PQexecParams(db_manager_.getDb()->getConnection(), update_sql.c_str(), 4, nullptr, update_params, nullptr, nullptr, 0);
+    PGresult* update_res = db_manager_.getDb()->executeParams(update_sql, 4, update_params);
     
     if (!update_res || PQresultStatus(update_res) != PGRES_COMMAND_OK) {
         if (update_res) PQclear(update_res);
@@ -11382,12 +11502,12 @@ std::string RequestHandler::handleReviewVerification(const std::string& body) {
         // Try v2 first
         std::string verify_sql = "UPDATE chats SET is_verified = true WHERE id = $1::uuid";
         const char* verify_params[1] = {channel_id.c_str()};
-        PGresult* verify_res = PQexecParams(db_manager_.getDb()->getConnection(), verify_sql.c_str(), 1, nullptr, verify_params, nullptr, nullptr, 0);
+        PGresult* verify_res = db_manager_.getDb()->executeParams(verify_sql, 1, verify_params);
         if (verify_res) PQclear(verify_res);
         
         // Also try legacy
         std::string verify_legacy_sql = "UPDATE channels SET is_verified = true WHERE id = $1::uuid";
-        verify_res = PQexecParams(db_manager_.getDb()->getConnection(), verify_legacy_sql.c_str(), 1, nullptr, verify_params, nullptr, nullptr, 0);
+        verify_res = db_manager_.getDb()->executeParams(verify_legacy_sql, 1, verify_params);
         if (verify_res) PQclear(verify_res);
     }
     
@@ -11411,7 +11531,7 @@ std::string RequestHandler::handleGetMyVerificationRequests(const std::string& b
     std::string sql = "SELECT id, channel_id, channel_username, channel_name, subscribers_count, reason, status, admin_comment, created_at, reviewed_at "
                       "FROM verification_requests WHERE owner_id = $1::uuid ORDER BY created_at DESC LIMIT 50";
     const char* params[1] = {user_id.c_str()};
-    PGresult* res = PQexecParams(db_manager_.getDb()->getConnection(), sql.c_str(), 1, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = db_manager_.getDb()->executeParams(sql, 1, params);
     
     if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
         if (res) PQclear(res);
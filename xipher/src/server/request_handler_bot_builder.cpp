@@ -4,7 +4,7 @@
 #include "../include/server/request_handler.hpp"
 #include "../include/utils/json_parser.hpp"
 #include "../include/utils/logger.hpp"
-#include "../include/auth/password_hash.hpp"
+#include "../include/auth/password_hasher.hpp"
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
@@ -491,8 +491,12 @@ std::string RequestHandler::handleCreateBot(const std::string& body) {
     if (bot_user_secret.empty()) {
         return JsonParser::createErrorResponse("Failed to generate bot user secret");
     }
-    std::string bot_user_pass_hash = PasswordHash::hash(bot_user_secret);
-    if (bot_user_pass_hash.empty()) {
+    std::string bot_user_pass_hash;
+    const auto hashed = auth_manager_.passwordHasher().hash(bot_user_secret, &bot_user_pass_hash);
+    if (hashed == PasswordHasher::Status::Busy) {
+        return JsonParser::createErrorResponse("Server is busy, please try again later");
+    }
+    if (hashed != PasswordHasher::Status::Ok) {
         return JsonParser::createErrorResponse("Failed to create bot user password hash");
     }
     if (!db_manager_.createBotUser(username_norm, bot_user_pass_hash, bot_user_id)) {
@@ -732,7 +736,12 @@ std::string RequestHandler::handleRevealBotToken(const std::string& body) {
     if (actor.id.empty()) {
         return JsonParser::createErrorResponse("User not found");
     }
-    if (!PasswordHash::verify(password, actor.password_hash)) {
+    bool password_ok = false;
+    if (auth_manager_.passwordHasher().verify(password, actor.password_hash, &password_ok) ==
+        PasswordHasher::Status::Busy) {
+        return JsonParser::createErrorResponse("Server is busy, please try again later");
+    }
+    if (!password_ok) {
         return JsonParser::createErrorResponse("Invalid password");
     }
 
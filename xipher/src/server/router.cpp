@@ -0,0 +1,68 @@
+#include "../include/server/router.hpp"
+
+namespace xipher {
+
+Router::Router() = default;
+Router::~Router() = default;
+
+Router::TrieNode* Router::TrieNode::child(char c) const {
+    for (const auto& entry : children) {
+        if (entry.first == c) {
+            return entry.second.get();
+        }
+    }
+    return nullptr;
+}
+
+void Router::add(const std::string& method, const std::string& path, RouteHandler handler, RouteInfo info) {
+    auto& exact = tables_[method].exact;
+    if (exact.find(path) == exact.end()) {
+        route_count_++;
+    }
+    exact[path] = Route{std::move(handler), std::move(info)};
+}
+
+void Router::addPrefix(const std::string& method, const std::string& prefix, RouteHandler handler, RouteInfo info) {
+    TrieNode* node = &tables_[method].prefixes;
+    for (char c : prefix) {
+        TrieNode* next = node->child(c);
+        if (!next) {
+            node->children.emplace_back(c, std::make_unique<TrieNode>());
+            next = node->children.back().second.get();
+        }
+        node = next;
+    }
+    if (!node->route) {
+        route_count_++;
+    }
+    node->route = std::make_unique<Route>(Route{std::move(handler), std::move(info)});
+}
+
+const Route* Router::match(const std::string& method, const std::string& path) const {
+    auto table_it = tables_.find(method);
+    if (table_it == tables_.end()) {
+        return nullptr;
+    }
+    const MethodTable& table = table_it->second;
+
+    auto exact_it = table.exact.find(path);
+    if (exact_it != table.exact.end()) {
+        return &exact_it->second;
+    }
+
+    // Longest registered prefix wins
+    const Route* best = nullptr;
+    const TrieNode* node = &table.prefixes;
+    for (char c : path) {
+        node = node->child(c);
+        if (!node) {
+            break;
+        }
+        if (node->route) {
+            best = node->route.get();
+        }
+    }
+    return best;
+}
+
+} // namespace xipher
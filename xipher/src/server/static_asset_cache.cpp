@@ -0,0 +1,310 @@
+#include "../include/server/static_asset_cache.hpp"
+#include "../include/utils/logger.hpp"
+#include "../include/utils/http_utils.hpp"
+#include <boost/filesystem.hpp>
+#include <openssl/sha.h>
+#include <zlib.h>
+#ifdef XIPHER_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = boost::filesystem;
+
+namespace xipher {
+
+namespace {
+
+// Below this size the encoded variant plus headers rarely beats identity.
+constexpr std::uint64_t kMinCompressSize = 256;
+// Quality 11 is ~10x slower for a few percent; 9 keeps a full web/ scan at startup short.
+constexpr int kBrotliQuality = 9;
+
+std::string contentHash(const std::string& data) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest);
+    std::ostringstream oss;
+    for (int i = 0; i < 12; ++i) {
+        oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(digest[i]);
+    }
+    return oss.str();
+}
+
+bool isCompressible(const std::string& content_type) {
+    return content_type.rfind("text/", 0) == 0 ||
+           content_type == "application/javascript" ||
+           content_type == "application/json" ||
+           content_type == "image/svg+xml" ||
+           content_type == "image/x-icon";
+}
+
+// Bundler output with a content hash in the name (chat.3f9a1c2b.js,
+// app.5d41402abc4b.css) never changes under the same URL. Only scripts,
+// styles and fonts qualify, the hash must follow a '.', and it has to mix
+// digits and letters, so icon-20240101.png or logo.deadbeef.svg stay
+// revalidated.
+bool isHashedBundle(const fs::path& path) {
+    static const char* const kBundleExtensions[] = {".js", ".mjs", ".css", ".woff", ".woff2"};
+    const std::string extension = toLowerCopy(path.extension().string());
+    if (std::find(std::begin(kBundleExtensions), std::end(kBundleExtensions), extension) ==
+        std::end(kBundleExtensions)) {
+        return false;
+    }
+    const std::string stem = path.stem().string();
+    const size_t dot = stem.find_last_of('.');
+    if (dot == std::string::npos || dot == 0) {
+        return false;
+    }
+    const std::string tag = stem.substr(dot + 1);
+    if (tag.size() < 8 || tag.size() > 32) {
+        return false;
+    }
+    bool has_digit = false;
+    bool has_letter = false;
+    for (const char c : tag) {
+        if (c >= '0' && c <= '9') {
+            has_digit = true;
+        } else if (c >= 'a' && c <= 'f') {
+            has_letter = true;
+        } else {
+            return false;
+        }
+    }
+    return has_digit && has_letter;
+}
+
+std::shared_ptr<const std::string> gzipCompress(const std::string& input) {
+    z_stream zs{};
+    // 15 window bits + 16 selects the gzip wrapper
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nullptr;
+    }
+    std::string output;
+    output.resize(deflateBound(&zs, input.size()));
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    zs.avail_in = static_cast<uInt>(input.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    zs.avail_out = static_cast<uInt>(output.size());
+    const int rc = deflate(&zs, Z_FINISH);
+    const size_t written = zs.total_out;
+    deflateEnd(&zs);
+    if (rc != Z_STREAM_END) {
+        return nullptr;
+    }
+    output.resize(written);
+    return std::make_shared<const std::string>(std::move(output));
+}
+
+std::shared_ptr<const std::string> brotliCompress(const std::string& input) {
+#ifdef XIPHER_HAVE_BROTLI
+    size_t encoded_size = BrotliEncoderMaxCompressedSize(input.size());
+    if (encoded_size == 0) {
+        return nullptr;
+    }
+    std::string output(encoded_size, '\0');
+    if (!BrotliEncoderCompress(kBrotliQuality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                               input.size(), reinterpret_cast<const uint8_t*>(input.data()),
+                               &encoded_size, reinterpret_cast<uint8_t*>(&output[0]))) {
+        return nullptr;
+    }
+    output.resize(encoded_size);
+    return std::make_shared<const std::string>(std::move(output));
+#else
+    (void)input;
+    return nullptr;
+#endif
+}
+
+} // namespace
+
+StaticAssetCache::StaticAssetCache(std::string root, MimeResolver mime_resolver,
+                                   std::uint64_t max_file_size, std::chrono::seconds recheck_interval)
+    : root_(std::move(root)),
+      mime_resolver_(std::move(mime_resolver)),
+      max_file_size_(max_file_size),
+      recheck_interval_(recheck_interval),
+      assets_(std::make_shared<const AssetMap>()) {
+}
+
+StaticAssetCache::~StaticAssetCache() {
+    stop();
+}
+
+void StaticAssetCache::start() {
+    reload();
+    if (recheck_interval_.count() <= 0 || watcher_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(watcher_mutex_);
+        stopping_ = false;
+    }
+    watcher_ = std::thread([this]() { watchLoop(); });
+}
+
+void StaticAssetCache::stop() {
+    {
+        std::lock_guard<std::mutex> lock(watcher_mutex_);
+        stopping_ = true;
+    }
+    watcher_cv_.notify_all();
+    if (watcher_.joinable()) {
+        watcher_.join();
+    }
+}
+
+void StaticAssetCache::reload() {
+    std::lock_guard<std::mutex> reload_lock(reload_mutex_);
+
+    std::shared_ptr<const AssetMap> current;
+    {
+        std::lock_guard<std::mutex> lock(assets_mutex_);
+        current = assets_;
+    }
+
+    auto next = std::make_shared<AssetMap>();
+    size_t reloaded = 0;
+    boost::system::error_code ec;
+    for (fs::recursive_directory_iterator it(root_, ec), end; !ec && it != end; it.increment(ec)) {
+        boost::system::error_code stat_ec;
+        if (!fs::is_regular_file(it->path(), stat_ec)) {
+            continue;
+        }
+        const std::string path = it->path().string();
+        const std::uint64_t size = fs::file_size(it->path(), stat_ec);
+        const std::time_t mtime = stat_ec ? 0 : fs::last_write_time(it->path(), stat_ec);
+        if (stat_ec || size > max_file_size_) {
+            continue;
+        }
+
+        auto existing = current->find(path);
+        if (existing != current->end() && existing->second->mtime == mtime && existing->second->size == size) {
+            next->emplace(path, existing->second);
+            continue;
+        }
+        if (auto asset = loadAsset(path, mtime, size)) {
+            next->emplace(path, std::move(asset));
+            reloaded++;
+        }
+    }
+    if (ec) {
+        Logger::getInstance().warning("Static asset scan of " + root_ + " failed: " + ec.message());
+    }
+
+    const bool changed = reloaded > 0 || next->size() != current->size();
+    if (changed) {
+        Logger::getInstance().info("Static asset cache: " + std::to_string(next->size()) + " files, " +
+                                   std::to_string(reloaded) + " (re)loaded");
+    }
+    std::lock_guard<std::mutex> lock(assets_mutex_);
+    assets_ = std::move(next);
+}
+
+std::shared_ptr<const StaticAssetCache::Asset> StaticAssetCache::find(const std::string& path) const {
+    std::shared_ptr<const AssetMap> assets;
+    {
+        std::lock_guard<std::mutex> lock(assets_mutex_);
+        assets = assets_;
+    }
+    auto it = assets->find(path);
+    return it == assets->end() ? nullptr : it->second;
+}
+
+bool StaticAssetCache::acceptsEncoding(const std::string& accept_encoding, const std::string& coding) {
+    // RFC 9110 12.5.3: an entry naming the coding overrides "*", wherever
+    // it appears, so every entry is read before deciding.
+    const std::string header = toLowerCopy(accept_encoding);
+    int explicit_match = -1;  // -1 = not listed, 0 = refused (q=0), 1 = accepted
+    int wildcard_match = -1;
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t comma = header.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = header.size();
+        }
+        const std::string item = header.substr(pos, comma - pos);
+        pos = comma + 1;
+
+        const size_t semicolon = item.find(';');
+        std::string token = item.substr(0, semicolon);
+        token.erase(0, token.find_first_not_of(" \t"));
+        token.erase(token.find_last_not_of(" \t") + 1);
+        if (token != coding && token != "*") {
+            continue;
+        }
+        bool accepted = true;
+        const size_t q = semicolon == std::string::npos ? std::string::npos : item.find("q=", semicolon);
+        if (q != std::string::npos) {
+            try {
+                accepted = std::stod(item.substr(q + 2)) > 0.0;
+            } catch (...) {
+                accepted = false;
+            }
+        }
+        int& match = token == "*" ? wildcard_match : explicit_match;
+        // A repeated entry refusing the coding wins over one accepting it
+        match = match == 0 ? 0 : (accepted ? 1 : 0);
+    }
+    if (explicit_match >= 0) {
+        return explicit_match == 1;
+    }
+    return wildcard_match == 1;
+}
+
+std::shared_ptr<const StaticAssetCache::Asset> StaticAssetCache::loadAsset(const std::string& path,
+                                                                           std::time_t mtime,
+                                                                           std::uint64_t size) const {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+    std::string content;
+    content.resize(static_cast<size_t>(size));
+    if (size > 0 && !file.read(&content[0], static_cast<std::streamsize>(size))) {
+        Logger::getInstance().warning("Static asset cache: short read on " + path);
+        return nullptr;
+    }
+
+    auto asset = std::make_shared<Asset>();
+    const fs::path fs_path(path);
+    asset->content_type = mime_resolver_ ? mime_resolver_(fs_path.extension().string()) : "application/octet-stream";
+    asset->cache_control = isHashedBundle(fs_path) ? "public, max-age=31536000, immutable" : "no-cache";
+    asset->etag = "\"" + contentHash(content) + "\"";
+    asset->last_modified = formatHttpDate(mtime);
+    asset->mtime = mtime;
+    asset->size = size;
+
+    if (size >= kMinCompressSize && isCompressible(asset->content_type)) {
+        auto gz = gzipCompress(content);
+        if (gz && gz->size() < content.size()) {
+            asset->gzip = std::move(gz);
+        }
+        auto br = brotliCompress(content);
+        if (br && br->size() < content.size()) {
+            asset->brotli = std::move(br);
+        }
+    }
+    asset->identity = std::make_shared<const std::string>(std::move(content));
+    return asset;
+}
+
+void StaticAssetCache::watchLoop() {
+    std::unique_lock<std::mutex> lock(watcher_mutex_);
+    while (!stopping_) {
+        if (watcher_cv_.wait_for(lock, recheck_interval_, [this]() { return stopping_; })) {
+            break;
+        }
+        lock.unlock();
+        try {
+            reload();
+        } catch (const std::exception& e) {
+            Logger::getInstance().error("Static asset reload failed: " + std::string(e.what()));
+        }
+        lock.lock();
+    }
+}
+
+} // namespace xipher
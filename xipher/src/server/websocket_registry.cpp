@@ -0,0 +1,93 @@
+#include "../include/server/websocket_registry.hpp"
+#include <functional>
+
+namespace xipher {
+
+WebSocketRegistry::Shard& WebSocketRegistry::shardFor(const std::string& user_id) {
+    return shards_[std::hash<std::string>{}(user_id) % kShardCount];
+}
+
+void WebSocketRegistry::add(const std::string& user_id, const SessionPtr& session) {
+    if (user_id.empty() || !session) {
+        return;
+    }
+    const std::string previous = session->userId();
+    if (previous == user_id) {
+        return;
+    }
+    if (!previous.empty()) {
+        Shard& old_shard = shardFor(previous);
+        std::lock_guard<std::mutex> lock(old_shard.mutex);
+        removeLocked(old_shard, previous, session.get());
+    }
+
+    session->setUserId(user_id);
+    Shard& shard = shardFor(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& sessions = shard.users[user_id];
+    if (sessions.empty()) {
+        user_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    auto inserted = sessions.emplace(session.get(), session);
+    if (inserted.second) {
+        session_count_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // Address reused by a new session before the expired entry was pruned
+        inserted.first->second = session;
+    }
+}
+
+void WebSocketRegistry::remove(const SessionPtr& session) {
+    if (!session) {
+        return;
+    }
+    const std::string user_id = session->userId();
+    if (user_id.empty()) {
+        return;
+    }
+    Shard& shard = shardFor(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    removeLocked(shard, user_id, session.get());
+}
+
+std::vector<WebSocketRegistry::SessionPtr> WebSocketRegistry::sessionsFor(const std::string& user_id) {
+    std::vector<SessionPtr> result;
+    Shard& shard = shardFor(user_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto user_it = shard.users.find(user_id);
+    if (user_it == shard.users.end()) {
+        return result;
+    }
+    auto& sessions = user_it->second;
+    result.reserve(sessions.size());
+    for (auto it = sessions.begin(); it != sessions.end();) {
+        if (auto session = it->second.lock()) {
+            result.push_back(std::move(session));
+            ++it;
+        } else {
+            it = sessions.erase(it);
+            session_count_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    if (sessions.empty()) {
+        shard.users.erase(user_it);
+        user_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void WebSocketRegistry::removeLocked(Shard& shard, const std::string& user_id, const WebSocketSession* session) {
+    auto user_it = shard.users.find(user_id);
+    if (user_it == shard.users.end()) {
+        return;
+    }
+    if (user_it->second.erase(session) > 0) {
+        session_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (user_it->second.empty()) {
+        shard.users.erase(user_it);
+        user_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace xipher
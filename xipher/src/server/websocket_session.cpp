@@ -0,0 +1,132 @@
+#include "../include/server/websocket_session.hpp"
+#include "../include/utils/logger.hpp"
+#include <boost/asio/post.hpp>
+
+namespace beast = boost::beast;
+namespace net = boost::asio;
+
+namespace xipher {
+
+WebSocketSession::WebSocketSession(beast::tcp_stream&& stream, const Limits& limits)
+    : ws_(std::move(stream)), limits_(limits) {
+}
+
+bool WebSocketSession::send(std::string message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_) {
+        return false;
+    }
+    if (pending_.size() + 1 > limits_.max_queued_frames ||
+        pending_bytes_ + message.size() > limits_.max_queued_bytes) {
+        if (limits_.policy == SlowConsumerPolicy::Drop) {
+            dropped_frames_++;
+            // Log the first drop of a streak only; a stalled client would flood the log.
+            if (!dropping_) {
+                dropping_ = true;
+                Logger::getInstance().warning("WebSocket outbound queue full (" + std::to_string(pending_.size()) +
+                                              " frames, " + std::to_string(pending_bytes_) + " bytes), dropping frames");
+            }
+            return false;
+        }
+        Logger::getInstance().warning("WebSocket slow consumer: " + std::to_string(pending_.size()) + " frames, " +
+                                      std::to_string(pending_bytes_) + " bytes queued, disconnecting");
+        closing_ = true;
+        pending_.clear();
+        pending_bytes_ = 0;
+        net::post(ws_.get_executor(), [self = shared_from_this()]() { self->closeOnStrand(); });
+        return false;
+    }
+
+    pending_bytes_ += message.size();
+    pending_.push_back(std::move(message));
+    if (!writing_) {
+        writing_ = true;
+        net::post(ws_.get_executor(), [self = shared_from_this()]() { self->flush(); });
+    }
+    return true;
+}
+
+void WebSocketSession::setCoalescing(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    coalesce_ = enabled;
+}
+
+WebSocketSession::QueueStats WebSocketSession::queueStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    QueueStats stats;
+    stats.queued_frames = pending_.size();
+    stats.queued_bytes = pending_bytes_;
+    stats.dropped_frames = dropped_frames_;
+    stats.write_in_flight = writing_;
+    return stats;
+}
+
+void WebSocketSession::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+        pending_.clear();
+        pending_bytes_ = 0;
+    }
+    net::post(ws_.get_executor(), [self = shared_from_this()]() { self->closeOnStrand(); });
+}
+
+std::string WebSocketSession::userId() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return user_id_;
+}
+
+void WebSocketSession::setUserId(std::string user_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    user_id_ = std::move(user_id);
+}
+
+void WebSocketSession::flush() {
+    // Runs on the strand. Only one write is ever outstanding: the completion
+    // handler calls flush() again, and writing_ stays set until the queue is empty.
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.empty() || closing_) {
+            writing_ = false;
+            return;
+        }
+        in_flight_ = std::move(pending_.front());
+        pending_.pop_front();
+        pending_bytes_ -= in_flight_.size();
+        // Whatever piled up during the previous write goes out as one frame.
+        while (coalesce_ && !pending_.empty() &&
+               in_flight_.size() + pending_.front().size() <= limits_.coalesce_max_bytes) {
+            in_flight_ += pending_.front();
+            pending_bytes_ -= pending_.front().size();
+            pending_.pop_front();
+        }
+        if (pending_.empty()) {
+            dropping_ = false;
+        }
+    }
+
+    ws_.text(true);
+    ws_.async_write(net::buffer(in_flight_),
+        [self = shared_from_this()](beast::error_code ec, std::size_t) {
+            if (ec) {
+                Logger::getInstance().error("WebSocket write error: " + ec.message());
+                std::lock_guard<std::mutex> lock(self->mutex_);
+                self->closing_ = true;
+                self->writing_ = false;
+                self->pending_.clear();
+                self->pending_bytes_ = 0;
+                return;
+            }
+            self->flush();
+        });
+}
+
+void WebSocketSession::closeOnStrand() {
+    // Closing the socket instead of a close handshake: a stalled peer would not
+    // read the close frame either.
+    beast::error_code ec;
+    beast::get_lowest_layer(ws_).socket().shutdown(net::ip::tcp::socket::shutdown_both, ec);
+    beast::get_lowest_layer(ws_).close();
+}
+
+} // namespace xipher
@@ -0,0 +1,113 @@
+#include "../include/server/worker_pool.hpp"
+#include "../include/utils/logger.hpp"
+#include <algorithm>
+
+namespace xipher {
+
+WorkerPool::WorkerPool(size_t thread_count, size_t max_queue_depth)
+    : thread_count_(std::max<size_t>(1, thread_count)),
+      max_queue_depth_(std::max<size_t>(1, max_queue_depth)) {
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+void WorkerPool::start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) return;
+        running_ = true;
+    }
+    workers_.reserve(thread_count_);
+    for (size_t i = 0; i < thread_count_; ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+    Logger::getInstance().info("WorkerPool started with " + std::to_string(thread_count_) +
+                               " threads, queue limit " + std::to_string(max_queue_depth_));
+}
+
+void WorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+        queue_.clear();
+        route_in_flight_.clear();
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable() && worker.get_id() != std::this_thread::get_id()) {
+            worker.join();
+        } else if (worker.joinable()) {
+            worker.detach();
+        }
+    }
+    workers_.clear();
+}
+
+void WorkerPool::setRouteLimit(const std::string& route_class, size_t max_in_flight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (max_in_flight == 0) {
+        route_limits_.erase(route_class);
+    } else {
+        route_limits_[route_class] = max_in_flight;
+    }
+}
+
+WorkerPool::SubmitResult WorkerPool::submit(const std::string& route_class, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return SubmitResult::Stopped;
+        }
+        if (queue_.size() >= max_queue_depth_) {
+            return SubmitResult::QueueFull;
+        }
+        auto limit_it = route_limits_.find(route_class);
+        size_t& in_flight = route_in_flight_[route_class];
+        if (limit_it != route_limits_.end() && in_flight >= limit_it->second) {
+            return SubmitResult::RouteLimited;
+        }
+        in_flight++;
+        queue_.push_back(Task{route_class, std::move(task)});
+    }
+    cv_.notify_one();
+    return SubmitResult::Accepted;
+}
+
+size_t WorkerPool::queueDepth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+void WorkerPool::workerLoop() {
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+            if (!running_) {
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        try {
+            task.fn();
+        } catch (const std::exception& e) {
+            Logger::getInstance().error("Unhandled exception in worker task (" + task.route_class + "): " + e.what());
+        } catch (...) {
+            Logger::getInstance().error("Unhandled unknown exception in worker task (" + task.route_class + ")");
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = route_in_flight_.find(task.route_class);
+        if (it != route_in_flight_.end() && it->second > 0) {
+            it->second--;
+        }
+    }
+}
+
+} // namespace xipher
@@ -106,6 +106,39 @@ std::string InMemoryStorage::int64ToString(int64_t value) {
     return std::to_string(value);
 }
 
+void InMemoryStorage::pageRange(const std::vector<std::string>& message_ids, int limit,
+                                const std::string& before_id, const std::string& after_id,
+                                size_t* begin, size_t* end) const {
+    const size_t page = static_cast<size_t>(std::max(limit, 0));
+    *begin = 0;
+    *end = message_ids.size();
+    const std::string& cursor = !before_id.empty() ? before_id : after_id;
+    if (!cursor.empty()) {
+        auto order_it = message_order_.find(cursor);
+        if (order_it == message_order_.end()) {
+            *end = 0;
+            return;
+        }
+        const int64_t order = order_it->second;
+        auto orderOf = [this](const std::string& id) {
+            auto it = message_order_.find(id);
+            return it != message_order_.end() ? it->second : 0;
+        };
+        if (!before_id.empty()) {
+            auto pos = std::lower_bound(message_ids.begin(), message_ids.end(), order,
+                [&](const std::string& id, int64_t value) { return orderOf(id) < value; });
+            *end = static_cast<size_t>(pos - message_ids.begin());
+        } else {
+            auto pos = std::upper_bound(message_ids.begin(), message_ids.end(), order,
+                [&](int64_t value, const std::string& id) { return value < orderOf(id); });
+            *begin = static_cast<size_t>(pos - message_ids.begin());
+            *end = std::min(message_ids.size(), *begin + page);
+            return;
+        }
+    }
+    *begin = *end - std::min(*end, page);
+}
+
 // ========== USER OPERATIONS ==========
 
 bool InMemoryStorage::createUser(const std::string& username, const std::string& password_hash, std::string& user_id) {
@@ -361,6 +394,7 @@ bool InMemoryStorage::sendMessage(const std::string& sender_id, const std::strin
     msg.reply_to_message_id = reply_to_message_id;
     
     messages_[msg_id] = msg;
+    message_order_[msg_id] = message_order_counter_++;
     
     std::string chat_key = normalizeChatKey(sender_id, receiver_id);
     chat_messages_[chat_key].push_back(msg_id);
@@ -372,7 +406,8 @@ bool InMemoryStorage::sendMessage(const std::string& sender_id, const std::strin
     return true;
 }
 
-std::vector<Message> InMemoryStorage::getMessages(const std::string& user1_id, const std::string& user2_id, int limit) {
+std::vector<Message> InMemoryStorage::getMessages(const std::string& user1_id, const std::string& user2_id, int limit,
+                                                  const std::string& before_id, const std::string& after_id) {
     std::lock_guard<std::mutex> lock(storage_mutex_);
     
     std::vector<Message> result;
@@ -383,11 +418,13 @@ std::vector<Message> InMemoryStorage::getMessages(const std::string& user1_id, c
         return result;
     }
     
-    // Get messages in reverse order (newest first), then reverse for chronological order
+    // Chronological order; the page ends at the newest message or the cursor
     const auto& message_ids = it->second;
-    int count = std::min(limit, static_cast<int>(message_ids.size()));
+    size_t begin = 0;
+    size_t end = 0;
+    pageRange(message_ids, limit, before_id, after_id, &begin, &end);
     
-    for (int i = message_ids.size() - count; i < static_cast<int>(message_ids.size()); i++) {
+    for (size_t i = begin; i < end; i++) {
         auto msg_it = messages_.find(message_ids[i]);
         if (msg_it != messages_.end()) {
             result.push_back(msg_it->second);
@@ -465,6 +502,7 @@ bool InMemoryStorage::deleteMessage(const std::string& message_id) {
     
     // Remove message
     messages_.erase(msg_it);
+    message_order_.erase(message_id);
     
     return true;
 }
@@ -786,12 +824,15 @@ bool InMemoryStorage::sendGroupMessage(const std::string& group_id, const std::s
     msg.created_at = getCurrentTimestamp();
     
     group_messages_[msg_id] = msg;
+    message_order_[msg_id] = message_order_counter_++;
     group_message_list_[group_id].push_back(msg_id);
     
     return true;
 }
 
-std::vector<DatabaseManager::GroupMessage> InMemoryStorage::getGroupMessages(const std::string& group_id, int limit) {
+std::vector<DatabaseManager::GroupMessage> InMemoryStorage::getGroupMessages(const std::string& group_id, int limit,
+                                                                           const std::string& before_id,
+                                                                           const std::string& after_id) {
     std::lock_guard<std::mutex> lock(storage_mutex_);
     
     std::vector<DatabaseManager::GroupMessage> result;
@@ -799,10 +840,11 @@ std::vector<DatabaseManager::GroupMessage> InMemoryStorage::getGroupMessages(con
     
     if (it != group_message_list_.end()) {
         const auto& message_ids = it->second;
-        int count = std::min(limit, static_cast<int>(message_ids.size()));
+        size_t begin = 0;
+        size_t end = 0;
+        pageRange(message_ids, limit, before_id, after_id, &begin, &end);
         
-        // Get last N messages
-        for (int i = message_ids.size() - count; i < static_cast<int>(message_ids.size()); i++) {
+        for (size_t i = begin; i < end; i++) {
             auto msg_it = group_messages_.find(message_ids[i]);
             if (msg_it != group_messages_.end()) {
                 result.push_back(msg_it->second);
@@ -1196,12 +1238,15 @@ bool InMemoryStorage::sendChannelMessage(const std::string& channel_id, const st
     msg.created_at = getCurrentTimestamp();
     
     channel_messages_[msg_id] = msg;
+    message_order_[msg_id] = message_order_counter_++;
     channel_message_list_[channel_id].push_back(msg_id);
     
     return true;
 }
 
-std::vector<DatabaseManager::ChannelMessage> InMemoryStorage::getChannelMessages(const std::string& channel_id, int limit) {
+std::vector<DatabaseManager::ChannelMessage> InMemoryStorage::getChannelMessages(const std::string& channel_id, int limit,
+                                                                               const std::string& before_id,
+                                                                               const std::string& after_id) {
     std::lock_guard<std::mutex> lock(storage_mutex_);
     
     std::vector<DatabaseManager::ChannelMessage> result;
@@ -1209,10 +1254,11 @@ std::vector<DatabaseManager::ChannelMessage> InMemoryStorage::getChannelMessages
     
     if (it != channel_message_list_.end()) {
         const auto& message_ids = it->second;
-        int count = std::min(limit, static_cast<int>(message_ids.size()));
+        size_t begin = 0;
+        size_t end = 0;
+        pageRange(message_ids, limit, before_id, after_id, &begin, &end);
         
-        // Get last N messages
-        for (int i = message_ids.size() - count; i < static_cast<int>(message_ids.size()); i++) {
+        for (size_t i = begin; i < end; i++) {
             auto msg_it = channel_messages_.find(message_ids[i]);
             if (msg_it != channel_messages_.end()) {
                 result.push_back(msg_it->second);
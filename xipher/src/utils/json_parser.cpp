@@ -1,4 +1,5 @@
 #include "../include/utils/json_parser.hpp"
+#include "../include/utils/json_writer.hpp"
 #include <sstream>
 #include <algorithm>
 #include <cctype>
@@ -321,16 +322,8 @@ std::string JsonParser::createSuccessResponse(const std::string& message, const
 
 std::string JsonParser::escapeJson(const std::string& str) {
     std::string result;
-    for (char c : str) {
-        switch (c) {
-            case '"': result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\n': result += "\\n"; break;
-            case '\r': result += "\\r"; break;
-            case '\t': result += "\\t"; break;
-            default: result += c; break;
-        }
-    }
+    result.reserve(str.size());
+    JsonWriter::appendEscaped(result, str);
     return result;
 }
 
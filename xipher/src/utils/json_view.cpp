@@ -0,0 +1,450 @@
+#include "../include/utils/json_view.hpp"
+#include "../include/utils/json_parser.hpp"
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xipher {
+
+namespace {
+
+// Deeper nesting than any request we accept; bounds the validator's recursion.
+constexpr int kMaxDepth = 512;
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isStructural(char c) {
+    return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+}
+
+bool isScalarLiteral(std::string_view text) {
+    if (text == "true" || text == "false" || text == "null") {
+        return true;
+    }
+    if (text.empty() || !(text[0] == '-' || (text[0] >= '0' && text[0] <= '9'))) {
+        return false;
+    }
+    for (char c : text) {
+        if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view trimRight(std::string_view text) {
+    while (!text.empty() && isSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+std::string unescape(std::string_view raw) {
+    if (raw.find('\\') == std::string_view::npos) {
+        return std::string(raw);
+    }
+    return JsonParser::unescapeJson(std::string(raw));
+}
+
+// Recursive-descent check over the structural index: token order must form
+// valid JSON and the gaps between tokens may only hold whitespace or a scalar.
+class Validator {
+public:
+    Validator(std::string_view json, const std::vector<uint32_t>& tokens) : json_(json), tokens_(tokens) {}
+
+    bool run() {
+        if (!value(0)) {
+            return false;
+        }
+        skipSpace();
+        return pos_ == json_.size() && t_ == tokens_.size();
+    }
+
+private:
+    void skipSpace() {
+        while (pos_ < json_.size() && isSpace(json_[pos_])) {
+            pos_++;
+        }
+    }
+
+    bool atToken(char c) {
+        skipSpace();
+        return t_ < tokens_.size() && tokens_[t_] == pos_ && json_[pos_] == c;
+    }
+
+    bool consume(char c) {
+        if (!atToken(c)) {
+            return false;
+        }
+        pos_++;
+        t_++;
+        return true;
+    }
+
+    bool string() {
+        if (!atToken('"') || t_ + 1 >= tokens_.size() || json_[tokens_[t_ + 1]] != '"') {
+            return false;
+        }
+        pos_ = tokens_[t_ + 1] + 1;
+        t_ += 2;
+        return true;
+    }
+
+    bool value(int depth) {
+        if (depth > kMaxDepth) {
+            return false;
+        }
+        skipSpace();
+        if (pos_ >= json_.size()) {
+            return false;
+        }
+        const char c = json_[pos_];
+        if (t_ < tokens_.size() && tokens_[t_] == pos_) {
+            if (c == '"') {
+                return string();
+            }
+            if (c == '{') {
+                consume('{');
+                if (consume('}')) {
+                    return true;
+                }
+                do {
+                    if (!string() || !consume(':') || !value(depth + 1)) {
+                        return false;
+                    }
+                } while (consume(','));
+                return consume('}');
+            }
+            if (c == '[') {
+                consume('[');
+                if (consume(']')) {
+                    return true;
+                }
+                do {
+                    if (!value(depth + 1)) {
+                        return false;
+                    }
+                } while (consume(','));
+                return consume(']');
+            }
+            return false;
+        }
+        const size_t end = t_ < tokens_.size() ? tokens_[t_] : json_.size();
+        if (!isScalarLiteral(trimRight(json_.substr(pos_, end - pos_)))) {
+            return false;
+        }
+        pos_ = end;
+        return true;
+    }
+
+    std::string_view json_;
+    const std::vector<uint32_t>& tokens_;
+    size_t pos_ = 0;
+    size_t t_ = 0;
+};
+
+} // namespace
+
+JsonDocument::JsonDocument(std::string_view json) : json_(json) {
+    // Left invalid; upload routes cap their body at kMaxSize so it does not
+    // come to this for a request body.
+    if (json_.size() > kMaxSize) {
+        return;
+    }
+    buildIndex();
+}
+
+void JsonDocument::buildIndex() {
+    structurals_.reserve(json_.size() / 8 + 16);
+    const char* data = json_.data();
+    const size_t size = json_.size();
+    bool in_string = false;
+    size_t escaped_pos = SIZE_MAX;  // byte right after a backslash inside a string
+    bool ok = true;
+
+    auto visit = [&](size_t pos) {
+        const char c = data[pos];
+        if (in_string) {
+            if (pos == escaped_pos) {
+                return;
+            }
+            if (c == '\\') {
+                escaped_pos = pos + 1;
+            } else if (c == '"') {
+                in_string = false;
+                structurals_.push_back(static_cast<uint32_t>(pos));
+            }
+            return;
+        }
+        if (c == '"') {
+            in_string = true;
+            structurals_.push_back(static_cast<uint32_t>(pos));
+        } else if (c == '\\') {
+            ok = false;
+        } else {
+            structurals_.push_back(static_cast<uint32_t>(pos));
+        }
+    };
+
+    size_t pos = 0;
+#if defined(__SSE2__)
+    // Flag every byte that can change parser state, then visit only those.
+    // Structurals inside strings are flagged too and dropped by visit().
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i open_brace = _mm_set1_epi8('{');
+    const __m128i close_brace = _mm_set1_epi8('}');
+    const __m128i open_bracket = _mm_set1_epi8('[');
+    const __m128i close_bracket = _mm_set1_epi8(']');
+    for (; pos + 16 <= size; pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const __m128i strings = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        const __m128i separators = _mm_or_si128(_mm_cmpeq_epi8(chunk, colon), _mm_cmpeq_epi8(chunk, comma));
+        const __m128i braces = _mm_or_si128(_mm_cmpeq_epi8(chunk, open_brace), _mm_cmpeq_epi8(chunk, close_brace));
+        const __m128i brackets = _mm_or_si128(_mm_cmpeq_epi8(chunk, open_bracket), _mm_cmpeq_epi8(chunk, close_bracket));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_or_si128(strings, separators), _mm_or_si128(braces, brackets))));
+        while (mask != 0) {
+            visit(pos + static_cast<size_t>(__builtin_ctz(mask)));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; pos < size; ++pos) {
+        const char c = data[pos];
+        if (c == '"' || c == '\\' || (!in_string && isStructural(c))) {
+            visit(pos);
+        }
+    }
+
+    valid_ = ok && !in_string && Validator(json_, structurals_).run();
+}
+
+JsonValue JsonDocument::root() const {
+    if (!valid_) {
+        return JsonValue();
+    }
+    uint32_t begin = 0;
+    while (begin < json_.size() && isSpace(json_[begin])) {
+        begin++;
+    }
+    return JsonValue(this, begin, 0);
+}
+
+JsonType JsonValue::type() const {
+    if (!doc_ || begin_ >= doc_->json_.size()) {
+        return JsonType::Invalid;
+    }
+    switch (doc_->json_[begin_]) {
+        case '"': return JsonType::String;
+        case '{': return JsonType::Object;
+        case '[': return JsonType::Array;
+        case 't':
+        case 'f': return JsonType::Bool;
+        case 'n': return JsonType::Null;
+        default: return JsonType::Number;
+    }
+}
+
+bool JsonValue::firstChild(uint32_t& token) const {
+    // token_ is the opening bracket
+    token = token_ + 1;
+    const char close = doc_->tokenChar(token_) == '{' ? '}' : ']';
+    if (token >= doc_->structurals_.size()) {
+        return false;
+    }
+    if (doc_->tokenChar(token) == close) {
+        // Either empty, or a single scalar element: [1]
+        if (close == '}') {
+            return false;
+        }
+        const size_t gap_begin = doc_->structurals_[token_] + 1;
+        std::string_view gap = doc_->json_.substr(gap_begin, doc_->structurals_[token] - gap_begin);
+        while (!gap.empty() && isSpace(gap.front())) {
+            gap.remove_prefix(1);
+        }
+        return !gap.empty();
+    }
+    return true;
+}
+
+uint32_t JsonValue::skipValue(uint32_t token) const {
+    const auto& tokens = doc_->structurals_;
+    if (token >= tokens.size()) {
+        return token;
+    }
+    const JsonValue value = valueAtToken(token);
+    if (value.begin_ != tokens[token]) {
+        return token;  // scalar: no tokens of its own
+    }
+    const char c = doc_->tokenChar(token);
+    if (c == '"') {
+        return token + 2;
+    }
+    if (c != '{' && c != '[') {
+        return token;
+    }
+    int depth = 0;
+    for (uint32_t t = token; t < tokens.size(); ++t) {
+        const char tc = doc_->tokenChar(t);
+        if (tc == '"') {
+            t++;  // skip the closing quote
+        } else if (tc == '{' || tc == '[') {
+            depth++;
+        } else if (tc == '}' || tc == ']') {
+            if (--depth == 0) {
+                return t + 1;
+            }
+        }
+    }
+    return static_cast<uint32_t>(tokens.size());
+}
+
+JsonValue JsonValue::valueAtToken(uint32_t token) const {
+    // A child value starts right after the previous structural (':', ',' or '[')
+    const auto& tokens = doc_->structurals_;
+    uint32_t begin = token > 0 ? tokens[token - 1] + 1 : 0;
+    while (begin < doc_->json_.size() && isSpace(doc_->json_[begin])) {
+        begin++;
+    }
+    return JsonValue(doc_, begin, token);
+}
+
+std::string_view JsonValue::keyAt(uint32_t token) const {
+    const auto& tokens = doc_->structurals_;
+    const uint32_t open = tokens[token] + 1;
+    return doc_->json_.substr(open, tokens[token + 1] - open);
+}
+
+bool JsonValue::keyEquals(uint32_t token, std::string_view key) const {
+    const std::string_view raw = keyAt(token);
+    if (raw.find('\\') == std::string_view::npos) {
+        return raw == key;
+    }
+    return unescape(raw) == key;
+}
+
+JsonValue JsonValue::operator[](std::string_view key) const {
+    uint32_t token = 0;
+    if (type() != JsonType::Object || !firstChild(token)) {
+        return JsonValue();
+    }
+    const auto& tokens = doc_->structurals_;
+    for (;;) {
+        const uint32_t value_token = token + 3;
+        if (keyEquals(token, key)) {
+            return valueAtToken(value_token);
+        }
+        const uint32_t next = skipValue(value_token);
+        if (next >= tokens.size() || doc_->tokenChar(next) != ',') {
+            return JsonValue();
+        }
+        token = next + 1;
+    }
+}
+
+JsonValue JsonValue::operator[](size_t index) const {
+    JsonValue found;
+    size_t i = 0;
+    forEachElement([&](const JsonValue& element) {
+        if (i++ == index) {
+            found = element;
+        }
+    });
+    return found;
+}
+
+size_t JsonValue::size() const {
+    size_t count = 0;
+    if (type() == JsonType::Object) {
+        forEachMember([&](std::string_view, const JsonValue&) { count++; });
+    } else if (type() == JsonType::Array) {
+        forEachElement([&](const JsonValue&) { count++; });
+    }
+    return count;
+}
+
+std::string_view JsonValue::raw() const {
+    const JsonType kind = type();
+    if (kind == JsonType::Invalid) {
+        return {};
+    }
+    const auto& tokens = doc_->structurals_;
+    if (kind == JsonType::String) {
+        return doc_->json_.substr(begin_, tokens[token_ + 1] + 1 - begin_);
+    }
+    if (kind == JsonType::Object || kind == JsonType::Array) {
+        const uint32_t after = skipValue(token_);
+        return doc_->json_.substr(begin_, tokens[after - 1] + 1 - begin_);
+    }
+    const size_t end = token_ < tokens.size() ? tokens[token_] : doc_->json_.size();
+    return trimRight(doc_->json_.substr(begin_, end - begin_));
+}
+
+std::string_view JsonValue::rawString() const {
+    if (type() != JsonType::String) {
+        return {};
+    }
+    const std::string_view quoted = raw();
+    return quoted.substr(1, quoted.size() - 2);
+}
+
+std::string JsonValue::asString(std::string_view fallback) const {
+    switch (type()) {
+        case JsonType::Invalid:
+            return std::string(fallback);
+        case JsonType::String:
+            return unescape(rawString());
+        default:
+            return std::string(raw());
+    }
+}
+
+int64_t JsonValue::asInt(int64_t fallback) const {
+    // Clients send ids and amounts as strings as often as numbers
+    const std::string_view text = isString() ? rawString() : raw();
+    int64_t value = 0;
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || text.empty()) {
+        return fallback;
+    }
+    return value;
+}
+
+double JsonValue::asDouble(double fallback) const {
+    const std::string text(isString() ? rawString() : raw());
+    if (text.empty()) {
+        return fallback;
+    }
+    char* end = nullptr;
+    const double value = std::strtod(text.c_str(), &end);
+    return end == text.c_str() ? fallback : value;
+}
+
+bool JsonValue::asBool(bool fallback) const {
+    const std::string_view text = isString() ? rawString() : raw();
+    if (text == "true" || text == "1") {
+        return true;
+    }
+    if (text == "false" || text == "0") {
+        return false;
+    }
+    return fallback;
+}
+
+std::map<std::string, std::string> JsonValue::toStringMap() const {
+    std::map<std::string, std::string> result;
+    forEachMember([&](std::string_view key, const JsonValue& value) {
+        result[unescape(key)] = value.asString();
+    });
+    return result;
+}
+
+} // namespace xipher
@@ -0,0 +1,186 @@
+#include "../include/utils/json_writer.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xipher {
+
+namespace {
+
+bool needsEscape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+// Length of the leading run of `text` that can be copied unescaped.
+size_t plainRun(const char* data, size_t size) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control_max = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // Unsigned c <= 0x1F  <=>  max(c, 0x1F) == 0x1F
+        const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(chunk, control_max), control_max);
+        const __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                          _mm_cmpeq_epi8(chunk, backslash)),
+                                             control);
+        const int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (needsEscape(static_cast<unsigned char>(data[i]))) {
+            return i;
+        }
+    }
+    return size;
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(size_t reserve_bytes) : out_(&own_) {
+    own_.reserve(reserve_bytes);
+}
+
+JsonWriter::JsonWriter(std::string& out) : out_(&out) {}
+
+void JsonWriter::separate() {
+    if (need_comma_) {
+        out_->push_back(',');
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separate();
+    out_->push_back('{');
+    need_comma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    out_->push_back('}');
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separate();
+    out_->push_back('[');
+    need_comma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    out_->push_back(']');
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    separate();
+    out_->push_back('"');
+    appendEscaped(*out_, name);
+    out_->append("\":", 2);
+    need_comma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    separate();
+    out_->push_back('"');
+    appendEscaped(*out_, text);
+    out_->push_back('"');
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separate();
+    if (flag) {
+        out_->append("true", 4);
+    } else {
+        out_->append("false", 5);
+    }
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    if (!std::isfinite(number)) {
+        return null();
+    }
+    separate();
+    char buf[32];
+    const int len = std::snprintf(buf, sizeof(buf), "%.15g", number);
+    out_->append(buf, static_cast<size_t>(len));
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separate();
+    out_->append("null", 4);
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(std::string_view json) {
+    separate();
+    out_->append(json.data(), json.size());
+    need_comma_ = true;
+    return *this;
+}
+
+void JsonWriter::appendInt(int64_t number) {
+    separate();
+    char buf[24];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), number);
+    out_->append(buf, static_cast<size_t>(res.ptr - buf));
+    need_comma_ = true;
+}
+
+void JsonWriter::appendUint(uint64_t number) {
+    separate();
+    char buf[24];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), number);
+    out_->append(buf, static_cast<size_t>(res.ptr - buf));
+    need_comma_ = true;
+}
+
+void JsonWriter::appendEscaped(std::string& out, std::string_view text) {
+    static const char kHex[] = "0123456789abcdef";
+    const char* data = text.data();
+    size_t size = text.size();
+    while (size > 0) {
+        const size_t run = plainRun(data, size);
+        out.append(data, run);
+        if (run == size) {
+            return;
+        }
+        const unsigned char c = static_cast<unsigned char>(data[run]);
+        switch (c) {
+            case '"': out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            case '\b': out.append("\\b", 2); break;
+            case '\f': out.append("\\f", 2); break;
+            default: {
+                const char esc[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+                out.append(esc, 6);
+                break;
+            }
+        }
+        data += run + 1;
+        size -= run + 1;
+    }
+}
+
+} // namespace xipher
@@ -1,31 +1,75 @@
 #include "../include/utils/logger.hpp"
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <ctime>
 
 namespace xipher {
 
+namespace {
+
+constexpr size_t kMaxBatch = 1024;
+constexpr auto kIdleWait = std::chrono::milliseconds(100);
+
+LogLevel parseLevel(const char* raw, LogLevel fallback) {
+    if (!raw || !*raw) {
+        return fallback;
+    }
+    std::string value(raw);
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (value == "debug") return LogLevel::DEBUG;
+    if (value == "info") return LogLevel::INFO;
+    if (value == "warning" || value == "warn") return LogLevel::WARNING;
+    if (value == "error") return LogLevel::ERROR;
+    return fallback;
+}
+
+} // namespace
+
 Logger& Logger::getInstance() {
     static Logger instance;
     return instance;
 }
 
+Logger::Logger() : ring_(new Slot[kRingCapacity]) {
+    for (uint64_t i = 0; i < kRingCapacity; ++i) {
+        ring_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    level_.store(static_cast<int>(parseLevel(std::getenv("XIPHER_LOG_LEVEL"), LogLevel::INFO)),
+                 std::memory_order_relaxed);
+    writer_ = std::thread([this]() { writerLoop(); });
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
 void Logger::log(LogLevel level, const std::string& message) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::string log_entry = "[" + getCurrentTime() + "] [" + levelToString(level) + "] " + message;
-    
-    // Console output
-    if (level == LogLevel::ERROR) {
-        std::cerr << log_entry << std::endl;
-    } else {
-        std::cout << log_entry << std::endl;
+    log(level, std::string(message));
+}
+
+void Logger::log(LogLevel level, std::string&& message) {
+    if (!isEnabled(level)) {
+        return;
+    }
+    Record record;
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+    record.message = std::move(message);
+    if (!tryPush(std::move(record))) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
-    
-    // File output
-    if (file_logging_enabled_ && log_file_.is_open()) {
-        log_file_ << log_entry << std::endl;
-        log_file_.flush();
+    // The writer polls anyway; wake it early only when it is parked or for errors.
+    if (level == LogLevel::ERROR || writer_idle_.load(std::memory_order_relaxed)) {
+        wake_cv_.notify_one();
     }
 }
 
@@ -46,7 +90,7 @@ void Logger::error(const std::string& message) {
 }
 
 void Logger::setLogFile(const std::string& filename) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(file_mutex_);
     if (log_file_.is_open()) {
         log_file_.close();
     }
@@ -54,7 +98,136 @@ void Logger::setLogFile(const std::string& filename) {
     file_logging_enabled_ = log_file_.is_open();
 }
 
-std::string Logger::levelToString(LogLevel level) {
+void Logger::setLevel(LogLevel level) {
+    level_.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void Logger::flush() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    const uint64_t target = enqueue_pos_.load(std::memory_order_acquire);
+    wake_cv_.notify_one();
+    flushed_cv_.wait(lock, [this, target]() { return written_pos_ >= target || stopping_; });
+}
+
+bool Logger::tryPush(Record&& record) {
+    uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;) {
+        slot = &ring_[pos & (kRingCapacity - 1)];
+        const uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+        const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  // full
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+    slot->record = std::move(record);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool Logger::tryPop(Record& record) {
+    Slot& slot = ring_[dequeue_pos_ & (kRingCapacity - 1)];
+    const uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+    if (static_cast<int64_t>(seq) - static_cast<int64_t>(dequeue_pos_ + 1) < 0) {
+        return false;  // empty, or the producer has not published the slot yet
+    }
+    record = std::move(slot.record);
+    slot.record.message.clear();
+    slot.sequence.store(dequeue_pos_ + kRingCapacity, std::memory_order_release);
+    ++dequeue_pos_;
+    return true;
+}
+
+void Logger::writerLoop() {
+    std::string out;
+    std::string err;
+    std::string file;
+    // localtime_r once per second instead of once per line
+    std::time_t cached_second = 0;
+    char time_prefix[32] = {0};
+
+    auto append = [&](LogLevel level, std::chrono::system_clock::time_point time, const std::string& message) {
+        const std::time_t second = std::chrono::system_clock::to_time_t(time);
+        if (second != cached_second) {
+            std::tm tm_local{};
+            localtime_r(&second, &tm_local);
+            std::strftime(time_prefix, sizeof(time_prefix), "%Y-%m-%d %H:%M:%S", &tm_local);
+            cached_second = second;
+        }
+        std::string& console = level == LogLevel::ERROR ? err : out;
+        const size_t start = console.size();
+        console += '[';
+        console += time_prefix;
+        console += "] [";
+        console += levelToString(level);
+        console += "] ";
+        console += message;
+        console += '\n';
+        file.append(console, start, std::string::npos);
+    };
+
+    Record record;
+    for (;;) {
+        size_t batch = 0;
+        while (batch < kMaxBatch && tryPop(record)) {
+            append(record.level, record.time, record.message);
+            ++batch;
+        }
+        const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            append(LogLevel::WARNING, std::chrono::system_clock::now(),
+                   "Logger queue full, dropped " + std::to_string(dropped) + " lines");
+        }
+
+        if (!out.empty() || !err.empty()) {
+            if (!out.empty()) {
+                std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+                std::cout.flush();
+            }
+            if (!err.empty()) {
+                std::cerr.write(err.data(), static_cast<std::streamsize>(err.size()));
+                std::cerr.flush();
+            }
+            {
+                std::lock_guard<std::mutex> lock(file_mutex_);
+                if (file_logging_enabled_ && log_file_.is_open()) {
+                    log_file_.write(file.data(), static_cast<std::streamsize>(file.size()));
+                    log_file_.flush();
+                }
+            }
+            out.clear();
+            err.clear();
+            file.clear();
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        written_pos_ = dequeue_pos_;
+        flushed_cv_.notify_all();
+        if (batch == kMaxBatch) {
+            continue;  // more is waiting, skip the wait
+        }
+        if (stopping_) {
+            // Drain whatever was published before stop
+            lock.unlock();
+            if (tryPop(record)) {
+                append(record.level, record.time, record.message);
+                continue;
+            }
+            break;
+        }
+        writer_idle_.store(true, std::memory_order_relaxed);
+        wake_cv_.wait_for(lock, kIdleWait);
+        writer_idle_.store(false, std::memory_order_relaxed);
+    }
+}
+
+const char* Logger::levelToString(LogLevel level) {
     switch (level) {
         case LogLevel::DEBUG: return "DEBUG";
         case LogLevel::INFO: return "INFO";
@@ -64,14 +237,19 @@ std::string Logger::levelToString(LogLevel level) {
     }
 }
 
-std::string Logger::getCurrentTime() {
-    auto now = std::time(nullptr);
-    auto tm = *std::localtime(&now);
-    
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-    return oss.str();
+bool LogRateLimiter::allow(uint64_t* suppressed) {
+    const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t window = window_.load(std::memory_order_relaxed);
+    if (now != window && window_.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+        count_.store(0, std::memory_order_relaxed);
+    }
+    if (count_.fetch_add(1, std::memory_order_relaxed) >= per_second_) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    *suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
 }
 
 } // namespace xipher
-
@@ -0,0 +1,137 @@
+// asyncReadBody: the idle timeout applies between body chunks, not to the
+// whole upload.
+//
+//   cmake -S . -B build -DXIPHER_BUILD_TESTS=ON && cmake --build build --target http_body_reader_test
+//   ctest --test-dir build
+
+#include "../include/server/http_body_reader.hpp"
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace xipher;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+namespace {
+
+constexpr auto kIdleTimeout = std::chrono::milliseconds(300);
+constexpr auto kChunkGap = std::chrono::milliseconds(100);
+constexpr int kChunks = 10;  // ~1 s in total, well past kIdleTimeout
+
+struct Result {
+    beast::error_code ec;
+    std::string body;
+};
+
+// Serves one request with the same header-then-body sequence as
+// HttpServer::readRequest, while `send` writes the request from another thread.
+template <class Sender>
+Result readOneRequest(Sender send) {
+    net::io_context ioc;
+    tcp::acceptor acceptor(ioc, tcp::endpoint(net::ip::address_v4::loopback(), 0));
+    const unsigned short port = acceptor.local_endpoint().port();
+
+    std::thread client([port, send]() {
+        net::io_context client_ioc;
+        tcp::socket socket(client_ioc);
+        socket.connect(tcp::endpoint(net::ip::address_v4::loopback(), port));
+        send(socket);
+        beast::error_code ignored;
+        socket.shutdown(tcp::socket::shutdown_send, ignored);
+        char drain[64];
+        socket.read_some(net::buffer(drain), ignored);
+    });
+
+    Result result;
+    beast::tcp_stream stream(acceptor.accept());
+    beast::flat_buffer buffer;
+    http::request_parser<http::string_body> parser;
+    stream.expires_after(kIdleTimeout);
+    http::async_read_header(stream, buffer, parser, [&](beast::error_code ec, std::size_t) {
+        if (ec) {
+            result.ec = ec;
+            return;
+        }
+        asyncReadBody(stream, buffer, parser, kIdleTimeout, [&](beast::error_code ec) {
+            result.ec = ec;
+            if (!ec) {
+                result.body = parser.get().body();
+            }
+        });
+    });
+    ioc.run();
+    stream.close();
+    client.join();
+    return result;
+}
+
+void writeString(tcp::socket& socket, const std::string& data) {
+    net::write(socket, net::buffer(data));
+}
+
+std::string header(size_t content_length) {
+    return "POST /api/upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: " +
+           std::to_string(content_length) + "\r\n\r\n";
+}
+
+bool slowBodySucceeds() {
+    const std::string chunk(1024, 'x');
+    Result result = readOneRequest([chunk](tcp::socket& socket) {
+        writeString(socket, header(chunk.size() * kChunks));
+        for (int i = 0; i < kChunks; ++i) {
+            std::this_thread::sleep_for(kChunkGap);
+            writeString(socket, chunk);
+        }
+    });
+    if (result.ec) {
+        std::cerr << "slow body: unexpected error: " << result.ec.message() << "\n";
+        return false;
+    }
+    if (result.body.size() != chunk.size() * kChunks) {
+        std::cerr << "slow body: got " << result.body.size() << " bytes\n";
+        return false;
+    }
+    return true;
+}
+
+bool stalledBodyTimesOut() {
+    Result result = readOneRequest([](tcp::socket& socket) {
+        writeString(socket, header(4096) + std::string(100, 'x'));
+        std::this_thread::sleep_for(kIdleTimeout * 3);
+    });
+    if (result.ec != beast::error::timeout) {
+        std::cerr << "stalled body: expected timeout, got '" << result.ec.message() << "'\n";
+        return false;
+    }
+    return true;
+}
+
+bool emptyBodyCompletes() {
+    Result result = readOneRequest([](tcp::socket& socket) {
+        writeString(socket, header(0));
+    });
+    if (result.ec || !result.body.empty()) {
+        std::cerr << "empty body: unexpected result: " << result.ec.message() << "\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    int failures = 0;
+    failures += slowBodySucceeds() ? 0 : 1;
+    failures += stalledBodyTimesOut() ? 0 : 1;
+    failures += emptyBodyCompletes() ? 0 : 1;
+    if (failures == 0) {
+        std::cout << "http_body_reader_test: all passed\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -5961,7 +5961,9 @@ function connectWebSocket() {
                 try {
                     ws.send(JSON.stringify({
                         type: 'auth',
-                        token: token
+                        token: token,
+                        // onmessage splits concatenated JSON, server may batch frames
+                        coalesce: true
                     }));
                     console.log('[WebSocket] Auth message sent');
                 } catch (e) {